@@ -1,6 +1,7 @@
 ; ============================================================
 ; LZ77 RGBA (u32 pixels) - MASM x64, SSE2, Windows x64 ABI
 ; Format tokenu: Token12 { offset_px:u32, length_px:u32, next_px:u32 }
+;             oraz format kompaktowy (lz77_rgba_compress_packed / _decompress_packed)
 ;
 ; Poprawki zastosowane w tej wersji:
 ;  1) POPRAWNE offsety argumentow stosowych dla kompresji:
@@ -15,6 +16,9 @@
 ;       - init head[] movdqu
 ;       - porownanie kandydatow 16B (4 px)
 ;       - kopiowanie w dekompresji 16B
+;  8) Porownanie kandydatow konczy sie dokladna dlugoscia z maski niezgodnosci
+;     (bsf/tzcnt) zamiast petli skalarnej. Sciezki AVX2 (8 px) i AVX-512
+;     (16 px) wybierane przez CPUID przy pierwszym wywolaniu kompresji.
 ; ============================================================
 
 OPTION PROLOGUE:NONE
@@ -54,6 +58,72 @@ LOCAL_BESTOFF EQU 12
 ; Offset argumentu stosowego dla dekompresji (po prologu 0x40 bajtw)
 DECOMP_ARG_OUTLEN EQU 068h         ; Offset dla wskanika out_len w dekompresji
 
+; Poziomy SIMD (zgodne z LZ77_SIMD_* biblioteki C++)
+SIMD_UNKNOWN    EQU 0FFh           ; jeszcze nie sprawdzono
+SIMD_SSE2       EQU 1
+SIMD_AVX2       EQU 2
+SIMD_AVX512     EQU 3
+
+.data
+g_simd_level    BYTE SIMD_UNKNOWN  ; wynik lz77_detect_simd
+.code
+
+
+; ============================================================
+; Wykrycie poziomu SIMD: CPUID (liscie 1 i 7) + XGETBV.
+; AVX2 wymaga tez BMI1 (tzcnt), AVX-512 zapisu stanu ZMM przez OS.
+; Zachowuje wszystkie rejestry; wynik zapisany w g_simd_level.
+; Wyscig dwoch watkow jest nieszkodliwy - oba zapisza te sama wartosc.
+; ============================================================
+lz77_detect_simd PROC
+    push rax
+    push rbx
+    push rcx
+    push rdx
+    push rsi
+    push rdi
+
+    mov  esi, SIMD_SSE2              ; SSE2 - poziom bazowy x64
+    mov  eax, 1
+    cpuid
+    and  ecx, 18000000h              ; OSXSAVE (bit 27) + AVX (bit 28)
+    cmp  ecx, 18000000h
+    jne  LZS_STORE
+    xor  ecx, ecx
+    xgetbv                           ; XCR0 -> EDX:EAX
+    mov  edi, eax
+    and  eax, 6
+    cmp  eax, 6                      ; stan XMM i YMM zapisywany przez OS
+    jne  LZS_STORE
+
+    mov  eax, 7
+    xor  ecx, ecx
+    cpuid
+    mov  eax, ebx
+    and  eax, 28h                    ; AVX2 (bit 5) + BMI1 (bit 3)
+    cmp  eax, 28h
+    jne  LZS_STORE
+    mov  esi, SIMD_AVX2
+    test ebx, 10000h                 ; AVX512F (bit 16)
+    jz   LZS_STORE
+    and  edi, 0E0h                   ; opmask + ZMM_Hi256 + Hi16_ZMM
+    cmp  edi, 0E0h
+    jne  LZS_STORE
+    mov  esi, SIMD_AVX512
+
+LZS_STORE:
+    mov  eax, esi
+    mov  BYTE PTR [g_simd_level], al
+
+    pop  rdi
+    pop  rsi
+    pop  rdx
+    pop  rcx
+    pop  rbx
+    pop  rax
+    ret
+lz77_detect_simd ENDP
+
 
 ; ============================================================
 ; Procedura kompresji LZ77 dla danych RGBA
@@ -90,6 +160,11 @@ lz77_rgba_compress PROC
     mov  rax, QWORD PTR [rsp + COMP_ARG_WORKCAP]   ; work_cap
     mov  r13, QWORD PTR [rsp + COMP_ARG_OUTLEN]    ; out_len*
 
+    cmp  BYTE PTR [g_simd_level], SIMD_UNKNOWN
+    jne  LZC_SIMD_OK
+    call lz77_detect_simd          ; Pierwsze wywolanie - wybor sciezki porownania
+LZC_SIMD_OK:
+
     xor  r12d, r12d               ; Wyzerowano licznik zapisanych bajtw (out_bytes=0)
 
     ; Sprawdzono czy bufor docelowy pomieci co najmniej jeden token
@@ -189,6 +264,9 @@ LZC_CHAIN_LOOP:
     lea  rcx, [rsi + rcx*4]          ; Wskanik do danych kandydata
     xor  eax, eax                    ; curLen = 0
 
+    cmp  BYTE PTR [g_simd_level], SIMD_AVX2
+    jae  LZC_CMP_WIDE                ; AVX2 / AVX-512 wybrane przez CPUID
+
 ; Porwnanie blokami 16-bajtowymi (4 piksele) z uyciem SSE2
 LZC_CMP_BLOCK:
     lea  edx, [eax + 4]
@@ -200,11 +278,67 @@ LZC_CMP_BLOCK:
     movdqu xmm1, XMMWORD PTR [rcx + rax*4]  ; Zaadowano 4 piksele z kandydata
     pcmpeqd xmm0, xmm1                       ; Porwnanie - wynik 0xFFFFFFFF dla rwnych
     pmovmskb edx, xmm0                       ; Maska bitowa wyniku porwnania
-    cmp  edx, 0FFFFh                          ; Czy wszystkie 16 bajtw rwne?
-    jne  LZC_CMP_SCALAR
+    xor  edx, 0FFFFh                          ; Bity ustawione dla rnych bajtw
+    jnz  LZC_CMP_MISMATCH
     add  eax, 4                               ; Zwikszono dugo o 4
     jmp  LZC_CMP_BLOCK                         ; Kontynuacja
 
+; Pierwszy rny bajt z maski wyznacza dokadn dugo
+LZC_CMP_MISMATCH:
+    bsf  edx, edx
+    shr  edx, 2                               ; Bajt -> piksel
+    add  eax, edx
+    jmp  LZC_CMP_DONE
+
+; Porwnanie po 8 pikseli (AVX2) lub 16 pikseli (AVX-512)
+LZC_CMP_WIDE:
+    ja   LZC_CMP_ZMM
+LZC_CMP_YMM:
+    lea  edx, [eax + 8]
+    cmp  edx, r10d
+    ja   LZC_CMP_WIDE_END             ; Ogon krtszy ni 8 px - SSE2 i skalarnie
+
+    lea  rdx, [r8 + rax]
+    vmovdqu ymm0, YMMWORD PTR [rsi + rdx*4]
+    vpcmpeqd ymm0, ymm0, YMMWORD PTR [rcx + rax*4]
+    vpmovmskb edx, ymm0
+    not  edx                                  ; Bity ustawione dla rnych bajtw
+    test edx, edx
+    jnz  LZC_CMP_YMM_MISMATCH
+    add  eax, 8
+    jmp  LZC_CMP_YMM
+
+LZC_CMP_YMM_MISMATCH:
+    tzcnt edx, edx
+    shr  edx, 2
+    add  eax, edx
+    vzeroupper
+    jmp  LZC_CMP_DONE
+
+LZC_CMP_ZMM:
+    lea  edx, [eax + 16]
+    cmp  edx, r10d
+    ja   LZC_CMP_YMM                  ; Ogon krtszy ni 16 px - dalej AVX2
+
+    lea  rdx, [r8 + rax]
+    vmovdqu32 zmm0, ZMMWORD PTR [rsi + rdx*4]
+    vpcmpd k1, zmm0, ZMMWORD PTR [rcx + rax*4], 4   ; Maska rnych pikseli (NE)
+    kmovw edx, k1
+    test edx, edx
+    jnz  LZC_CMP_ZMM_MISMATCH
+    add  eax, 16
+    jmp  LZC_CMP_ZMM
+
+LZC_CMP_ZMM_MISMATCH:
+    tzcnt edx, edx                            ; Maska jest ju per piksel
+    add  eax, edx
+    vzeroupper
+    jmp  LZC_CMP_DONE
+
+LZC_CMP_WIDE_END:
+    vzeroupper                                ; Bez kar przejcia AVX -> SSE
+    jmp  LZC_CMP_BLOCK
+
 ; Porwnanie skalarne dla pozostaych pikseli
 LZC_CMP_SCALAR:
     cmp  eax, r10d
@@ -548,4 +682,624 @@ LZD_EXIT:
     ret
 lz77_rgba_decompress ENDP
 
+
+; ============================================================
+; Format kompaktowy (LZ77_FORMAT_PACKED)
+;   [flagi:u8] + do 8 tokenow; bit k flag = 1 -> dopasowanie, 0 -> seria literalow
+;   dopasowanie:     3 bajty LE: bity 0..11 offset-1, bity 12..17 dlugosc-1
+;   seria literalow: [n-1:u8] + n pikseli (n = 1..256)
+; ============================================================
+PACKED_MATCH_BYTES EQU 3           ; rozmiar tokena dopasowania
+PACKED_MIN_MATCH   EQU 2           ; krotsze dopasowania zapisywane jako literaly
+PACKED_MAX_RUN     EQU 256         ; maksymalna dlugosc serii literalow
+PACKED_GROUP       EQU 8           ; liczba tokenow opisywanych jednym bajtem flag
+
+; Offsety argumentow stosowych po prologu kompresji kompaktowej (8*push + sub rsp,48 = 0x70)
+CPK_ARG_WORK      EQU 098h
+CPK_ARG_WORKCAP   EQU 0A0h
+CPK_ARG_OUTLEN    EQU 0A8h
+
+; Zmienne lokalne kompresji kompaktowej (48 bajtow)
+; [rsp+0]  DWORD chain_remaining
+; [rsp+4]  DWORD candidate_save
+; [rsp+8]  DWORD offset_save
+; [rsp+12] DWORD bestoff_save
+; [rsp+16] QWORD lit_start         ; poczatek oczekujacej serii literalow
+; [rsp+24] QWORD flag_pos          ; pozycja bajtu flag biezacej grupy w dst
+; [rsp+32] DWORD group_left        ; wolne bity w bajcie flag (0 = otworz nowa grupe)
+; [rsp+36] DWORD pend_len          ; dlugosc dopasowania do zapisu po serii (0 = koniec danych)
+PK_CHAIN      EQU 0
+PK_CAND       EQU 4
+PK_OFFSET     EQU 8
+PK_BESTOFF    EQU 12
+PK_LITSTART   EQU 16
+PK_FLAGPOS    EQU 24
+PK_GROUPLEFT  EQU 32
+PK_PENDLEN    EQU 36
+
+
+; ============================================================
+; Procedura kompresji LZ77 do formatu kompaktowego
+; Wejscie jak w lz77_rgba_compress:
+;   RCX - src_px, RDX - src_count_px, R8 - dst, R9 - dst_cap_bytes
+;   [RSP+98h] - work, [RSP+0A0h] - work_cap, [RSP+0A8h] - out_len
+;
+; Literaly nie sa zapisywane od razu: [lit_start .. i) to oczekujaca seria,
+; zapisywana (LZP_FLUSH) przed kazdym dopasowaniem i na koncu danych.
+; ============================================================
+PUBLIC lz77_rgba_compress_packed
+lz77_rgba_compress_packed PROC
+    push rbx
+    push rbp
+    push rsi
+    push rdi
+    push r12
+    push r13
+    push r14
+    push r15
+    sub  rsp, 48
+
+    mov  rsi, rcx                 ; src_px
+    mov  r14, rdx                 ; src_count_px
+    mov  rdi, r8                  ; dst
+    mov  r15, r9                  ; dst_cap_bytes
+
+    mov  rbx, QWORD PTR [rsp + CPK_ARG_WORK]
+    mov  rax, QWORD PTR [rsp + CPK_ARG_WORKCAP]
+    mov  r13, QWORD PTR [rsp + CPK_ARG_OUTLEN]
+
+    cmp  BYTE PTR [g_simd_level], SIMD_UNKNOWN
+    jne  LZP_SIMD_OK
+    call lz77_detect_simd
+LZP_SIMD_OK:
+
+    xor  r12d, r12d               ; out_bytes = 0
+    mov  QWORD PTR [rsp + PK_LITSTART], 0
+    mov  QWORD PTR [rsp + PK_FLAGPOS], 0
+    mov  DWORD PTR [rsp + PK_GROUPLEFT], 0
+    mov  DWORD PTR [rsp + PK_PENDLEN], 0
+
+    test r14, r14
+    jz   LZP_DONE                 ; Puste wejscie - 0 bajtow
+
+    test rbx, rbx
+    jz   LZP_LITERAL_ONLY
+    cmp  rax, WORK_NEED_BYTES
+    jb   LZP_LITERAL_ONLY
+
+    lea  rbp, [rbx + WORK_HEAD_BYTES]   ; prev_base
+
+    pcmpeqd xmm2, xmm2
+    mov  rcx, WORK_HEAD_BYTES / 16
+    mov  rax, rbx
+LZP_INIT_HEAD:
+    movdqu XMMWORD PTR [rax], xmm2
+    add  rax, 16
+    dec  rcx
+    jnz  LZP_INIT_HEAD
+
+    xor  r8d, r8d                 ; i = 0
+
+LZP_MAIN:
+    cmp  r8, r14
+    jae  LZP_FINAL
+
+    mov  r9, r14
+    sub  r9, r8                   ; remaining
+    cmp  r9, 1
+    je   LZP_LAST_PIXEL           ; Ostatni piksel bez sasiada - dolacza do serii
+
+    ; maxMatch = min(MAX_MATCH_PX, remaining) - brak jawnego next_px
+    mov  r10, r9
+    cmp  r10, MAX_MATCH_PX
+    jbe  LZP_MAX_OK
+    mov  r10, MAX_MATCH_PX
+LZP_MAX_OK:
+
+    mov  eax, DWORD PTR [rsi + r8*4]
+    mov  edx, DWORD PTR [rsi + r8*4 + 4]
+    rol  edx, 5
+    xor  eax, edx
+    and  eax, HASH_MASK
+
+    xor  r11d, r11d
+    cmp  r8, WINDOW_PX
+    jb   LZP_DICT_OK
+    mov  r11, r8
+    sub  r11, WINDOW_PX
+LZP_DICT_OK:
+
+    mov  ecx, DWORD PTR [rbx + rax*4]
+    xor  r9d, r9d                    ; bestLen = 0
+    mov  DWORD PTR [rsp + PK_BESTOFF], 0
+    mov  DWORD PTR [rsp + PK_CHAIN], MAX_CANDIDATES
+
+LZP_CHAIN_LOOP:
+    cmp  ecx, INVALID_POS
+    je   LZP_CHAIN_DONE
+    cmp  rcx, r11
+    jb   LZP_CHAIN_DONE
+
+    mov  eax, r8d
+    sub  eax, ecx
+    mov  DWORD PTR [rsp + PK_CAND],   ecx
+    mov  DWORD PTR [rsp + PK_OFFSET], eax
+
+    lea  rcx, [rsi + rcx*4]
+    xor  eax, eax                    ; curLen = 0
+
+    cmp  BYTE PTR [g_simd_level], SIMD_AVX2
+    jae  LZP_CMP_WIDE
+
+LZP_CMP_BLOCK:
+    lea  edx, [eax + 4]
+    cmp  edx, r10d
+    ja   LZP_CMP_SCALAR
+
+    lea  rdx, [r8 + rax]
+    movdqu xmm0, XMMWORD PTR [rsi + rdx*4]
+    movdqu xmm1, XMMWORD PTR [rcx + rax*4]
+    pcmpeqd xmm0, xmm1
+    pmovmskb edx, xmm0
+    xor  edx, 0FFFFh
+    jnz  LZP_CMP_MISMATCH
+    add  eax, 4
+    jmp  LZP_CMP_BLOCK
+
+LZP_CMP_MISMATCH:
+    bsf  edx, edx                    ; dokladna dlugosc z maski
+    shr  edx, 2
+    add  eax, edx
+    jmp  LZP_CMP_DONE
+
+LZP_CMP_WIDE:
+    ja   LZP_CMP_ZMM
+LZP_CMP_YMM:
+    lea  edx, [eax + 8]
+    cmp  edx, r10d
+    ja   LZP_CMP_WIDE_END
+
+    lea  rdx, [r8 + rax]
+    vmovdqu ymm0, YMMWORD PTR [rsi + rdx*4]
+    vpcmpeqd ymm0, ymm0, YMMWORD PTR [rcx + rax*4]
+    vpmovmskb edx, ymm0
+    not  edx
+    test edx, edx
+    jnz  LZP_CMP_YMM_MISMATCH
+    add  eax, 8
+    jmp  LZP_CMP_YMM
+
+LZP_CMP_YMM_MISMATCH:
+    tzcnt edx, edx
+    shr  edx, 2
+    add  eax, edx
+    vzeroupper
+    jmp  LZP_CMP_DONE
+
+LZP_CMP_ZMM:
+    lea  edx, [eax + 16]
+    cmp  edx, r10d
+    ja   LZP_CMP_YMM
+
+    lea  rdx, [r8 + rax]
+    vmovdqu32 zmm0, ZMMWORD PTR [rsi + rdx*4]
+    vpcmpd k1, zmm0, ZMMWORD PTR [rcx + rax*4], 4
+    kmovw edx, k1
+    test edx, edx
+    jnz  LZP_CMP_ZMM_MISMATCH
+    add  eax, 16
+    jmp  LZP_CMP_ZMM
+
+LZP_CMP_ZMM_MISMATCH:
+    tzcnt edx, edx
+    add  eax, edx
+    vzeroupper
+    jmp  LZP_CMP_DONE
+
+LZP_CMP_WIDE_END:
+    vzeroupper
+    jmp  LZP_CMP_BLOCK
+
+LZP_CMP_SCALAR:
+    cmp  eax, r10d
+    jae  LZP_CMP_DONE
+    lea  rdx, [r8 + rax]
+    mov  edx, DWORD PTR [rsi + rdx*4]
+    cmp  edx, DWORD PTR [rcx + rax*4]
+    jne  LZP_CMP_DONE
+    inc  eax
+    jmp  LZP_CMP_SCALAR
+
+LZP_CMP_DONE:
+    cmp  eax, r9d
+    jle  LZP_NO_IMPROVE
+    mov  r9d, eax
+    mov  edx, DWORD PTR [rsp + PK_OFFSET]
+    mov  DWORD PTR [rsp + PK_BESTOFF], edx
+LZP_NO_IMPROVE:
+
+    mov  ecx, DWORD PTR [rsp + PK_CAND]
+    mov  eax, ecx
+    and  eax, (WINDOW_PX - 1)
+    mov  ecx, DWORD PTR [rbp + rax*4]
+
+    dec  DWORD PTR [rsp + PK_CHAIN]
+    jnz  LZP_CHAIN_LOOP
+
+LZP_CHAIN_DONE:
+    ; Bezpieczniki jak w lz77_rgba_compress: bestLen <= maxMatch, 0 < bestOff <= i
+    cmp  r9d, r10d
+    ja   LZP_EMIT_LITERAL
+    cmp  r9d, PACKED_MIN_MATCH
+    jb   LZP_EMIT_LITERAL
+    mov  edx, DWORD PTR [rsp + PK_BESTOFF]
+    test edx, edx
+    jz   LZP_EMIT_LITERAL
+    cmp  rdx, r8
+    ja   LZP_EMIT_LITERAL
+
+    ; Dopasowanie: najpierw zapis oczekujacej serii literalow, potem tokena dopasowania
+    mov  DWORD PTR [rsp + PK_PENDLEN], r9d
+    jmp  LZP_FLUSH
+
+; ============================================================
+; Literal: piksel i dolacza do serii, pozycja i trafia do slownika
+; (remaining >= 2, wiec para src[i], src[i+1] istnieje)
+; ============================================================
+LZP_EMIT_LITERAL:
+    mov  eax, DWORD PTR [rsi + r8*4]
+    mov  edx, DWORD PTR [rsi + r8*4 + 4]
+    rol  edx, 5
+    xor  eax, edx
+    and  eax, HASH_MASK
+    mov  ecx, r8d
+    and  ecx, (WINDOW_PX - 1)
+    mov  edx, DWORD PTR [rbx + rax*4]
+    mov  DWORD PTR [rbp + rcx*4], edx
+    mov  DWORD PTR [rbx + rax*4], r8d
+    inc  r8
+    jmp  LZP_MAIN
+
+LZP_LAST_PIXEL:
+    inc  r8
+    jmp  LZP_MAIN
+
+; Tryb tylko literalny - caly obraz jako serie literalow
+LZP_LITERAL_ONLY:
+    mov  r8, r14
+
+LZP_FINAL:
+    mov  DWORD PTR [rsp + PK_PENDLEN], 0
+
+; ============================================================
+; Zapis serii literalow [lit_start .. i) w porcjach po PACKED_MAX_RUN pikseli
+; ============================================================
+LZP_FLUSH:
+    mov  r10, r8
+    sub  r10, QWORD PTR [rsp + PK_LITSTART]   ; liczba oczekujacych literalow
+
+LZP_FLUSH_LOOP:
+    test r10, r10
+    jz   LZP_FLUSH_DONE
+    mov  r11, r10
+    cmp  r11, PACKED_MAX_RUN
+    jbe  LZP_RUN_OK
+    mov  r11, PACKED_MAX_RUN
+LZP_RUN_OK:                                  ; r11 = dlugosc serii
+
+    ; Wymagane miejsce: licznik + run*4 bajtow (+1 na bajt flag nowej grupy)
+    lea  rax, [r11*4 + 1]
+    cmp  DWORD PTR [rsp + PK_GROUPLEFT], 0
+    jne  LZP_RUN_ROOM
+    inc  rax
+LZP_RUN_ROOM:
+    mov  rdx, r15
+    sub  rdx, r12
+    cmp  rdx, rax
+    jb   LZP_FAIL
+
+    cmp  DWORD PTR [rsp + PK_GROUPLEFT], 0
+    jne  LZP_RUN_GROUP_OK
+    mov  QWORD PTR [rsp + PK_FLAGPOS], r12
+    mov  BYTE PTR [rdi + r12], 0
+    inc  r12
+    mov  DWORD PTR [rsp + PK_GROUPLEFT], PACKED_GROUP
+LZP_RUN_GROUP_OK:
+    dec  DWORD PTR [rsp + PK_GROUPLEFT]       ; bit serii literalow pozostaje 0
+
+    lea  eax, [r11 - 1]
+    mov  BYTE PTR [rdi + r12], al
+    inc  r12
+
+    ; Kopiowanie run*4 bajtow z src[lit_start] - blokami 16B (SSE2), ogon po 4B
+    mov  rcx, QWORD PTR [rsp + PK_LITSTART]
+    lea  rdx, [rsi + rcx*4]
+    lea  rcx, [rdi + r12]
+    lea  rax, [r11*4]
+LZP_RUN_COPY16:
+    cmp  rax, 16
+    jb   LZP_RUN_COPY4
+    movdqu xmm0, XMMWORD PTR [rdx]
+    movdqu XMMWORD PTR [rcx], xmm0
+    add  rdx, 16
+    add  rcx, 16
+    sub  rax, 16
+    jmp  LZP_RUN_COPY16
+LZP_RUN_COPY4:
+    test rax, rax
+    jz   LZP_RUN_COPIED
+    movd xmm0, DWORD PTR [rdx]
+    movd DWORD PTR [rcx], xmm0
+    add  rdx, 4
+    add  rcx, 4
+    sub  rax, 4
+    jmp  LZP_RUN_COPY4
+LZP_RUN_COPIED:
+    lea  r12, [r12 + r11*4]
+    add  QWORD PTR [rsp + PK_LITSTART], r11
+    sub  r10, r11
+    jmp  LZP_FLUSH_LOOP
+
+LZP_FLUSH_DONE:
+    mov  r9d, DWORD PTR [rsp + PK_PENDLEN]
+    test r9d, r9d
+    jz   LZP_DONE                  ; Koniec danych - seria zapisana
+
+; ============================================================
+; Zapis tokena dopasowania (3 bajty) i ustawienie jego bitu flag
+; ============================================================
+    mov  eax, PACKED_MATCH_BYTES
+    cmp  DWORD PTR [rsp + PK_GROUPLEFT], 0
+    jne  LZP_MATCH_ROOM
+    inc  eax
+LZP_MATCH_ROOM:
+    mov  rdx, r15
+    sub  rdx, r12
+    cmp  rdx, rax
+    jb   LZP_FAIL
+
+    cmp  DWORD PTR [rsp + PK_GROUPLEFT], 0
+    jne  LZP_MATCH_GROUP_OK
+    mov  QWORD PTR [rsp + PK_FLAGPOS], r12
+    mov  BYTE PTR [rdi + r12], 0
+    inc  r12
+    mov  DWORD PTR [rsp + PK_GROUPLEFT], PACKED_GROUP
+LZP_MATCH_GROUP_OK:
+    ; bit tokena = PACKED_GROUP - group_left
+    mov  ecx, PACKED_GROUP
+    sub  ecx, DWORD PTR [rsp + PK_GROUPLEFT]
+    mov  eax, 1
+    shl  eax, cl
+    mov  rdx, QWORD PTR [rsp + PK_FLAGPOS]
+    or   BYTE PTR [rdi + rdx], al
+    dec  DWORD PTR [rsp + PK_GROUPLEFT]
+
+    ; (offset-1) | (dlugosc-1) << 12
+    mov  eax, DWORD PTR [rsp + PK_BESTOFF]
+    dec  eax
+    lea  edx, [r9 - 1]
+    shl  edx, 12
+    or   eax, edx
+    mov  WORD PTR [rdi + r12], ax
+    shr  eax, 16
+    mov  BYTE PTR [rdi + r12 + 2], al
+    add  r12, PACKED_MATCH_BYTES
+
+    ; Wstawienie pozycji [i .. i+bestLen) do slownika
+    mov  r10d, r9d
+    xor  eax, eax
+LZP_INSERT_LOOP:
+    cmp  eax, r10d
+    jae  LZP_INSERT_DONE
+
+    mov  ecx, r8d
+    add  ecx, eax
+    lea  rdx, [rcx + 1]
+    cmp  rdx, r14
+    jae  LZP_INSERT_DONE
+
+    mov  r9d,  DWORD PTR [rsi + rcx*4]
+    mov  r11d, DWORD PTR [rsi + rcx*4 + 4]
+    rol  r11d, 5
+    xor  r9d,  r11d
+    and  r9d,  HASH_MASK
+
+    mov  edx, ecx
+    and  edx, (WINDOW_PX - 1)
+
+    mov  r11d, DWORD PTR [rbx + r9*4]
+    mov  DWORD PTR [rbp + rdx*4], r11d
+    mov  DWORD PTR [rbx + r9*4], ecx
+
+    inc  eax
+    jmp  LZP_INSERT_LOOP
+
+LZP_INSERT_DONE:
+    add  r8, r10                                ; i += bestLen
+    mov  QWORD PTR [rsp + PK_LITSTART], r8      ; nowa seria zaczyna sie za dopasowaniem
+    jmp  LZP_MAIN
+
+LZP_FAIL:
+    mov  QWORD PTR [r13], 0
+    jmp  LZP_EXIT
+
+LZP_DONE:
+    mov  QWORD PTR [r13], r12
+
+LZP_EXIT:
+    add  rsp, 48
+    pop  r15
+    pop  r14
+    pop  r13
+    pop  r12
+    pop  rdi
+    pop  rsi
+    pop  rbp
+    pop  rbx
+    ret
+lz77_rgba_compress_packed ENDP
+
+
+; ============================================================
+; Procedura dekompresji formatu kompaktowego
+; Wejscie jak w lz77_rgba_decompress:
+;   RCX - src, RDX - src_len, R8 - dst, R9 - dst_cap_px, [RSP+68h] - out_len_px
+;
+; Rejestry petli: RBX - pozycja w src, R12 - out_px, EBP - bajt flag
+; (przesuwany w prawo po kazdym tokenie), R8D - tokeny pozostale w grupie.
+; ============================================================
+PUBLIC lz77_rgba_decompress_packed
+lz77_rgba_decompress_packed PROC
+    push rbx
+    push rbp
+    push rsi
+    push rdi
+    push r12
+    push r13
+    push r14
+    push r15
+
+    mov  rsi, rcx                 ; src
+    mov  r14, rdx                 ; src_len
+    mov  rdi, r8                  ; dst
+    mov  r15, r9                  ; dst_cap_px
+    mov  r13, QWORD PTR [rsp + DECOMP_ARG_OUTLEN]
+
+    xor  r12d, r12d               ; out_px
+    xor  ebx,  ebx                ; in_bytes
+
+LZDP_GROUP:
+    cmp  rbx, r14
+    jae  LZDP_DONE
+    movzx ebp, BYTE PTR [rsi + rbx]   ; bajt flag grupy
+    inc  rbx
+    mov  r8d, PACKED_GROUP
+
+LZDP_TOKEN:
+    cmp  rbx, r14
+    jae  LZDP_DONE                ; Ostatnia grupa moze byc niepelna
+    test ebp, 1
+    jnz  LZDP_MATCH
+
+    ; Seria literalow: licznik n-1 i n pikseli
+    movzx ecx, BYTE PTR [rsi + rbx]
+    inc  ecx                      ; n
+    lea  r9, [rcx*4]              ; n*4 bajtow
+    mov  rax, r14
+    sub  rax, rbx
+    dec  rax
+    cmp  rax, r9
+    jb   LZDP_FAIL                ; Seria ucieta w strumieniu
+    mov  rax, r15
+    sub  rax, r12
+    cmp  rax, rcx
+    jb   LZDP_FAIL                ; Przepelnienie bufora wyjsciowego
+
+    lea  rdx, [rsi + rbx + 1]
+    lea  r10, [rdi + r12*4]
+    lea  rbx, [rbx + r9 + 1]
+    add  r12, rcx
+LZDP_LIT16:
+    cmp  r9, 16
+    jb   LZDP_LIT4
+    movdqu xmm0, XMMWORD PTR [rdx]
+    movdqu XMMWORD PTR [r10], xmm0
+    add  rdx, 16
+    add  r10, 16
+    sub  r9, 16
+    jmp  LZDP_LIT16
+LZDP_LIT4:
+    test r9, r9
+    jz   LZDP_NEXT
+    movd xmm0, DWORD PTR [rdx]
+    movd DWORD PTR [r10], xmm0
+    add  rdx, 4
+    add  r10, 4
+    sub  r9, 4
+    jmp  LZDP_LIT4
+
+LZDP_MATCH:
+    mov  rax, r14
+    sub  rax, rbx
+    cmp  rax, PACKED_MATCH_BYTES
+    jb   LZDP_FAIL
+
+    movzx eax, WORD PTR [rsi + rbx]
+    movzx edx, BYTE PTR [rsi + rbx + 2]
+    shl  edx, 16
+    or   eax, edx
+    add  rbx, PACKED_MATCH_BYTES
+
+    mov  ecx, eax
+    shr  ecx, 12
+    and  ecx, 3Fh
+    inc  ecx                      ; dlugosc
+    and  eax, 0FFFh
+    inc  eax                      ; offset
+
+    ; Walidacja: offset <= out_px oraz dlugosc <= wolne miejsce
+    mov  rdx, r15
+    sub  rdx, r12                 ; room
+    cmp  rax, r12
+    ja   LZDP_FAIL
+    cmp  rdx, rcx
+    jb   LZDP_FAIL
+
+    lea  r10, [rdi + r12*4]       ; cel
+    lea  r11, [rax*4]
+    mov  r9, r10
+    sub  r9, r11                  ; zrodlo = cel - offset
+    add  r12, rcx
+
+    ; offset >= 4 i miejsce na zaokraglona dlugosc: kopiowanie pelnymi blokami 16B
+    cmp  eax, 4
+    jb   LZDP_MATCH_SCALAR
+    lea  r11, [rcx + 3]
+    and  r11, -4
+    cmp  rdx, r11
+    jb   LZDP_MATCH_SCALAR
+    shl  r11, 2
+    xor  eax, eax
+LZDP_MATCH16:
+    movdqu xmm0, XMMWORD PTR [r9 + rax]
+    movdqu XMMWORD PTR [r10 + rax], xmm0
+    add  rax, 16
+    cmp  rax, r11
+    jb   LZDP_MATCH16
+    jmp  LZDP_NEXT
+
+; Offset < 4 lub koniec bufora: kopiowanie piksel po pikselu (powielanie wzorca)
+LZDP_MATCH_SCALAR:
+    mov  eax, DWORD PTR [r9]
+    mov  DWORD PTR [r10], eax
+    add  r9, 4
+    add  r10, 4
+    dec  ecx
+    jnz  LZDP_MATCH_SCALAR
+
+LZDP_NEXT:
+    shr  ebp, 1
+    dec  r8d
+    jnz  LZDP_TOKEN
+    jmp  LZDP_GROUP
+
+LZDP_FAIL:
+    mov  QWORD PTR [r13], 0
+    jmp  LZDP_EXIT
+
+LZDP_DONE:
+    mov  QWORD PTR [r13], r12
+
+LZDP_EXIT:
+    pop  r15
+    pop  r14
+    pop  r13
+    pop  r12
+    pop  rdi
+    pop  rsi
+    pop  rbp
+    pop  rbx
+    ret
+lz77_rgba_decompress_packed ENDP
+
 END
\ No newline at end of file
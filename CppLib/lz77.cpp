@@ -9,23 +9,230 @@
 
 #include "lz77.h"
 #include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
 
- // Okno ślizgowe: 4096 pikseli wstecz, tablice hash: 65536 wpisów (potęga 2 umożliwia maskowanie bitowe).
+// Jądra SSE2 / AVX2 / AVX-512 tylko na x64 (SSE2 jest tam zawsze dostępne); na innych
+// architekturach działa wyłącznie wersja przenośna.
+#if defined(_M_X64) || defined(__x86_64__)
+#define LZ77_X64_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC udostępnia intrinsics AVX2/AVX-512 bez dodatkowych opcji; GCC i Clang wymagają
+// atrybutu target na funkcjach, które ich używają (reszta pliku zostaje na bazowym x64).
+#if defined(LZ77_X64_SIMD) && !defined(_MSC_VER)
+#define LZ77_TARGET_AVX2   __attribute__((target("avx2,bmi")))
+#define LZ77_TARGET_AVX512 __attribute__((target("avx512f,avx2,bmi")))
+#else
+#define LZ77_TARGET_AVX2
+#define LZ77_TARGET_AVX512
+#endif
+
+ // Okno ślizgowe: 4096 pikseli wstecz, tablice hash: do 65536 wpisów (potęga 2 umożliwia maskowanie bitowe).
+// Krótkie wejście dostaje mniejszą tablicę — ok. 2 wpisy na piksel, co najmniej 2^HASH_BITS_MIN.
 static const uint32_t WINDOW_PX = 4096;
-static const uint32_t HASH_SIZE = 65536;
-static const uint32_t HASH_MASK = HASH_SIZE - 1;
+static const uint32_t HASH_BITS_MAX = 16;
+static const uint32_t HASH_BITS_MIN = 8;
+static const uint32_t HASH_SIZE = 1u << HASH_BITS_MAX;
 // Jedno dopasowanie nie może objąć więcej niż 64 piksele; łańcuch hash przeszukuje co najwyżej 32 kandydatów.
 static const uint32_t MAX_MATCH_PX = 64;
 static const uint32_t MAX_CANDIDATES = 32;
 // Token ma 12 bajtów: trzy pola uint32_t (offset_px, length_px, next_px).
 static const uint32_t TOKEN_SIZE = 12;
+// Format kompaktowy: dopasowanie zajmuje 3 bajty (12 bitów offsetu, 6 bitów długości),
+// seria literałów — 1 bajt licznika i do 256 surowych pikseli; grupy po 8 tokenów poprzedza bajt flag.
+static const uint32_t PACKED_MATCH_BYTES = 3;
+static const uint32_t PACKED_MIN_MATCH = 2;
+static const uint32_t PACKED_MAX_LITERAL_RUN = 256;
+static const uint32_t PACKED_GROUP_TOKENS = 8;
+
+// Wyszukiwanie w kubełkach (LZ77_MATCH_FINDER_BUCKET): kubełek to jedna linia pamięci podręcznej
+// z BUCKET_WAYS pozycjami i ich odciskami, od najnowszej. Odcisk obejmuje BUCKET_TAG_PX pikseli
+// kandydata, więc większość fałszywych kandydatów odpada bez odczytu pikseli źródła.
+static const uint32_t BUCKET_WAYS = 8;
+static const uint32_t BUCKET_TAG_PX = 4;
+static const uint32_t BUCKET_BITS_MIN = 4;
+static const size_t   BUCKET_ALIGN = 64;
+
 // Wartość oznaczająca pusty slot w tablicy head[] lub prev[].
 static const uint32_t INVALID_POS = 0xFFFFFFFFu;
 
-// Bufor roboczy: head[65536] zajmuje 256 KB, prev[4096] zajmuje 16 KB.
+// Bufor roboczy (największy — dla wejścia od 32768 pikseli): head[65536] zajmuje 256 KB,
+// prev[4096] zajmuje 16 KB.
 static const size_t WORK_HEAD_BYTES = HASH_SIZE * sizeof(uint32_t);
 static const size_t WORK_PREV_BYTES = WINDOW_PX * sizeof(uint32_t);
 static const size_t WORK_NEED_BYTES = WORK_HEAD_BYTES + WORK_PREV_BYTES;
+static_assert(WORK_NEED_BYTES == LZ77_WORK_NEED_BYTES, "LZ77_WORK_NEED_BYTES to bufor dla dowolnego wejscia");
+
+// Zakresy parametrów poziomów (lz77_params): okno i maks. dopasowanie to potęgi 2,
+// więc pola tokenu dopasowania mają po log2 bitów; łącznie najwyżej 32 bity.
+static const uint32_t LEVEL_MIN_WINDOW_PX = 256;
+static const uint32_t LEVEL_MAX_WINDOW_PX = 65536;
+static const uint32_t LEVEL_MAX_MATCH_PX = 65536;
+static const uint32_t LEVEL_MAX_CHAIN = 65536;
+
+// Kandydaci z poprzednich wierszy obrazu (lz77_rgba_compress_image): nad pikselem,
+// nad-lewo, nad-prawo i dwa wiersze wyżej — sprawdzani przed łańcuchem hash.
+static const uint32_t ROW_CANDIDATES_MAX = 4;
+
+// Parsowanie optymalne (LZ77_PARSE_OPTIMAL): programowanie dynamiczne w segmentach
+// po OPT_SEGMENT_PX pikseli; tablice segmentu leżą w buforze roboczym za prev[].
+// Koszty w 1/8 bajta: piksel literału 4 B, początek serii 1 B licznika + bit flagi,
+// dopasowanie matchBytes + bit flagi.
+static const uint32_t OPT_SEGMENT_PX = 16384;
+static const uint32_t OPT_COST_LITERAL = 32;
+static const uint32_t OPT_COST_RUN_START = 9;
+static const uint32_t OPT_COST_INF = 0x3FFFFFFFu;
+// Dopasowanie co najmniej tej długości jest przyjmowane bez przeszukiwania pozycji wewnątrz
+// niego — bez tego długie serie (np. jednolite tło) kosztowałyby O(n * maxMatch) porównań.
+// Ostatnie OPT_NICE_TAIL_PX pozycji takiego dopasowania są przeszukiwane, by kolejny token
+// mógł zacząć się przed jego końcem.
+static const uint32_t OPT_NICE_MATCH_PX = 256;
+static const uint32_t OPT_NICE_TAIL_PX = 4;
+static const size_t   OPT_WORK_BYTES =
+    (size_t)OPT_SEGMENT_PX * sizeof(uint64_t) +                     // kopiec kandydatów dopasowań
+    (size_t)(OPT_SEGMENT_PX + 1) * (2 * sizeof(uint32_t)) +          // costL[], costM[]
+    (size_t)OPT_SEGMENT_PX * (3 * sizeof(uint32_t)) +                // matchLen[], matchOff[], emitLen[]
+    (size_t)(OPT_SEGMENT_PX + 1) * (sizeof(uint16_t) + sizeof(uint8_t));  // fromM[], litFromM[]
+
+// Presety poziomów LZ77_LEVEL_MIN..LZ77_LEVEL_MAX: { okno, maks. dopasowanie, głębokość łańcucha, poziom, parsowanie }.
+// Poziomy 1 i 2 mają pola tokenu formatu LZ77_FORMAT_PACKED (12 + 6 bitów); poziom 2 = lz77_rgba_compress_packed.
+static const lz77_params LEVEL_PRESETS[] = {
+    {  4096,    64,    1, 1, LZ77_PARSE_GREEDY  },   // fast   — tylko najnowszy kandydat
+    {  4096,    64,   32, 2, LZ77_PARSE_GREEDY  },   // normal — parametry formatu LZ77_FORMAT_PACKED
+    { 16384,   256,   64, 3, LZ77_PARSE_LAZY    },   // high   — 14 + 8 bitów, token 3 B
+    { 32768,  4096,  256, 4, LZ77_PARSE_LAZY2   },   // max    — 15 + 12 bitów, token 4 B
+    { 65536, 65536, 1024, 5, LZ77_PARSE_OPTIMAL },   // ultra  — 16 + 16 bitów, token 4 B
+};
+
+// Parametry wyszukiwania i układ tokenu dopasowania wyznaczone z lz77_params.
+struct PackedConfig {
+    uint32_t window;      // rozmiar okna (potęga 2)
+    uint32_t maxMatch;    // maks. długość dopasowania
+    uint32_t maxChain;    // maks. liczba kandydatów łańcucha hash
+    uint32_t offsetBits;  // log2(window): bity offset-1 w tokenie
+    uint32_t lengthBits;  // log2(maxMatch): bity długość-1 w tokenie
+    uint32_t matchBytes;  // bajty tokenu dopasowania (3 lub 4)
+    uint32_t parse;       // LZ77_PARSE_*
+    uint32_t rowCount;    // liczba kandydatów z poprzednich wierszy (0 = strumień płaski)
+    uint32_t rowOffsets[ROW_CANDIDATES_MAX];
+    uint32_t hashBits;    // log2 liczby wpisów head[] (packed_config_size)
+    uint32_t prevSlots;   // liczba wpisów prev[] — okno lub mniej dla krótkiego wejścia
+    uint32_t finder;      // LZ77_MATCH_FINDER_* (lz77_rgba_compress_ex, lz77_stream_begin_ex)
+    uint32_t bucketBits;  // log2 liczby kubełków (LZ77_MATCH_FINDER_BUCKET)
+};
+
+// Konfiguracja formatu LZ77_FORMAT_PACKED (i kodu ASM): stałe z początku pliku.
+static const PackedConfig DEFAULT_CONFIG = { WINDOW_PX, MAX_MATCH_PX, MAX_CANDIDATES, 12, 6, PACKED_MATCH_BYTES, LZ77_PARSE_GREEDY,
+    0, { 0, 0, 0, 0 }, HASH_BITS_MAX, WINDOW_PX, LZ77_MATCH_FINDER_CHAIN, 0 };
+
+static inline bool is_pow2(uint32_t v)
+{
+    return v != 0 && (v & (v - 1)) == 0;
+}
+
+static inline uint32_t log2_pow2(uint32_t v)
+{
+    uint32_t bits = 0;
+    while ((1u << bits) < v)
+        bits++;
+    return bits;
+}
+
+// Walidacja lz77_params i wyznaczenie PackedConfig; false dla parametrów spoza zakresów.
+static bool packed_config(const lz77_params* params, PackedConfig* cfg)
+{
+    if (params == nullptr ||
+        !is_pow2(params->window_px) || params->window_px < LEVEL_MIN_WINDOW_PX || params->window_px > LEVEL_MAX_WINDOW_PX ||
+        !is_pow2(params->max_match_px) || params->max_match_px < PACKED_MIN_MATCH || params->max_match_px > LEVEL_MAX_MATCH_PX ||
+        params->max_chain == 0 || params->max_chain > LEVEL_MAX_CHAIN ||
+        params->parse > LZ77_PARSE_OPTIMAL)
+        return false;
+
+    cfg->window = params->window_px;
+    cfg->maxMatch = params->max_match_px;
+    cfg->maxChain = params->max_chain;
+    cfg->offsetBits = log2_pow2(params->window_px);
+    cfg->lengthBits = log2_pow2(params->max_match_px);
+    // Token ma co najmniej 3 bajty (jak w LZ77_FORMAT_PACKED), więc dekoder obsługuje tylko dwa układy.
+    cfg->matchBytes = (cfg->offsetBits + cfg->lengthBits <= 24) ? 3 : 4;
+    cfg->parse = params->parse;
+    cfg->rowCount = 0;
+    cfg->hashBits = HASH_BITS_MAX;
+    cfg->prevSlots = params->window_px;
+    cfg->finder = LZ77_MATCH_FINDER_CHAIN;
+    cfg->bucketBits = 0;
+    return true;
+}
+
+// Tablice kodera dopasowane do wejścia src_count pikseli: head[] ma co najmniej 2 * src_count
+// wpisów (HASH_BITS_MIN..HASH_BITS_MAX bitów), a prev[] — tyle slotów, ile pozycji może
+// zająć wejście krótsze od okna (wielokrotność 4 — wyrównanie tablic parsowania optymalnego).
+// Czyszczenie head[] przy każdym wywołaniu kosztuje wtedy proporcjonalnie do wejścia,
+// a nie stałe 256 KB — istotne dla ikon i miniatur. Bez wpływu na format strumienia.
+//
+// Liczba kubełków (cfg.finder == LZ77_MATCH_FINDER_BUCKET) to ok. jeden na 4 pozycje okna,
+// lecz nie więcej, niż mieści bufor head[65536] + prev[okno] — bufor z lz77_params_work_bytes
+// wystarcza dla obu struktur.
+static void packed_config_size(PackedConfig& cfg, size_t src_count)
+{
+    uint32_t bits = HASH_BITS_MIN;
+    while (bits < HASH_BITS_MAX && ((size_t)1 << bits) < 2 * src_count)
+        bits++;
+    cfg.hashBits = bits;
+
+    size_t slots = (src_count + 3) & ~(size_t)3;
+    cfg.prevSlots = slots < cfg.window ? (uint32_t)slots : cfg.window;
+
+    size_t live = src_count < cfg.window ? src_count : cfg.window;
+    size_t chainBytes = ((size_t)HASH_SIZE + cfg.window) * sizeof(uint32_t);
+    bits = BUCKET_BITS_MIN;
+    while (((size_t)4 << bits) < live && (BUCKET_ALIGN << (bits + 1)) + BUCKET_ALIGN - 1 <= chainBytes)
+        bits++;
+    cfg.bucketBits = bits;
+}
+
+// Offsety kandydatów z poprzednich wierszy dla obrazu o szerokości width: w (nad), w + 1 (nad-lewo),
+// w - 1 (nad-prawo) i 2w (dwa wiersze wyżej). Pomijane są offsety spoza okna — przy szerokim
+// obrazie i małym oknie zostaje mniej kandydatów (lub żaden); dekoder ich nie zna, więc format
+// strumienia się nie zmienia.
+static void packed_config_rows(PackedConfig& cfg, size_t width)
+{
+    cfg.rowCount = 0;
+    if (width == 0 || width > cfg.window)
+        return;
+
+    const uint32_t w = (uint32_t)width;
+    const uint32_t offsets[ROW_CANDIDATES_MAX] = { w, w + 1, w - 1, 2 * w };
+    for (uint32_t k = 0; k < ROW_CANDIDATES_MAX; k++) {
+        uint32_t off = offsets[k];
+        bool dup = false;
+        for (uint32_t j = 0; j < cfg.rowCount; j++)
+            dup = dup || cfg.rowOffsets[j] == off;
+        if (off != 0 && off <= cfg.window && !dup)
+            cfg.rowOffsets[cfg.rowCount++] = off;
+    }
+}
+
+// Wymagany bufor roboczy: head[] + prev[] (lub kubełki z zapasem na wyrównanie do linii)
+// oraz — dla parsowania optymalnego — tablice segmentu.
+static inline size_t packed_work_bytes(const PackedConfig& cfg)
+{
+    size_t bytes = (cfg.finder == LZ77_MATCH_FINDER_BUCKET)
+        ? (BUCKET_ALIGN << cfg.bucketBits) + BUCKET_ALIGN - 1
+        : (((size_t)1 << cfg.hashBits) + cfg.prevSlots) * sizeof(uint32_t);
+    if (cfg.parse == LZ77_PARSE_OPTIMAL)
+        bytes += OPT_WORK_BYTES;
+    return bytes;
+}
 
 struct Token12 {
     uint32_t offset_px;   // odległość wstecz do początku dopasowania; 0 oznacza literal
@@ -33,276 +240,2787 @@ struct Token12 {
     uint32_t next_px;     // piksel bezpośrednio po dopasowaniu lub wartość literalu
 };
 
-// Hash z dwóch sąsiednich pikseli: XOR pierwszego z rotacją drugiego o 5 bitów w lewo.
-// Dwa piksele wejściowe zwiększają selektywność i zmniejszają liczbę fałszywych trafień.
-static inline uint32_t pixel_hash(uint32_t p0, uint32_t p1)
+// ============================================================
+// Jądra SIMD: długość wspólnego prefiksu (rozszerzanie dopasowania) i kopiowanie
+// dopasowania w dekompresji. Wariant wybierany raz, przy ładowaniu biblioteki (CPUID),
+// i wywoływany przez wskaźnik; wynik nie zależy od wariantu.
+// ============================================================
+
+// Długość wspólnego prefiksu a[] i b[], najwyżej maxLen pikseli.
+typedef uint32_t(*MatchLenFn)(const uint32_t* a, const uint32_t* b, uint32_t maxLen);
+// Kopiowanie length pikseli dopasowania z d - offset do d; room = wolne piksele od d.
+// Bloki wektorowe mogą zapisać do końca bloku za length (nadpisze to kolejny token),
+// dlatego wymagają zaokrąglonej długości <= room. Offset >= szerokość bloku: kopiowanie
+// blokami; offset dzielący szerokość bloku (serie 1, 2, 4... pikseli): zapis powielonego
+// wzorca; pozostałe małe offsety — węższy wariant lub piksel po pikselu.
+typedef void(*CopyMatchFn)(uint32_t* d, uint32_t offset, uint32_t length, size_t room);
+
+static uint32_t match_len_scalar(const uint32_t* a, const uint32_t* b, uint32_t maxLen)
+{
+    uint32_t len = 0;
+    while (len < maxLen && a[len] == b[len])
+        len++;
+    return len;
+}
+
+// Kopiowanie piksel po pikselu — poprawne także dla offset < length (powielanie wzorca).
+static inline void copy_match_px(uint32_t* d, uint32_t offset, uint32_t length)
+{
+    const uint32_t* s = d - offset;
+    for (uint32_t k = 0; k < length; k++)
+        d[k] = s[k];
+}
+
+static void copy_match_scalar(uint32_t* d, uint32_t offset, uint32_t length, size_t room)
+{
+    uint32_t rounded = (length + 3) & ~3u;
+    if (offset >= 4 && rounded <= room) {
+        const uint32_t* s = d - offset;
+        for (uint32_t b = 0; b < rounded; b += 4)
+            memcpy(d + b, s + b, 16);
+    }
+    else {
+        copy_match_px(d, offset, length);
+    }
+}
+
+#ifdef LZ77_X64_SIMD
+static inline uint32_t ctz32(uint32_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, v);
+    return (uint32_t)idx;
+#else
+    return (uint32_t)__builtin_ctz(v);
+#endif
+}
+
+// SSE2 (odpowiednik pcmpeqd/pmovmskb z AsmDll.dll): 4 piksele na porównanie. Przy różnicy
+// pierwszy różny piksel wskazuje najmłodszy ustawiony bit odwróconej maski (4 bity na piksel).
+static uint32_t match_len_sse2(const uint32_t* a, const uint32_t* b, uint32_t maxLen)
+{
+    uint32_t len = 0;
+    while (len + 4 <= maxLen) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + len));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + len));
+        uint32_t diff = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi32(va, vb)) ^ 0xFFFFu;
+        if (diff != 0)
+            return len + ctz32(diff) / 4;
+        len += 4;
+    }
+    while (len < maxLen && a[len] == b[len])
+        len++;
+    return len;
+}
+
+static void copy_match_sse2(uint32_t* d, uint32_t offset, uint32_t length, size_t room)
+{
+    uint32_t rounded = (length + 3) & ~3u;
+    const uint32_t* s = d - offset;
+    if (rounded > room || offset == 3) {
+        copy_match_px(d, offset, length);
+    }
+    else if (offset >= 4) {
+        for (uint32_t b = 0; b < rounded; b += 4)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + b), _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + b)));
+    }
+    else {
+        __m128i pat = (offset == 1)
+            ? _mm_set1_epi32((int)s[0])
+            : _mm_shuffle_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s)), _MM_SHUFFLE(1, 0, 1, 0));
+        for (uint32_t b = 0; b < rounded; b += 4)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + b), pat);
+    }
+}
+
+// AVX2: 8 pikseli na vpcmpeqd/vpmovmskb, tzcnt na masce różnic; ogon < 8 pikseli jednym blokiem SSE2.
+LZ77_TARGET_AVX2
+static uint32_t match_len_avx2(const uint32_t* a, const uint32_t* b, uint32_t maxLen)
+{
+    uint32_t len = 0;
+    while (len + 8 <= maxLen) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + len));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + len));
+        uint32_t diff = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi32(va, vb));
+        if (diff != 0)
+            return len + _tzcnt_u32(diff) / 4;
+        len += 8;
+    }
+    if (len + 4 <= maxLen) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + len));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + len));
+        uint32_t diff = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi32(va, vb)) ^ 0xFFFFu;
+        if (diff != 0)
+            return len + _tzcnt_u32(diff) / 4;
+        len += 4;
+    }
+    while (len < maxLen && a[len] == b[len])
+        len++;
+    return len;
+}
+
+LZ77_TARGET_AVX2
+static void copy_match_avx2(uint32_t* d, uint32_t offset, uint32_t length, size_t room)
+{
+    uint32_t rounded = (length + 7) & ~7u;
+    const uint32_t* s = d - offset;
+    if (rounded > room || (offset < 8 && offset != 1 && offset != 2 && offset != 4)) {
+        copy_match_sse2(d, offset, length, room);
+    }
+    else if (offset >= 8) {
+        for (uint32_t b = 0; b < rounded; b += 8)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + b), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + b)));
+    }
+    else {
+        __m256i pat;
+        if (offset == 1)
+            pat = _mm256_set1_epi32((int)s[0]);
+        else if (offset == 2)
+            pat = _mm256_set1_epi64x((long long)((uint64_t)s[0] | ((uint64_t)s[1] << 32)));
+        else
+            pat = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+        for (uint32_t b = 0; b < rounded; b += 8)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + b), pat);
+    }
+}
+
+// AVX-512: 16 pikseli na vpcmpeqd do rejestru maski; ogon maskowanym odczytem (bez czytania za maxLen).
+LZ77_TARGET_AVX512
+static uint32_t match_len_avx512(const uint32_t* a, const uint32_t* b, uint32_t maxLen)
+{
+    uint32_t len = 0;
+    while (len + 16 <= maxLen) {
+        __m512i va = _mm512_loadu_si512(a + len);
+        __m512i vb = _mm512_loadu_si512(b + len);
+        uint32_t diff = (uint32_t)_mm512_cmpneq_epi32_mask(va, vb);
+        if (diff != 0)
+            return len + _tzcnt_u32(diff);
+        len += 16;
+    }
+    uint32_t rest = maxLen - len;
+    if (rest != 0) {
+        __mmask16 m = (__mmask16)((1u << rest) - 1);
+        __m512i va = _mm512_maskz_loadu_epi32(m, a + len);
+        __m512i vb = _mm512_maskz_loadu_epi32(m, b + len);
+        uint32_t diff = (uint32_t)_mm512_mask_cmpneq_epi32_mask(m, va, vb);
+        len += (diff != 0) ? _tzcnt_u32(diff) : rest;
+    }
+    return len;
+}
+
+LZ77_TARGET_AVX512
+static void copy_match_avx512(uint32_t* d, uint32_t offset, uint32_t length, size_t room)
+{
+    uint32_t rounded = (length + 15) & ~15u;
+    const uint32_t* s = d - offset;
+    if (rounded > room || (offset < 16 && offset != 1 && offset != 2 && offset != 4 && offset != 8)) {
+        copy_match_avx2(d, offset, length, room);
+    }
+    else if (offset >= 16) {
+        for (uint32_t b = 0; b < rounded; b += 16)
+            _mm512_storeu_si512(d + b, _mm512_loadu_si512(s + b));
+    }
+    else {
+        // Offset jest potęgą 2 < 16: piksel k bloku = s[k & (offset - 1)].
+        __mmask16 srcMask = (__mmask16)((1u << offset) - 1);
+        __m512i idx = _mm512_and_si512(
+            _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0),
+            _mm512_set1_epi32((int)(offset - 1)));
+        __m512i pat = _mm512_maskz_permutexvar_epi32(0xFFFF, idx, _mm512_maskz_loadu_epi32(srcMask, s));
+        for (uint32_t b = 0; b < rounded; b += 16)
+            _mm512_storeu_si512(d + b, pat);
+    }
+}
+#endif
+
+// ============================================================
+// Filtry wierszy (lz77_filter_rows / lz77_unfilter_rows): predyktory PNG działające na
+// każdym bajcie piksela osobno (modulo 256) i bezstratna transformacja YCoCg-R reszt.
+// Reszta = piksel - predykcja, następnie (opcjonalnie) YCoCg-R na bajtach B, G, R — kanał
+// alfa bez zmian. Transformacja to kroki liftingu z połową ze znakiem (int8 >> 1), więc jest
+// odwracalna dla dowolnych bajtów, a małe reszty (także ujemne) dają małe Co, Y i Cg.
+// Pierwszy wiersz wywołania nie ma wiersza powyżej (jak w PNG: wiersz zer), więc bloki
+// obrazu filtrowane osobno są niezależne.
+// ============================================================
+
+// Dodawanie / odejmowanie / średnia (zaokrąglona w dół) czterech bajtów naraz (SWAR).
+static inline uint32_t bytes_add(uint32_t x, uint32_t y)
+{
+    return ((x & 0x7F7F7F7Fu) + (y & 0x7F7F7F7Fu)) ^ ((x ^ y) & 0x80808080u);
+}
+
+static inline uint32_t bytes_sub(uint32_t x, uint32_t y)
+{
+    return ((x | 0x80808080u) - (y & 0x7F7F7F7Fu)) ^ ((x ^ ~y) & 0x80808080u);
+}
+
+static inline uint32_t bytes_avg(uint32_t x, uint32_t y)
+{
+    return (x & y) + (((x ^ y) & 0xFEFEFEFEu) >> 1);
+}
+
+// Predyktor Paetha (PNG) dla każdego bajtu: a — lewy, b — górny, c — górny-lewy.
+static inline uint32_t bytes_paeth(uint32_t a, uint32_t b, uint32_t c)
+{
+    uint32_t out = 0;
+    for (uint32_t s = 0; s < 32; s += 8) {
+        int ia = (int)((a >> s) & 0xFF), ib = (int)((b >> s) & 0xFF), ic = (int)((c >> s) & 0xFF);
+        int pa = abs(ib - ic), pb = abs(ia - ic), pc = abs(ia + ib - 2 * ic);
+        int p = (pa <= pb && pa <= pc) ? ia : (pb <= pc) ? ib : ic;
+        out |= (uint32_t)p << s;
+    }
+    return out;
+}
+
+static inline uint32_t filter_predict(uint32_t filter, uint32_t a, uint32_t b, uint32_t c)
+{
+    switch (filter) {
+    case LZ77_FILTER_SUB:     return a;
+    case LZ77_FILTER_UP:      return b;
+    case LZ77_FILTER_AVERAGE: return bytes_avg(a, b);
+    case LZ77_FILTER_PAETH:   return bytes_paeth(a, b, c);
+    default:                  return 0;
+    }
+}
+
+// Połowa bajtu traktowanego jako int8 (przesunięcie arytmetyczne), jako uint32 modulo 256.
+static inline uint32_t half_signed(uint32_t v)
+{
+    return (uint32_t)((int32_t)(int8_t)(uint8_t)v >> 1);
+}
+
+// YCoCg-R: bajt 0 = Co, bajt 1 = Y, bajt 2 = Cg, bajt 3 (alfa) bez zmian.
+static inline uint32_t ycocg_forward(uint32_t v)
+{
+    uint32_t b = v & 0xFF, g = (v >> 8) & 0xFF, r = (v >> 16) & 0xFF;
+    uint32_t co = (r - b) & 0xFF;
+    uint32_t t = (b + half_signed(co)) & 0xFF;
+    uint32_t cg = (g - t) & 0xFF;
+    uint32_t y = (t + half_signed(cg)) & 0xFF;
+    return (v & 0xFF000000u) | (cg << 16) | (y << 8) | co;
+}
+
+static inline uint32_t ycocg_inverse(uint32_t v)
+{
+    uint32_t co = v & 0xFF, y = (v >> 8) & 0xFF, cg = (v >> 16) & 0xFF;
+    uint32_t t = (y - half_signed(cg)) & 0xFF;
+    uint32_t g = (cg + t) & 0xFF;
+    uint32_t b = (t - half_signed(co)) & 0xFF;
+    uint32_t r = (b + co) & 0xFF;
+    return (v & 0xFF000000u) | (r << 16) | (g << 8) | b;
+}
+
+// Koszt reszty w heurystyce wyboru filtra: suma |int8| bajtów (jak w PNG).
+static inline uint32_t residual_cost(uint32_t v)
+{
+    uint32_t cost = 0;
+    for (uint32_t s = 0; s < 32; s += 8) {
+        int r = (int8_t)(uint8_t)(v >> s);
+        cost += (uint32_t)(r < 0 ? -r : r);
+    }
+    return cost;
+}
+
+// Filtr wiersza cur (poprzedni wiersz prior; nullptr — wiersz zer) do out (out != cur);
+// zwraca koszt reszt. Wersja wektorowa liczy identyczny wynik.
+typedef uint64_t(*FilterRowFn)(const uint32_t* cur, const uint32_t* prior, uint32_t* out,
+    size_t width, uint32_t filter, uint32_t transform);
+// Odtworzenie wiersza z reszt in (in == out dozwolone); prior — odtworzony wiersz powyżej.
+typedef void(*UnfilterRowFn)(const uint32_t* in, const uint32_t* prior, uint32_t* out,
+    size_t width, uint32_t filter, uint32_t transform);
+
+static uint64_t filter_span_scalar(const uint32_t* cur, const uint32_t* prior, uint32_t* out,
+    size_t from, size_t width, uint32_t filter, uint32_t transform)
+{
+    uint64_t cost = 0;
+    for (size_t x = from; x < width; x++) {
+        uint32_t a = x ? cur[x - 1] : 0;
+        uint32_t b = prior ? prior[x] : 0;
+        uint32_t c = (prior && x) ? prior[x - 1] : 0;
+        uint32_t r = bytes_sub(cur[x], filter_predict(filter, a, b, c));
+        if (transform == LZ77_TRANSFORM_YCOCG_R)
+            r = ycocg_forward(r);
+        out[x] = r;
+        cost += residual_cost(r);
+    }
+    return cost;
+}
+
+static uint64_t filter_row_scalar(const uint32_t* cur, const uint32_t* prior, uint32_t* out,
+    size_t width, uint32_t filter, uint32_t transform)
+{
+    return filter_span_scalar(cur, prior, out, 0, width, filter, transform);
+}
+
+// Odtwarzanie piksel po pikselu (lewy sąsiad to już odtworzony piksel) — szablon bez
+// rozgałęzień na filtr w pętli.
+template <uint32_t Filter, bool Transform>
+static void unfilter_span(const uint32_t* in, const uint32_t* prior, uint32_t* out, size_t from, size_t width)
+{
+    for (size_t x = from; x < width; x++) {
+        uint32_t r = Transform ? ycocg_inverse(in[x]) : in[x];
+        uint32_t a = x ? out[x - 1] : 0;
+        uint32_t b = prior ? prior[x] : 0;
+        uint32_t c = (prior && x) ? prior[x - 1] : 0;
+        out[x] = bytes_add(r, filter_predict(Filter, a, b, c));
+    }
+}
+
+typedef void(*UnfilterSpanFn)(const uint32_t* in, const uint32_t* prior, uint32_t* out, size_t from, size_t width);
+
+static const UnfilterSpanFn UNFILTER_SPANS[LZ77_FILTER_COUNT][2] = {
+    { unfilter_span<LZ77_FILTER_NONE, false>,    unfilter_span<LZ77_FILTER_NONE, true> },
+    { unfilter_span<LZ77_FILTER_SUB, false>,     unfilter_span<LZ77_FILTER_SUB, true> },
+    { unfilter_span<LZ77_FILTER_UP, false>,      unfilter_span<LZ77_FILTER_UP, true> },
+    { unfilter_span<LZ77_FILTER_AVERAGE, false>, unfilter_span<LZ77_FILTER_AVERAGE, true> },
+    { unfilter_span<LZ77_FILTER_PAETH, false>,   unfilter_span<LZ77_FILTER_PAETH, true> },
+};
+
+static void unfilter_row_scalar(const uint32_t* in, const uint32_t* prior, uint32_t* out,
+    size_t width, uint32_t filter, uint32_t transform)
+{
+    UNFILTER_SPANS[filter][transform == LZ77_TRANSFORM_YCOCG_R](in, prior, out, 0, width);
+}
+
+#ifdef LZ77_X64_SIMD
+static inline __m128i half_signed_sse2(__m128i v)
+{
+    return _mm_srai_epi32(_mm_slli_epi32(v, 24), 25);
+}
+
+static inline __m128i ycocg_forward_sse2(__m128i v)
+{
+    const __m128i m = _mm_set1_epi32(0xFF);
+    __m128i b = _mm_and_si128(v, m);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8), m);
+    __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), m);
+    __m128i co = _mm_and_si128(_mm_sub_epi32(r, b), m);
+    __m128i t = _mm_and_si128(_mm_add_epi32(b, half_signed_sse2(co)), m);
+    __m128i cg = _mm_and_si128(_mm_sub_epi32(g, t), m);
+    __m128i y = _mm_and_si128(_mm_add_epi32(t, half_signed_sse2(cg)), m);
+    __m128i alpha = _mm_andnot_si128(_mm_set1_epi32(0x00FFFFFF), v);
+    return _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(cg, 16)), _mm_or_si128(_mm_slli_epi32(y, 8), co));
+}
+
+static inline __m128i ycocg_inverse_sse2(__m128i v)
+{
+    const __m128i m = _mm_set1_epi32(0xFF);
+    __m128i co = _mm_and_si128(v, m);
+    __m128i y = _mm_and_si128(_mm_srli_epi32(v, 8), m);
+    __m128i cg = _mm_and_si128(_mm_srli_epi32(v, 16), m);
+    __m128i t = _mm_and_si128(_mm_sub_epi32(y, half_signed_sse2(cg)), m);
+    __m128i g = _mm_and_si128(_mm_add_epi32(cg, t), m);
+    __m128i b = _mm_and_si128(_mm_sub_epi32(t, half_signed_sse2(co)), m);
+    __m128i r = _mm_and_si128(_mm_add_epi32(b, co), m);
+    __m128i alpha = _mm_andnot_si128(_mm_set1_epi32(0x00FFFFFF), v);
+    return _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+}
+
+// Paeth na 8 bajtach rozszerzonych do 16 bitów: pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|.
+static inline __m128i paeth_epi16_sse2(__m128i a, __m128i b, __m128i c)
+{
+    const __m128i ones = _mm_set1_epi16(-1);
+    __m128i bc = _mm_sub_epi16(b, c);
+    __m128i ac = _mm_sub_epi16(a, c);
+    __m128i abc = _mm_add_epi16(bc, ac);
+    __m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(_mm_setzero_si128(), bc));
+    __m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(_mm_setzero_si128(), ac));
+    __m128i pc = _mm_max_epi16(abc, _mm_sub_epi16(_mm_setzero_si128(), abc));
+    __m128i useA = _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc)), ones);
+    __m128i useB = _mm_andnot_si128(_mm_or_si128(useA, _mm_cmpgt_epi16(pb, pc)), ones);
+    __m128i useC = _mm_andnot_si128(_mm_or_si128(useA, useB), ones);
+    return _mm_or_si128(_mm_or_si128(_mm_and_si128(useA, a), _mm_and_si128(useB, b)), _mm_and_si128(useC, c));
+}
+
+static inline __m128i paeth_sse2(__m128i a, __m128i b, __m128i c)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = paeth_epi16_sse2(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+    __m128i hi = paeth_epi16_sse2(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+    return _mm_packus_epi16(lo, hi);
+}
+
+// Filtr wiersza po 4 piksele: wszystkie predyktory zależą tylko od pikseli wejścia,
+// więc każda grupa liczona jest niezależnie. Koszt: |int8| jako min(r, -r) i psadbw.
+static uint64_t filter_row_sse2(const uint32_t* cur, const uint32_t* prior, uint32_t* out,
+    size_t width, uint32_t filter, uint32_t transform)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    uint64_t cost = filter_span_scalar(cur, prior, out, 0, width < 1 ? width : 1, filter, transform);
+    __m128i acc = zero;
+
+    size_t x = 1;
+    for (; x + 4 <= width; x += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + x));
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + x - 1));
+        __m128i b = prior ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + x)) : zero;
+        __m128i c = prior ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + x - 1)) : zero;
+
+        __m128i pred;
+        switch (filter) {
+        case LZ77_FILTER_SUB:     pred = a; break;
+        case LZ77_FILTER_UP:      pred = b; break;
+        case LZ77_FILTER_AVERAGE: pred = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one)); break;
+        case LZ77_FILTER_PAETH:   pred = paeth_sse2(a, b, c); break;
+        default:                  pred = zero; break;
+        }
+
+        __m128i r = _mm_sub_epi8(v, pred);
+        if (transform == LZ77_TRANSFORM_YCOCG_R)
+            r = ycocg_forward_sse2(r);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), r);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_min_epu8(r, _mm_sub_epi8(zero, r)), zero));
+    }
+    cost += (uint64_t)_mm_cvtsi128_si64(acc) + (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc));
+    return cost + filter_span_scalar(cur, prior, out, x < width ? x : width, width, filter, transform);
+}
+
+// Odtwarzanie wiersza: NONE i UP po 4 piksele, SUB jako suma prefiksowa w rejestrze
+// (przeniesienie — ostatni odtworzony piksel); AVERAGE i PAETH zależą od lewego sąsiada
+// nieliniowo — piksel po pikselu.
+static void unfilter_row_sse2(const uint32_t* in, const uint32_t* prior, uint32_t* out,
+    size_t width, uint32_t filter, uint32_t transform)
+{
+    if (filter == LZ77_FILTER_AVERAGE || filter == LZ77_FILTER_PAETH) {
+        unfilter_row_scalar(in, prior, out, width, filter, transform);
+        return;
+    }
+
+    const bool ycocg = transform == LZ77_TRANSFORM_YCOCG_R;
+    __m128i carry = _mm_setzero_si128();
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+        if (ycocg)
+            r = ycocg_inverse_sse2(r);
+        if (filter == LZ77_FILTER_UP && prior)
+            r = _mm_add_epi8(r, _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + x)));
+        else if (filter == LZ77_FILTER_SUB) {
+            r = _mm_add_epi8(r, _mm_slli_si128(r, 4));
+            r = _mm_add_epi8(r, _mm_slli_si128(r, 8));
+            r = _mm_add_epi8(r, carry);
+            carry = _mm_shuffle_epi32(r, 0xFF);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), r);
+    }
+    UNFILTER_SPANS[filter][ycocg](in, prior, out, x, width);
+}
+#endif
+
+struct SimdKernels {
+    MatchLenFn    matchLen;
+    CopyMatchFn   copyMatch;
+    FilterRowFn   filterRow;
+    UnfilterRowFn unfilterRow;
+};
+
+// Indeks = LZ77_SIMD_*; poza x64 wszystkie poziomy wskazują wersję przenośną.
+// Filtry wierszy mają tylko wersję SSE2 — poziomy AVX2 / AVX-512 używają jej także.
+static const SimdKernels SIMD_KERNELS[] = {
+    { match_len_scalar, copy_match_scalar, filter_row_scalar, unfilter_row_scalar },
+#ifdef LZ77_X64_SIMD
+    { match_len_sse2,   copy_match_sse2,   filter_row_sse2,   unfilter_row_sse2 },
+    { match_len_avx2,   copy_match_avx2,   filter_row_sse2,   unfilter_row_sse2 },
+    { match_len_avx512, copy_match_avx512, filter_row_sse2,   unfilter_row_sse2 },
+#endif
+};
+static const int SIMD_KERNEL_COUNT = (int)(sizeof(SIMD_KERNELS) / sizeof(SIMD_KERNELS[0]));
+
+// Najwyższy poziom obsługiwany przez procesor i system: AVX wymaga OSXSAVE i zapisu stanu
+// YMM przez system (XCR0 bity 1-2), AVX-512 dodatkowo stanu opmask/ZMM (bity 5-7).
+static int detect_simd_level()
+{
+#ifdef LZ77_X64_SIMD
+    unsigned int r1[4] = { 0, 0, 0, 0 }, r7[4] = { 0, 0, 0, 0 };
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    unsigned int maxLeaf = (unsigned int)regs[0];
+    __cpuidex(regs, 1, 0);
+    memcpy(r1, regs, sizeof(r1));
+    if (maxLeaf >= 7) {
+        __cpuidex(regs, 7, 0);
+        memcpy(r7, regs, sizeof(r7));
+    }
+#else
+    unsigned int maxLeaf = __get_cpuid_max(0, nullptr);
+    __cpuid_count(1, 0, r1[0], r1[1], r1[2], r1[3]);
+    if (maxLeaf >= 7)
+        __cpuid_count(7, 0, r7[0], r7[1], r7[2], r7[3]);
+#endif
+    bool osxsave = (r1[2] & (1u << 27)) != 0;
+    bool avx = (r1[2] & (1u << 28)) != 0;
+    if (!osxsave || !avx)
+        return LZ77_SIMD_SSE2;
+
+#if defined(_MSC_VER)
+    uint64_t xcr0 = _xgetbv(0);
+#else
+    uint32_t xlo, xhi;
+    __asm__ volatile("xgetbv" : "=a"(xlo), "=d"(xhi) : "c"(0));
+    uint64_t xcr0 = ((uint64_t)xhi << 32) | xlo;
+#endif
+    bool avx2 = (r7[1] & (1u << 5)) != 0;
+    bool bmi1 = (r7[1] & (1u << 3)) != 0;
+    bool avx512f = (r7[1] & (1u << 16)) != 0;
+    if ((xcr0 & 0x06) != 0x06 || !avx2 || !bmi1)
+        return LZ77_SIMD_SSE2;
+    if (avx512f && (xcr0 & 0xE0) == 0xE0)
+        return LZ77_SIMD_AVX512;
+    return LZ77_SIMD_AVX2;
+#else
+    return LZ77_SIMD_SCALAR;
+#endif
+}
+
+static const int CPU_SIMD_LEVEL = detect_simd_level();
+static std::atomic<const SimdKernels*> g_kernels{ &SIMD_KERNELS[CPU_SIMD_LEVEL] };
+
+// Poziom wymuszony dla bieżącego wątku (lz77_set_thread_simd_level); nullptr — poziom procesu.
+static thread_local const SimdKernels* t_kernels = nullptr;
+
+static inline const SimdKernels& active_kernels()
+{
+    const SimdKernels* kernels = t_kernels;
+    return kernels ? *kernels : *g_kernels.load(std::memory_order_relaxed);
+}
+
+// Poziom obsługiwany przez CPU i zbudowane jądra; ujemny — wybór automatyczny.
+static int clamp_simd_level(int level)
+{
+    if (level < 0 || level > CPU_SIMD_LEVEL)
+        level = CPU_SIMD_LEVEL;
+    if (level >= SIMD_KERNEL_COUNT)
+        level = SIMD_KERNEL_COUNT - 1;
+    return level;
+}
+
+int lz77_cpu_simd_level(void)
+{
+    return CPU_SIMD_LEVEL;
+}
+
+int lz77_simd_level(void)
+{
+    return (int)(&active_kernels() - SIMD_KERNELS);
+}
+
+int lz77_set_simd_level(int level)
+{
+    level = clamp_simd_level(level);
+    g_kernels.store(&SIMD_KERNELS[level], std::memory_order_relaxed);
+    return level;
+}
+
+int lz77_set_thread_simd_level(int level)
+{
+    t_kernels = level < 0 ? nullptr : &SIMD_KERNELS[clamp_simd_level(level)];
+    return lz77_simd_level();
+}
+
+// Hash z dwóch sąsiednich pikseli: XOR pierwszego z rotacją drugiego o 5 bitów w lewo.
+// Dwa piksele wejściowe zwiększają selektywność i zmniejszają liczbę fałszywych trafień.
+// Mniejsza tablica (bits < HASH_BITS_MAX) dostaje też górną połowę — same dolne bity
+// to głównie kanał R pierwszego piksela. Pełna tablica — jak w kodzie ASM.
+static inline uint32_t pixel_hash(uint32_t p0, uint32_t p1, uint32_t bits)
+{
+    uint32_t rot = (p1 << 5) | (p1 >> 27);
+    uint32_t h = p0 ^ rot;
+    if (bits < HASH_BITS_MAX)
+        h ^= h >> 16;
+    return h & ((1u << bits) - 1);
+}
+
+// Piksele nad bieżącym (i jego sąsiedzi) — w obrazach z pionowymi strukturami często
+// dłuższe dopasowanie niż najnowsze wystąpienie pary pikseli w tablicach hash. Poprawia
+// *bestLen / *bestOff; zwraca liczbę sprawdzonych kandydatów.
+static inline uint32_t match_row_candidates(
+    const uint32_t* src_px,
+    size_t          i,
+    uint32_t        maxMatch,
+    const PackedConfig& cfg,
+    MatchLenFn      matchLen,
+    uint32_t*       bestLen,
+    uint32_t*       bestOff)
+{
+    uint32_t rowWalks = 0;
+    for (uint32_t k = 0; k < cfg.rowCount && *bestLen < maxMatch; k++) {
+        uint32_t offset = cfg.rowOffsets[k];
+        if (offset > i)
+            continue;
+
+        const uint32_t* ptrA = src_px + i;
+        const uint32_t* ptrB = ptrA - offset;
+        uint32_t curLen = (ptrA[*bestLen] == ptrB[*bestLen]) ? matchLen(ptrA, ptrB, maxMatch) : 0;
+        if (curLen > *bestLen) {
+            *bestLen = curLen;
+            *bestOff = offset;
+        }
+        rowWalks++;
+    }
+    return rowWalks;
+}
+
+// Przeszukiwanie łańcucha hash dla pozycji i: zwraca długość najdłuższego dopasowania (0 = brak)
+// i zapisuje jego offset w *outOff, a liczbę odwiedzonych kandydatów w *outWalks.
+// Wspólne dla formatu Token12 i formatu kompaktowego. Kandydaci z poprzednich wierszy
+// (cfg.rowCount > 0) sprawdzani są przed łańcuchem i wliczani do *outWalks.
+static inline uint32_t find_longest_match(
+    const uint32_t* src_px,
+    size_t          i,
+    uint32_t        maxMatch,
+    const PackedConfig& cfg,
+    const uint32_t* head,
+    const uint32_t* prev,
+    uint32_t*       outOff,
+    uint32_t*       outWalks)
+{
+    uint32_t h = pixel_hash(src_px[i], src_px[i + 1], cfg.hashBits);
+
+    // Pozycje starsze niż cfg.window od bieżącej są poza oknem i nie mogą być kandydatami.
+    uint32_t dictStart = (i >= cfg.window) ? (uint32_t)(i - cfg.window) : 0u;
+
+    uint32_t candidate = head[h];
+
+    uint32_t bestLen = 0;
+    uint32_t bestOff = 0;
+
+    uint32_t chainLeft = cfg.maxChain;
+    const MatchLenFn matchLen = active_kernels().matchLen;
+    uint32_t rowWalks = match_row_candidates(src_px, i, maxMatch, cfg, matchLen, &bestLen, &bestOff);
+
+    // Przeszukiwanie łańcucha hash: iteracja po kandydatach od najnowszego do najstarszego.
+    // Pętla kończy się po napotkaniu INVALID_POS, kandydata spoza okna lub wyczerpaniu limitu.
+    while (candidate != INVALID_POS && candidate >= dictStart && chainLeft > 0 && bestLen < maxMatch) {
+
+        uint32_t offset = (uint32_t)i - candidate;
+
+        const uint32_t* ptrA = src_px + i;
+        const uint32_t* ptrB = src_px + candidate;
+
+        // Kandydat może poprawić wynik tylko wtedy, gdy zgadza się także piksel ptrA[bestLen]
+        // (bestLen < maxMatch) — szybkie odrzucenie bez wywołania jądra porównania.
+        uint32_t curLen = (ptrA[bestLen] == ptrB[bestLen]) ? matchLen(ptrA, ptrB, maxMatch) : 0;
+
+        if (curLen > bestLen) {
+            bestLen = curLen;
+            bestOff = offset;
+        }
+
+        chainLeft--;
+
+        // Dopasowanie maksymalnej długości nie może zostać poprawione — starsi kandydaci
+        // daliby co najwyżej remis, a remis zachowuje najbliższy offset.
+        if (bestLen == maxMatch)
+            break;
+
+        // Przejście do następnego kandydata przez tablicę prev[]; slot wyznaczany modulo cfg.window.
+        uint32_t slot = candidate & (cfg.window - 1);
+        candidate = prev[slot];
+    }
+
+    *outOff = bestOff;
+    *outWalks = cfg.maxChain - chainLeft + rowWalks;
+    return bestLen;
+}
+
+// Wstawia pozycje [from .. from+count) do tablic hash, by kolejne tokeny mogły się do nich odwoływać.
+static inline void insert_positions(
+    const uint32_t* src_px,
+    size_t          src_count,
+    uint32_t        window,
+    uint32_t        hashBits,
+    uint32_t*       head,
+    uint32_t*       prev,
+    size_t          from,
+    uint32_t        count)
+{
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t pos = (uint32_t)(from + k);
+
+        // Para (src[pos], src[pos+1]) jest wymagana do obliczenia hashu; brak sąsiada kończy wstawianie.
+        if ((size_t)pos + 1 >= src_count)
+            break;
+
+        uint32_t nh = pixel_hash(src_px[pos], src_px[pos + 1], hashBits);
+        uint32_t slot = pos & (window - 1);
+
+        prev[slot] = head[nh];
+        head[nh] = pos;
+    }
+}
+
+// ==== Wyszukiwanie w kubełkach (LZ77_MATCH_FINDER_BUCKET) ====
+//
+// Kubełek to jedna linia pamięci podręcznej: BUCKET_WAYS pozycji i ich odcisków, od najnowszej.
+// Łańcuch prev[] przy każdym kandydacie skacze w losowe miejsce okna i czyta piksele źródła;
+// tu cały zbiór kandydatów jest w jednej linii, a piksele czytane są tylko dla kandydatów,
+// których odcisk zgadza się z bieżącą pozycją. Głębokość jest ograniczona do BUCKET_WAYS.
+struct alignas(64) MatchBucket {
+    uint32_t pos[BUCKET_WAYS];
+    uint32_t tag[BUCKET_WAYS];   // górna połowa: para pikseli [pos, pos+1]; dolna: para [pos+2, pos+3]
+};
+
+static_assert(sizeof(MatchBucket) == BUCKET_ALIGN, "kubełek musi zajmować jedną linię pamięci podręcznej");
+
+// Indeks kubełka dla pozycji pos (wymaga pos + 1 < src_count) i odcisk BUCKET_TAG_PX pikseli
+// w *outTag. Na końcu wejścia brakująca druga para liczy się jako zero.
+static inline uint32_t bucket_key(const uint32_t* src_px, size_t src_count, size_t pos, uint32_t bits, uint32_t* outTag)
+{
+    uint32_t p1 = src_px[pos + 1];
+    uint32_t k = src_px[pos] ^ ((p1 << 5) | (p1 >> 27));
+    uint32_t n = 0;
+    if (pos + 3 < src_count) {
+        uint32_t p3 = src_px[pos + 3];
+        n = src_px[pos + 2] ^ ((p3 << 5) | (p3 >> 27));
+    }
+    // Górne bity iloczynu wybierają kubełek, kolejne 16 — górną połowę odcisku.
+    uint32_t h = k * 0x9E3779B1u;
+    *outTag = ((h << bits) & 0xFFFF0000u) | ((n * 0xC2B2AE3Du) >> 16);
+    return h >> (32 - bits);
+}
+
+// Odpowiednik insert_positions: nowa pozycja trafia na początek kubełka, najstarsza wypada.
+// Kolejna pozycja serii takich samych pikseli (ten sam odcisk co pos - 1 na początku kubełka)
+// zastępuje poprzednią — seria zajmuje jeden slot i nie wypycha starszych kandydatów.
+static inline void bucket_insert_positions(
+    const uint32_t* src_px,
+    size_t          src_count,
+    uint32_t        bucketBits,
+    MatchBucket*    buckets,
+    size_t          from,
+    uint32_t        count)
+{
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t pos = (uint32_t)(from + k);
+        if ((size_t)pos + 1 >= src_count)
+            break;
+
+        uint32_t tag;
+        MatchBucket& b = buckets[bucket_key(src_px, src_count, pos, bucketBits, &tag)];
+        if (b.tag[0] == tag && b.pos[0] + 1 == pos) {
+            b.pos[0] = pos;
+            continue;
+        }
+#ifdef LZ77_X64_SIMD
+        // SSE2: przesunięcie o jeden slot w rejestrach i wyrównane zapisy całych połówek.
+        __m128i* vp = reinterpret_cast<__m128i*>(b.pos);
+        __m128i* vt = reinterpret_cast<__m128i*>(b.tag);
+        __m128i p0 = _mm_load_si128(vp), p1 = _mm_load_si128(vp + 1);
+        __m128i t0 = _mm_load_si128(vt), t1 = _mm_load_si128(vt + 1);
+        _mm_store_si128(vp + 1, _mm_or_si128(_mm_slli_si128(p1, 4), _mm_srli_si128(p0, 12)));
+        _mm_store_si128(vt + 1, _mm_or_si128(_mm_slli_si128(t1, 4), _mm_srli_si128(t0, 12)));
+        _mm_store_si128(vp, _mm_or_si128(_mm_slli_si128(p0, 4), _mm_cvtsi32_si128((int)pos)));
+        _mm_store_si128(vt, _mm_or_si128(_mm_slli_si128(t0, 4), _mm_cvtsi32_si128((int)tag)));
+#else
+        memmove(b.pos + 1, b.pos, (BUCKET_WAYS - 1) * sizeof(uint32_t));
+        memmove(b.tag + 1, b.tag, (BUCKET_WAYS - 1) * sizeof(uint32_t));
+        b.pos[0] = pos;
+        b.tag[0] = tag;
+#endif
+    }
+}
+
+// Maski slotów kubełka (bit w = slot w, od najnowszego): zwracana — pozycje w oknie z całym
+// odciskiem równym tag, *outPair — z równą tylko górną połową. Wiek i - pos mieści się
+// w [1, lim] wyłącznie dla pozycji w oknie; pusty slot (INVALID_POS) ma wiek i + 1 > lim.
+static inline uint32_t bucket_match_masks(const MatchBucket& b, uint32_t i, uint32_t lim, uint32_t tag, uint32_t* outPair)
+{
+    uint32_t full = 0;
+    uint32_t pair = 0;
+#ifdef LZ77_X64_SIMD
+    // SSE2: porównanie bez znaku przez przesunięcie obu stron o 2^31.
+    const __m128i bias = _mm_set1_epi32((int)0x80000000u);
+    const __m128i vi = _mm_set1_epi32((int)i);
+    const __m128i vlim = _mm_set1_epi32((int)((lim + 1) ^ 0x80000000u));
+    const __m128i vtag = _mm_set1_epi32((int)tag);
+    const __m128i vhigh = _mm_set1_epi32((int)0xFFFF0000u);
+    const __m128i zero = _mm_setzero_si128();
+    for (uint32_t h = 0; h < BUCKET_WAYS; h += 4) {
+        __m128i pos = _mm_load_si128(reinterpret_cast<const __m128i*>(b.pos + h));
+        __m128i diff = _mm_xor_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(b.tag + h)), vtag);
+        __m128i live = _mm_cmpgt_epi32(vlim, _mm_xor_si128(_mm_sub_epi32(vi, pos), bias));
+        __m128i eqFull = _mm_and_si128(live, _mm_cmpeq_epi32(diff, zero));
+        __m128i eqPair = _mm_and_si128(live, _mm_cmpeq_epi32(_mm_and_si128(diff, vhigh), zero));
+        full |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(eqFull)) << h;
+        pair |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(eqPair)) << h;
+    }
+#else
+    for (uint32_t w = 0; w < BUCKET_WAYS; w++) {
+        uint32_t age = i - b.pos[w];
+        uint32_t diff = b.tag[w] ^ tag;
+        if (age - 1 < lim) {
+            full |= (uint32_t)(diff == 0) << w;
+            pair |= (uint32_t)((diff & 0xFFFF0000u) == 0) << w;
+        }
+    }
+#endif
+    *outPair = pair & ~full;
+    return full;
+}
+
+// Numer najmłodszego ustawionego bitu maski slotów (mask != 0).
+static inline uint32_t bucket_first_slot(uint32_t mask)
+{
+#ifdef LZ77_X64_SIMD
+    return ctz32(mask);
+#else
+    uint32_t w = 0;
+    while ((mask & 1u) == 0) {
+        mask >>= 1;
+        w++;
+    }
+    return w;
+#endif
+}
+
+// Odpowiednik find_longest_match dla kubełków. Kandydaci z inną górną połową odcisku to kolizje
+// kubełka i są pomijani bez odczytu pikseli; zgodna tylko górna połowa oznacza dopasowanie krótsze
+// niż BUCKET_TAG_PX — najnowszy taki kandydat sprawdzany jest na końcu, gdy nic dłuższego nie
+// znaleziono. cfg.maxChain ogranicza liczbę porównań pikseli (liczonych w *outWalks).
+static inline uint32_t bucket_find_longest_match(
+    const uint32_t*    src_px,
+    size_t             src_count,
+    size_t             i,
+    uint32_t           maxMatch,
+    const PackedConfig& cfg,
+    const MatchBucket* buckets,
+    uint32_t*          outOff,
+    uint32_t*          outWalks)
+{
+    uint32_t tag;
+    const MatchBucket& b = buckets[bucket_key(src_px, src_count, i, cfg.bucketBits, &tag)];
+
+    // Pozycje starsze niż cfg.window od bieżącej są poza oknem i nie mogą być kandydatami.
+    uint32_t lim = (i >= cfg.window) ? cfg.window : (uint32_t)i;
+    uint32_t pair;
+    uint32_t full = bucket_match_masks(b, (uint32_t)i, lim, tag, &pair);
+
+    uint32_t bestLen = 0;
+    uint32_t bestOff = 0;
+
+    uint32_t verifyLeft = cfg.maxChain;
+    const MatchLenFn matchLen = active_kernels().matchLen;
+    uint32_t rowWalks = match_row_candidates(src_px, i, maxMatch, cfg, matchLen, &bestLen, &bestOff);
+
+    const uint32_t* ptrA = src_px + i;
+
+    // Sprawdzane są tylko sloty z całym odciskiem zgodnym, od najnowszego; przy szumie
+    // (typowo brak zgodnych slotów) pętla nie wykonuje się ani razu.
+    for (uint32_t m = full; m != 0 && verifyLeft > 0 && bestLen < maxMatch; m &= m - 1) {
+        uint32_t candidate = b.pos[bucket_first_slot(m)];
+        const uint32_t* ptrB = src_px + candidate;
+        uint32_t curLen = (ptrA[bestLen] == ptrB[bestLen]) ? matchLen(ptrA, ptrB, maxMatch) : 0;
+        if (curLen > bestLen) {
+            bestLen = curLen;
+            bestOff = (uint32_t)i - candidate;
+        }
+        verifyLeft--;
+    }
+
+    if (bestLen < BUCKET_TAG_PX && bestLen < maxMatch && pair != 0 && verifyLeft > 0) {
+        uint32_t candidate = b.pos[bucket_first_slot(pair)];
+        const uint32_t* ptrB = src_px + candidate;
+        uint32_t curLen = (ptrA[bestLen] == ptrB[bestLen]) ? matchLen(ptrA, ptrB, maxMatch) : 0;
+        if (curLen > bestLen) {
+            bestLen = curLen;
+            bestOff = (uint32_t)i - candidate;
+        }
+        verifyLeft--;
+    }
+
+    *outOff = bestOff;
+    *outWalks = cfg.maxChain - verifyLeft + rowWalks;
+    return bestLen;
+}
+
+// Stan wyszukiwania dopasowań: tablice hash (lub kubełki — cfg->finder) i pierwsza pozycja
+// jeszcze niewstawiona do nich. Wyszukiwania muszą iść rosnąco po pozycjach: przed szukaniem
+// na pozycji i wstawiane są wszystkie pozycje < i i żadna późniejsza (kandydat >= i dałby
+// ujemny offset).
+struct MatchFinder {
+    const uint32_t* src;
+    size_t          count;
+    const PackedConfig* cfg;
+    uint32_t*       head;
+    uint32_t*       prev;
+    MatchBucket*    buckets;
+    size_t          hashed;
+
+    void insert_upto(size_t target)
+    {
+        if (target > hashed) {
+            if (buckets != nullptr)
+                bucket_insert_positions(src, count, cfg->bucketBits, buckets, hashed, (uint32_t)(target - hashed));
+            else
+                insert_positions(src, count, cfg->window, cfg->hashBits, head, prev, hashed, (uint32_t)(target - hashed));
+            hashed = target;
+        }
+    }
+
+    // Najdłuższe dopasowanie na pozycji i nie dłuższe niż maxMatch (wymaga count - i >= 2
+    // i insert_upto(i)); liczba odwiedzonych kandydatów w *outWalks.
+    uint32_t search(size_t i, uint32_t maxMatch, uint32_t* outOff, uint32_t* outWalks) const
+    {
+        if (buckets != nullptr)
+            return bucket_find_longest_match(src, count, i, maxMatch, *cfg, buckets, outOff, outWalks);
+        return find_longest_match(src, i, maxMatch, *cfg, head, prev, outOff, outWalks);
+    }
+
+    // Najdłuższe dopasowanie formatu kompaktowego na pozycji i.
+    uint32_t find(size_t i, uint32_t* outOff, uint64_t& walksTotal) const
+    {
+        // Bez jawnego next_px dopasowanie może sięgać do samego końca wejścia.
+        size_t remaining = count - i;
+        uint32_t maxMatch = (remaining > cfg->maxMatch) ? cfg->maxMatch : (uint32_t)remaining;
+        uint32_t walks = 0;
+        uint32_t len = search(i, maxMatch, outOff, &walks);
+        walksTotal += walks;
+        return len;
+    }
+};
+
+// Przygotowuje tablice wyszukiwania w buforze roboczym (co najmniej packed_work_bytes(*cfg)).
+// Czyszczony jest tylko head[] lub kubełki dopasowane do wejścia, nie cały bufor.
+// Zwraca pierwszy bajt za tablicami (tablice segmentu parsowania optymalnego).
+static uint8_t* match_finder_init(MatchFinder& mf, const uint32_t* src_px, size_t src_count,
+    const PackedConfig* cfg, void* work)
+{
+    mf = MatchFinder{ src_px, src_count, cfg, nullptr, nullptr, nullptr, 0 };
+
+    if (cfg->finder == LZ77_MATCH_FINDER_BUCKET) {
+        uintptr_t addr = (reinterpret_cast<uintptr_t>(work) + BUCKET_ALIGN - 1) & ~(uintptr_t)(BUCKET_ALIGN - 1);
+        size_t bytes = BUCKET_ALIGN << cfg->bucketBits;
+        mf.buckets = reinterpret_cast<MatchBucket*>(addr);
+        memset(mf.buckets, 0xFF, bytes);
+        return reinterpret_cast<uint8_t*>(addr) + bytes;
+    }
+
+    // head[] wskazuje najnowszą pozycję dla każdego hashu; prev[] łączy starsze pozycje w łańcuch.
+    // Wszystkie sloty head[] ustawione na INVALID_POS (0xFF..FF); prev[] nie wymaga inicjalizacji.
+    mf.head = reinterpret_cast<uint32_t*>(work);
+    mf.prev = mf.head + ((size_t)1 << cfg->hashBits);
+    memset(mf.head, 0xFF, ((size_t)1 << cfg->hashBits) * sizeof(uint32_t));
+    return reinterpret_cast<uint8_t*>(mf.prev + cfg->prevSlots);
+}
+
+void lz77_rgba_compress(
+    const uint32_t* src_px,
+    size_t          src_count,
+    uint8_t* dst,
+    size_t          dst_cap,
+    void* work,
+    size_t          work_cap,
+    size_t* out_len)
+{
+    *out_len = 0;
+
+    if (dst_cap < TOKEN_SIZE)
+        return;
+
+    if (src_count == 0) {
+        *out_len = 0;
+        return;
+    }
+
+    // prev[] dopasowane do długości wejścia (packed_config_size); head[] zawsze pełne
+    // (HASH_BITS_MAX) — ten sam hash co w kodzie ASM, więc strumień Token12 obu DLL
+    // jest identyczny.
+    PackedConfig cfg = DEFAULT_CONFIG;
+    packed_config_size(cfg, src_count);
+    cfg.hashBits = HASH_BITS_MAX;
+
+    // Brak bufora roboczego lub zbyt mały: każdy piksel emitowany jako oddzielny literal.
+    // Strumień jest poprawny i dekompresuje się bez błędów, lecz bez kompresji.
+    if (work == nullptr || work_cap < packed_work_bytes(cfg)) {
+        size_t out_bytes = 0;
+        for (size_t i = 0; i < src_count; i++) {
+            if (dst_cap - out_bytes < TOKEN_SIZE) {
+                *out_len = 0;
+                return;
+            }
+            Token12* tok = reinterpret_cast<Token12*>(dst + out_bytes);
+            tok->offset_px = 0;
+            tok->length_px = 0;
+            tok->next_px = src_px[i];
+            out_bytes += TOKEN_SIZE;
+        }
+        *out_len = out_bytes;
+        return;
+    }
+
+    MatchFinder mf;
+    match_finder_init(mf, src_px, src_count, &cfg, work);
+
+    size_t out_bytes = 0;
+
+    size_t i = 0;
+    while (i < src_count) {
+
+        size_t remaining = src_count - i;
+
+        // Ostatni piksel nie ma sąsiada potrzebnego do obliczenia hashu, więc zawsze trafia jako literal.
+        if (remaining == 1) {
+            if (dst_cap - out_bytes < TOKEN_SIZE) {
+                *out_len = 0;
+                return;
+            }
+            Token12* tok = reinterpret_cast<Token12*>(dst + out_bytes);
+            tok->offset_px = 0;
+            tok->length_px = 0;
+            tok->next_px = src_px[i];
+            out_bytes += TOKEN_SIZE;
+            i++;
+            continue;
+        }
+
+        // Odejmowanie 1: token zawsze przechowuje jawny piksel następujący po dopasowaniu (next_px),
+        // więc nie można dopasować do ostatniego piksela w oknie.
+        uint32_t maxMatch = (uint32_t)(remaining - 1);
+        if (maxMatch > MAX_MATCH_PX)
+            maxMatch = MAX_MATCH_PX;
+
+        // Tablice zawierają wszystkie pozycje < i (wstawione po poprzednich tokenach).
+        uint32_t bestOff = 0;
+        uint32_t walks = 0;
+        mf.insert_upto(i);
+        uint32_t bestLen = mf.search(i, maxMatch, &bestOff, &walks);
+
+        if (dst_cap - out_bytes < TOKEN_SIZE) {
+            *out_len = 0;
+            return;
+        }
+
+        // Dla dopasowania next_px to piksel tuż za skopiowanym ciągiem; dla literalu to sam piksel src[i].
+        uint32_t next_px;
+        if (bestLen > 0)
+            next_px = src_px[i + bestLen];
+        else
+            next_px = src_px[i];
+
+        Token12* tok = reinterpret_cast<Token12*>(dst + out_bytes);
+        tok->offset_px = bestOff;
+        tok->length_px = bestLen;
+        tok->next_px = next_px;
+        out_bytes += TOKEN_SIZE;
+
+        i += bestLen + 1;
+    }
+
+    *out_len = out_bytes;
+}
+
+void lz77_rgba_decompress(
+    const uint8_t* src,
+    size_t          src_len,
+    uint32_t* dst_px,
+    size_t          dst_cap,
+    size_t* out_len)
+{
+    *out_len = 0;
+
+    const CopyMatchFn copyMatch = active_kernels().copyMatch;
+    size_t src_pos = 0;
+    size_t out_px = 0;
+
+    while (true) {
+
+        // Pętla kończy się, gdy w strumieniu nie ma już pełnego tokenu (12 bajtów).
+        if (src_pos + TOKEN_SIZE > src_len)
+            break;
+
+        // Tokeny bloku w pliku .lz77 nie muszą być wyrównane do 4 bajtów — kopia.
+        Token12 tok;
+        memcpy(&tok, src + src_pos, TOKEN_SIZE);
+        uint32_t offset_px = tok.offset_px;
+        uint32_t length_px = tok.length_px;
+        uint32_t next_px = tok.next_px;
+
+        src_pos += TOKEN_SIZE;
+
+        // Literal: oba pola offset i length równe zero — zapisywany jest wyłącznie piksel next_px.
+        if (offset_px == 0 && length_px == 0) {
+            if (out_px >= dst_cap) {
+                *out_len = 0;
+                return;
+            }
+            dst_px[out_px++] = next_px;
+            continue;
+        }
+
+        // Dopasowanie wymaga miejsca na length_px skopiowanych pikseli oraz dodatkowego next_px.
+        if (out_px + length_px + 1 > dst_cap) {
+            *out_len = 0;
+            return;
+        }
+
+        // offset_px == 0 przy length_px > 0 jest stanem nieprawidłowym — strumień uszkodzony.
+        if (offset_px == 0) {
+            *out_len = 0;
+            return;
+        }
+
+        // offset_px > out_px oznaczałoby odwołanie do obszaru jeszcze niezapisanego — strumień uszkodzony.
+        if (offset_px > out_px) {
+            *out_len = 0;
+            return;
+        }
+
+        // Jądro kopiowania (active_kernels().copyMatch): bloki wektorowe, gdy odstęp między
+        // źródłem a zapisem jest co najmniej szerokością bloku (SSE2: 4 piksele = movdqu w ASM);
+        // przy mniejszym odstępie odczyt nachodzi na zapis i kopiowanie idzie piksel po pikselu,
+        // co realizuje semantykę run-length. Nadmiarowe piksele bloku nadpisze next_px i kolejne tokeny.
+        copyMatch(dst_px + out_px, offset_px, length_px, dst_cap - out_px);
+
+        out_px += length_px;
+
+        // Piksel next_px zapisywany bezpośrednio po skopiowanym ciągu.
+        dst_px[out_px++] = next_px;
+    }
+
+    *out_len = out_px;
+}
+
+// Stan zapisu formatu kompaktowego: pozycja w dst oraz bajt flag bieżącej grupy tokenów.
+struct PackedWriter {
+    uint8_t* dst;
+    size_t   cap;
+    size_t   pos;
+    size_t   flagPos;     // pozycja bajtu flag bieżącej grupy
+    uint32_t groupLeft;   // wolne bity w bajcie flag; 0 = następny token otwiera nową grupę
+};
+
+// Rezerwuje miejsce na token (payload bajtów) i ustawia jego bit w bajcie flag: 1 = dopasowanie, 0 = seria literałów.
+static inline bool packed_begin_token(PackedWriter& w, size_t payload, bool isMatch)
+{
+    size_t need = payload + (w.groupLeft == 0 ? 1 : 0);
+    if (w.cap - w.pos < need)
+        return false;
+
+    if (w.groupLeft == 0) {
+        w.flagPos = w.pos;
+        w.dst[w.pos++] = 0;
+        w.groupLeft = PACKED_GROUP_TOKENS;
+    }
+    if (isMatch)
+        w.dst[w.flagPos] |= (uint8_t)(1u << (PACKED_GROUP_TOKENS - w.groupLeft));
+    w.groupLeft--;
+    return true;
+}
+
+// Zapisuje count pikseli jako serie literałów po maksymalnie 256 pikseli.
+static inline bool packed_emit_literals(PackedWriter& w, const uint32_t* px, size_t count)
+{
+    while (count > 0) {
+        uint32_t run = (count > PACKED_MAX_LITERAL_RUN) ? PACKED_MAX_LITERAL_RUN : (uint32_t)count;
+        size_t bytes = (size_t)run * sizeof(uint32_t);
+
+        if (!packed_begin_token(w, 1 + bytes, false))
+            return false;
+
+        w.dst[w.pos++] = (uint8_t)(run - 1);
+        memcpy(w.dst + w.pos, px, bytes);
+        w.pos += bytes;
+
+        px += run;
+        count -= run;
+    }
+    return true;
+}
+
+// Dopasowanie w cfg.matchBytes bajtach little-endian: najmłodsze cfg.offsetBits bitów = offset-1,
+// kolejne cfg.lengthBits bitów = długość-1, reszta = 0. Dla DEFAULT_CONFIG: 12 + 6 bitów w 3 bajtach.
+static inline bool packed_emit_match(PackedWriter& w, const PackedConfig& cfg, uint32_t offset, uint32_t length)
+{
+    if (!packed_begin_token(w, cfg.matchBytes, true))
+        return false;
+
+    uint32_t v = (offset - 1) | ((length - 1) << cfg.offsetBits);
+    for (uint32_t b = 0; b < cfg.matchBytes; b++)
+        w.dst[w.pos + b] = (uint8_t)(v >> (8 * b));
+    w.pos += cfg.matchBytes;
+    return true;
+}
+
+// Liczba serii literałów potrzebnych do zapisania count pikseli.
+static inline uint64_t packed_literal_runs(size_t count)
+{
+    return (count + PACKED_MAX_LITERAL_RUN - 1) / PACKED_MAX_LITERAL_RUN;
+}
+
+// Liczniki tokenów zbierane podczas zapisu (patrz lz77_stats).
+struct PackedCounters {
+    uint64_t literalPx;
+    uint64_t literalRuns;
+    uint64_t matches;
+    uint64_t matchPx;
+    uint64_t chainWalks;
+};
+
+// Stan kodera formatu kompaktowego — wspólny dla kompresji jednorazowej (compress_packed_impl)
+// i strumieniowej (lz77_stream_*). Koder działa krokami (packed_encode_step); każdy krok zapisuje
+// co najwyżej jedną serię literałów i jedno dopasowanie, więc zmieści się w PACKED_STEP_BYTES.
+//
+// Literały nie są emitowane od razu: [litStart .. i) to oczekująca seria. Jej pełne serie po 256
+// pikseli zapisywane są z wyprzedzeniem (od litEmit) — podział na serie jest taki sam jak przy
+// zapisie całości naraz, więc strumień nie zależy od tego, ile bajtów przyjmuje wyjście.
+// litStart zostaje na początku serii: parsowanie optymalne używa go jako stanu kosztu.
+struct PackedEncoder {
+    const uint32_t* src;
+    size_t          count;
+    PackedConfig    cfg;
+    MatchFinder     mf;
+    PackedCounters  c;
+    bool            literalOnly;   // brak bufora roboczego — same literały
+    bool            done;
+
+    size_t          i;             // pozycja kodera; literały [litStart .. i) są już rozstrzygnięte
+    size_t          litStart;
+    size_t          litEmit;       // literały [litStart .. litEmit) już zapisane
+
+    // LZ77_PARSE_GREEDY / LAZY / LAZY2 — wynik wyszukiwania z wyprzedzeniem (pozycja aheadPos).
+    uint32_t        lazySteps;
+    size_t          aheadPos;
+    uint32_t        aheadLen, aheadOff;
+
+    // LZ77_PARSE_OPTIMAL — bieżący segment [segStart, segStart + segN), zapisany do segP.
+    uint8_t*        segWork;
+    size_t          segStart;
+    uint32_t        segCarried;    // pozycje na początku segmentu przeszukane w poprzednim segmencie
+    uint32_t        segN;
+    uint32_t        segP;
+    bool            segLast;
+    bool            segPlanned;
+};
+
+// Górna granica bajtów zapisanych w jednym kroku kodera: seria literałów (bajt flag, licznik,
+// 256 pikseli) i dopasowanie (bajt flag, do 4 bajtów), z zapasem.
+static const size_t PACKED_STEP_BYTES = 4096;
+
+static void packed_encoder_init(PackedEncoder& e, const uint32_t* src_px, size_t src_count,
+    const PackedConfig& cfg, void* work, size_t work_cap)
+{
+    memset(&e, 0, sizeof(e));
+    e.src = src_px;
+    e.count = src_count;
+    e.cfg = cfg;
+    packed_config_size(e.cfg, src_count);
+
+    // Brak bufora roboczego: cały obraz zapisany jako serie literałów (ok. 4 bajty na piksel).
+    e.literalOnly = work == nullptr || work_cap < packed_work_bytes(e.cfg);
+    if (e.literalOnly) {
+        e.i = src_count;
+        return;
+    }
+
+    e.segWork = match_finder_init(e.mf, src_px, src_count, &e.cfg, work);
+    e.lazySteps = (cfg.parse == LZ77_PARSE_LAZY2) ? 2u : (cfg.parse == LZ77_PARSE_LAZY) ? 1u : 0u;
+    e.aheadPos = SIZE_MAX;
+}
+
+// Zapisuje count (<= 256) oczekujących literałów od litEmit jako jedną serię.
+static inline bool packed_flush_literals(PackedEncoder& e, PackedWriter& w, size_t count)
+{
+    if (count == 0)
+        return true;
+    if (!packed_emit_literals(w, e.src + e.litEmit, count))
+        return false;
+    e.c.literalPx += count;
+    e.c.literalRuns++;
+    e.litEmit += count;
+    return true;
+}
+
+// Zapisuje oczekującą serię literałów [litEmit .. pos) (krótszą niż 256 pikseli) i dopasowanie
+// (offset, length) zaczynające się w pos; kolejna seria zaczyna się za dopasowaniem.
+static inline bool packed_emit_pending(PackedEncoder& e, PackedWriter& w, size_t pos, uint32_t offset, uint32_t length)
+{
+    if (!packed_flush_literals(e, w, pos - e.litEmit) ||
+        !packed_emit_match(w, e.cfg, offset, length))
+        return false;
+
+    e.c.matches++;
+    e.c.matchPx += length;
+    e.litStart = e.litEmit = pos + length;
+    return true;
+}
+
+// Jeden krok parsowania LZ77_PARSE_GREEDY / LAZY / LAZY2: pozycja i trafia do serii literałów
+// albo zaczyna się w niej dopasowanie.
+//   LZ77_PARSE_GREEDY  — najdłuższe dopasowanie na bieżącej pozycji,
+//   LZ77_PARSE_LAZY(2) — przed zapisem dopasowania sprawdzana jest 1 (2) pozycja przed
+//                        jego końcem; skrócenie dopasowania wygrywa, gdy następny token
+//                        sięga wtedy dalej.
+static inline bool packed_step_greedy(PackedEncoder& e, PackedWriter& w)
+{
+    MatchFinder& mf = e.mf;
+    size_t i = e.i;
+
+    // Ostatni piksel nie ma sąsiada do hashu — dołącza do serii literałów.
+    if (e.count - i == 1) {
+        e.i++;
+        return true;
+    }
+
+    uint32_t bestOff = 0;
+    uint32_t bestLen;
+    if (i == e.aheadPos) {
+        bestLen = e.aheadLen;
+        bestOff = e.aheadOff;
+    }
+    else {
+        mf.insert_upto(i);
+        bestLen = mf.find(i, &bestOff, e.c.chainWalks);
+    }
+
+    // Dopasowanie 1-pikselowe (token + przerwanie serii) nie jest tańsze od literału.
+    if (bestLen < PACKED_MIN_MATCH) {
+        e.i++;
+        return true;
+    }
+
+    // Tryb leniwy: piksel literału (4 B) jest droższy od całego tokenu dopasowania, więc
+    // odkładanie dopasowania za literały nie opłaca się. Zamiast tego sprawdzane są
+    // pozycje 1..lazySteps przed końcem dopasowania: jeśli token zaczęty tam sięga dalej
+    // niż token zaczęty na końcu (lub literał, gdy tam brak dopasowania), bieżące
+    // dopasowanie jest skracane. Pozycje szukane są rosnąco, a wyniki zapamiętywane.
+    size_t end = i + bestLen;
+    if (e.lazySteps > 0 && end < e.count) {
+        uint32_t back = std::min(e.lazySteps, bestLen - PACKED_MIN_MATCH);
+        size_t first = std::max(end - back, mf.hashed);
+
+        size_t cutPos = 0, cutReach = 0;
+        uint32_t cutLen = 0, cutOff = 0;
+        for (size_t p = first; p < end; p++) {
+            mf.insert_upto(p);
+            uint32_t off = 0;
+            uint32_t len = mf.find(p, &off, e.c.chainWalks);
+            if (len >= PACKED_MIN_MATCH && p + len > cutReach) {
+                cutPos = p;
+                cutReach = p + len;
+                cutLen = len;
+                cutOff = off;
+            }
+        }
+
+        uint32_t nextLen = 0, nextOff = 0;
+        if (e.count - end >= 2) {
+            mf.insert_upto(end);
+            nextLen = mf.find(end, &nextOff, e.c.chainWalks);
+        }
+        size_t nextReach = end + (nextLen >= PACKED_MIN_MATCH ? nextLen : 0);
+
+        if (cutReach > nextReach) {
+            bestLen = (uint32_t)(cutPos - i);
+            e.aheadPos = cutPos;
+            e.aheadLen = cutLen;
+            e.aheadOff = cutOff;
+        }
+        else {
+            e.aheadPos = end;
+            e.aheadLen = nextLen;
+            e.aheadOff = nextOff;
+        }
+    }
+
+    if (!packed_emit_pending(e, w, i, bestOff, bestLen))
+        return false;
+    e.i = i + bestLen;
+    return true;
+}
+
+// Parsowanie optymalne: dla każdego segmentu [segStart, segStart + n) programowanie dynamiczne
+// z dwoma stanami końca prefiksu — po dopasowaniu (costM) i w serii literałów (costL):
+//   costL[x] = min(costL[x-1], costM[x-1] + początek serii) + literał
+//   costM[x] = min po p z p + MIN <= x <= p + matchLen[p] (min(costL[p], costM[p]) + dopasowanie)
+// Każdy krótszy prefiks dopasowania z p też jest dopasowaniem, a token ma stały koszt, więc
+// przedziały [p + MIN, p + matchLen[p]] obsługuje kopiec minimów z leniwym usuwaniem.
+// Dopasowanie ucięte końcem segmentu nie jest zapisywane: kolejny segment zaczyna się od
+// jego początku (z zachowanymi wynikami wyszukiwania), o ile zajmuje najwyżej pół segmentu.
+// Pozycje wewnątrz dopasowania >= OPT_NICE_MATCH_PX (poza ostatnimi OPT_NICE_TAIL_PX)
+// nie są przeszukiwane (matchLen = 0).
+//
+// packed_plan_segment wyznacza emitLen[] segmentu; tokeny zapisuje packed_step_optimal.
+static void packed_plan_segment(PackedEncoder& e)
+{
+    uint64_t* heap     = reinterpret_cast<uint64_t*>(e.segWork);
+    uint32_t* costL    = reinterpret_cast<uint32_t*>(heap + OPT_SEGMENT_PX);
+    uint32_t* costM    = costL + OPT_SEGMENT_PX + 1;
+    uint32_t* matchLen = costM + OPT_SEGMENT_PX + 1;
+    uint32_t* matchOff = matchLen + OPT_SEGMENT_PX;
+    uint32_t* emitLen  = matchOff + OPT_SEGMENT_PX;
+    uint16_t* fromM    = reinterpret_cast<uint16_t*>(emitLen + OPT_SEGMENT_PX);
+    uint8_t*  litFromM = reinterpret_cast<uint8_t*>(fromM + OPT_SEGMENT_PX + 1);
+
+    const uint32_t costMatch = e.cfg.matchBytes * 8 + 1;
+    const std::greater<uint64_t> minHeap;
+    MatchFinder& mf = e.mf;
+
+    size_t segStart = e.segStart;
+    uint32_t n = (uint32_t)std::min<size_t>(OPT_SEGMENT_PX, mf.count - segStart);
+    size_t heapSize = 0;
+
+    // Pomijanie pozycji nie przechodzi przez granicę segmentu: dopasowanie, które je
+    // uzasadniało, mogło zostać ucięte, a nowe pozycje muszą mieć własne wyniki.
+    uint32_t skipUntil = 0;
+
+    // Stan na początku segmentu: w serii literałów, jeśli seria z poprzedniego jest otwarta.
+    bool startInRun = e.litStart < segStart;
+    costM[0] = startInRun ? OPT_COST_INF : 0;
+    costL[0] = startInRun ? 0 : OPT_COST_INF;
+
+    for (uint32_t x = 0; x <= n; x++) {
+        // Dopasowanie z p = x - MIN staje się dostępne (najkrótsza dozwolona długość).
+        if (x >= PACKED_MIN_MATCH && matchLen[x - PACKED_MIN_MATCH] != 0) {
+            uint32_t p = x - PACKED_MIN_MATCH;
+            uint64_t value = std::min(costL[p], costM[p]) + costMatch;
+            heap[heapSize++] = (value << 16) | p;
+            std::push_heap(heap, heap + heapSize, minHeap);
+        }
+
+        if (x > 0) {
+            // Kandydaci, których dopasowanie kończy się przed x, są usuwani ze szczytu kopca.
+            while (heapSize > 0) {
+                uint32_t p = (uint32_t)(heap[0] & 0xFFFFu);
+                if (p + matchLen[p] >= x)
+                    break;
+                std::pop_heap(heap, heap + heapSize, minHeap);
+                heapSize--;
+            }
+            if (heapSize > 0) {
+                costM[x] = (uint32_t)(heap[0] >> 16);
+                fromM[x] = (uint16_t)(heap[0] & 0xFFFFu);
+            }
+            else {
+                costM[x] = OPT_COST_INF;
+            }
+
+            uint32_t fromL = costL[x - 1] + OPT_COST_LITERAL;
+            uint32_t fromMatch = costM[x - 1] + OPT_COST_RUN_START + OPT_COST_LITERAL;
+            costL[x] = std::min(fromL, fromMatch);
+            litFromM[x] = (fromMatch < fromL) ? 1 : 0;
+        }
+
+        if (x < n && x >= e.segCarried) {
+            size_t pos = segStart + x;
+            uint32_t len = 0, off = 0;
+            if (x >= skipUntil && mf.count - pos >= 2) {
+                mf.insert_upto(pos);
+                len = mf.find(pos, &off, e.c.chainWalks);
+                if (len >= OPT_NICE_MATCH_PX)
+                    skipUntil = x + len - OPT_NICE_TAIL_PX;
+            }
+            matchLen[x] = (len >= PACKED_MIN_MATCH) ? len : 0;
+            matchOff[x] = off;
+        }
+    }
+
+    // Odtworzenie ścieżki od końca segmentu: emitLen[p] = długość dopasowania od p, 0 = literał.
+    uint32_t x = n;
+    bool inMatch = costM[n] <= costL[n];
+    while (x > 0) {
+        if (inMatch) {
+            uint32_t p = fromM[x];
+            emitLen[p] = x - p;
+            inMatch = !(costL[p] < costM[p]);
+            x = p;
+        }
+        else {
+            emitLen[x - 1] = 0;
+            inMatch = litFromM[x] != 0;
+            x--;
+        }
+    }
+
+    e.segN = n;
+    e.segP = 0;
+    e.segLast = segStart + n == mf.count;
+    e.segPlanned = true;
+}
+
+// Jeden krok parsowania optymalnego: zaplanowanie segmentu albo zapis jego kolejnego tokenu.
+static bool packed_step_optimal(PackedEncoder& e, PackedWriter& w)
+{
+    if (!e.segPlanned) {
+        packed_plan_segment(e);
+        return true;
+    }
+
+    uint32_t* matchLen = reinterpret_cast<uint32_t*>(reinterpret_cast<uint64_t*>(e.segWork) + OPT_SEGMENT_PX)
+        + 2 * (OPT_SEGMENT_PX + 1);
+    uint32_t* matchOff = matchLen + OPT_SEGMENT_PX;
+    uint32_t* emitLen  = matchOff + OPT_SEGMENT_PX;
+
+    uint32_t n = e.segN;
+    uint32_t p = e.segP;
+
+    // Pozycje bez dopasowania dołączają do serii literałów — najwyżej do pełnej serii,
+    // którą zapisze następny krok.
+    while (p < n && emitLen[p] == 0 && e.segStart + p - e.litEmit < PACKED_MAX_LITERAL_RUN)
+        p++;
+    e.segP = p;
+    e.i = e.segStart + p;
+    if (p < n && emitLen[p] == 0)
+        return true;
+
+    if (p < n && !(!e.segLast && p > 0 && p + emitLen[p] == n && n - p <= OPT_SEGMENT_PX / 2)) {
+        if (!packed_emit_pending(e, w, e.segStart + p, matchOff[p], emitLen[p]))
+            return false;
+        e.segP = p + emitLen[p];
+        e.i = e.segStart + e.segP;
+        return true;
+    }
+
+    // Koniec segmentu. p < n: ostatnie dopasowanie przechodzi do następnego segmentu razem
+    // z wynikami wyszukiwania.
+    e.segCarried = n - p;
+    memmove(matchLen, matchLen + p, e.segCarried * sizeof(uint32_t));
+    memmove(matchOff, matchOff + p, e.segCarried * sizeof(uint32_t));
+    e.segStart += p;
+    e.i = e.segStart;
+    e.segPlanned = false;
+    return true;
+}
+
+// Jeden krok kodera; false = brak miejsca w w (strumień w w jest wtedy niekompletny).
+// Po ostatnim kroku e.done = true.
+static inline bool packed_encode_step(PackedEncoder& e, PackedWriter& w)
+{
+    // Pełna seria oczekujących literałów — zapisywana od razu.
+    if (e.i - e.litEmit >= PACKED_MAX_LITERAL_RUN)
+        return packed_flush_literals(e, w, PACKED_MAX_LITERAL_RUN);
+
+    bool end = e.literalOnly ||
+        (e.cfg.parse == LZ77_PARSE_OPTIMAL ? (!e.segPlanned && e.segStart >= e.count) : e.i >= e.count);
+    if (end) {
+        if (!packed_flush_literals(e, w, e.i - e.litEmit))
+            return false;
+        e.done = true;
+        return true;
+    }
+
+    return (e.cfg.parse == LZ77_PARSE_OPTIMAL) ? packed_step_optimal(e, w) : packed_step_greedy(e, w);
+}
+
+static void packed_fill_stats(const PackedEncoder& e, lz77_stats* stats)
+{
+    if (stats) {
+        stats->literal_px = e.c.literalPx;
+        stats->literal_runs = e.c.literalRuns;
+        stats->matches = e.c.matches;
+        stats->match_px = e.c.matchPx;
+        stats->chain_walks = e.c.chainWalks;
+    }
+}
+
+// Wspólna implementacja lz77_rgba_compress_packed, lz77_rgba_compress_packed_stats
+// i lz77_rgba_compress_level (cfg wyznacza okno, długość dopasowań, łańcuch, układ tokenu
+// i sposób parsowania): koder PackedEncoder zapisujący wprost do dst. Liczniki zbierane są
+// zawsze (koszt kilku dodawań na token) i zapisywane do *stats na końcu, jeśli stats != nullptr.
+static void compress_packed_impl(
+    const uint32_t* src_px,
+    size_t          src_count,
+    uint8_t* dst,
+    size_t          dst_cap,
+    void* work,
+    size_t          work_cap,
+    const PackedConfig& cfg,
+    size_t* out_len,
+    lz77_stats* stats)
+{
+    *out_len = 0;
+    if (stats)
+        memset(stats, 0, sizeof(*stats));
+
+    if (src_count == 0)
+        return;
+
+    PackedWriter w{ dst, dst_cap, 0, 0, 0 };
+    PackedEncoder e;
+    packed_encoder_init(e, src_px, src_count, cfg, work, work_cap);
+
+    while (!e.done) {
+        if (!packed_encode_step(e, w))
+            return;
+    }
+
+    *out_len = w.pos;
+    packed_fill_stats(e, stats);
+}
+
+void lz77_rgba_compress_packed(
+    const uint32_t* src_px,
+    size_t          src_count,
+    uint8_t* dst,
+    size_t          dst_cap,
+    void* work,
+    size_t          work_cap,
+    size_t* out_len)
+{
+    compress_packed_impl(src_px, src_count, dst, dst_cap, work, work_cap, DEFAULT_CONFIG, out_len, nullptr);
+}
+
+void lz77_rgba_compress_packed_stats(
+    const uint32_t* src_px,
+    size_t          src_count,
+    uint8_t* dst,
+    size_t          dst_cap,
+    void* work,
+    size_t          work_cap,
+    size_t* out_len,
+    lz77_stats* stats)
+{
+    compress_packed_impl(src_px, src_count, dst, dst_cap, work, work_cap, DEFAULT_CONFIG, out_len, stats);
+}
+
+int lz77_level_params(int level, lz77_params* out)
+{
+    if (out == nullptr || level < LZ77_LEVEL_MIN || level > LZ77_LEVEL_MAX)
+        return 0;
+    *out = LEVEL_PRESETS[level - LZ77_LEVEL_MIN];
+    return 1;
+}
+
+int lz77_params_valid(const lz77_params* params)
+{
+    PackedConfig cfg;
+    return packed_config(params, &cfg) ? 1 : 0;
+}
+
+size_t lz77_params_work_bytes(const lz77_params* params)
+{
+    PackedConfig cfg;
+    if (!packed_config(params, &cfg))
+        return 0;
+    return packed_work_bytes(cfg);
+}
+
+size_t lz77_work_bytes(size_t src_count, const lz77_params* params)
+{
+    PackedConfig cfg = DEFAULT_CONFIG;
+    if (params != nullptr && !packed_config(params, &cfg))
+        return 0;
+    packed_config_size(cfg, src_count);
+
+    // Większy z buforów obu struktur — ten sam rozmiar dla każdej wartości finder
+    // lz77_rgba_compress_ex. Bez params także lz77_rgba_compress — pełna tablica head[].
+    cfg.finder = LZ77_MATCH_FINDER_CHAIN;
+    if (params == nullptr)
+        cfg.hashBits = HASH_BITS_MAX;
+    size_t chain = packed_work_bytes(cfg);
+    cfg.finder = LZ77_MATCH_FINDER_BUCKET;
+    size_t bucket = packed_work_bytes(cfg);
+    return chain > bucket ? chain : bucket;
+}
+
+void lz77_rgba_compress_level(
+    const uint32_t* src_px,
+    size_t          src_count,
+    uint8_t* dst,
+    size_t          dst_cap,
+    void* work,
+    size_t          work_cap,
+    const lz77_params* params,
+    size_t* out_len,
+    lz77_stats* stats)
+{
+    PackedConfig cfg;
+    if (!packed_config(params, &cfg)) {
+        *out_len = 0;
+        if (stats)
+            memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    compress_packed_impl(src_px, src_count, dst, dst_cap, work, work_cap, cfg, out_len, stats);
+}
+
+void lz77_rgba_compress_image(
+    const uint32_t* src_px,
+    size_t          src_count,
+    size_t          width,
+    uint8_t* dst,
+    size_t          dst_cap,
+    void* work,
+    size_t          work_cap,
+    const lz77_params* params,
+    size_t* out_len,
+    lz77_stats* stats)
+{
+    PackedConfig cfg = DEFAULT_CONFIG;
+    if (params != nullptr && !packed_config(params, &cfg)) {
+        *out_len = 0;
+        if (stats)
+            memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    packed_config_rows(cfg, width);
+    compress_packed_impl(src_px, src_count, dst, dst_cap, work, work_cap, cfg, out_len, stats);
+}
+
+void lz77_rgba_compress_ex(
+    const uint32_t* src_px,
+    size_t          src_count,
+    size_t          width,
+    uint8_t* dst,
+    size_t          dst_cap,
+    void* work,
+    size_t          work_cap,
+    const lz77_params* params,
+    int             finder,
+    size_t* out_len,
+    lz77_stats* stats)
+{
+    PackedConfig cfg = DEFAULT_CONFIG;
+    if (params != nullptr && !packed_config(params, &cfg)) {
+        *out_len = 0;
+        if (stats)
+            memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    packed_config_rows(cfg, width);
+    cfg.finder = (finder == LZ77_MATCH_FINDER_BUCKET) ? LZ77_MATCH_FINDER_BUCKET : LZ77_MATCH_FINDER_CHAIN;
+    compress_packed_impl(src_px, src_count, dst, dst_cap, work, work_cap, cfg, out_len, stats);
+}
+
+size_t lz77_compress_bound(uint16_t format, size_t src_count)
+{
+    if (format == LZ77_FORMAT_TOKEN12)
+        return (src_count > SIZE_MAX / TOKEN_SIZE) ? 0 : src_count * TOKEN_SIZE;
+
+    if (format != LZ77_FORMAT_PACKED && format != LZ77_FORMAT_PACKED_EX)
+        return 0;
+
+    // Dopasowanie (najwyżej 4 B) obejmuje co najmniej 2 piksele, a każda przerwana nim seria
+    // kosztuje 1 B licznika i bit flagi — mniej niż 8 B tych pikseli zapisanych jako literały.
+    // Najdłuższy strumień to więc same literały: 4 B na piksel, bajt licznika na 256 pikseli
+    // i bajt flag na 8 serii (tak koduje np. szum).
+    if (src_count > (SIZE_MAX - 64) / 5)
+        return 0;
+    size_t runs = (src_count + PACKED_MAX_LITERAL_RUN - 1) / PACKED_MAX_LITERAL_RUN;
+    return src_count * sizeof(uint32_t) + runs + (runs + PACKED_GROUP_TOKENS - 1) / PACKED_GROUP_TOKENS;
+}
+
+// Kompresja strumieniowa: stan kodera i bufor pośredni leżą na początku bufora roboczego,
+// za nimi tablice kodera (jak w lz77_rgba_compress_level). Koder zapisuje tokeny do stage[];
+// wywołujący dostaje bajty sprzed bajtu flag otwartej grupy — bit flagi tokenu ustawiany
+// jest dopiero przy jego zapisie, więc otwarta grupa (do 8 tokenów) czeka w stage[].
+static const uint32_t STREAM_MAGIC = 0x4C5A5354u;   // "LZST"
+static const size_t   STREAM_ALIGN = 64;
+static const size_t   STREAM_STAGE_BYTES = 16384;   // otwarta grupa (<= 8 * 1025 B) + PACKED_STEP_BYTES
+
+struct PackedStream {
+    uint32_t      magic;
+    PackedEncoder enc;
+    PackedWriter  w;          // zapis do stage[]
+    size_t        flushed;    // bajty stage[] już oddane wywołującemu
+    uint8_t       stage[STREAM_STAGE_BYTES];
+};
+
+static const size_t STREAM_STATE_BYTES = (sizeof(PackedStream) + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+
+static inline PackedStream* stream_state(void* work)
+{
+    uintptr_t p = reinterpret_cast<uintptr_t>(work);
+    return reinterpret_cast<PackedStream*>((p + STREAM_ALIGN - 1) & ~(uintptr_t)(STREAM_ALIGN - 1));
+}
+
+size_t lz77_stream_work_bytes(const lz77_params* params)
+{
+    PackedConfig cfg = DEFAULT_CONFIG;
+    if (params != nullptr && !packed_config(params, &cfg))
+        return 0;
+    return STREAM_ALIGN - 1 + STREAM_STATE_BYTES + packed_work_bytes(cfg);
+}
+
+// Wspólny początek lz77_stream_begin, lz77_stream_begin_image (width == 0 — strumień płaski)
+// i lz77_stream_begin_ex. Tablice wyznaczone dla łańcuchów przy pełnym oknie mieszczą
+// też kubełki (packed_config_size), więc wymaganie bufora nie zależy od finder.
+static int stream_begin_impl(
+    void* work,
+    size_t          work_cap,
+    const uint32_t* src_px,
+    size_t          src_count,
+    size_t          width,
+    const lz77_params* params,
+    int             finder)
+{
+    PackedConfig cfg = DEFAULT_CONFIG;
+    if (work == nullptr || (params != nullptr && !packed_config(params, &cfg)) ||
+        work_cap < STREAM_ALIGN - 1 + STREAM_STATE_BYTES + packed_work_bytes(cfg))
+        return 0;
+    size_t tablesBytes = packed_work_bytes(cfg);
+    packed_config_rows(cfg, width);
+    cfg.finder = (finder == LZ77_MATCH_FINDER_BUCKET) ? LZ77_MATCH_FINDER_BUCKET : LZ77_MATCH_FINDER_CHAIN;
+
+    PackedStream* s = stream_state(work);
+    s->magic = STREAM_MAGIC;
+    s->w = PackedWriter{ s->stage, STREAM_STAGE_BYTES, 0, 0, 0 };
+    s->flushed = 0;
+    packed_encoder_init(s->enc, src_px, src_count, cfg,
+        reinterpret_cast<uint8_t*>(s) + STREAM_STATE_BYTES, tablesBytes);
+    s->enc.done = src_count == 0;
+    return 1;
+}
+
+int lz77_stream_begin(
+    void* work,
+    size_t          work_cap,
+    const uint32_t* src_px,
+    size_t          src_count,
+    const lz77_params* params)
+{
+    return stream_begin_impl(work, work_cap, src_px, src_count, 0, params, LZ77_MATCH_FINDER_CHAIN);
+}
+
+int lz77_stream_begin_image(
+    void* work,
+    size_t          work_cap,
+    const uint32_t* src_px,
+    size_t          src_count,
+    size_t          width,
+    const lz77_params* params)
+{
+    return stream_begin_impl(work, work_cap, src_px, src_count, width, params, LZ77_MATCH_FINDER_CHAIN);
+}
+
+int lz77_stream_begin_ex(
+    void* work,
+    size_t          work_cap,
+    const uint32_t* src_px,
+    size_t          src_count,
+    size_t          width,
+    const lz77_params* params,
+    int             finder)
+{
+    return stream_begin_impl(work, work_cap, src_px, src_count, width, params, finder);
+}
+
+int lz77_stream_compress(
+    void* work,
+    uint8_t* dst,
+    size_t          dst_cap,
+    size_t* out_len,
+    lz77_stats* stats)
+{
+    *out_len = 0;
+    if (work == nullptr)
+        return LZ77_STREAM_ERROR;
+    PackedStream* s = stream_state(work);
+    if (s->magic != STREAM_MAGIC)
+        return LZ77_STREAM_ERROR;
+
+    PackedEncoder& e = s->enc;
+    PackedWriter& w = s->w;
+    size_t out = 0;
+
+    for (;;) {
+        // Bajty gotowe: wszystko przed bajtem flag otwartej grupy (po końcu — cały stage[]).
+        size_t ready = (e.done || w.groupLeft == 0) ? w.pos : w.flagPos;
+        size_t n = std::min(ready - s->flushed, dst_cap - out);
+        memcpy(dst + out, s->stage + s->flushed, n);
+        out += n;
+        s->flushed += n;
+
+        if (s->flushed < ready || (out == dst_cap && !(e.done && s->flushed == w.pos))) {
+            *out_len = out;
+            return LZ77_STREAM_NEED_OUTPUT;
+        }
+        if (e.done) {
+            s->magic = 0;
+            *out_len = out;
+            packed_fill_stats(e, stats);
+            return LZ77_STREAM_DONE;
+        }
+
+        // Otwarta grupa przesuwana na początek stage[], gdy brakuje miejsca na kolejny krok.
+        if (w.cap - w.pos < PACKED_STEP_BYTES) {
+            memmove(s->stage, s->stage + s->flushed, w.pos - s->flushed);
+            w.pos -= s->flushed;
+            if (w.groupLeft != 0)
+                w.flagPos -= s->flushed;
+            s->flushed = 0;
+        }
+
+        if (!packed_encode_step(e, w)) {
+            s->magic = 0;
+            *out_len = out;
+            return LZ77_STREAM_ERROR;
+        }
+    }
+}
+
+// Odtwarzanie filtrowanych wierszy w trakcie dekodowania (lz77_rgba_decompress_image): dekoder
+// zapisuje reszty do src, a po każdej grupie tokenów gotowe wiersze trafiają do dst — wiersz
+// jest odtwarzany, zanim zniknie z pamięci podręcznej. Reszty muszą zostać w src do końca,
+// bo późniejsze dopasowania kopiują właśnie je.
+struct RowSink {
+    const uint32_t* src;
+    uint32_t*       dst;
+    size_t          width;
+    size_t          rows;
+    uint32_t        transform;
+    const uint8_t*  filters;     // nullptr — wszystkie wiersze LZ77_FILTER_NONE
+    UnfilterRowFn   unfilterRow;
+    size_t          done;        // odtworzone wiersze
+    size_t          nextPx;      // (done + 1) * width — piksele potrzebne do kolejnego wiersza
+};
+
+static void row_sink_flush(RowSink& s, size_t decoded_px)
+{
+    while (s.done < s.rows && s.nextPx <= decoded_px) {
+        size_t first = s.done * s.width;
+        s.unfilterRow(s.src + first, s.done ? s.dst + first - s.width : nullptr, s.dst + first, s.width,
+            s.filters ? s.filters[s.done] : LZ77_FILTER_NONE, s.transform);
+        s.done++;
+        s.nextPx += s.width;
+    }
+}
+
+// Wspólna implementacja lz77_rgba_decompress_packed, lz77_rgba_decompress_level
+// i lz77_rgba_decompress_image (sink != nullptr — odtwarzanie wierszy po każdej grupie tokenów).
+// MatchBytes (3 lub 4) jest parametrem szablonu, by odczyt tokenu dopasowania nie wymagał pętli.
+template <uint32_t MatchBytes>
+static void decompress_packed_impl(
+    const uint8_t* src,
+    size_t          src_len,
+    uint32_t* dst_px,
+    size_t          dst_cap,
+    const PackedConfig& cfg,
+    size_t* out_len,
+    RowSink* sink)
+{
+    *out_len = 0;
+
+    const uint32_t offsetMask = cfg.window - 1;
+    const uint32_t lengthMask = cfg.maxMatch - 1;
+    const CopyMatchFn copyMatch = active_kernels().copyMatch;
+
+    size_t src_pos = 0;
+    size_t out_px = 0;
+
+    while (src_pos < src_len) {
+
+        // Bajt flag opisuje do 8 kolejnych tokenów; ostatnia grupa strumienia może być niepełna.
+        uint32_t flags = src[src_pos++];
+
+        for (uint32_t k = 0; k < PACKED_GROUP_TOKENS && src_pos < src_len; k++, flags >>= 1) {
+
+            if (flags & 1u) {
+                if (src_len - src_pos < MatchBytes)
+                    return;
+
+                uint32_t v = (uint32_t)src[src_pos]
+                    | ((uint32_t)src[src_pos + 1] << 8)
+                    | ((uint32_t)src[src_pos + 2] << 16);
+                if (MatchBytes == 4)
+                    v |= (uint32_t)src[src_pos + 3] << 24;
+                src_pos += MatchBytes;
+
+                uint32_t offset_px = (v & offsetMask) + 1;
+                uint32_t length_px = ((v >> cfg.offsetBits) & lengthMask) + 1;
+                size_t room = dst_cap - out_px;
+
+                // Jedno połączone sprawdzenie: odwołanie przed początek wyjścia lub przepełnienie bufora.
+                if ((offset_px > out_px) | (length_px > room))
+                    return;
+
+                // Bloki wektorowe zaokrąglają długość w górę — nadmiarowe piksele nadpisze kolejny
+                // token. Koniec bufora lub offset mniejszy od bloku — kopiowanie piksel po pikselu.
+                copyMatch(dst_px + out_px, offset_px, length_px, room);
+                out_px += length_px;
+            }
+            else {
+                uint32_t run = (uint32_t)src[src_pos] + 1;
+                size_t bytes = (size_t)run * sizeof(uint32_t);
+
+                if ((src_len - src_pos - 1 < bytes) | (run > dst_cap - out_px))
+                    return;
+
+                memcpy(dst_px + out_px, src + src_pos + 1, bytes);
+                src_pos += 1 + bytes;
+                out_px += run;
+            }
+        }
+
+        if (sink != nullptr && out_px >= sink->nextPx)
+            row_sink_flush(*sink, out_px);
+    }
+
+    *out_len = out_px;
+}
+
+void lz77_rgba_decompress_packed(
+    const uint8_t* src,
+    size_t          src_len,
+    uint32_t* dst_px,
+    size_t          dst_cap,
+    size_t* out_len)
+{
+    decompress_packed_impl<PACKED_MATCH_BYTES>(src, src_len, dst_px, dst_cap, DEFAULT_CONFIG, out_len, nullptr);
+}
+
+void lz77_rgba_decompress_level(
+    const uint8_t* src,
+    size_t          src_len,
+    uint32_t* dst_px,
+    size_t          dst_cap,
+    const lz77_params* params,
+    size_t* out_len)
+{
+    *out_len = 0;
+
+    PackedConfig cfg;
+    if (!packed_config(params, &cfg))
+        return;
+
+    if (cfg.matchBytes == 4)
+        decompress_packed_impl<4>(src, src_len, dst_px, dst_cap, cfg, out_len, nullptr);
+    else
+        decompress_packed_impl<3>(src, src_len, dst_px, dst_cap, cfg, out_len, nullptr);
+}
+
+// ============================================================
+// Kodowanie entropijne strumienia tokenów (lz77_entropy_encode, lz77_rgba_decompress_entropy).
+//
+// Pola tokenów formatu kompaktowego rozdzielane są na ENTROPY_STREAMS strumieni bajtów
+// o różnych rozkładach: bajty flag, liczniki serii, młodszy i starszy bajt offset-1
+// i długość-1 oraz cztery kanały bajtów pikseli literałów. Każdy strumień ma własny
+// kanoniczny kod Huffmana (długość kodu do HUFF_MAX_BITS — dekodowanie jedną tablicą)
+// i własny strumień bitów (LSB first). Dekoder odczytuje strumienie przeplatane, wprost
+// do pikseli: cztery kanały literału i cztery pola dopasowania to niezależne łańcuchy
+// zależności, więc ich odczyty z tablic nakładają się w potoku procesora.
+//
+// Blok zaczyna się bajtem ENTROPY_RAW (dalej strumień kompaktowy bez zmian — gdy kod
+// nie zmniejsza rozmiaru) lub ENTROPY_HUFFMAN:
+//   [uint32 tokens] i dla każdego strumienia [uint8 tryb]:
+//     HUFF_EMPTY  — strumień pusty
+//     HUFF_SINGLE — [uint8 symbol]; jedyny symbol, 0 bitów na wystąpienie
+//     HUFF_CODED  — [uint8 maxSymbol] [długości kodów symboli 0..maxSymbol po 4 bity,
+//                   młodsza połowa bajtu pierwsza] [uint32 bajty strumienia bitów]
+//   dalej strumienie bitów trybu HUFF_CODED w kolejności strumieni.
+// ============================================================
+static const uint32_t ENTROPY_STREAMS = 10;
+static const uint32_t ES_FLAGS = 0;        // bajty flag grup tokenów
+static const uint32_t ES_RUNS = 1;         // liczniki serii literałów (n-1)
+static const uint32_t ES_OFFSET_LO = 2;    // offset-1, bity 0..7
+static const uint32_t ES_OFFSET_HI = 3;    // offset-1, bity 8..15
+static const uint32_t ES_LENGTH_LO = 4;    // długość-1, bity 0..7
+static const uint32_t ES_LENGTH_HI = 5;    // długość-1, bity 8..15
+static const uint32_t ES_LITERAL = 6;      // 6..9 — bajty 0..3 pikseli literałów
+
+static const uint8_t ENTROPY_RAW = 0;
+static const uint8_t ENTROPY_HUFFMAN = 1;
+
+static const uint8_t HUFF_EMPTY = 0;
+static const uint8_t HUFF_SINGLE = 1;
+static const uint8_t HUFF_CODED = 2;
+
+static const uint32_t HUFF_SYMBOLS = 256;
+static const uint32_t HUFF_MAX_BITS = 11;
+static const uint32_t HUFF_TABLE_SIZE = 1u << HUFF_MAX_BITS;
+
+// Długości kodu Huffmana dla freq[HUFF_SYMBOLS] (co najmniej dwa symbole o freq > 0):
+// drzewo metodą dwóch kolejek na liściach posortowanych wg częstości. Gdy najdłuższy kod
+// przekracza HUFF_MAX_BITS, częstości są połowione (niezerowe zostają >= 1) i drzewo
+// budowane ponownie — przy samych jedynkach głębokość to co najwyżej 8.
+static void huff_build_lengths(const uint64_t* freq, uint8_t* lengths)
+{
+    uint32_t order[HUFF_SYMBOLS];
+    uint64_t scaled[HUFF_SYMBOLS];
+    uint32_t n = 0;
+    for (uint32_t s = 0; s < HUFF_SYMBOLS; s++) {
+        lengths[s] = 0;
+        scaled[s] = freq[s];
+        if (freq[s])
+            order[n++] = s;
+    }
+
+    uint64_t weight[2 * HUFF_SYMBOLS];
+    uint32_t parent[2 * HUFF_SYMBOLS];
+    uint32_t depth[2 * HUFF_SYMBOLS];
+    for (;;) {
+        std::sort(order, order + n, [&scaled](uint32_t a, uint32_t b) {
+            return scaled[a] < scaled[b] || (scaled[a] == scaled[b] && a < b);
+            });
+        for (uint32_t i = 0; i < n; i++)
+            weight[i] = scaled[order[i]];
+
+        // Węzły wewnętrzne powstają w kolejności niemalejących wag: [node, next) to kolejka.
+        uint32_t leaf = 0, node = n;
+        for (uint32_t next = n; next < 2 * n - 1; next++) {
+            uint32_t pick[2];
+            for (uint32_t j = 0; j < 2; j++)
+                pick[j] = (leaf < n && (node >= next || weight[leaf] <= weight[node])) ? leaf++ : node++;
+            weight[next] = weight[pick[0]] + weight[pick[1]];
+            parent[pick[0]] = parent[pick[1]] = next;
+        }
+
+        uint32_t maxDepth = 0;
+        depth[2 * n - 2] = 0;
+        for (uint32_t k = 2 * n - 2; k-- > 0;) {
+            depth[k] = depth[parent[k]] + 1;
+            if (k < n)
+                maxDepth = std::max(maxDepth, depth[k]);
+        }
+
+        if (maxDepth <= HUFF_MAX_BITS) {
+            for (uint32_t i = 0; i < n; i++)
+                lengths[order[i]] = (uint8_t)depth[i];
+            return;
+        }
+        for (uint32_t i = 0; i < n; i++)
+            scaled[order[i]] = (scaled[order[i]] + 1) >> 1;
+    }
+}
+
+// Kody kanoniczne (jak w Deflate) z odwróconą kolejnością bitów — strumień LSB first.
+static void huff_assign_codes(const uint8_t* lengths, uint16_t* codes)
+{
+    uint32_t count[HUFF_MAX_BITS + 1] = { 0 };
+    for (uint32_t s = 0; s < HUFF_SYMBOLS; s++)
+        count[lengths[s]]++;
+    count[0] = 0;
+
+    uint32_t next[HUFF_MAX_BITS + 1] = { 0 };
+    uint32_t code = 0;
+    for (uint32_t bits = 1; bits <= HUFF_MAX_BITS; bits++) {
+        code = (code + count[bits - 1]) << 1;
+        next[bits] = code;
+    }
+
+    for (uint32_t s = 0; s < HUFF_SYMBOLS; s++) {
+        uint32_t len = lengths[s];
+        if (len == 0)
+            continue;
+        uint32_t c = next[len]++;
+        uint32_t reversed = 0;
+        for (uint32_t b = 0; b < len; b++)
+            reversed |= ((c >> b) & 1u) << (len - 1 - b);
+        codes[s] = (uint16_t)reversed;
+    }
+}
+
+// Tablica dekodowania: HUFF_MAX_BITS najmłodszych bitów -> (symbol << 4) | długość kodu.
+// false dla kodu niepełnego lub nadmiarowego (suma Krafta różna od 1).
+static bool huff_build_table(const uint8_t* lengths, uint16_t* table)
 {
-    uint32_t rot = (p1 << 5) | (p1 >> 27);
-    return (p0 ^ rot) & HASH_MASK;
+    uint32_t kraft = 0;
+    for (uint32_t s = 0; s < HUFF_SYMBOLS; s++) {
+        if (lengths[s] > HUFF_MAX_BITS)
+            return false;
+        if (lengths[s])
+            kraft += HUFF_TABLE_SIZE >> lengths[s];
+    }
+    if (kraft != HUFF_TABLE_SIZE)
+        return false;
+
+    uint16_t codes[HUFF_SYMBOLS];
+    huff_assign_codes(lengths, codes);
+    for (uint32_t s = 0; s < HUFF_SYMBOLS; s++) {
+        uint32_t len = lengths[s];
+        if (len == 0)
+            continue;
+        for (uint32_t j = codes[s]; j < HUFF_TABLE_SIZE; j += 1u << len)
+            table[j] = (uint16_t)((s << 4) | len);
+    }
+    return true;
 }
 
-void lz77_rgba_compress(
-    const uint32_t* src_px,
-    size_t          src_count,
-    uint8_t* dst,
-    size_t          dst_cap,
-    void* work,
-    size_t          work_cap,
-    size_t* out_len)
+// Przejście po strumieniu formatu kompaktowego z wywołaniem v.match(offset-1, długość-1),
+// v.literals(n-1, piksele, n) i v.flags(bajt flag) dla każdej grupy. Bity tokenu
+// dopasowania ponad polami offsetu i długości są pomijane (jak w dekoderze).
+// false dla strumienia uciętego w środku tokenu.
+template <class Visitor>
+static bool packed_walk(const uint8_t* src, size_t src_len, const PackedConfig& cfg, Visitor& v)
 {
-    *out_len = 0;
-
-    if (dst_cap < TOKEN_SIZE)
-        return;
+    const uint32_t offsetMask = cfg.window - 1;
+    const uint32_t lengthMask = cfg.maxMatch - 1;
+    size_t pos = 0;
 
-    if (src_count == 0) {
-        *out_len = 0;
-        return;
-    }
+    while (pos < src_len) {
+        uint32_t flagByte = src[pos++];
+        uint32_t flags = flagByte;
+        uint32_t tokens = 0;
 
-    // Brak bufora roboczego lub zbyt mały: każdy piksel emitowany jako oddzielny literal.
-    // Strumień jest poprawny i dekompresuje się bez błędów, lecz bez kompresji.
-    if (work == nullptr || work_cap < WORK_NEED_BYTES) {
-        size_t out_bytes = 0;
-        for (size_t i = 0; i < src_count; i++) {
-            if (dst_cap - out_bytes < TOKEN_SIZE) {
-                *out_len = 0;
-                return;
+        for (; tokens < PACKED_GROUP_TOKENS && pos < src_len; tokens++, flags >>= 1) {
+            if (flags & 1u) {
+                if (src_len - pos < cfg.matchBytes)
+                    return false;
+                uint32_t m = (uint32_t)src[pos] | ((uint32_t)src[pos + 1] << 8) | ((uint32_t)src[pos + 2] << 16);
+                if (cfg.matchBytes == 4)
+                    m |= (uint32_t)src[pos + 3] << 24;
+                pos += cfg.matchBytes;
+                v.match(m & offsetMask, (m >> cfg.offsetBits) & lengthMask);
+            }
+            else {
+                uint32_t run = (uint32_t)src[pos] + 1;
+                if (src_len - pos - 1 < (size_t)run * sizeof(uint32_t))
+                    return false;
+                v.literals(src[pos], src + pos + 1, run);
+                pos += 1 + (size_t)run * sizeof(uint32_t);
             }
-            Token12* tok = reinterpret_cast<Token12*>(dst + out_bytes);
-            tok->offset_px = 0;
-            tok->length_px = 0;
-            tok->next_px = src_px[i];
-            out_bytes += TOKEN_SIZE;
         }
-        *out_len = out_bytes;
-        return;
+        if (tokens)
+            v.flags(flagByte, tokens);
     }
+    return true;
+}
 
-    // head[] wskazuje najnowszą pozycję dla każdego hashu; prev[] łączy starsze pozycje w łańcuch.
-    uint32_t* head = reinterpret_cast<uint32_t*>(work);
-    uint32_t* prev = head + HASH_SIZE;
+// Pierwsze przejście kodera: częstości symboli każdego strumienia i liczba tokenów.
+struct EntropyHistogram {
+    uint64_t freq[ENTROPY_STREAMS][HUFF_SYMBOLS];
+    uint64_t tokens;
 
-    // Wszystkie sloty head[] ustawione na INVALID_POS (0xFF..FF); prev[] nie wymaga inicjalizacji.
-    memset(head, 0xFF, WORK_HEAD_BYTES);
+    void flags(uint32_t flagByte, uint32_t count)
+    {
+        freq[ES_FLAGS][flagByte]++;
+        tokens += count;
+    }
 
-    size_t out_bytes = 0;
+    void match(uint32_t offset, uint32_t length)
+    {
+        freq[ES_OFFSET_LO][offset & 0xFF]++;
+        freq[ES_OFFSET_HI][offset >> 8]++;
+        freq[ES_LENGTH_LO][length & 0xFF]++;
+        freq[ES_LENGTH_HI][length >> 8]++;
+    }
 
-    size_t i = 0;
-    while (i < src_count) {
+    void literals(uint32_t runByte, const uint8_t* px, uint32_t count)
+    {
+        freq[ES_RUNS][runByte]++;
+        for (uint32_t i = 0; i < count; i++, px += 4) {
+            freq[ES_LITERAL][px[0]]++;
+            freq[ES_LITERAL + 1][px[1]]++;
+            freq[ES_LITERAL + 2][px[2]]++;
+            freq[ES_LITERAL + 3][px[3]]++;
+        }
+    }
+};
 
-        size_t remaining = src_count - i;
+// Kod jednego strumienia po pierwszym przejściu.
+struct EntropyCode {
+    uint8_t  mode;
+    uint8_t  maxSymbol;   // HUFF_SINGLE — jedyny symbol
+    uint8_t  lengths[HUFF_SYMBOLS];
+    uint16_t codes[HUFF_SYMBOLS];
+    uint64_t bytes;       // rozmiar strumienia bitów (HUFF_CODED)
+};
 
-        // Ostatni piksel nie ma sąsiada potrzebnego do obliczenia hashu, więc zawsze trafia jako literal.
-        if (remaining == 1) {
-            if (dst_cap - out_bytes < TOKEN_SIZE) {
-                *out_len = 0;
-                return;
-            }
-            Token12* tok = reinterpret_cast<Token12*>(dst + out_bytes);
-            tok->offset_px = 0;
-            tok->length_px = 0;
-            tok->next_px = src_px[i];
-            out_bytes += TOKEN_SIZE;
-            i++;
-            continue;
-        }
+struct BitWriter {
+    uint8_t* p;
+    uint64_t bits;
+    uint32_t count;
+};
 
-        // Odejmowanie 1: token zawsze przechowuje jawny piksel następujący po dopasowaniu (next_px),
-        // więc nie można dopasować do ostatniego piksela w oknie.
-        uint32_t maxMatch = (uint32_t)(remaining - 1);
-        if (maxMatch > MAX_MATCH_PX)
-            maxMatch = MAX_MATCH_PX;
+static inline void bit_put(BitWriter& w, uint32_t code, uint32_t len)
+{
+    w.bits |= (uint64_t)code << w.count;
+    w.count += len;
+    while (w.count >= 8) {
+        *w.p++ = (uint8_t)w.bits;
+        w.bits >>= 8;
+        w.count -= 8;
+    }
+}
 
-        uint32_t h = pixel_hash(src_px[i], src_px[i + 1]);
+static inline void bit_flush(BitWriter& w)
+{
+    if (w.count)
+        *w.p++ = (uint8_t)w.bits;
+    w.bits = 0;
+    w.count = 0;
+}
 
-        // Pozycje starsze niż WINDOW_PX od bieżącej są poza oknem i nie mogą być kandydatami.
-        uint32_t dictStart = (i >= WINDOW_PX) ? (uint32_t)(i - WINDOW_PX) : 0u;
+// Drugie przejście kodera: zapis kodów do strumieni bitów (dokładne rozmiary znane
+// z pierwszego przejścia, więc strumienie piszą wprost do swoich miejsc w dst).
+struct EntropyEmitter {
+    const EntropyCode* code;
+    BitWriter*         out;
 
-        uint32_t candidate = head[h];
+    inline void put(uint32_t stream, uint32_t symbol)
+    {
+        if (code[stream].mode == HUFF_CODED)
+            bit_put(out[stream], code[stream].codes[symbol], code[stream].lengths[symbol]);
+    }
 
-        uint32_t bestLen = 0;
-        uint32_t bestOff = 0;
+    void flags(uint32_t flagByte, uint32_t)
+    {
+        put(ES_FLAGS, flagByte);
+    }
 
-        uint32_t chainLeft = MAX_CANDIDATES;
+    void match(uint32_t offset, uint32_t length)
+    {
+        put(ES_OFFSET_LO, offset & 0xFF);
+        put(ES_OFFSET_HI, offset >> 8);
+        put(ES_LENGTH_LO, length & 0xFF);
+        put(ES_LENGTH_HI, length >> 8);
+    }
 
-        // Przeszukiwanie łańcucha hash: iteracja po kandydatach od najnowszego do najstarszego.
-        // Pętla kończy się po napotkaniu INVALID_POS, kandydata spoza okna lub wyczerpaniu limitu.
-        while (candidate != INVALID_POS && candidate >= dictStart && chainLeft > 0) {
+    void literals(uint32_t runByte, const uint8_t* px, uint32_t count)
+    {
+        put(ES_RUNS, runByte);
+        for (uint32_t i = 0; i < count; i++, px += 4) {
+            put(ES_LITERAL, px[0]);
+            put(ES_LITERAL + 1, px[1]);
+            put(ES_LITERAL + 2, px[2]);
+            put(ES_LITERAL + 3, px[3]);
+        }
+    }
+};
 
-            uint32_t offset = (uint32_t)i - candidate;
+static inline void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
 
-            const uint32_t* ptrA = src_px + i;
-            const uint32_t* ptrB = src_px + candidate;
-            uint32_t curLen = 0;
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
 
-            // Porównanie blokami 4 pikseli (odpowiednik instrukcji SSE2 pcmpeqd/pmovmskb w wersji ASM).
-            // Pętla blokowa przerywa się, gdy którykolwiek z czterech pikseli się różni.
-            while (curLen + 4 <= maxMatch) {
-                if (ptrA[curLen] == ptrB[curLen] &&
-                    ptrA[curLen + 1] == ptrB[curLen + 1] &&
-                    ptrA[curLen + 2] == ptrB[curLen + 2] &&
-                    ptrA[curLen + 3] == ptrB[curLen + 3])
-                {
-                    curLen += 4;
-                }
-                else {
-                    break;
-                }
-            }
-            // Ogon: mniej niż 4 piksele lub nieudany blok — kontynuacja skalarna piksel po pikselu.
-            while (curLen < maxMatch && ptrA[curLen] == ptrB[curLen])
-                curLen++;
+size_t lz77_entropy_bound(size_t src_len)
+{
+    return (src_len == SIZE_MAX) ? 0 : src_len + 1;
+}
 
-            if (curLen > bestLen) {
-                bestLen = curLen;
-                bestOff = offset;
-            }
+void lz77_entropy_encode(
+    const uint8_t* src,
+    size_t          src_len,
+    const lz77_params* params,
+    uint8_t* dst,
+    size_t          dst_cap,
+    size_t* out_len)
+{
+    *out_len = 0;
 
-            // Przejście do następnego kandydata przez tablicę prev[]; slot wyznaczany modulo WINDOW_PX.
-            uint32_t slot = candidate & (WINDOW_PX - 1);
-            candidate = prev[slot];
+    PackedConfig cfg = DEFAULT_CONFIG;
+    if (src == nullptr || dst == nullptr || src_len == 0 || (params != nullptr && !packed_config(params, &cfg)))
+        return;
+
+    // Histogramy (~20 KB) i kody (~8 KB) — w wywołaniu, bez alokacji.
+    EntropyHistogram hist;
+    memset(&hist, 0, sizeof(hist));
+    if (!packed_walk(src, src_len, cfg, hist))
+        return;
 
-            chainLeft--;
+    EntropyCode code[ENTROPY_STREAMS];
+    uint64_t total = 1 + 4;
+    for (uint32_t s = 0; s < ENTROPY_STREAMS; s++) {
+        EntropyCode& c = code[s];
+        const uint64_t* freq = hist.freq[s];
+        uint32_t used = 0, last = 0;
+        for (uint32_t sym = 0; sym < HUFF_SYMBOLS; sym++) {
+            if (freq[sym]) {
+                used++;
+                last = sym;
+            }
         }
 
-        if (dst_cap - out_bytes < TOKEN_SIZE) {
-            *out_len = 0;
-            return;
+        c.bytes = 0;
+        c.maxSymbol = (uint8_t)last;
+        if (used == 0) {
+            c.mode = HUFF_EMPTY;
+            total += 1;
+        }
+        else if (used == 1) {
+            c.mode = HUFF_SINGLE;
+            total += 2;
         }
+        else {
+            c.mode = HUFF_CODED;
+            huff_build_lengths(freq, c.lengths);
+            huff_assign_codes(c.lengths, c.codes);
+            uint64_t bits = 0;
+            for (uint32_t sym = 0; sym <= last; sym++)
+                bits += freq[sym] * c.lengths[sym];
+            c.bytes = (bits + 7) / 8;
+            total += 2 + (last + 2) / 2 + 4 + c.bytes;
+        }
+    }
 
-        // Dla dopasowania next_px to piksel tuż za skopiowanym ciągiem; dla literalu to sam piksel src[i].
-        uint32_t next_px;
-        if (bestLen > 0)
-            next_px = src_px[i + bestLen];
-        else
-            next_px = src_px[i];
+    // Kod nie zmniejsza bloku (np. same dopasowania o rozproszonych offsetach) — strumień bez zmian.
+    bool coded = total < (uint64_t)src_len + 1 && hist.tokens <= UINT32_MAX;
+    for (uint32_t s = 0; coded && s < ENTROPY_STREAMS; s++)
+        coded = code[s].bytes <= UINT32_MAX;
+    if (!coded) {
+        if (dst_cap < src_len + 1)
+            return;
+        dst[0] = ENTROPY_RAW;
+        memcpy(dst + 1, src, src_len);
+        *out_len = src_len + 1;
+        return;
+    }
+    if (total > dst_cap)
+        return;
 
-        Token12* tok = reinterpret_cast<Token12*>(dst + out_bytes);
-        tok->offset_px = bestOff;
-        tok->length_px = bestLen;
-        tok->next_px = next_px;
-        out_bytes += TOKEN_SIZE;
+    // Nagłówek, a za nim miejsca strumieni bitów w kolejności strumieni.
+    uint8_t* p = dst;
+    *p++ = ENTROPY_HUFFMAN;
+    put_u32(p, (uint32_t)hist.tokens);
+    p += 4;
+    for (uint32_t s = 0; s < ENTROPY_STREAMS; s++) {
+        const EntropyCode& c = code[s];
+        *p++ = c.mode;
+        if (c.mode == HUFF_SINGLE) {
+            *p++ = c.maxSymbol;
+        }
+        else if (c.mode == HUFF_CODED) {
+            *p++ = c.maxSymbol;
+            for (uint32_t sym = 0; sym <= c.maxSymbol; sym += 2) {
+                uint32_t hi = (sym + 1 <= c.maxSymbol) ? c.lengths[sym + 1] : 0;
+                *p++ = (uint8_t)(c.lengths[sym] | (hi << 4));
+            }
+            put_u32(p, (uint32_t)c.bytes);
+            p += 4;
+        }
+    }
+
+    BitWriter out[ENTROPY_STREAMS];
+    for (uint32_t s = 0; s < ENTROPY_STREAMS; s++) {
+        out[s] = BitWriter{ p, 0, 0 };
+        p += code[s].bytes;
+    }
 
-        // Aktualizacja tablic hash dla wszystkich pozycji objętych tokenem [i .. i+bestLen].
-        // Wstawianych jest bestLen+1 wpisów, by kolejne tokeny mogły odwoływać się do tych pozycji.
-        for (uint32_t k = 0; k <= bestLen; k++) {
-            uint32_t pos = (uint32_t)i + k;
+    EntropyEmitter emit{ code, out };
+    packed_walk(src, src_len, cfg, emit);
+    for (uint32_t s = 0; s < ENTROPY_STREAMS; s++)
+        bit_flush(out[s]);
 
-            // Para (src[pos], src[pos+1]) jest wymagana do obliczenia hashu; brak sąsiada kończy wstawianie.
-            if ((size_t)pos + 1 >= src_count)
-                break;
+    *out_len = (size_t)total;
+}
 
-            uint32_t nh = pixel_hash(src_px[pos], src_px[pos + 1]);
-            uint32_t slot = pos & (WINDOW_PX - 1);
+// Odczyt strumienia bitów LSB first z buforem 64-bitowym. Za końcem danych dopisywane są
+// zera (pad — ich liczba); odczyt któregoś z nich oznacza strumień uszkodzony (pad > count).
+struct BitReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t       bits;
+    uint32_t       count;
+    size_t         pad;
+};
 
-            prev[slot] = head[nh];
-            head[nh] = pos;
+static inline void bit_refill(BitReader& r)
+{
+    if (r.end - r.p >= 8) {
+        uint64_t v;
+        memcpy(&v, r.p, sizeof(v));
+        r.bits |= v << r.count;
+        r.p += (63 - r.count) >> 3;
+        r.count |= 56;
+    }
+    else {
+        while (r.count <= 56) {
+            if (r.p < r.end)
+                r.bits |= (uint64_t)*r.p++ << r.count;
+            else
+                r.pad += 8;
+            r.count += 8;
         }
-
-        i += bestLen + 1;
     }
+}
 
-    *out_len = out_bytes;
+static inline uint32_t huff_decode(BitReader& r, const uint16_t* table)
+{
+    if (r.count < HUFF_MAX_BITS)
+        bit_refill(r);
+    uint32_t e = table[r.bits & (HUFF_TABLE_SIZE - 1)];
+    uint32_t len = e & 15u;
+    r.bits >>= len;
+    r.count -= len;
+    return e >> 4;
 }
 
-void lz77_rgba_decompress(
+// Dekodowanie bloku zapisanego przez lz77_entropy_encode (sink — jak w decompress_packed_impl).
+static void decompress_entropy_impl(
     const uint8_t* src,
     size_t          src_len,
     uint32_t* dst_px,
     size_t          dst_cap,
-    size_t* out_len)
+    const PackedConfig& cfg,
+    size_t* out_len,
+    RowSink* sink)
 {
     *out_len = 0;
+    if (src_len == 0)
+        return;
 
-    size_t src_pos = 0;
-    size_t out_px = 0;
-
-    while (true) {
+    if (src[0] == ENTROPY_RAW) {
+        if (cfg.matchBytes == 4)
+            decompress_packed_impl<4>(src + 1, src_len - 1, dst_px, dst_cap, cfg, out_len, sink);
+        else
+            decompress_packed_impl<3>(src + 1, src_len - 1, dst_px, dst_cap, cfg, out_len, sink);
+        return;
+    }
+    if (src[0] != ENTROPY_HUFFMAN || src_len < 5)
+        return;
 
-        // Pętla kończy się, gdy w strumieniu nie ma już pełnego tokenu (12 bajtów).
-        if (src_pos + TOKEN_SIZE > src_len)
-            break;
+    // Tablice dekodowania wszystkich strumieni (40 KB) — na stosie wywołania.
+    uint16_t table[ENTROPY_STREAMS][HUFF_TABLE_SIZE];
+    BitReader reader[ENTROPY_STREAMS];
+    uint32_t streamBytes[ENTROPY_STREAMS];
 
-        const Token12* tok = reinterpret_cast<const Token12*>(src + src_pos);
-        uint32_t offset_px = tok->offset_px;
-        uint32_t length_px = tok->length_px;
-        uint32_t next_px = tok->next_px;
+    size_t pos = 1;
+    uint64_t tokens = get_u32(src + pos);
+    pos += 4;
 
-        src_pos += TOKEN_SIZE;
+    for (uint32_t s = 0; s < ENTROPY_STREAMS; s++) {
+        if (pos >= src_len)
+            return;
+        uint8_t mode = src[pos++];
+        streamBytes[s] = 0;
 
-        // Literal: oba pola offset i length równe zero — zapisywany jest wyłącznie piksel next_px.
-        if (offset_px == 0 && length_px == 0) {
-            if (out_px >= dst_cap) {
-                *out_len = 0;
-                return;
+        if (mode == HUFF_EMPTY || mode == HUFF_SINGLE) {
+            // Pusty strumień: każdy odczyt zużywa bit spoza danych — wykrywany jako pad.
+            uint16_t entry = 1;
+            if (mode == HUFF_SINGLE) {
+                if (pos >= src_len)
+                    return;
+                entry = (uint16_t)(src[pos++] << 4);
             }
-            dst_px[out_px++] = next_px;
-            continue;
+            for (uint32_t j = 0; j < HUFF_TABLE_SIZE; j++)
+                table[s][j] = entry;
         }
+        else if (mode == HUFF_CODED) {
+            if (pos >= src_len)
+                return;
+            uint32_t maxSymbol = src[pos++];
+            size_t packed = (maxSymbol + 2) / 2;
+            if (src_len - pos < packed + 4)
+                return;
 
-        // Dopasowanie wymaga miejsca na length_px skopiowanych pikseli oraz dodatkowego next_px.
-        if (out_px + length_px + 1 > dst_cap) {
-            *out_len = 0;
+            uint8_t lengths[HUFF_SYMBOLS] = { 0 };
+            for (uint32_t sym = 0; sym <= maxSymbol; sym++)
+                lengths[sym] = (src[pos + sym / 2] >> ((sym & 1) * 4)) & 15u;
+            pos += packed;
+            streamBytes[s] = get_u32(src + pos);
+            pos += 4;
+            if (!huff_build_table(lengths, table[s]))
+                return;
+        }
+        else {
             return;
         }
+    }
 
-        // offset_px == 0 przy length_px > 0 jest stanem nieprawidłowym — strumień uszkodzony.
-        if (offset_px == 0) {
-            *out_len = 0;
+    for (uint32_t s = 0; s < ENTROPY_STREAMS; s++) {
+        if (src_len - pos < streamBytes[s])
             return;
+        reader[s] = BitReader{ src + pos, src + pos + streamBytes[s], 0, 0, 0 };
+        pos += streamBytes[s];
+    }
+
+    const CopyMatchFn copyMatch = active_kernels().copyMatch;
+    size_t out_px = 0;
+
+    while (tokens > 0) {
+        uint32_t flags = huff_decode(reader[ES_FLAGS], table[ES_FLAGS]);
+        uint32_t group = (uint32_t)std::min<uint64_t>(tokens, PACKED_GROUP_TOKENS);
+        tokens -= group;
+
+        for (uint32_t k = 0; k < group; k++, flags >>= 1) {
+            if (flags & 1u) {
+                uint32_t offLo = huff_decode(reader[ES_OFFSET_LO], table[ES_OFFSET_LO]);
+                uint32_t offHi = huff_decode(reader[ES_OFFSET_HI], table[ES_OFFSET_HI]);
+                uint32_t lenLo = huff_decode(reader[ES_LENGTH_LO], table[ES_LENGTH_LO]);
+                uint32_t lenHi = huff_decode(reader[ES_LENGTH_HI], table[ES_LENGTH_HI]);
+                uint32_t offset_px = (offLo | (offHi << 8)) + 1;
+                uint32_t length_px = (lenLo | (lenHi << 8)) + 1;
+                size_t room = dst_cap - out_px;
+
+                if ((offset_px > out_px) | (length_px > room) | (offset_px > cfg.window) | (length_px > cfg.maxMatch))
+                    return;
+
+                copyMatch(dst_px + out_px, offset_px, length_px, room);
+                out_px += length_px;
+            }
+            else {
+                uint32_t run = huff_decode(reader[ES_RUNS], table[ES_RUNS]) + 1;
+                if (run > dst_cap - out_px)
+                    return;
+
+                uint32_t* d = dst_px + out_px;
+                for (uint32_t i = 0; i < run; i++) {
+                    uint32_t b0 = huff_decode(reader[ES_LITERAL], table[ES_LITERAL]);
+                    uint32_t b1 = huff_decode(reader[ES_LITERAL + 1], table[ES_LITERAL + 1]);
+                    uint32_t b2 = huff_decode(reader[ES_LITERAL + 2], table[ES_LITERAL + 2]);
+                    uint32_t b3 = huff_decode(reader[ES_LITERAL + 3], table[ES_LITERAL + 3]);
+                    d[i] = b0 | (b1 << 8) | (b2 << 16) | (b3 << 24);
+                }
+                out_px += run;
+            }
         }
 
-        // offset_px > out_px oznaczałoby odwołanie do obszaru jeszcze niezapisanego — strumień uszkodzony.
-        if (offset_px > out_px) {
-            *out_len = 0;
+        if (sink != nullptr && out_px >= sink->nextPx)
+            row_sink_flush(*sink, out_px);
+    }
+
+    for (uint32_t s = 0; s < ENTROPY_STREAMS; s++) {
+        if (reader[s].pad > reader[s].count)
             return;
-        }
+    }
+    *out_len = out_px;
+}
 
-        size_t src_start = out_px - offset_px;
-
-        // Wybór ścieżki kopiowania zależy od odległości między źródłem a miejscem zapisu:
-        //   offset_px >= 4: odstęp co najmniej 16 bajtów — pierwsze 16 bajtów nie nachodzi na zapis,
-        //                   co pozwala na bezpieczne kopiowanie blokami 4-pikselowymi (SSE2 movdqu w ASM).
-        //                   Późniejsze bloki mogą czytać już zapisane piksele — to zamierzona semantyka RLE.
-        //   offset_px < 4:  odstęp mniejszy niż 16 bajtów — wymagane kopiowanie skalarne piksel po pikselu,
-        //                   gdyż odczyt i zapis nachodzą na siebie od samego początku.
-        if (offset_px >= 4) {
-            const uint32_t* s = dst_px + src_start;
-            uint32_t* d = dst_px + out_px;
-            uint32_t bytes_to_copy = length_px * 4;
-            uint32_t byte_off = 0;
-
-            while (byte_off + 16 <= bytes_to_copy) {
-                uint32_t p0 = *reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(s) + byte_off);
-                uint32_t p1 = *reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(s) + byte_off + 4);
-                uint32_t p2 = *reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(s) + byte_off + 8);
-                uint32_t p3 = *reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(s) + byte_off + 12);
-                *reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(d) + byte_off) = p0;
-                *reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(d) + byte_off + 4) = p1;
-                *reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(d) + byte_off + 8) = p2;
-                *reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(d) + byte_off + 12) = p3;
-                byte_off += 16;
-            }
-            // Ogon poniżej 16 bajtów kopiowany po jednym pikselu (4 bajty).
-            while (byte_off < bytes_to_copy) {
-                uint32_t px = *reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(s) + byte_off);
-                *reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(d) + byte_off) = px;
-                byte_off += 4;
+static bool row_filters_valid(const uint8_t* row_filters, size_t rows)
+{
+    if (row_filters == nullptr)
+        return true;
+    for (size_t y = 0; y < rows; y++) {
+        if (row_filters[y] >= LZ77_FILTER_COUNT)
+            return false;
+    }
+    return true;
+}
+
+int lz77_filter_rows(
+    const uint32_t* src_px,
+    uint32_t* dst_px,
+    size_t          width,
+    size_t          rows,
+    uint32_t        filter,
+    uint32_t        transform,
+    uint8_t* row_filters)
+{
+    if (src_px == nullptr || dst_px == nullptr || src_px == dst_px || row_filters == nullptr || width == 0 ||
+        (filter >= LZ77_FILTER_COUNT && filter != LZ77_FILTER_ADAPTIVE) || transform > LZ77_TRANSFORM_YCOCG_R)
+        return 0;
+
+    const FilterRowFn filterRow = active_kernels().filterRow;
+    for (size_t y = 0; y < rows; y++) {
+        const uint32_t* cur = src_px + y * width;
+        const uint32_t* prior = y ? cur - width : nullptr;
+        uint32_t* out = dst_px + y * width;
+
+        uint32_t chosen = filter;
+        if (filter == LZ77_FILTER_ADAPTIVE) {
+            // Heurystyka PNG: filtr o najmniejszej sumie |reszt| w wierszu. W pierwszym
+            // wierszu UP daje to samo co NONE, a PAETH to samo co SUB — są pomijane.
+            uint64_t best = UINT64_MAX;
+            uint32_t last = LZ77_FILTER_NONE;
+            for (uint32_t f = 0; f < LZ77_FILTER_COUNT; f++) {
+                if (prior == nullptr && (f == LZ77_FILTER_UP || f == LZ77_FILTER_PAETH))
+                    continue;
+                uint64_t cost = filterRow(cur, prior, out, width, f, transform);
+                if (cost < best) {
+                    best = cost;
+                    chosen = f;
+                }
+                last = f;
             }
+            if (chosen != last)
+                filterRow(cur, prior, out, width, chosen, transform);
         }
         else {
-            // Kopiowanie skalarne: odczyt może wyprzedzać zapis o mniej niż 4 piksele,
-            // co realizuje poprawną semantykę run-length (powielanie wzorca in-place).
-            for (uint32_t k = 0; k < length_px; k++)
-                dst_px[out_px + k] = dst_px[src_start + k];
+            filterRow(cur, prior, out, width, filter, transform);
         }
+        row_filters[y] = (uint8_t)chosen;
+    }
+    return 1;
+}
 
-        out_px += length_px;
+int lz77_unfilter_rows(
+    uint32_t* px,
+    size_t          width,
+    size_t          rows,
+    uint32_t        transform,
+    const uint8_t* row_filters)
+{
+    if (px == nullptr || width == 0 || transform > LZ77_TRANSFORM_YCOCG_R || !row_filters_valid(row_filters, rows))
+        return 0;
 
-        // Piksel next_px zapisywany bezpośrednio po skopiowanym ciągu.
-        dst_px[out_px++] = next_px;
-    }
+    RowSink sink{ px, px, width, rows, transform, row_filters, active_kernels().unfilterRow, 0, width };
+    row_sink_flush(sink, rows * width);
+    return 1;
+}
 
-    *out_len = out_px;
+// Wspólna implementacja lz77_rgba_decompress_image i lz77_rgba_decompress_entropy
+// z filtrami wierszy (entropy — blok zapisany przez lz77_entropy_encode).
+static void decompress_image_impl(
+    const uint8_t* src,
+    size_t          src_len,
+    uint32_t* dst_px,
+    size_t          dst_cap,
+    uint32_t* work_px,
+    const PackedConfig& cfg,
+    size_t          width,
+    uint32_t        transform,
+    const uint8_t* row_filters,
+    size_t* out_len,
+    bool            entropy)
+{
+    *out_len = 0;
+
+    if (width == 0 || dst_cap % width != 0 ||
+        transform > LZ77_TRANSFORM_YCOCG_R || !row_filters_valid(row_filters, dst_cap / width))
+        return;
+
+    // Bez bufora reszt: dekodowanie do dst i odtworzenie wierszy w miejscu (drugi przebieg).
+    uint32_t* decoded = work_px ? work_px : dst_px;
+    RowSink sink{ decoded, dst_px, width, dst_cap / width, transform, row_filters, active_kernels().unfilterRow, 0, width };
+    RowSink* fused = work_px ? &sink : nullptr;
+
+    size_t decoded_px = 0;
+    if (entropy)
+        decompress_entropy_impl(src, src_len, decoded, dst_cap, cfg, &decoded_px, fused);
+    else if (cfg.matchBytes == 4)
+        decompress_packed_impl<4>(src, src_len, decoded, dst_cap, cfg, &decoded_px, fused);
+    else
+        decompress_packed_impl<3>(src, src_len, decoded, dst_cap, cfg, &decoded_px, fused);
+
+    // Obraz to pełne wiersze — strumień kończący się w środku wiersza jest uszkodzony.
+    if (decoded_px == 0 || decoded_px % width != 0)
+        return;
+    row_sink_flush(sink, decoded_px);
+    *out_len = decoded_px;
+}
+
+void lz77_rgba_decompress_image(
+    const uint8_t* src,
+    size_t          src_len,
+    uint32_t* dst_px,
+    size_t          dst_cap,
+    uint32_t* work_px,
+    const lz77_params* params,
+    size_t          width,
+    uint32_t        transform,
+    const uint8_t* row_filters,
+    size_t* out_len)
+{
+    *out_len = 0;
+
+    PackedConfig cfg = DEFAULT_CONFIG;
+    if (params != nullptr && !packed_config(params, &cfg))
+        return;
+
+    decompress_image_impl(src, src_len, dst_px, dst_cap, work_px, cfg, width, transform, row_filters, out_len, false);
+}
+
+void lz77_rgba_decompress_entropy(
+    const uint8_t* src,
+    size_t          src_len,
+    uint32_t* dst_px,
+    size_t          dst_cap,
+    uint32_t* work_px,
+    const lz77_params* params,
+    size_t          width,
+    uint32_t        transform,
+    const uint8_t* row_filters,
+    size_t* out_len)
+{
+    *out_len = 0;
+
+    PackedConfig cfg = DEFAULT_CONFIG;
+    if (params != nullptr && !packed_config(params, &cfg))
+        return;
+
+    // Bez filtrów wierszy — samo dekodowanie (width bez znaczenia).
+    if (transform == LZ77_TRANSFORM_NONE && row_filters == nullptr)
+        decompress_entropy_impl(src, src_len, dst_px, dst_cap, cfg, out_len, nullptr);
+    else
+        decompress_image_impl(src, src_len, dst_px, dst_cap, work_px, cfg, width, transform, row_filters, out_len, true);
 }
\ No newline at end of file
@@ -10,6 +10,17 @@
 
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
+
+/*
+ * LZ77_API  eksport funkcji z CppDll.dll (Windows). W bibliotece przenosnej
+ * (CMake: lz77core, LZ77_STATIC) oraz poza Windows makro jest puste.
+ */
+#if defined(_WIN32) && !defined(LZ77_STATIC)
+#define LZ77_API __declspec(dllexport)
+#else
+#define LZ77_API
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,11 +36,12 @@ extern "C" {
      *   src_count  liczba pikseli wejsciowych
      *   dst        wyjscie: bufor na skompresowane tokeny
      *   dst_cap    pojemnosc bufora wyjsciowego w bajtach
-     *   work       bufor roboczy (min. LZ77_WORK_NEED_BYTES)
+     *   work       bufor roboczy (min. lz77_work_bytes(src_count, NULL);
+     *               LZ77_WORK_NEED_BYTES wystarcza dla kazdego src_count)
      *   work_cap   pojemnosc bufora roboczego w bajtach
      *   out_len    [out] liczba zapisanych bajtow (0 = blad lub brak wejscia)
      */
-    __declspec(dllexport)
+    LZ77_API
         void lz77_rgba_compress(
             const uint32_t* src_px,
             size_t          src_count,
@@ -52,7 +64,7 @@ extern "C" {
      *   dst_cap  pojemnosc bufora wyjsciowego w pikselach
      *   out_len  [out] liczba zdekompresowanych pikseli (0 = blad)
      */
-    __declspec(dllexport)
+    LZ77_API
         void lz77_rgba_decompress(
             const uint8_t* src,
             size_t          src_len,
@@ -61,16 +73,609 @@ extern "C" {
             size_t* out_len
         );
 
+    /*
+     * lz77_rgba_compress_packed
+     *
+     * Kompresuje tablice pikseli RGBA do kompaktowego strumienia tokenow (LZ77_FORMAT_PACKED).
+     * Parametry i zachowanie jak w lz77_rgba_compress.
+     *
+     * Uklad strumienia:
+     *   [flagi:u8] [token 0] ... [token 7] [flagi:u8] [token 8] ...
+     *   bit k bajtu flag (od najmlodszego) opisuje token k w grupie:
+     *     1 = dopasowanie: 3 bajty LE, bity 0..11 = offset-1, bity 12..17 = dlugosc-1, bity 18..23 = 0
+     *     0 = seria literalow: [n-1:u8] i n surowych pikseli (n = 1..256)
+     *   Ostatnia grupa moze zawierac mniej niz 8 tokenow; strumien konczy sie wraz z danymi.
+     *
+     * Najgorszy przypadek (same literaly): ok. 4 bajty na piksel + 1 bajt na 256 pikseli.
+     */
+    LZ77_API
+        void lz77_rgba_compress_packed(
+            const uint32_t* src_px,
+            size_t          src_count,
+            uint8_t* dst,
+            size_t          dst_cap,
+            void* work,
+            size_t          work_cap,
+            size_t* out_len
+        );
+
+    /*
+     * lz77_stats  liczniki jednego wywolania kompresji (lz77_rgba_compress_packed_stats):
+     *   literal_px    piksele zapisane jako literaly
+     *   literal_runs  liczba serii literalow (tokenow literalowych)
+     *   matches       liczba tokenow dopasowan
+     *   match_px      piksele pokryte dopasowaniami (srednia dlugosc = match_px / matches)
+     *   chain_walks   liczba kandydatow odwiedzonych w lancuchach hash
+     */
+    typedef struct lz77_stats {
+        uint64_t literal_px;
+        uint64_t literal_runs;
+        uint64_t matches;
+        uint64_t match_px;
+        uint64_t chain_walks;
+    } lz77_stats;
+
+    /*
+     * lz77_rgba_compress_packed_stats
+     *
+     * Jak lz77_rgba_compress_packed (wynik identyczny bajt w bajt), dodatkowo
+     * wypelnia *stats (moze byc NULL). Tylko CppDll.dll  AsmDll.dll nie
+     * eksportuje tej funkcji.
+     */
+    LZ77_API
+        void lz77_rgba_compress_packed_stats(
+            const uint32_t* src_px,
+            size_t          src_count,
+            uint8_t* dst,
+            size_t          dst_cap,
+            void* work,
+            size_t          work_cap,
+            size_t* out_len,
+            lz77_stats* stats
+        );
+
+    /*
+     * lz77_rgba_decompress_packed
+     *
+     * Dekompresuje strumien w formacie LZ77_FORMAT_PACKED. Parametry jak w lz77_rgba_decompress.
+     */
+    LZ77_API
+        void lz77_rgba_decompress_packed(
+            const uint8_t* src,
+            size_t          src_len,
+            uint32_t* dst_px,
+            size_t          dst_cap,
+            size_t* out_len
+        );
+
+    /*
+     * lz77_params  parametry poziomu kompresji (lz77_rgba_compress_level):
+     *   window_px     rozmiar okna w pikselach (potega 2, 256..65536)
+     *   max_match_px  maks. dlugosc dopasowania (potega 2, 2..65536)
+     *   max_chain     maks. liczba kandydatow lancucha hash (1..65536); tylko koder
+     *   level         numer presetu (LZ77_LEVEL_*) lub 0 dla parametrow wlasnych;
+     *                  tylko informacyjnie, zapisywany w naglowku pliku
+     *   parse         sposob wyboru dopasowan (LZ77_PARSE_*); tylko koder
+     *
+     * Uklad strumienia jak w lz77_rgba_compress_packed, z polami tokenu dopasowania
+     * o szerokosci log2(window_px) bitow (offset-1) i log2(max_match_px) bitow
+     * (dlugosc-1); token zajmuje 3 bajty, gdy pola mieszcza sie w 24 bitach, inaczej 4.
+     * Dla window_px = 4096 i max_match_px = 64 strumien jest identyczny
+     * z LZ77_FORMAT_PACKED.
+     */
+    typedef struct lz77_params {
+        uint32_t window_px;
+        uint32_t max_match_px;
+        uint32_t max_chain;
+        uint32_t level;
+        uint32_t parse;
+    } lz77_params;
+
+    /*
+     * Sposoby wyboru dopasowan (lz77_params.parse). Wszystkie daja strumien tego samego
+     * formatu  dekoder i szybkosc dekompresji sie nie zmieniaja.
+     *   LZ77_PARSE_GREEDY   najdluzsze dopasowanie na biezacej pozycji
+     *   LZ77_PARSE_LAZY     przed zapisem dopasowania sprawdzana jest pozycja o 1 przed
+     *                        jego koncem; gdy token zaczety tam siega dalej niz token
+     *                        zaczety na koncu, dopasowanie jest skracane
+     *   LZ77_PARSE_LAZY2    jak LAZY, z pozycjami o 1 i 2 przed koncem dopasowania
+     *   LZ77_PARSE_OPTIMAL  programowanie dynamiczne minimalizujace rozmiar strumienia
+     *                        w segmentach po 16384 piksele
+     */
+    static const uint32_t LZ77_PARSE_GREEDY = 0;
+    static const uint32_t LZ77_PARSE_LAZY = 1;
+    static const uint32_t LZ77_PARSE_LAZY2 = 2;
+    static const uint32_t LZ77_PARSE_OPTIMAL = 3;
+
+    /*
+     * Poziomy kompresji (lz77_level_params):
+     *   1 fast    okno 4096,  dopasowanie do 64,    lancuch 1,    greedy
+     *   2 normal  okno 4096,  dopasowanie do 64,    lancuch 32,   greedy (= lz77_rgba_compress_packed)
+     *   3 high    okno 16384, dopasowanie do 256,   lancuch 64,   lazy
+     *   4 max     okno 32768, dopasowanie do 4096,  lancuch 256,  lazy2
+     *   5 ultra   okno 65536, dopasowanie do 65536, lancuch 1024, optimal
+     */
+    static const int LZ77_LEVEL_MIN = 1;
+    static const int LZ77_LEVEL_DEFAULT = 2;
+    static const int LZ77_LEVEL_MAX = 5;
+
+    /*
+     * lz77_level_params
+     *
+     * Wypelnia *out parametrami poziomu level. Zwraca 1, lub 0 dla poziomu spoza zakresu.
+     */
+    LZ77_API
+        int lz77_level_params(int level, lz77_params* out);
+
+    /*
+     * lz77_params_valid
+     *
+     * Zwraca 1, gdy parametry mieszcza sie w zakresach opisanych przy lz77_params.
+     */
+    LZ77_API
+        int lz77_params_valid(const lz77_params* params);
+
+    /*
+     * lz77_params_work_bytes
+     *
+     * Rozmiar bufora roboczego dla parametrow: head[65536] + prev[window_px] wpisow uint32_t
+     * (272 KB dla okna 4096, 512 KB dla okna 65536); dla LZ77_PARSE_OPTIMAL dodatkowo
+     * ok. 500 KB tablic segmentu. 0 dla nieprawidlowych parametrow.
+     */
+    LZ77_API
+        size_t lz77_params_work_bytes(const lz77_params* params);
+
+    /*
+     * lz77_rgba_compress_level
+     *
+     * Jak lz77_rgba_compress_packed_stats, z oknem, dlugoscia dopasowan, glebokoscia
+     * lancucha i sposobem wyboru dopasowan z *params. Nieprawidlowe parametry  *out_len = 0. Bufor roboczy mniejszy
+     * niz lz77_params_work_bytes  strumien z samych literalow. stats moze byc NULL.
+     * Tylko CppDll.dll  AsmDll.dll nie eksportuje tej funkcji.
+     */
+    LZ77_API
+        void lz77_rgba_compress_level(
+            const uint32_t* src_px,
+            size_t          src_count,
+            uint8_t* dst,
+            size_t          dst_cap,
+            void* work,
+            size_t          work_cap,
+            const lz77_params* params,
+            size_t* out_len,
+            lz77_stats* stats
+        );
+
+    /*
+     * lz77_rgba_decompress_level
+     *
+     * Dekompresuje strumien zapisany przez lz77_rgba_compress_level z tymi samymi
+     * window_px i max_match_px (max_chain i parse nie maja znaczenia). Parametry jak
+     * w lz77_rgba_decompress; nieprawidlowe parametry  *out_len = 0.
+     */
+    LZ77_API
+        void lz77_rgba_decompress_level(
+            const uint8_t* src,
+            size_t          src_len,
+            uint32_t* dst_px,
+            size_t          dst_cap,
+            const lz77_params* params,
+            size_t* out_len
+        );
+
+    /*
+     * lz77_rgba_compress_image
+     *
+     * Jak lz77_rgba_compress_level (params == NULL  parametry LZ77_FORMAT_PACKED, jak
+     * lz77_rgba_compress_packed_stats) dla src_count pikseli obrazu o szerokosci width
+     * (wiersze kolejno, bez odstepow). Oprocz kandydatow lancucha hash na kazdej pozycji
+     * sprawdzane sa piksele z poprzednich wierszy: offset width (nad), width + 1 (nad-lewo),
+     * width - 1 (nad-prawo) i 2 * width (dwa wiersze wyzej)  o ile mieszcza sie w oknie
+     * window_px. Okno 65536 obejmuje wiec dwa wiersze obrazu o szerokosci do 32768.
+     * Strumien ma ten sam format co lz77_rgba_compress_level  dekompresja przez
+     * lz77_rgba_decompress_level (lub lz77_rgba_decompress_packed dla params == NULL).
+     * width == 0  kompresja bez kandydatow z wierszy. Tylko CppDll.dll.
+     */
+    LZ77_API
+        void lz77_rgba_compress_image(
+            const uint32_t* src_px,
+            size_t          src_count,
+            size_t          width,
+            uint8_t* dst,
+            size_t          dst_cap,
+            void* work,
+            size_t          work_cap,
+            const lz77_params* params,
+            size_t* out_len,
+            lz77_stats* stats
+        );
+
+    /*
+     * Poziomy jader SIMD (porownanie dopasowan w kompresji, kopiowanie dopasowan w dekompresji):
+     *   LZ77_SIMD_SCALAR  bez SIMD (procesory inne niz x64)
+     *   LZ77_SIMD_SSE2    4 piksele / 16 B na instrukcje (jak AsmDll.dll)
+     *   LZ77_SIMD_AVX2    8 pikseli / 32 B
+     *   LZ77_SIMD_AVX512  16 pikseli / 64 B
+     * Poziom wybierany jest przy ladowaniu biblioteki (CPUID i XGETBV) jako najwyzszy
+     * obslugiwany przez procesor i system. Strumien wyjsciowy nie zalezy od poziomu.
+     */
+    static const int LZ77_SIMD_SCALAR = 0;
+    static const int LZ77_SIMD_SSE2 = 1;
+    static const int LZ77_SIMD_AVX2 = 2;
+    static const int LZ77_SIMD_AVX512 = 3;
+
+    /*
+     * lz77_cpu_simd_level  najwyzszy poziom LZ77_SIMD_* obslugiwany na tej maszynie.
+     * lz77_simd_level      poziom uzywany przez funkcje kompresji i dekompresji
+     *                       w biezacym watku.
+     */
+    LZ77_API
+        int lz77_cpu_simd_level(void);
+    LZ77_API
+        int lz77_simd_level(void);
+
+    /*
+     * lz77_set_simd_level
+     *
+     * Wymusza nizszy poziom jader (porownania w benchmarku, testy). Poziom powyzej
+     * lz77_cpu_simd_level lub ujemny przywraca wybor automatyczny. Zwraca ustawiony poziom.
+     * Zmiana w trakcie trwajacych wywolan jest bezpieczna  wynik nie zalezy od poziomu.
+     */
+    LZ77_API
+        int lz77_set_simd_level(int level);
+
+    /*
+     * lz77_set_thread_simd_level
+     *
+     * Jak lz77_set_simd_level, lecz tylko dla wywolan z biezacego watku  rownolegle
+     * partie z roznymi poziomami (Logic.dll) nie nadpisuja sobie wyboru. Ujemny level
+     * przywraca poziom procesu. Zwraca poziom obowiazujacy w watku.
+     */
+    LZ77_API
+        int lz77_set_thread_simd_level(int level);
+
+    /*
+     * Struktury wyszukiwania dopasowan w kompresji (lz77_rgba_compress_ex, lz77_stream_begin_ex):
+     *   LZ77_MATCH_FINDER_CHAIN   lancuchy hash head[] / prev[]; glebokosc do max_chain
+     *   LZ77_MATCH_FINDER_BUCKET  kubelki po 8 pozycji w jednej linii 64 B, z odciskiem
+     *                              4 pikseli; piksele czytane tylko dla zgodnych odciskow,
+     *                              glebokosc najwyzej 8 kandydatow
+     * Format strumienia nie zalezy od struktury (dekompresja bez zmian), ale same bajty
+     * wyjscia i stopien kompresji  tak. Bufor z lz77_params_work_bytes i lz77_work_bytes
+     * wystarcza dla obu. Pozostale funkcje kompresji uzywaja LZ77_MATCH_FINDER_CHAIN.
+     */
+    static const int LZ77_MATCH_FINDER_CHAIN = 0;
+    static const int LZ77_MATCH_FINDER_BUCKET = 1;
+
+    /*
+     * lz77_rgba_compress_ex
+     *
+     * Jak lz77_rgba_compress_image ze struktura wyszukiwania dopasowan wybrana dla tego
+     * wywolania: finder = LZ77_MATCH_FINDER_*, inna wartosc  LZ77_MATCH_FINDER_CHAIN
+     * (wynik identyczny z lz77_rgba_compress_image). width == 0 i params == NULL daje strumien
+     * LZ77_FORMAT_PACKED jak lz77_rgba_compress_packed_stats. Bufor roboczy jak dla
+     * lz77_rgba_compress_image. Tylko CppDll.dll.
+     */
+    LZ77_API
+        void lz77_rgba_compress_ex(
+            const uint32_t* src_px,
+            size_t          src_count,
+            size_t          width,
+            uint8_t* dst,
+            size_t          dst_cap,
+            void* work,
+            size_t          work_cap,
+            const lz77_params* params,
+            int             finder,
+            size_t* out_len,
+            lz77_stats* stats
+        );
+
+    /*
+     * Wersje formatu strumienia tokenow (zapisywane w naglowku pliku .lz77):
+     *   LZ77_FORMAT_TOKEN12    stale tokeny 12-bajtowe (lz77_rgba_compress)
+     *   LZ77_FORMAT_PACKED     format kompaktowy (lz77_rgba_compress_packed)
+     *   LZ77_FORMAT_PACKED_EX  format kompaktowy z parametrami poziomu zapisanymi
+     *                           w naglowku pliku (lz77_rgba_compress_level)
+     */
+    static const uint16_t LZ77_FORMAT_TOKEN12 = 1;
+    static const uint16_t LZ77_FORMAT_PACKED = 2;
+    static const uint16_t LZ77_FORMAT_PACKED_EX = 3;
+
     /*
      * LZ77_WORK_NEED_BYTES
      *
-     * Minimalny rozmiar bufora roboczego wymaganego przez lz77_rgba_compress:
+     * Rozmiar bufora roboczego wystarczajacy dla lz77_rgba_compress i formatu
+     * kompaktowego przy dowolnej liczbie pikseli (i wymagany przez kod ASM):
      *   head[65536 wpisow] = 256 KB
      *   prev[ 4096 wpisow] =  16 KB
      *   Razem             = 272 KB
+     * Faktyczne wymaganie dla danego wejscia podaje lz77_work_bytes.
      */
     static const size_t LZ77_WORK_NEED_BYTES = (65536u + 4096u) * sizeof(uint32_t);
 
+    /*
+     * lz77_work_bytes
+     *
+     * Faktyczny rozmiar bufora roboczego kompresji src_count pikseli
+     * (lz77_rgba_compress, *_packed, *_level, *_image). Tablica head[]
+     * rosnie z wejsciem (ok. 2 wpisy na piksel, od 256 do 65536 wpisow),
+     * a prev[] ma najwyzej src_count wpisow - kompresor czysci przy kazdym
+     * wywolaniu tylko tyle, ile zajmuje head[], zamiast stalych 256 KB.
+     * Wyjatek: lz77_rgba_compress zawsze uzywa pelnej tablicy (65536 wpisow,
+     * hash jak w AsmDll.dll - identyczny strumien Token12), wiec dla
+     * params == NULL wynik obejmuje pelna tablice head[].
+     * Nigdy wiecej niz lz77_params_work_bytes (params == NULL: LZ77_WORK_NEED_BYTES).
+     * Zwraca 0 dla niepoprawnych parametrow.
+     */
+    LZ77_API
+        size_t lz77_work_bytes(size_t src_count, const lz77_params* params);
+
+    /*
+     * lz77_compress_bound
+     *
+     * Najwiekszy rozmiar strumienia (w bajtach) dla src_count pikseli w formacie format
+     * (LZ77_FORMAT_*); bufor dst o tej pojemnosci zawsze wystarcza. Granica jest osiagana
+     * (dane nieskompresowalne):
+     *   LZ77_FORMAT_TOKEN12             12 B na piksel (kazdy token obejmuje co najmniej 1 piksel)
+     *   LZ77_FORMAT_PACKED / PACKED_EX  same literaly: 4 B na piksel, 1 B licznika na kazde
+     *                                    256 pikseli i 1 B flag na kazde 8 serii; dopasowanie
+     *                                    (do 4 B, co najmniej 2 piksele) jest zawsze krotsze,
+     *                                    wiec granica nie zalezy od lz77_params
+     * Zwraca 0 dla nieznanego formatu lub gdy wynik nie miesci sie w size_t.
+     */
+    LZ77_API
+        size_t lz77_compress_bound(uint16_t format, size_t src_count);
+
+    /*
+     * Kompresja strumieniowa (format kompaktowy)  wyjscie zapisywane w kolejnych fragmentach
+     * dowolnej wielkosci zamiast jednego bufora na najgorszy przypadek:
+     *
+     *   lz77_stream_begin(work, work_cap, src_px, src_count, params);
+     *   do {
+     *       rc = lz77_stream_compress(work, chunk, chunk_cap, &len, stats);
+     *       ... zapis len bajtow chunk ...
+     *   } while (rc == LZ77_STREAM_NEED_OUTPUT);
+     *
+     * Polaczone fragmenty sa identyczne bajt w bajt z wynikiem lz77_rgba_compress_level
+     * (params) lub lz77_rgba_compress_packed (params == NULL). Stan kompresji lezy w buforze
+     * roboczym  src_px i work musza pozostac niezmienione do LZ77_STREAM_DONE. Biblioteka
+     * nie alokuje pamieci. Tylko CppDll.dll  AsmDll.dll nie eksportuje tych funkcji.
+     *
+     * Wyniki lz77_stream_compress:
+     *   LZ77_STREAM_DONE         strumien zakonczony (len moze byc 0); stats wypelnione
+     *   LZ77_STREAM_NEED_OUTPUT  fragment pelny (len == chunk_cap) lub brak gotowych bajtow
+     *                             przy chunk_cap == 0; wywolac ponownie z nowym fragmentem
+     *   LZ77_STREAM_ERROR        work bez lz77_stream_begin lub strumien juz zakonczony
+     */
+    static const int LZ77_STREAM_DONE = 0;
+    static const int LZ77_STREAM_NEED_OUTPUT = 1;
+    static const int LZ77_STREAM_ERROR = -1;
+
+    /*
+     * lz77_stream_work_bytes
+     *
+     * Rozmiar bufora roboczego kompresji strumieniowej: stan kodera z buforem posrednim
+     * (ok. 17 KB) i tablice jak lz77_params_work_bytes. params == NULL  format
+     * LZ77_FORMAT_PACKED. 0 dla nieprawidlowych parametrow.
+     */
+    LZ77_API
+        size_t lz77_stream_work_bytes(const lz77_params* params);
+
+    /*
+     * lz77_stream_begin
+     *
+     * Rozpoczyna kompresje src_count pikseli src_px. Zwraca 1, lub 0 dla nieprawidlowych
+     * parametrow albo bufora roboczego mniejszego niz lz77_stream_work_bytes.
+     */
+    LZ77_API
+        int lz77_stream_begin(
+            void* work,
+            size_t          work_cap,
+            const uint32_t* src_px,
+            size_t          src_count,
+            const lz77_params* params
+        );
+
+    /*
+     * lz77_stream_begin_image
+     *
+     * Jak lz77_stream_begin dla obrazu o szerokosci width  koder sprawdza kandydatow
+     * z poprzednich wierszy jak lz77_rgba_compress_image, a polaczone fragmenty sa
+     * identyczne z jego wynikiem. Bufor roboczy jak dla lz77_stream_begin.
+     */
+    LZ77_API
+        int lz77_stream_begin_image(
+            void* work,
+            size_t          work_cap,
+            const uint32_t* src_px,
+            size_t          src_count,
+            size_t          width,
+            const lz77_params* params
+        );
+
+    /*
+     * lz77_stream_begin_ex
+     *
+     * Jak lz77_stream_begin_image ze struktura wyszukiwania finder (jak w lz77_rgba_compress_ex)
+     * zapamietana w stanie strumienia  polaczone fragmenty sa identyczne z wynikiem
+     * lz77_rgba_compress_ex. Bufor roboczy jak dla lz77_stream_begin.
+     */
+    LZ77_API
+        int lz77_stream_begin_ex(
+            void* work,
+            size_t          work_cap,
+            const uint32_t* src_px,
+            size_t          src_count,
+            size_t          width,
+            const lz77_params* params,
+            int             finder
+        );
+
+    /*
+     * lz77_stream_compress
+     *
+     * Zapisuje kolejne bajty strumienia do dst (najwyzej dst_cap); *out_len  liczba
+     * zapisanych bajtow. Zwraca LZ77_STREAM_*; stats (moze byc NULL) wypelniane przy
+     * LZ77_STREAM_DONE.
+     */
+    LZ77_API
+        int lz77_stream_compress(
+            void* work,
+            uint8_t* dst,
+            size_t          dst_cap,
+            size_t* out_len,
+            lz77_stats* stats
+        );
+
+    /*
+     * Filtry wierszy  odwracalny etap przed kompresja (lz77_filter_rows) i po dekompresji
+     * (lz77_unfilter_rows, lz77_rgba_decompress_image). Zdjecia rzadko zawieraja dokladnie
+     * powtorzone piksele; reszty predykcji gladkich obszarow  tak.
+     *
+     * Predyktory PNG, na kazdym bajcie piksela osobno (modulo 256):
+     *   LZ77_FILTER_NONE     bez predykcji
+     *   LZ77_FILTER_SUB      piksel z lewej
+     *   LZ77_FILTER_UP       piksel powyzej
+     *   LZ77_FILTER_AVERAGE  (lewy + gorny) / 2, zaokraglone w dol
+     *   LZ77_FILTER_PAETH    predyktor Paetha (lewy, gorny, gorny-lewy)
+     *   LZ77_FILTER_ADAPTIVE  tylko lz77_filter_rows: filtr wybierany dla kazdego wiersza
+     *                          (najmniejsza suma |reszt|, jak w PNG)
+     * Pierwszy wiersz wywolania nie ma wiersza powyzej (wiersz zer), wiec bloki obrazu
+     * filtrowane osobno dekompresuja sie niezaleznie.
+     *
+     * Transformacja kolorow (po predykcji, na resztach):
+     *   LZ77_TRANSFORM_NONE     bez transformacji
+     *   LZ77_TRANSFORM_YCOCG_R  bezstratna YCoCg-R na bajtach B, G, R (alfa bez zmian):
+     *                            bajt 0 = Co, bajt 1 = Y, bajt 2 = Cg
+     */
+    static const uint32_t LZ77_FILTER_NONE = 0;
+    static const uint32_t LZ77_FILTER_SUB = 1;
+    static const uint32_t LZ77_FILTER_UP = 2;
+    static const uint32_t LZ77_FILTER_AVERAGE = 3;
+    static const uint32_t LZ77_FILTER_PAETH = 4;
+    static const uint32_t LZ77_FILTER_COUNT = 5;
+    static const uint32_t LZ77_FILTER_ADAPTIVE = 0xFF;
+
+    static const uint32_t LZ77_TRANSFORM_NONE = 0;
+    static const uint32_t LZ77_TRANSFORM_YCOCG_R = 1;
+
+    /*
+     * lz77_filter_rows
+     *
+     * Filtruje rows wierszy po width pikseli z src_px do dst_px (osobne bufory) filtrem
+     * filter (LZ77_FILTER_*) i transformacja transform (LZ77_TRANSFORM_*); row_filters[rows]
+     *  [out] filtr kazdego wiersza (do zapisu w kontenerze). Wynik kompresowac dowolna
+     * funkcja lz77_rgba_compress_*. Zwraca 1, lub 0 dla nieprawidlowych argumentow.
+     * Jadro SSE2 wg lz77_simd_level; wynik nie zalezy od poziomu SIMD.
+     */
+    LZ77_API
+        int lz77_filter_rows(
+            const uint32_t* src_px,
+            uint32_t* dst_px,
+            size_t          width,
+            size_t          rows,
+            uint32_t        filter,
+            uint32_t        transform,
+            uint8_t* row_filters
+        );
+
+    /*
+     * lz77_unfilter_rows
+     *
+     * Odwraca lz77_filter_rows w miejscu (px  zdekompresowane reszty). row_filters == NULL
+     *  wszystkie wiersze LZ77_FILTER_NONE (sama transformacja). Zwraca 0 dla nieznanego
+     * filtra lub transformacji.
+     */
+    LZ77_API
+        int lz77_unfilter_rows(
+            uint32_t* px,
+            size_t          width,
+            size_t          rows,
+            uint32_t        transform,
+            const uint8_t* row_filters
+        );
+
+    /*
+     * lz77_rgba_decompress_image
+     *
+     * Dekompresja strumienia formatu kompaktowego (params jak w lz77_rgba_compress_image)
+     * polaczona z odwroceniem filtrow: dekoder zapisuje reszty do work_px (dst_cap pikseli),
+     * a kazdy kompletny wiersz jest odtwarzany do dst_px zaraz po zdekodowaniu  koszt
+     * to jeden dodatkowy przebieg po wierszach jeszcze w pamieci podrecznej.
+     * work_px == NULL  reszty dekodowane do dst_px i odtwarzane w miejscu po dekodowaniu.
+     * dst_cap musi byc wielokrotnoscia width; *out_len = 0 dla bledu lub strumienia
+     * konczacego sie w srodku wiersza.
+     */
+    LZ77_API
+        void lz77_rgba_decompress_image(
+            const uint8_t* src,
+            size_t          src_len,
+            uint32_t* dst_px,
+            size_t          dst_cap,
+            uint32_t* work_px,
+            const lz77_params* params,
+            size_t          width,
+            uint32_t        transform,
+            const uint8_t* row_filters,
+            size_t* out_len
+        );
+
+    /*
+     * Kodowanie entropijne  drugi etap po kompresji LZ77, zamiast ogolnego kompresora
+     * (np. Deflate w archiwum ZIP) na gotowych plikach .lz77.
+     *
+     * lz77_entropy_encode przepisuje strumien formatu kompaktowego (wynik dowolnej funkcji
+     * lz77_rgba_compress_* lub kompresji strumieniowej z tymi samymi params) na strumien
+     * kodowany: pola tokenow rozdzielone na 10 strumieni bajtow (flagi, liczniki serii,
+     * mlodszy i starszy bajt offsetu i dlugosci, 4 kanaly bajtow literalow), kazdy z wlasnym
+     * kanonicznym kodem Huffmana (kody do 11 bitow). Gdy kod nie zmniejsza strumienia,
+     * zapisywany jest strumien bez zmian (1 bajt wiecej). Biblioteka nie alokuje pamieci.
+     *
+     * lz77_entropy_bound  pojemnosc dst, ktora zawsze wystarcza: src_len + 1
+     * (0, gdy wynik nie miesci sie w size_t).
+     *
+     * lz77_entropy_encode  *out_len = 0 dla nieprawidlowych parametrow, strumienia
+     * ucietego w srodku tokenu lub za malego dst. params == NULL  LZ77_FORMAT_PACKED.
+     * Tylko CppDll.dll.
+     */
+    LZ77_API
+        size_t lz77_entropy_bound(size_t src_len);
+
+    LZ77_API
+        void lz77_entropy_encode(
+            const uint8_t* src,
+            size_t          src_len,
+            const lz77_params* params,
+            uint8_t* dst,
+            size_t          dst_cap,
+            size_t* out_len
+        );
+
+    /*
+     * lz77_rgba_decompress_entropy
+     *
+     * Dekompresja strumienia lz77_entropy_encode wprost do pikseli  bez odtwarzania
+     * strumienia tokenow: strumienie bitow czytane sa na przemian (cztery kanaly literalu,
+     * cztery pola dopasowania), a dopasowania kopiuja jadra SIMD jak w lz77_rgba_decompress_*.
+     * transform == LZ77_TRANSFORM_NONE i row_filters == NULL  bez filtrow wierszy (width
+     * i work_px bez znaczenia); inaczej parametry i odtwarzanie wierszy jak
+     * w lz77_rgba_decompress_image. Tylko CppDll.dll.
+     */
+    LZ77_API
+        void lz77_rgba_decompress_entropy(
+            const uint8_t* src,
+            size_t          src_len,
+            uint32_t* dst_px,
+            size_t          dst_cap,
+            uint32_t* work_px,
+            const lz77_params* params,
+            size_t          width,
+            uint32_t        transform,
+            const uint8_t* row_filters,
+            size_t* out_len
+        );
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,369 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#include "lz77_container.h"
+#include <string.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ============================================================
+// Lz77PackedBound — granica z kodeka (lz77_compress_bound).
+// ============================================================
+size_t Lz77PackedBound(size_t pixelCount)
+{
+    return lz77_compress_bound(LZ77_FORMAT_PACKED, pixelCount);
+}
+
+uint32_t Lz77BlockRowsFor(uint32_t width, uint32_t height, uint32_t blockPixels)
+{
+    if (blockPixels == 0xFFFFFFFFu) return height;
+    if (blockPixels == 0) blockPixels = LZ77_DEFAULT_BLOCK_PIXELS;
+
+    uint32_t rows = std::max(1u, blockPixels / std::max(1u, width));
+    return std::min(rows, height);
+}
+
+// ============================================================
+// Lz77MappedFile — pod Windows ścieżka szeroka (CreateFileW), w pozostałych
+// systemach ścieżka natywna (open).
+// ============================================================
+#ifdef _WIN32
+bool Lz77MappedFile::OpenRead(const std::filesystem::path& path)
+{
+    Close();
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    m_file = file;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 ||
+        static_cast<uint64_t>(size.QuadPart) > SIZE_MAX) {
+        Close();
+        return false;
+    }
+    m_size = static_cast<uint64_t>(size.QuadPart);
+    return Map(false);
+}
+
+bool Lz77MappedFile::CreateWrite(const std::filesystem::path& path, uint64_t bytes)
+{
+    Close();
+    if (bytes == 0 || bytes > SIZE_MAX) return false;
+    // PAGE_READWRITE wymaga uchwytu z prawem odczytu i zapisu.
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    m_file = file;
+    m_size = bytes;
+    return Map(true);   // odwzorowanie o rozmiarze bytes rozszerza plik
+}
+
+bool Lz77MappedFile::Map(bool write)
+{
+    m_mapping = CreateFileMappingW(static_cast<HANDLE>(m_file), nullptr,
+        write ? PAGE_READWRITE : PAGE_READONLY,
+        static_cast<DWORD>(m_size >> 32), static_cast<DWORD>(m_size), nullptr);
+    if (m_mapping)
+        m_data = static_cast<uint8_t*>(MapViewOfFile(static_cast<HANDLE>(m_mapping),
+            write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, static_cast<SIZE_T>(m_size)));
+    if (!m_data) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool Lz77MappedFile::Close()
+{
+    bool ok = true;
+    if (m_data) ok = UnmapViewOfFile(m_data) != FALSE;
+    if (m_mapping) CloseHandle(static_cast<HANDLE>(m_mapping));
+    if (m_file) ok = (CloseHandle(static_cast<HANDLE>(m_file)) != FALSE) && ok;
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    return ok;
+}
+#else
+bool Lz77MappedFile::OpenRead(const std::filesystem::path& path)
+{
+    Close();
+    m_fd = open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) return false;
+
+    struct stat st {};
+    if (fstat(m_fd, &st) != 0 || st.st_size <= 0 ||
+        static_cast<uint64_t>(st.st_size) > SIZE_MAX) {
+        Close();
+        return false;
+    }
+    m_size = static_cast<uint64_t>(st.st_size);
+    return Map(false);
+}
+
+bool Lz77MappedFile::CreateWrite(const std::filesystem::path& path, uint64_t bytes)
+{
+    Close();
+    if (bytes == 0 || bytes > SIZE_MAX || bytes > static_cast<uint64_t>(INT64_MAX)) return false;
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (m_fd < 0) return false;
+    m_size = bytes;
+
+    // Rezerwacja bloków na dysku — zapis do widoku ponad wolne miejsce kończy się
+    // sygnałem SIGBUS zamiast błędem; ftruncate tylko ustala rozmiar (plik rzadki).
+#ifdef __linux__
+    bool sized = posix_fallocate(m_fd, 0, static_cast<off_t>(bytes)) == 0;
+#else
+    bool sized = ftruncate(m_fd, static_cast<off_t>(bytes)) == 0;
+#endif
+    if (!sized) {
+        Close();
+        return false;
+    }
+    return Map(true);
+}
+
+bool Lz77MappedFile::Map(bool write)
+{
+    void* p = mmap(nullptr, static_cast<size_t>(m_size),
+        write ? PROT_READ | PROT_WRITE : PROT_READ,
+        write ? MAP_SHARED : MAP_PRIVATE, m_fd, 0);
+    if (p == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    m_data = static_cast<uint8_t*>(p);
+    return true;
+}
+
+bool Lz77MappedFile::Close()
+{
+    bool ok = true;
+    if (m_data) ok = munmap(m_data, static_cast<size_t>(m_size)) == 0;
+    if (m_fd >= 0) ok = (close(m_fd) == 0) && ok;
+    m_data = nullptr;
+    m_size = 0;
+    m_fd = -1;
+    return ok;
+}
+#endif
+
+// ============================================================
+// Lz77WriteContainer — nagłówek rozszerzony, tabela bloków, strumienie bloków,
+// kopiowane do pliku odwzorowanego w pamięci w docelowym rozmiarze.
+// Close też może zgłosić błąd zamknięcia pliku.
+// ============================================================
+bool Lz77WriteContainer(const std::filesystem::path& path,
+    uint32_t width,
+    uint32_t height,
+    uint16_t version,
+    uint32_t blockRows,
+    const std::vector<Lz77BlockSpan>& blocks,
+    const lz77_params* params,
+    const Lz77RowFilters* filters,
+    bool entropy,
+    uint64_t* fileBytes)
+{
+    if (fileBytes) *fileBytes = 0;
+
+    std::vector<uint64_t> table(blocks.size());
+    uint64_t total = 0;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        table[b] = static_cast<uint64_t>(blocks[b].size);
+        total += table[b];
+    }
+
+    Lz77FileHeader hdr{};
+    hdr.magic = LZ77_FILE_MAGIC_EXT;
+    hdr.width = width;
+    hdr.height = height;
+    hdr.compressedBytes = total;
+    hdr.version = version;
+    hdr.flags = LZ77_FLAG_BLOCKS | (params ? LZ77_FLAG_PARAMS : 0) | (filters ? LZ77_FLAG_FILTERS : 0) |
+        (entropy ? LZ77_FLAG_ENTROPY : 0);
+    hdr.blockRows = blockRows;
+    hdr.blockCount = static_cast<uint32_t>(blocks.size());
+    hdr.headerBytes = static_cast<uint32_t>(sizeof(hdr) + table.size() * sizeof(uint64_t) +
+        (params ? sizeof(lz77_params) : 0) + (filters ? 1 + static_cast<size_t>(height) : 0));
+
+    Lz77MappedFile file;
+    if (!file.CreateWrite(path, hdr.headerBytes + total)) return false;
+
+    uint8_t* out = file.Data();
+    memcpy(out, &hdr, sizeof(hdr));
+    out += sizeof(hdr);
+    memcpy(out, table.data(), table.size() * sizeof(uint64_t));
+    out += table.size() * sizeof(uint64_t);
+    if (params) {
+        memcpy(out, params, sizeof(*params));
+        out += sizeof(*params);
+    }
+    if (filters) {
+        *out++ = static_cast<uint8_t>(filters->transform);
+        memcpy(out, filters->rows.data(), height);
+        out += height;
+    }
+    for (const Lz77BlockSpan& block : blocks) {
+        memcpy(out, block.data, block.size);
+        out += block.size;
+    }
+
+    if (!file.Close()) return false;
+    if (fileBytes) *fileBytes = hdr.headerBytes + total;
+    return true;
+}
+
+// ============================================================
+// Lz77ReadContainer — te same kroki walidacji co ReadCompressedIndex
+// w CppLogicDll/logic.cpp (magic, znane flagi, spójność tabeli bloków,
+// rekord parametrów poziomu i filtrów wierszy, dane tokenów i każdy blok
+// w granicach pliku).
+// Dekoder czyta tokeny wprost z widoku pliku, więc granice są sprawdzane
+// przed zwróceniem data.
+// ============================================================
+bool Lz77ReadContainer(const std::filesystem::path& path,
+    Lz77FileHeader& hdr,
+    Lz77BlockIndex& index,
+    Lz77MappedFile& file,
+    const uint8_t*& data)
+{
+    data = nullptr;
+    if (!file.OpenRead(path)) return false;
+
+    const uint8_t* src = file.Data();
+    const uint64_t fileBytes = file.Size();
+
+    // Kopia bytes bajtów od pozycji pos; false, jeśli wykracza poza plik.
+    auto read = [src, fileBytes](void* dst, uint64_t pos, size_t bytes) {
+        if (pos > fileBytes || bytes > fileBytes - pos) return false;
+        memcpy(dst, src + pos, bytes);
+        return true;
+        };
+
+    // Wspólne wyjście z błędem — zamyka plik.
+    auto fail = [&file]() { file.Close(); return false; };
+
+    hdr = Lz77FileHeader{};
+    index.params = lz77_params{};
+    index.filters = Lz77RowFilters{};
+    index.entropy = false;
+    if (!read(&hdr, 0, LZ77_BASE_HEADER_BYTES) ||
+        (hdr.magic != LZ77_FILE_MAGIC && hdr.magic != LZ77_FILE_MAGIC_EXT))
+        return fail();
+
+    std::vector<uint64_t> table;
+
+    if (hdr.magic == LZ77_FILE_MAGIC) {
+        // Plik wersji 1.1 — brak pól rozszerzonych, zawsze Token12.
+        hdr.version = LZ77_FORMAT_TOKEN12;
+        hdr.flags = 0;
+        hdr.headerBytes = static_cast<uint32_t>(LZ77_BASE_HEADER_BYTES);
+    }
+    else {
+        uint8_t* raw = reinterpret_cast<uint8_t*>(&hdr);
+        if (!read(raw + LZ77_BASE_HEADER_BYTES, LZ77_BASE_HEADER_BYTES, LZ77_EXT_MIN_HEADER_BYTES - LZ77_BASE_HEADER_BYTES) ||
+            hdr.headerBytes < LZ77_EXT_MIN_HEADER_BYTES || (hdr.flags & ~LZ77_KNOWN_FLAGS) != 0)
+            return fail();
+
+        if (hdr.flags & LZ77_FLAG_BLOCKS) {
+            if (!read(raw + LZ77_EXT_MIN_HEADER_BYTES, LZ77_EXT_MIN_HEADER_BYTES, sizeof(hdr) - LZ77_EXT_MIN_HEADER_BYTES))
+                return fail();
+
+            // Tabela bloków musi mieścić się w nagłówku i pokrywać całą wysokość obrazu.
+            uint64_t tableBytes = static_cast<uint64_t>(hdr.blockCount) * sizeof(uint64_t);
+            if (hdr.blockRows == 0 || hdr.blockCount == 0 ||
+                hdr.blockCount != (static_cast<uint64_t>(hdr.height) + hdr.blockRows - 1) / hdr.blockRows ||
+                sizeof(hdr) + tableBytes > hdr.headerBytes)
+                return fail();
+
+            table.resize(hdr.blockCount);
+            if (!read(table.data(), sizeof(hdr), static_cast<size_t>(tableBytes)))
+                return fail();
+
+            // Rekord parametrów poziomu — zaraz po tabeli bloków.
+            if ((hdr.flags & LZ77_FLAG_PARAMS) &&
+                (sizeof(hdr) + tableBytes + sizeof(lz77_params) > hdr.headerBytes ||
+                 !read(&index.params, sizeof(hdr) + tableBytes, sizeof(lz77_params))))
+                return fail();
+
+            // Rekord filtrów wierszy — po rekordzie parametrów; znane filtry i transformacja,
+            // tylko dla formatu kompaktowego.
+            if (hdr.flags & LZ77_FLAG_FILTERS) {
+                uint64_t pos = sizeof(hdr) + tableBytes + ((hdr.flags & LZ77_FLAG_PARAMS) ? sizeof(lz77_params) : 0);
+                uint8_t transform = 0;
+                if (pos + 1 + hdr.height > hdr.headerBytes || hdr.version == LZ77_FORMAT_TOKEN12)
+                    return fail();
+                index.filters.rows.resize(hdr.height);
+                if (!read(&transform, pos, 1) || !read(index.filters.rows.data(), pos + 1, hdr.height) ||
+                    transform > LZ77_TRANSFORM_YCOCG_R)
+                    return fail();
+                for (uint8_t filter : index.filters.rows) {
+                    if (filter >= LZ77_FILTER_COUNT)
+                        return fail();
+                }
+                index.filters.transform = transform;
+            }
+        }
+        else if (hdr.flags & (LZ77_FLAG_PARAMS | LZ77_FLAG_FILTERS | LZ77_FLAG_ENTROPY)) {
+            return fail();   // rekordy parametrów i filtrów oraz kodowanie entropijne tylko z tabelą bloków
+        }
+
+        // Format kompaktowy z rekordem parametrów musi mieć jego okno i długość dopasowań;
+        // LZ77_FORMAT_PACKED_EX wymaga rekordu (dekoder rozmiaru pól tokenu).
+        if (hdr.version == LZ77_FORMAT_PACKED && (hdr.flags & LZ77_FLAG_PARAMS) &&
+            (index.params.window_px != LZ77_PACKED_WINDOW_PX || index.params.max_match_px != LZ77_PACKED_MAX_MATCH_PX))
+            return fail();
+        if (hdr.version == LZ77_FORMAT_PACKED_EX && !(hdr.flags & LZ77_FLAG_PARAMS))
+            return fail();
+
+        // Kodowanie entropijne dotyczy tylko formatu kompaktowego.
+        if ((hdr.flags & LZ77_FLAG_ENTROPY) && hdr.version == LZ77_FORMAT_TOKEN12)
+            return fail();
+        index.entropy = (hdr.flags & LZ77_FLAG_ENTROPY) != 0;
+
+        // Pola dopisane przez nowsze wersje programu są pomijane — dane zaczynają się od headerBytes.
+    }
+
+    // Plik bez tabeli bloków to jeden blok obejmujący cały obraz.
+    if (!(hdr.flags & LZ77_FLAG_BLOCKS)) {
+        hdr.blockRows = hdr.height;
+        hdr.blockCount = 1;
+        table.assign(1, static_cast<uint64_t>(hdr.compressedBytes));   // kopia pola niewyrównanego
+    }
+
+    // Dane tokenów muszą mieścić się w pliku, a każdy blok w danych tokenów.
+    if (hdr.compressedBytes == 0 || hdr.headerBytes > fileBytes ||
+        hdr.compressedBytes > fileBytes - hdr.headerBytes)
+        return fail();
+
+    index.blockRows = hdr.blockRows;
+    index.offsets.assign(table.size() + 1, 0);
+    for (size_t b = 0; b < table.size(); ++b) {
+        if (table[b] > hdr.compressedBytes - index.offsets[b])
+            return fail();
+        index.offsets[b + 1] = index.offsets[b] + table[b];
+    }
+    if (index.offsets.back() != hdr.compressedBytes)
+        return fail();
+
+    data = src + hdr.headerBytes;
+    return true;
+}
@@ -0,0 +1,179 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#pragma once
+
+// ============================================================
+// Przenośna obsługa kontenera .lz77 — używana przez bibliotekę lz77core
+// i narzędzie wiersza poleceń lz77img. Pliki odwzorowywane są w pamięci
+// (Lz77MappedFile — mmap; pod Windows CreateFileMappingW, jedyne użycie WinAPI).
+//
+// Układ pliku jest identyczny z Lz77FileHeader z CppLogicDll/logic.h,
+// więc pliki zapisane pod Windows i pod Linuksem są wymienne.
+// Definicje są powielone celowo (jak LOGIC_LZ77_WORK_BYTES) — Logic.dll
+// nie zależy od nagłówków CppLib; przy zmianie formatu trzeba zmienić oba pliki.
+// ============================================================
+
+#include "lz77.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <filesystem>
+
+// ============================================================
+// Nagłówek pliku .lz77 — patrz opis Lz77FileHeader w CppLogicDll/logic.h.
+//   [uint32 magic] [uint32 width] [uint32 height] [uint64 compressedBytes]
+//   [uint16 version] [uint16 flags] [uint32 headerBytes]
+//   [uint32 blockRows] [uint32 blockCount] [uint64 blockBytes[blockCount]]
+//   [lz77_params — tylko z LZ77_FLAG_PARAMS, 20 bajtów]
+//   [uint8 transform] [uint8 rowFilters[height]] — tylko z LZ77_FLAG_FILTERS
+//   [compressedBytes bajtów strumieni bloków] — z LZ77_FLAG_ENTROPY zakodowanych
+//   przez lz77_entropy_encode
+// Wszystkie pola little-endian; #pragma pack(1) — sizeof == 36 bajtów.
+// ============================================================
+#pragma pack(push, 1)
+struct Lz77FileHeader {
+    uint32_t magic;             // LZ77_FILE_MAGIC lub LZ77_FILE_MAGIC_EXT
+    uint32_t width;             // szerokość obrazu w pikselach
+    uint32_t height;            // wysokość obrazu w pikselach
+    uint64_t compressedBytes;   // rozmiar danych tokenów LZ77 następujących po nagłówku
+    uint16_t version;           // format tokenów (LZ77_FORMAT_*)
+    uint16_t flags;             // bity LZ77_FLAG_*
+    uint32_t headerBytes;       // rozmiar nagłówka razem z tabelą bloków (offset danych)
+    uint32_t blockRows;         // wierszy obrazu na blok
+    uint32_t blockCount;        // liczba wpisów tabeli bloków
+};
+#pragma pack(pop)
+
+static const uint32_t LZ77_FILE_MAGIC = 0x4C5A3737u;      // "LZ77" — nagłówek podstawowy, Token12
+static const uint32_t LZ77_FILE_MAGIC_EXT = 0x4C5A3758u;  // "LZ7X" — nagłówek rozszerzony
+static const uint16_t LZ77_FLAG_BLOCKS = 0x0001;          // dane podzielone na bloki z tabelą bloków
+static const uint16_t LZ77_FLAG_PARAMS = 0x0002;          // po tabeli bloków rekord lz77_params (wymaga LZ77_FLAG_BLOCKS)
+static const uint16_t LZ77_FLAG_FILTERS = 0x0004;         // dalej rekord filtrów wierszy (wymaga LZ77_FLAG_BLOCKS)
+static const uint16_t LZ77_FLAG_ENTROPY = 0x0008;         // strumienie bloków po kodowaniu entropijnym (nie Token12)
+static const uint16_t LZ77_KNOWN_FLAGS = LZ77_FLAG_BLOCKS | LZ77_FLAG_PARAMS | LZ77_FLAG_FILTERS | LZ77_FLAG_ENTROPY;
+static const size_t   LZ77_BASE_HEADER_BYTES = 20;
+static const size_t   LZ77_EXT_MIN_HEADER_BYTES = 28;
+
+// Okno i maks. dopasowanie formatu LZ77_FORMAT_PACKED (poziomy 1 i 2) — wersja 2
+// z rekordem parametrów musi je zawierać (jak LOGIC_PACKED_* w logic.h).
+static const uint32_t LZ77_PACKED_WINDOW_PX = 4096;
+static const uint32_t LZ77_PACKED_MAX_MATCH_PX = 64;
+
+// Domyślna liczba pikseli bloku i liczba obrazów w obiegu na wątek
+// (wartości zgodne z LOGIC_DEFAULT_BLOCK_PIXELS / LOGIC_DEFAULT_IN_FLIGHT_PER_THREAD).
+static const uint32_t LZ77_DEFAULT_BLOCK_PIXELS = 1u << 20;
+static const uint32_t LZ77_DEFAULT_IN_FLIGHT_PER_THREAD = 2;
+
+// ============================================================
+// Lz77RowFilters — rekord LZ77_FLAG_FILTERS: transformacja kolorów
+// (LZ77_TRANSFORM_*) i filtr każdego wiersza obrazu (LZ77_FILTER_*),
+// jak z lz77_filter_rows wywołanego osobno dla każdego bloku.
+// Pusty rows — plik bez filtrów.
+// ============================================================
+struct Lz77RowFilters {
+    uint32_t             transform = 0;
+    std::vector<uint8_t> rows;
+};
+
+// ============================================================
+// Lz77BlockIndex — granice bloków w danych tokenów:
+// blok b zajmuje bajty [offsets[b], offsets[b + 1]).
+// params  — parametry poziomu z nagłówka (LZ77_FLAG_PARAMS); zera, gdy brak.
+// filters — rekord LZ77_FLAG_FILTERS; pusty, gdy brak.
+// entropy — LZ77_FLAG_ENTROPY: bloki dekompresować lz77_rgba_decompress_entropy.
+// ============================================================
+struct Lz77BlockIndex {
+    uint32_t              blockRows = 0;
+    std::vector<uint64_t> offsets;
+    lz77_params           params{};
+    Lz77RowFilters        filters;
+    bool                  entropy = false;
+};
+
+// ============================================================
+// Lz77MappedFile — plik odwzorowany w pamięci (patrz MappedFile w
+// CppLogicDll/logic.cpp): mmap w systemach POSIX, CreateFileMappingW +
+// MapViewOfFile pod Windows. Uchwyty Windows przechowywane jako void*,
+// żeby nagłówek nie wciągał windows.h.
+//
+// OpenRead    — cały plik tylko do odczytu; pusty plik zwraca false.
+// CreateWrite — nowy plik (nadpisuje istniejący) o rozmiarze bytes, do zapisu;
+//               miejsce na dysku rezerwowane przed odwzorowaniem, więc brak
+//               miejsca jest błędem CreateWrite, a nie sygnałem przy zapisie.
+// Close       — false, jeśli system zgłosił błąd zamknięcia pliku.
+// ============================================================
+class Lz77MappedFile {
+public:
+    Lz77MappedFile() = default;
+    ~Lz77MappedFile() { Close(); }
+
+    Lz77MappedFile(const Lz77MappedFile&) = delete;
+    Lz77MappedFile& operator=(const Lz77MappedFile&) = delete;
+
+    bool OpenRead(const std::filesystem::path& path);
+    bool CreateWrite(const std::filesystem::path& path, uint64_t bytes);
+    bool Close();
+
+    uint8_t* Data() const { return m_data; }
+    uint64_t Size() const { return m_size; }
+
+private:
+    bool Map(bool write);
+
+    uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+#ifdef _WIN32
+    void*    m_file = nullptr;      // HANDLE pliku (nullptr — brak)
+    void*    m_mapping = nullptr;   // HANDLE odwzorowania
+#else
+    int      m_fd = -1;
+#endif
+};
+
+// Strumień tokenów jednego bloku do zapisu.
+struct Lz77BlockSpan {
+    const uint8_t* data;
+    size_t         size;
+};
+
+// Pesymistyczny rozmiar wyjścia formatu kompaktowego dla pixelCount pikseli
+// (same literały: 4 B/piksel + licznik serii + bajty flag).
+size_t Lz77PackedBound(size_t pixelCount);
+
+// Liczba wierszy bloku: blockPixels == 0 — wartość domyślna,
+// 0xFFFFFFFF — cały obraz jako jeden blok; wynik w przedziale [1, height].
+uint32_t Lz77BlockRowsFor(uint32_t width, uint32_t height, uint32_t blockPixels);
+
+// Zapis pliku .lz77 z tabelą bloków i — gdy params != nullptr — rekordem
+// parametrów poziomu (LZ77_FLAG_PARAMS), a gdy filters != nullptr — rekordem
+// filtrów wierszy (LZ77_FLAG_FILTERS, filters->rows ma height wpisów); entropy —
+// bloki zakodowane lz77_entropy_encode (LZ77_FLAG_ENTROPY). Plik tworzony jest
+// od razu w docelowym rozmiarze i wypełniany przez odwzorowanie.
+// fileBytes — [out, opcjonalnie] rozmiar zapisanego pliku (nagłówek + bloki).
+// Zwraca false przy błędzie zapisu.
+bool Lz77WriteContainer(const std::filesystem::path& path,
+    uint32_t width,
+    uint32_t height,
+    uint16_t version,
+    uint32_t blockRows,
+    const std::vector<Lz77BlockSpan>& blocks,
+    const lz77_params* params,
+    const Lz77RowFilters* filters,
+    bool entropy,
+    uint64_t* fileBytes = nullptr);
+
+// Odwzorowanie i walidacja pliku .lz77 (także plików bez tabeli bloków —
+// opisywanych jako jeden blok). data wskazuje dane tokenów w widoku 'file'
+// (ważne do jego zamknięcia) — bez kopii. Zwraca false dla pliku uszkodzonego.
+bool Lz77ReadContainer(const std::filesystem::path& path,
+    Lz77FileHeader& hdr,
+    Lz77BlockIndex& index,
+    Lz77MappedFile& file,
+    const uint8_t*& data);
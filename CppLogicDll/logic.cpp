@@ -21,6 +21,13 @@
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <array>
+#include <functional>
+#include <new>
+#include <type_traits>
 
 static ULONG_PTR g_gdiplusToken = 0;
 
@@ -61,25 +68,20 @@ BOOL WINAPI DllMain(HINSTANCE /*hInst*/, DWORD reason, LPVOID /*reserved*/)
 // kodu jest całkowicie nieświadoma różnicy.
 //
 // Parametry wyjściowe:
-//   hMod     — uchwyt załadowanej DLL; caller musi wywołać FreeLibrary(hMod)
-//              po zakończeniu pracy, aby zwolnić zasoby.
-//   compFn   — wskaźnik na funkcję kompresji
-//   decompFn — wskaźnik na funkcję dekompresji
+//   hMod     — uchwyt załadowanej DLL; pozostaje załadowana do końca procesu
+//              (trzyma ją rejestr kerneli, patrz EnsureKernelRegistry)
+//   api      — wskaźniki na funkcje obu formatów (Token12 i kompaktowego)
 //   errorOut — komunikat błędu (tylko gdy funkcja zwraca false)
 //
-// WAŻNE: Ładujemy TYLKO JEDNĄ DLL naraz (albo ASM albo CPP).
-// Ładowanie obu jednocześnie jest zbędne i mogłoby powodować konflikty
-// globalnych tablic head[]/prev[] gdyby DLL-e nie izolowały swojego stanu.
+// Obie DLL mogą być załadowane jednocześnie — kernele nie mają stanu
+// globalnego (poziom SIMD CppDll.dll ustawiany jest dla wątku);
+// tablice head[]/prev[] leżą w buforze roboczym przekazywanym przez wywołującego.
 // ============================================================
-static bool LoadLZ77DLL(bool useASM,
+static bool LoadLZ77DLL(const char* dllName,
     HMODULE& hMod,
-    LZ77CompressFunc& compFn,
-    LZ77DecompressFunc& decompFn,
+    LZ77Api& api,
     std::wstring& errorOut)
 {
-    // Nazwy DLL zgodne z nazwami projektow w rozwiazaniu VS
-    const char* dllName = useASM ? "AsmDll.dll" : "CppDll.dll";
-
     // WAŻNE: LoadLibraryA ładuje DLL z tego samego katalogu co Logic.dll
     // (domyślne zachowanie systemu Windows dla ścieżek względnych).
     // Jeśli DLL nie zostanie znaleziona, GetLastError() zwróci kod błędu
@@ -97,13 +99,36 @@ static bool LoadLZ77DLL(bool useASM,
     // Rzutowanie reinterpret_cast jest konieczne, bo GetProcAddress zwraca
     // generyczny FARPROC (void*). Sygnatury muszą dokładnie odpowiadać tym
     // z nagłówka DLL — niezgodność typów prowadzi do UB lub naruszenia stosu.
-    compFn = reinterpret_cast<LZ77CompressFunc>  (GetProcAddress(hMod, "lz77_rgba_compress"));
-    decompFn = reinterpret_cast<LZ77DecompressFunc>(GetProcAddress(hMod, "lz77_rgba_decompress"));
+    api.compress = reinterpret_cast<LZ77CompressFunc>  (GetProcAddress(hMod, "lz77_rgba_compress"));
+    api.decompress = reinterpret_cast<LZ77DecompressFunc>(GetProcAddress(hMod, "lz77_rgba_decompress"));
+    api.compressPacked = reinterpret_cast<LZ77CompressFunc>  (GetProcAddress(hMod, "lz77_rgba_compress_packed"));
+    api.decompressPacked = reinterpret_cast<LZ77DecompressFunc>(GetProcAddress(hMod, "lz77_rgba_decompress_packed"));
+    // Opcjonalny eksport (tylko CppDll.dll) — brak nie jest błędem.
+    api.compressPackedStats = reinterpret_cast<LZ77CompressStatsFunc>(GetProcAddress(hMod, "lz77_rgba_compress_packed_stats"));
+    api.compressLevel = reinterpret_cast<LZ77CompressLevelFunc>(GetProcAddress(hMod, "lz77_rgba_compress_level"));
+    api.decompressLevel = reinterpret_cast<LZ77DecompressLevelFunc>(GetProcAddress(hMod, "lz77_rgba_decompress_level"));
+    api.levelParams = reinterpret_cast<LZ77LevelParamsFunc>(GetProcAddress(hMod, "lz77_level_params"));
+    api.cpuSimdLevel = reinterpret_cast<LZ77CpuSimdLevelFunc>(GetProcAddress(hMod, "lz77_cpu_simd_level"));
+    api.setThreadSimdLevel = reinterpret_cast<LZ77SetSimdLevelFunc>(GetProcAddress(hMod, "lz77_set_thread_simd_level"));
+    api.compressBound = reinterpret_cast<LZ77CompressBoundFunc>(GetProcAddress(hMod, "lz77_compress_bound"));
+    api.workBytes = reinterpret_cast<LZ77WorkBytesFunc>(GetProcAddress(hMod, "lz77_work_bytes"));
+    api.streamWorkBytes = reinterpret_cast<LZ77StreamWorkBytesFunc>(GetProcAddress(hMod, "lz77_stream_work_bytes"));
+    api.streamBegin = reinterpret_cast<LZ77StreamBeginFunc>(GetProcAddress(hMod, "lz77_stream_begin"));
+    api.streamCompress = reinterpret_cast<LZ77StreamCompressFunc>(GetProcAddress(hMod, "lz77_stream_compress"));
+    api.compressImage = reinterpret_cast<LZ77CompressImageFunc>(GetProcAddress(hMod, "lz77_rgba_compress_image"));
+    api.streamBeginImage = reinterpret_cast<LZ77StreamBeginImageFunc>(GetProcAddress(hMod, "lz77_stream_begin_image"));
+    api.filterRows = reinterpret_cast<LZ77FilterRowsFunc>(GetProcAddress(hMod, "lz77_filter_rows"));
+    api.decompressImage = reinterpret_cast<LZ77DecompressImageFunc>(GetProcAddress(hMod, "lz77_rgba_decompress_image"));
+    api.entropyBound = reinterpret_cast<LZ77EntropyBoundFunc>(GetProcAddress(hMod, "lz77_entropy_bound"));
+    api.entropyEncode = reinterpret_cast<LZ77EntropyEncodeFunc>(GetProcAddress(hMod, "lz77_entropy_encode"));
+    api.decompressEntropy = reinterpret_cast<LZ77DecompressEntropyFunc>(GetProcAddress(hMod, "lz77_rgba_decompress_entropy"));
+    api.compressEx = reinterpret_cast<LZ77CompressExFunc>(GetProcAddress(hMod, "lz77_rgba_compress_ex"));
+    api.streamBeginEx = reinterpret_cast<LZ77StreamBeginExFunc>(GetProcAddress(hMod, "lz77_stream_begin_ex"));
 
-    // WAŻNE: Walidacja obu wskaźników przed zwrotem.
+    // WAŻNE: Walidacja wszystkich wskaźników przed zwrotem.
     // Brak eksportu oznacza niezgodną wersję DLL lub błąd budowania projektu.
     // W takim przypadku zwalniamy DLL (FreeLibrary), by nie było wycieku zasobów.
-    if (!compFn || !decompFn) {
+    if (!api.compress || !api.decompress || !api.compressPacked || !api.decompressPacked) {
         std::wstringstream ss;
         ss << L"GetProcAddress nie znalazlo eksportow LZ77 w: " << dllName;
         errorOut = ss.str();
@@ -115,556 +140,3196 @@ static bool LoadLZ77DLL(bool useASM,
 }
 
 // ============================================================
-// WAŻNE: LoadImagePixels — wczytywanie obrazu do liniowej tablicy pikseli RGBA.
+// Rejestr kerneli (opis w logic.h przy Lz77KernelInfo).
 //
-// Używa GDI+ (Gdiplus::Bitmap) — obsługuje PNG, JPG, BMP, TIFF, GIF i inne.
-// Wszystkie formaty są sprowadzane do jednolitego formatu PixelFormat32bppARGB:
-//   każdy piksel = 4 bajty [Alpha, Red, Green, Blue].
+// g_kernels budowany jest raz (std::call_once) i potem już się nie zmienia —
+// wskaźniki KernelEntry są ważne do końca procesu. Pomiary przepustowości
+// w info zmieniane są pod g_kernelMtx.
 //
-// WAŻNE — obsługa Stride:
-//   Stride (bmpData.Stride) to liczba bajtów w jednym wierszu danych GDI+.
-//   Może być WIĘKSZY niż width * 4, ponieważ GDI+ wyrównuje wiersze
-//   do wielokrotności 4 bajtów. Dlatego kopiujemy wiersz po wierszu
-//   (pętla po y), a nie całość jednym memcpy — kopiowałoby padding!
+// Inicjalizacja NIE może odbywać się w DllMain (LoadLibrary pod blokadą
+// loadera grozi zakleszczeniem) — wykonuje ją pierwsze wywołanie eksportu.
+// Z tego samego powodu DLL-e kerneli nigdy nie są zwalniane; system zwalnia
+// je razem z procesem.
 // ============================================================
-static bool LoadImagePixels(const std::wstring& path,
-    std::vector<uint32_t>& pixels,
-    uint32_t& width,
-    uint32_t& height)
+struct KernelEntry {
+    Lz77KernelInfo info;
+    LZ77Api        api;
+};
+
+static std::once_flag           g_kernelsOnce;
+static std::vector<KernelEntry> g_kernels;
+static std::wstring             g_kernelErrors;   // błędy ładowania DLL (do logu)
+static std::mutex               g_kernelMtx;
+
+// Nazwy wariantów "cpp-*" według poziomu SIMD (LZ77_SIMD_*).
+static const char* const KERNEL_SIMD_NAMES[] = { "cpp-scalar", "cpp-sse2", "cpp-avx2", "cpp-avx512" };
+
+static void AddKernel(uint32_t id, const char* name, const char* module,
+    const LZ77Api& api, int32_t simdLevel, uint32_t extraCaps = 0)
 {
-    // Tworzymy obiekt Bitmap z pliku; GetLastStatus() sprawdza czy GDI+ załadował poprawnie.
-    Gdiplus::Bitmap* bmp = Gdiplus::Bitmap::FromFile(path.c_str());
-    if (!bmp || bmp->GetLastStatus() != Gdiplus::Ok) {
-        delete bmp;
-        return false;
-    }
+    KernelEntry e{};
+    e.info.id = id;
+    e.info.simdLevel = simdLevel;
+    snprintf(e.info.name, sizeof(e.info.name), "%s", name);
+    snprintf(e.info.module, sizeof(e.info.module), "%s", module);
+    e.info.caps = LOGIC_KERNEL_CAP_TOKEN12 | LOGIC_KERNEL_CAP_PACKED;
+    if (api.compressLevel && api.decompressLevel && api.levelParams)
+        e.info.caps |= LOGIC_KERNEL_CAP_LEVELS;
+    if (api.compressPackedStats)
+        e.info.caps |= LOGIC_KERNEL_CAP_STATS;
+    if (simdLevel >= 0)
+        e.info.caps |= LOGIC_KERNEL_CAP_SIMD;
+    e.info.caps |= extraCaps;
+    e.api = api;
+    g_kernels.push_back(e);
+}
 
-    width = bmp->GetWidth();
-    height = bmp->GetHeight();
+// ============================================================
+// Profil kalibracji (Lz77Calibrate) — plik INI w katalogu użytkownika:
+//   %LOCALAPPDATA%\Lz77\calibration.ini
+//
+//   [machine] cpus=<procesory logiczne>  simd=<poziom SIMD CPU lub -1>
+//   [best]    kernel=<nazwa>  threads=<wątki>  saturation=<wątki nasycenia>
+//   [kernels] <nazwa>=<MB/s kompresji>,<MB/s dekompresji>   (na jeden wątek)
+//
+// Profil jest wczytywany razem z rejestrem kerneli. Pomiary z [kernels]
+// stają się pomiarami kerneli (LOGIC_KERNEL_FASTEST), a threads — liczbą
+// wątków dla numThreads <= 0. Profil z innej maszyny (cpus/simd) jest
+// pomijany.
+// ============================================================
+static std::atomic<uint32_t> g_profileThreads{ 0 };
 
-    // Zabezpieczenie przed zerowymi wymiarami (uszkodzony lub pusty obraz).
-    if (width == 0 || height == 0) {
-        delete bmp;
-        return false;
-    }
+static std::wstring CalibrationProfilePath()
+{
+    wchar_t buf[MAX_PATH];
+    DWORD len = GetEnvironmentVariableW(L"LOCALAPPDATA", buf, MAX_PATH);
+    if (len == 0 || len >= MAX_PATH) return std::wstring();
+    return std::wstring(buf) + L"\\Lz77\\calibration.ini";
+}
 
-    // Alokacja bufora na width * height pikseli (każdy uint32_t = ARGB).
-    pixels.resize(static_cast<size_t>(width) * height);
+// Poziom SIMD CPU według CppDll.dll (-1 bez CppDll.dll) — część tożsamości maszyny.
+static int MachineSimdLevel()
+{
+    for (const KernelEntry& e : g_kernels)
+        if (e.api.cpuSimdLevel) return e.api.cpuSimdLevel();
+    return -1;
+}
 
-    Gdiplus::Rect rect(0, 0, static_cast<INT>(width), static_cast<INT>(height));
-    Gdiplus::BitmapData bmpData{};
+static void LoadCalibrationProfile()
+{
+    std::wstring path = CalibrationProfilePath();
+    if (path.empty()) return;
 
-    // WAŻNE: LockBits blokuje piksele w pamięci i daje bezpośredni dostęp do danych.
-    // ImageLockModeRead — tylko odczyt (wystarczający tutaj; Write byłby nadmiarowy).
-    // PixelFormat32bppARGB — wymagamy konkretnego formatu; GDI+ skonwertuje automatycznie.
-    if (bmp->LockBits(&rect,
-        Gdiplus::ImageLockModeRead,
-        PixelFormat32bppARGB,
-        &bmpData) != Gdiplus::Ok)
-    {
-        delete bmp;
-        return false;
-    }
+    wchar_t buf[64];
+    GetPrivateProfileStringW(L"machine", L"cpus", L"", buf, 64, path.c_str());
+    uint32_t cpus = static_cast<uint32_t>(wcstoul(buf, nullptr, 10));
+    GetPrivateProfileStringW(L"machine", L"simd", L"", buf, 64, path.c_str());
+    int simd = static_cast<int>(wcstol(buf, nullptr, 10));
+    if (cpus == 0 || cpus != std::thread::hardware_concurrency() || simd != MachineSimdLevel())
+        return;
 
-    // WAŻNE: Kopiowanie wiersz po wierszu z uwzględnieniem Stride.
-    // bmpData.Scan0 wskazuje na pierwszy bajt danych GDI+ (wiersz 0).
-    // Każdy wiersz jest oddalony od poprzedniego o bmpData.Stride bajtów,
-    // ale my chcemy wiersz ciągły o rozmiarze width*4 bajtów.
-    for (uint32_t y = 0; y < height; ++y) {
-        memcpy(pixels.data() + y * width,
-            reinterpret_cast<const uint8_t*>(bmpData.Scan0) + y * bmpData.Stride,
-            static_cast<size_t>(width) * sizeof(uint32_t));
+    for (KernelEntry& e : g_kernels) {
+        std::wstring name(e.info.name, e.info.name + strlen(e.info.name));
+        GetPrivateProfileStringW(L"kernels", name.c_str(), L"", buf, 64, path.c_str());
+        wchar_t* end = nullptr;
+        e.info.compressMBps = wcstod(buf, &end);
+        if (end && *end == L',')
+            e.info.decompressMBps = wcstod(end + 1, nullptr);
     }
 
-    // WAŻNE: UnlockBits musi być wywołane zawsze po LockBits — nawet w ścieżce błędu.
-    // Brak UnlockBits powoduje zablokowanie bitmapy i wyciek zasobów GDI+.
-    bmp->UnlockBits(&bmpData);
-    delete bmp;
-    return true;
+    GetPrivateProfileStringW(L"best", L"threads", L"", buf, 64, path.c_str());
+    g_profileThreads.store(static_cast<uint32_t>(wcstoul(buf, nullptr, 10)));
 }
 
-// ============================================================
-// WAŻNE: GetGdiplusEncoderClsid — wyszukiwanie CLSID kodera GDI+ po MIME type.
-//
-// GDI+ identyfikuje kodeki (PNG, BMP, JPEG...) przez CLSID, a nie przez
-// nazwy plików. Aby zapisać BMP, musimy znaleźć CLSID kodera "image/bmp".
-//
-// Mechanizm:
-//   1. GetImageEncodersSize() — pyta GDI+ o liczbę i łączny rozmiar (w bajtach)
-//      tablicy dostępnych kodeków.
-//   2. GetImageEncoders() — wypełnia tablicę ImageCodecInfo wszystkimi dostępnymi
-//      kodekami (BMP, JPEG, PNG, GIF, TIFF).
-//   3. Iterujemy i porównujemy MimeType z szukanym — jeśli pasuje, kopiujemy CLSID.
-// ============================================================
-static bool GetGdiplusEncoderClsid(const wchar_t* mimeType, CLSID& clsid)
+static void EnsureKernelRegistry()
 {
-    UINT num = 0;
-    UINT size = 0;
-    Gdiplus::GetImageEncodersSize(&num, &size);
-    if (size == 0) return false;
+    std::call_once(g_kernelsOnce, []() {
+        HMODULE      hMod = nullptr;
+        LZ77Api      api;
+        std::wstring err;
 
-    std::vector<uint8_t> buf(size);
-    Gdiplus::GetImageEncoders(num, size,
-        reinterpret_cast<Gdiplus::ImageCodecInfo*>(buf.data()));
+        if (LoadLZ77DLL("CppDll.dll", hMod, api, err)) {
+            AddKernel(LOGIC_KERNEL_CPP, "cpp", "CppDll.dll", api, -1);
+            // Warianty z wymuszonym poziomem SIMD — tylko poziomy obsługiwane przez CPU.
+            if (api.cpuSimdLevel && api.setThreadSimdLevel) {
+                int cpuLevel = std::min(api.cpuSimdLevel(), 3);
+                for (int level = 0; level <= cpuLevel; ++level)
+                    AddKernel(LOGIC_KERNEL_CPP_SCALAR + level, KERNEL_SIMD_NAMES[level], "CppDll.dll", api, level);
+            }
+            if (api.compressEx && api.streamBeginEx)
+                AddKernel(LOGIC_KERNEL_CPP_BUCKET, "cpp-bucket", "CppDll.dll", api, -1, LOGIC_KERNEL_CAP_BUCKET);
+        }
+        else {
+            g_kernelErrors += err + L"\n";
+        }
 
-    for (UINT i = 0; i < num; ++i) {
-        const auto& codec = reinterpret_cast<Gdiplus::ImageCodecInfo*>(buf.data())[i];
-        if (wcscmp(codec.MimeType, mimeType) == 0) {
-            clsid = codec.Clsid;
-            return true;
+        api = LZ77Api{};
+        if (LoadLZ77DLL("AsmDll.dll", hMod, api, err)) {
+            AddKernel(LOGIC_KERNEL_ASM, "asm", "AsmDll.dll", api, -1);
         }
-    }
-    return false;
+        else {
+            g_kernelErrors += err + L"\n";
+        }
+
+        LoadCalibrationProfile();
+        });
+}
+
+// Liczba wątków partii: numThreads > 0 bez zmian, w przeciwnym razie
+// z profilu kalibracji, a bez profilu — liczba procesorów logicznych.
+static int ThreadsFor(int numThreads)
+{
+    if (numThreads > 0) return numThreads;
+    EnsureKernelRegistry();
+    uint32_t threads = g_profileThreads.load();
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<int>(threads);
 }
 
 // ============================================================
-// WAŻNE: SavePixelsAsBMP — zapis liniowej tablicy pikseli RGBA do pliku BMP.
+// WAŻNE: BufferArena — pula dużych buforów (piksele, tokeny, bufory robocze)
+// wspólna dla wszystkich partii w procesie.
 //
-// Analogicznie do LoadImagePixels, ale w kierunku odwrotnym.
-// Tworzymy nową bitmapę GDI+ w pamięci, kopiujemy piksele wiersz po wierszu
-// (znów z uwzględnieniem Stride), następnie zapisujemy przez kodek BMP.
+// Bufory >= LOGIC_ARENA_MIN_BYTES alokowane są przez VirtualAlloc (wyrównanie
+// do strony, pamięć wprost od systemu, z pominięciem sterty CRT) w klasach
+// rozmiaru: cztery klasy na każdą potęgę dwójki (64, 80, 96, 112, 128 KB, ...),
+// więc nadmiar klasy nie przekracza 25% żądania. Zwolniony bufor wraca na listę
+// swojej klasy i trafia do kolejnego żądania tej klasy — kolejne obrazy partii
+// (i kolejne partie) nie płacą za alokację ani za page faulty świeżych stron.
+// Łączny rozmiar buforów w pamięci podręcznej ograniczony jest do
+// maxCachedBytes (Lz77ArenaConfigure); nadmiar jest zwracany systemowi.
+// Mniejsze bufory — zwykły operator new, bez pamięci podręcznej.
 //
-// Używamy formatu BMP (image/bmp), bo:
-//   - jest bezstratny (brak kompresji stratnej jak JPEG),
-//   - dekoder BMP jest zawsze dostępny w GDI+,
-//   - wynik dekompresji musi być identyczny piksel-po-pikselu z oryginałem.
+// Duże strony (MEM_LARGE_PAGES) — włączane przez Lz77ArenaConfigure; wymagają
+// uprawnienia SeLockMemoryPrivilege. Bez uprawnienia, lub gdy system nie ma
+// wolnej ciągłej pamięci fizycznej, alokacja wraca do zwykłych stron.
+//
+// UWAGA: arena, jak pula wątków, jest celowo alokowana przez new i nigdy
+// nie niszczona (bufory mogą być zwalniane do końca życia procesu).
 // ============================================================
-static bool SavePixelsAsBMP(const std::wstring& path,
-    const std::vector<uint32_t>& pixels,
-    uint32_t width,
-    uint32_t height)
-{
-    Gdiplus::Bitmap bmp(static_cast<INT>(width),
-        static_cast<INT>(height),
-        PixelFormat32bppARGB);
+static const size_t   LOGIC_ARENA_MIN_BYTES = 64u << 10;
+static const int      LOGIC_ARENA_MIN_SHIFT = 16;                     // log2(LOGIC_ARENA_MIN_BYTES)
+static const int      LOGIC_ARENA_MAX_SHIFT = 47;                     // największa klasa: < 2^48 B
+static const int      LOGIC_ARENA_CLASSES = ((LOGIC_ARENA_MAX_SHIFT - LOGIC_ARENA_MIN_SHIFT) << 2) + 5;
+static const uint64_t LOGIC_ARENA_DEFAULT_CACHED_BYTES = 1ull << 30;
 
-    Gdiplus::Rect rect(0, 0, static_cast<INT>(width), static_cast<INT>(height));
-    Gdiplus::BitmapData bmpData{};
+class BufferArena {
+public:
+    // Bufor co najmniej bytes bajtów; capacity — rzeczywisty rozmiar bufora.
+    // Rzuca std::bad_alloc, gdy system nie ma pamięci.
+    void* Acquire(size_t bytes, size_t& capacity)
+    {
+        if (bytes < LOGIC_ARENA_MIN_BYTES) {
+            capacity = bytes;
+            return ::operator new(bytes);
+        }
 
-    // ImageLockModeWrite — dostęp do zapisu; GDI+ blokuje bufor do czasu UnlockBits.
-    if (bmp.LockBits(&rect,
-        Gdiplus::ImageLockModeWrite,
-        PixelFormat32bppARGB,
-        &bmpData) != Gdiplus::Ok)
-        return false;
+        int cls = ClassOf(bytes, capacity);
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            if (!m_free[cls].empty()) {
+                void* p = m_free[cls].back();
+                m_free[cls].pop_back();
+                m_cachedBytes -= capacity;
+                return p;
+            }
+        }
 
-    // Kopiujemy wiersz po wierszu z uwzględnieniem Stride (patrz LoadImagePixels).
-    for (uint32_t y = 0; y < height; ++y) {
-        memcpy(reinterpret_cast<uint8_t*>(bmpData.Scan0) + y * bmpData.Stride,
-            pixels.data() + y * width,
-            static_cast<size_t>(width) * sizeof(uint32_t));
+        void* p = Allocate(capacity);
+        if (!p) throw std::bad_alloc();
+        return p;
     }
 
-    bmp.UnlockBits(&bmpData);
+    // Zwrot bufora z Acquire; capacity — wartość zwrócona przez Acquire.
+    void Release(void* p, size_t capacity) noexcept
+    {
+        if (!p) return;
+        if (capacity < LOGIC_ARENA_MIN_BYTES) {
+            ::operator delete(p);
+            return;
+        }
 
-    // Szukamy CLSID dla kodera BMP i zapisujemy plik.
-    CLSID bmpClsid{};
-    if (!GetGdiplusEncoderClsid(L"image/bmp", bmpClsid))
-        return false;
+        size_t classBytes = 0;
+        int cls = ClassOf(capacity, classBytes);
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            if (m_cachedBytes + capacity <= m_maxCachedBytes) {
+                try {
+                    m_free[cls].push_back(p);
+                    m_cachedBytes += capacity;
+                    return;
+                }
+                catch (...) {
+                    // Brak pamięci na listę — bufor wraca do systemu.
+                }
+            }
+        }
+        VirtualFree(p, 0, MEM_RELEASE);
+    }
 
-    return bmp.Save(path.c_str(), &bmpClsid) == Gdiplus::Ok;
-}
+    // Limit pamięci podręcznej (0 = LOGIC_ARENA_DEFAULT_CACHED_BYTES) i duże
+    // strony. Zwraca true, jeśli duże strony są dostępne i włączone.
+    bool Configure(uint64_t maxCachedBytes, bool largePages)
+    {
+        size_t largePageBytes = largePages ? EnableLargePages() : 0;
+        m_largePageBytes.store(largePageBytes);
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_maxCachedBytes = maxCachedBytes ? maxCachedBytes : LOGIC_ARENA_DEFAULT_CACHED_BYTES;
+        }
+        TrimTo(m_maxCachedBytes);
+        return largePageBytes != 0;
+    }
 
-// ============================================================
-// WAŻNE: WriteCompressedFile — zapis pliku w formacie .lz77.
-//
-// Format (zgodny z Lz77FileHeader):
-//   [20 bajtów nagłówka] [dataSize bajtów danych tokenów LZ77]
-//
-// Używa WinAPI (CreateFileW / WriteFile) zamiast std::ofstream,
-// bo daje bezpośrednią kontrolę nad trybem dostępu (GENERIC_WRITE)
-// i trybem tworzenia pliku (CREATE_ALWAYS — nadpisuje jeśli istnieje).
-//
-// WAŻNE: Weryfikacja końcowa:
-//   'ok' sprawdza czy oba WriteFile zakończyły się sukcesem.
-//   'written == dataSize' sprawdza czy faktyczna liczba zapisanych bajtów
-//   zgadza się z oczekiwaną (może się różnić np. przy błędzie dysku).
-// ============================================================
-static bool WriteCompressedFile(const std::wstring& path,
-    uint32_t width,
-    uint32_t height,
-    const uint8_t* data,
-    size_t dataSize)
-{
-    HANDLE hFile = CreateFileW(path.c_str(),
-        GENERIC_WRITE, 0, nullptr,
-        CREATE_ALWAYS,          // nadpisz istniejący plik
-        FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (hFile == INVALID_HANDLE_VALUE) return false;
+    // Zwolnienie buforów z pamięci podręcznej (od największych klas), aż
+    // ich łączny rozmiar spadnie do limit bajtów.
+    void TrimTo(uint64_t limit)
+    {
+        std::vector<void*> release;
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            for (int cls = LOGIC_ARENA_CLASSES - 1; cls >= 0 && m_cachedBytes > limit; --cls) {
+                while (!m_free[cls].empty() && m_cachedBytes > limit) {
+                    release.push_back(m_free[cls].back());
+                    m_free[cls].pop_back();
+                    m_cachedBytes -= ClassBytes(cls);
+                }
+            }
+        }
+        // VirtualFree poza muteksem — zwolnienie dużych buforów trwa.
+        for (void* p : release)
+            VirtualFree(p, 0, MEM_RELEASE);
+    }
 
-    // Budujemy strukturę nagłówka z magicznym znacznikiem i wymiarami.
-    Lz77FileHeader hdr{};
-    hdr.magic = LZ77_FILE_MAGIC;
-    hdr.width = width;
-    hdr.height = height;
-    hdr.compressedBytes = static_cast<uint64_t>(dataSize);
+    uint64_t CachedBytes()
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        return m_cachedBytes;
+    }
+
+private:
+    // Klasa rozmiaru: 2^k + sub * 2^(k-2), sub = 0..4 (sub == 4 to klasa 2^(k+1)).
+    static int ClassOf(size_t bytes, size_t& capacity)
+    {
+        if (bytes > (static_cast<size_t>(1) << LOGIC_ARENA_MAX_SHIFT)) throw std::bad_alloc();
+        int k = LOGIC_ARENA_MIN_SHIFT;
+        while ((static_cast<size_t>(1) << (k + 1)) <= bytes) ++k;
+        size_t step = (static_cast<size_t>(1) << k) >> 2;
+        size_t sub = (bytes - (static_cast<size_t>(1) << k) + step - 1) / step;
+        capacity = (static_cast<size_t>(1) << k) + sub * step;
+        return ((k - LOGIC_ARENA_MIN_SHIFT) << 2) + static_cast<int>(sub);
+    }
+
+    static size_t ClassBytes(int cls)
+    {
+        int k = LOGIC_ARENA_MIN_SHIFT + (cls >> 2);
+        return (static_cast<size_t>(1) << k) + (cls & 3) * ((static_cast<size_t>(1) << k) >> 2);
+    }
+
+    void* Allocate(size_t capacity)
+    {
+        // Duże strony tylko dla buforów co najmniej jednej dużej strony —
+        // rozmiar zaokrąglany w górę do jej wielokrotności.
+        size_t largePageBytes = m_largePageBytes.load();
+        if (largePageBytes != 0 && capacity >= largePageBytes) {
+            size_t bytes = (capacity + largePageBytes - 1) / largePageBytes * largePageBytes;
+            void* p = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (p) return p;
+        }
+        return VirtualAlloc(nullptr, capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+
+    // Włączenie SeLockMemoryPrivilege w tokenie procesu; zwraca rozmiar dużej
+    // strony albo 0, gdy duże strony są niedostępne.
+    static size_t EnableLargePages()
+    {
+        SIZE_T largePageBytes = GetLargePageMinimum();
+        if (largePageBytes == 0) return 0;
 
-    DWORD written = 0;
-    // Dwa wywołania WriteFile: najpierw nagłówek, potem dane.
-    // Operator && zapewnia short-circuit: jeśli zapis nagłówka się nie powiedzie,
-    // zapis danych nie jest nawet próbowany.
-    BOOL ok = WriteFile(hFile, &hdr, sizeof(hdr), &written, nullptr);
-    ok = ok && WriteFile(hFile, data, static_cast<DWORD>(dataSize), &written, nullptr);
+        HANDLE token = nullptr;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+            return 0;
 
-    CloseHandle(hFile);
-    return ok && (written == static_cast<DWORD>(dataSize));
+        TOKEN_PRIVILEGES tp{};
+        tp.PrivilegeCount = 1;
+        tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        // AdjustTokenPrivileges zwraca TRUE także bez uprawnienia —
+        // wtedy GetLastError() == ERROR_NOT_ALL_ASSIGNED.
+        bool ok = LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid) &&
+            AdjustTokenPrivileges(token, FALSE, &tp, 0, nullptr, nullptr) &&
+            GetLastError() == ERROR_SUCCESS;
+        CloseHandle(token);
+        return ok ? static_cast<size_t>(largePageBytes) : 0;
+    }
+
+    std::mutex          m_mtx;
+    std::vector<void*>  m_free[LOGIC_ARENA_CLASSES];   // wolne bufory każdej klasy
+    uint64_t            m_cachedBytes = 0;             // łączny rozmiar m_free (pod m_mtx)
+    uint64_t            m_maxCachedBytes = LOGIC_ARENA_DEFAULT_CACHED_BYTES;
+    std::atomic<size_t> m_largePageBytes{ 0 };         // 0 = duże strony wyłączone
+};
+
+static BufferArena& Arena()
+{
+    static BufferArena* arena = new BufferArena();
+    return *arena;
 }
 
 // ============================================================
-// WAŻNE: ReadCompressedFile — odczyt i walidacja pliku .lz77.
+// ArenaBuffer<T> — bufor elementów trywialnych w pamięci BufferArena
+// (interfejs jak std::vector: data / size / resize / operator[]).
 //
-// Kroki:
-//   1. Odczytuje nagłówek (20 bajtów).
-//   2. Sprawdza magic — ochrona przed przypadkowym przetworzeniem błędnego pliku.
-//   3. Sprawdza rozmiar danych — ochrona przed uszkodzonymi plikami, które podają
-//      fałszywy compressedBytes (np. gigantyczną wartość), co mogłoby wyczerpać RAM.
-//      Limit 512 MB to górna rozsądna granica dla obrazu.
-//   4. Alokuje bufor i odczytuje dane tokenów.
-//   5. Weryfikuje, że odczytano dokładnie tyle bajtów, ile deklaruje nagłówek.
+// WAŻNE: resize NIE zeruje nowych elementów — ich zawartość jest nieokreślona
+// (przy powiększeniu zachowywany jest tylko dotychczasowy prefiks). Bufory
+// potoku są w całości nadpisywane (LockBits, kompresor, dekoder),
+// więc zerowanie byłoby zbędnym przejściem po całej pamięci obrazu.
+// Gdzie potrzebna jest wartość początkowa — assign(n, v).
+// clear() zwraca pamięć do areny (nie tylko zeruje rozmiar).
 // ============================================================
-static bool ReadCompressedFile(const std::wstring& path,
-    uint32_t& width,
-    uint32_t& height,
-    std::vector<uint8_t>& data)
-{
-    // FILE_SHARE_READ pozwala innym procesom jednocześnie czytać plik (nieblokujące).
-    HANDLE hFile = CreateFileW(path.c_str(),
-        GENERIC_READ, FILE_SHARE_READ, nullptr,
-        OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (hFile == INVALID_HANDLE_VALUE) return false;
+template <class T>
+class ArenaBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "ArenaBuffer: tylko typy trywialne");
 
-    Lz77FileHeader hdr{};
-    DWORD read = 0;
-    ReadFile(hFile, &hdr, sizeof(hdr), &read, nullptr);
+public:
+    ArenaBuffer() = default;
+    ~ArenaBuffer() { clear(); }
 
-    // WAŻNE: Podwójna walidacja nagłówka — sprawdzamy zarówno liczbę odczytanych
-    // bajtów (czy plik nie jest krótszy od nagłówka) jak i magic number.
-    if (read != sizeof(hdr) || hdr.magic != LZ77_FILE_MAGIC) {
-        CloseHandle(hFile);
-        return false;
+    ArenaBuffer(ArenaBuffer&& other) noexcept
+        : m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity)
+    {
+        other.m_data = nullptr;
+        other.m_size = other.m_capacity = 0;
+    }
+
+    ArenaBuffer& operator=(ArenaBuffer&& other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_capacity, other.m_capacity);
+        }
+        return *this;
     }
 
-    width = hdr.width;
-    height = hdr.height;
+    ArenaBuffer(const ArenaBuffer&) = delete;
+    ArenaBuffer& operator=(const ArenaBuffer&) = delete;
 
-    // WAŻNE: Zabezpieczenie przed przepełnieniem pamięci.
-    // Zerowe compressedBytes oznacza pusty plik; > 512 MB to prawdopodobnie
-    // uszkodzone pole nagłówka. Bez tego limitu wektor mógłby spróbować zarezerwować
-    // terabajty pamięci i zakończyć się std::bad_alloc lub naruszeniem ochrony pamięci.
-    if (hdr.compressedBytes == 0 || hdr.compressedBytes > 512u * 1024u * 1024u) {
-        // Zabezpieczenie przed uszkodzonymi/gigantycznymi plikami (> 512 MB)
-        CloseHandle(hFile);
-        return false;
+    T*       data() { return m_data; }
+    const T* data() const { return m_data; }
+    size_t   size() const { return m_size; }
+    bool     empty() const { return m_size == 0; }
+    T*       begin() { return m_data; }
+    T*       end() { return m_data + m_size; }
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+    T&       operator[](size_t i) { return m_data[i]; }
+    const T& operator[](size_t i) const { return m_data[i]; }
+
+    void resize(size_t count)
+    {
+        if (count > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+        if (count * sizeof(T) > m_capacity) {
+            size_t capacity = 0;
+            T* p = static_cast<T*>(Arena().Acquire(count * sizeof(T), capacity));
+            if (m_size) memcpy(p, m_data, m_size * sizeof(T));
+            Arena().Release(m_data, m_capacity);
+            m_data = p;
+            m_capacity = capacity;
+        }
+        m_size = count;
     }
 
-    data.resize(static_cast<size_t>(hdr.compressedBytes));
-    ReadFile(hFile, data.data(), static_cast<DWORD>(hdr.compressedBytes), &read, nullptr);
+    void assign(size_t count, const T& value)
+    {
+        resize(count);
+        std::fill(begin(), end(), value);
+    }
 
-    CloseHandle(hFile);
-    return (read == static_cast<DWORD>(hdr.compressedBytes));
-}
+    void clear()
+    {
+        Arena().Release(m_data, m_capacity);
+        m_data = nullptr;
+        m_size = m_capacity = 0;
+    }
 
-// ============================================================
-// Zbiór rozszerzeń obrazkow obsługiwanych przez GDI+.
-// Używany w StartCompression do filtrowania plików podczas iteracji katalogu.
-// std::set<> zapewnia O(log n) wyszukiwanie — wydajniejsze niż liniowe
-// porównywanie dla potencjalnie dużej listy rozszerzeń.
-// ============================================================
-static const std::set<std::wstring> IMAGE_EXTENSIONS = {
-    L".png", L".jpg", L".jpeg", L".bmp",
-    L".tiff", L".tif", L".gif"
+private:
+    T*     m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = 0;   // w bajtach (rozmiar bufora z Acquire)
 };
 
+using PixelBuffer = ArenaBuffer<uint32_t>;
+using ByteBuffer = ArenaBuffer<uint8_t>;
+
 // ============================================================
-// WAŻNE: StartCompression — główna funkcja kompresji, eksportowana do C#.
+// WAŻNE: WorkerPool — stała pula wątków roboczych Logic.dll, wspólna dla
+// wszystkich partii (Start*, Lz77Decode*) w procesie.
 //
-// Architektura pomiaru czasu — trzy oddzielne fazy:
+// Każdy wątek ma własną kolejkę zadań (deque pod własnym muteksem):
+//   - zadania zgłaszane z zewnątrz trafiają do kolejek po kolei (round-robin),
+//   - wątek bierze zadania z końca własnej kolejki, a gdy jest pusta —
+//     kradnie z początku kolejek innych wątków (work stealing).
+// Wątek bez pracy śpi na zmiennej warunkowej (licznik m_pending zadań
+// w kolejkach), więc bezczynna pula nie zużywa CPU.
 //
-//   FAZA 1 — PRE-LOAD (przed stoperem):
-//     Wszystkie operacje I/O i alokacje pamięci wykonywane są w wątku głównym
-//     zanim stoper zostanie uruchomiony. Dla każdego pliku obrazu:
-//       - wczytanie pikseli RGBA przez GDI+ (LoadImagePixels),
-//       - pre-alokacja bufora wyjściowego dst (worst-case LZ77),
-//       - pre-alokacja bufora roboczego work (head[] + prev[]).
-//     Dzięki temu żadne I/O ani malloc nie wchodzi do sekcji mierzonej.
-//
-//   FAZA 2 — MIERZONA (tstart … tend):
-//     Obejmuje dokładnie i wyłącznie:
-//       - tworzenie wątków roboczych (emplace_back),
-//       - wywołania compFn() we wszystkich wątkach,
-//       - oczekiwanie na zakończenie wątków (join()).
-//     Wątki NIE wykonują żadnego I/O — operują wyłącznie na pre-alokowanych
-//     buforach w pamięci RAM.
-//
-//   FAZA 3 — POST (po stoperze):
-//     Sekwencyjny zapis wyników na dysk, wywołania logCb i progressCb.
-//
-// Gwarancja poprawności pomiaru:
-//   - Każde wywołanie compFn() jest objęte przedziałem [tstart, tend]. ✓
-//   - Żaden I/O (odczyt obrazu, zapis .lz77) nie wchodzi do [tstart, tend]. ✓
-//   - tstart jest pobierany tuż przed pierwszym emplace_back(). ✓
-//   - tend jest pobierany tuż po ostatnim join(). ✓
+// WorkerScratch — pamięć podręczna wątku (bufor roboczy head[] + prev[]
+// kompresora, z BufferArena), alokowana raz i używana przez kolejne
+// partie — "ciepła" w pamięci podręcznej CPU i bez kosztu alokacji na partię.
+//
+// Rozmiar puli:
+//   - Lz77PoolStart(n) — jawny rozmiar; partie nie zmieniają go, a ich
+//     równoległość jest ograniczona do n wątków,
+//   - bez Lz77PoolStart pula startuje przy pierwszej partii i rośnie do
+//     największej zamówionej liczby wątków (Acquire).
+// Lz77PoolShutdown kończy wątki po wykonaniu zadań z kolejek; kolejna
+// partia uruchomi pulę ponownie.
+//
+// UWAGA: pula jest celowo alokowana przez new i nigdy nie niszczona —
+// destruktor std::thread przy wyładowaniu DLL (DLL_PROCESS_DETACH, wątki
+// już zakończone przez system) wywołałby std::terminate.
+// Lz77PoolShutdown nie może być wołane z zadania puli (join samego siebie).
 // ============================================================
-void __stdcall StartCompression(
-    const wchar_t* sourceFolder,
-    const wchar_t* outputFolder,
-    bool             useASM,
-    int              numThreads,
-    ProgressCallback progressCb,
-    LogCallback      logCb,
-    int64_t* outElapsedMs)
-{
-    // --- Ladujemy JEDNA wybrana DLL (nie obie naraz)
-    HMODULE          hMod = nullptr;
-    LZ77CompressFunc compFn = nullptr;
-    LZ77DecompressFunc decompFn = nullptr;  // wymagane przez LoadLZ77DLL, nieużywane tutaj
-    std::wstring dllError;
+static const int LOGIC_POOL_MAX_THREADS = 256;
 
-    if (!LoadLZ77DLL(useASM, hMod, compFn, decompFn, dllError)) {
-        if (logCb) logCb((L"Blad ladowania DLL: " + dllError).c_str());
-        return;
+struct WorkerScratch {
+    ByteBuffer  work;
+    PixelBuffer pixels;   // reszty filtrów wierszy bloku (kompresja i dekompresja)
+    ByteBuffer  coded;    // blok po kodowaniu entropijnym (wymieniany z wyjściem bloku)
+
+    // Bufor roboczy o rozmiarze co najmniej bytes (rośnie, nigdy nie maleje).
+    ByteBuffer& Work(size_t bytes)
+    {
+        if (work.size() < bytes) work.resize(bytes);
+        return work;
     }
-    if (logCb) logCb(useASM ? L"Zaladowano DLL: AsmDll.dll"
-        : L"Zaladowano DLL: CppDll.dll");
 
-    // ============================================================
-    // Struktura zadania kompresji — przechowuje wszystko, czego
-    // potrzebuje wątek roboczy (pre-wczytane dane + pre-alokowane bufory).
-    // Wypełniana w całości w FAZIE 1 (przed stoperem).
-    // ============================================================
-    struct CompressTask {
-        std::wstring          filePath;   // oryginalna ścieżka (do logowania i zapisu)
-        std::vector<uint32_t> pixels;     // pre-wczytane piksele RGBA
-        uint32_t              w = 0;      // szerokość obrazu
-        uint32_t              h = 0;      // wysokość obrazu
-        std::vector<uint8_t>  dst;        // pre-alokowany bufor wyjściowy (tokeny LZ77)
-        std::vector<uint8_t>  work;       // pre-alokowany bufor roboczy (head[] + prev[])
-        size_t                outLen = 0; // [out] liczba zapisanych bajtów po compFn
-        bool                  loadOk = false;    // czy wczytanie obrazu się powiodło
-        bool                  exception = false; // czy compFn rzuciła wyjątek
-    };
+    // Bufor count pikseli — jak Work.
+    PixelBuffer& Pixels(size_t count)
+    {
+        if (pixels.size() < count) pixels.resize(count);
+        return pixels;
+    }
 
-    // ============================================================
-    // FAZA 1: PRE-LOAD — wczytanie obrazów i alokacja buforów.
-    //
-    // Wykonywana sekwencyjnie w wątku głównym, PRZED uruchomieniem stopera.
-    // Obejmuje wszystkie operacje I/O i malloc dla wszystkich plików.
-    // ============================================================
-    std::vector<CompressTask> tasks;
+    // Bufor bytes bajtów — jak Work.
+    ByteBuffer& Coded(size_t bytes)
+    {
+        if (coded.size() < bytes) coded.resize(bytes);
+        return coded;
+    }
+};
 
-    try {
-        for (auto& entry : fs::directory_iterator(sourceFolder)) {
-            if (!entry.is_regular_file()) continue;
-            std::wstring ext = entry.path().extension().wstring();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
-            if (!IMAGE_EXTENSIONS.count(ext)) continue;
+class WorkerPool {
+public:
+    using Task = std::function<void(WorkerScratch&)>;
+
+    // Jawny start z n wątkami (po zakończeniu poprzedniej puli).
+    bool Start(int threads)
+    {
+        std::lock_guard<std::mutex> lock(m_stateMtx);
+        StopLocked();
+        m_explicit = true;
+        return GrowLocked(threads);
+    }
+
+    void Shutdown()
+    {
+        std::lock_guard<std::mutex> lock(m_stateMtx);
+        StopLocked();
+        m_explicit = false;
+    }
+
+    int Size() const { return static_cast<int>(m_count.load(std::memory_order_acquire)); }
+
+    // Pula gotowa dla partii z threads wątkami; zwraca liczbę wątków puli.
+    int Acquire(int threads)
+    {
+        std::lock_guard<std::mutex> lock(m_stateMtx);
+        if (m_count.load() == 0 || (!m_explicit && Size() < threads))
+            GrowLocked(threads);
+        return Size();
+    }
+
+    // Zgłoszenie zadania; pula zatrzymana w międzyczasie (Lz77PoolShutdown
+    // z innego wątku) startuje ponownie z jednym wątkiem.
+    void Submit(Task task)
+    {
+        std::lock_guard<std::mutex> state(m_stateMtx);
+        if (m_count.load() == 0) GrowLocked(1);
+        size_t count = m_count.load(std::memory_order_acquire);
+        Worker& w = *m_workers[m_next.fetch_add(1, std::memory_order_relaxed) % count];
+        {
+            std::lock_guard<std::mutex> lock(w.mtx);
+            w.tasks.push_back(std::move(task));
+        }
+        m_pending.fetch_add(1);
+        // Pusty lock przed notify — wątek sprawdzający m_pending pod m_sleepMtx
+        // nie przegapi powiadomienia.
+        { std::lock_guard<std::mutex> lock(m_sleepMtx); }
+        m_cv.notify_one();
+    }
+
+private:
+    struct Worker {
+        std::mutex       mtx;
+        std::deque<Task> tasks;
+        WorkerScratch    scratch;
+        std::thread      thread;
+    };
+
+    bool GrowLocked(int threads)
+    {
+        threads = std::min(std::max(1, threads), LOGIC_POOL_MAX_THREADS);
+        try {
+            for (size_t i = m_count.load(); i < static_cast<size_t>(threads); ++i) {
+                m_workers[i] = std::make_unique<Worker>();
+                m_workers[i]->thread = std::thread(&WorkerPool::Run, this, i);
+                m_count.store(i + 1, std::memory_order_release);
+            }
+        }
+        catch (...) {
+            return false;   // brak zasobów na kolejny wątek — pula pozostaje mniejsza
+        }
+        return true;
+    }
+
+    void StopLocked()
+    {
+        size_t count = m_count.load();
+        if (count == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMtx);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (size_t i = 0; i < count; ++i)
+            m_workers[i]->thread.join();
+        m_count.store(0);
+        for (size_t i = 0; i < count; ++i)
+            m_workers[i].reset();
+        m_stop = false;
+    }
+
+    // Zadanie z końca własnej kolejki albo skradzione z początku cudzej.
+    bool TryPop(size_t self, Task& task)
+    {
+        size_t count = m_count.load(std::memory_order_acquire);
+        for (size_t k = 0; k < count; ++k) {
+            Worker& w = *m_workers[(self + k) % count];
+            std::lock_guard<std::mutex> lock(w.mtx);
+            if (w.tasks.empty()) continue;
+            if (k == 0) {
+                task = std::move(w.tasks.back());
+                w.tasks.pop_back();
+            }
+            else {
+                task = std::move(w.tasks.front());
+                w.tasks.pop_front();
+            }
+            m_pending.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    void Run(size_t self)
+    {
+        WorkerScratch& scratch = m_workers[self]->scratch;
+        Task task;
+        while (true) {
+            if (TryPop(self, task)) {
+                task(scratch);
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_sleepMtx);
+            // Zakończenie dopiero po opróżnieniu kolejek — zgłoszone partie kończą się.
+            if (m_stop && m_pending.load() == 0) break;
+            m_cv.wait(lock, [&]() { return m_pending.load() > 0 || m_stop; });
+        }
+    }
+
+    std::array<std::unique_ptr<Worker>, LOGIC_POOL_MAX_THREADS> m_workers;
+    std::atomic<size_t> m_count{ 0 };
+    std::atomic<size_t> m_next{ 0 };
+    std::atomic<size_t> m_pending{ 0 };
+    std::mutex          m_stateMtx;      // Start / Shutdown / Acquire / Submit
+    std::mutex          m_sleepMtx;
+    std::condition_variable m_cv;
+    bool                m_stop = false;  // pod m_sleepMtx
+    bool                m_explicit = false;
+};
+
+static WorkerPool& Pool()
+{
+    static WorkerPool* pool = new WorkerPool();
+    return *pool;
+}
+
+// ============================================================
+// PoolGroup — zgłoszenie n kopii zadania partii do puli i oczekiwanie
+// na ich zakończenie (odpowiednik utworzenia n wątków i join()).
+// ============================================================
+class PoolGroup {
+public:
+    void Run(int copies, const WorkerPool::Task& task)
+    {
+        m_left = copies;
+        for (int i = 0; i < copies; ++i) {
+            Pool().Submit([this, task](WorkerScratch& scratch) {
+                task(scratch);
+                std::lock_guard<std::mutex> lock(m_mtx);
+                if (--m_left == 0) m_cv.notify_all();
+                });
+        }
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_cv.wait(lock, [&]() { return m_left == 0; });
+    }
+
+private:
+    std::mutex              m_mtx;
+    std::condition_variable m_cv;
+    int                     m_left = 0;
+};
+
+// Liczba kopii zadania partii (PoolGroup::Run) dla threads wątków: najwyżej
+// rozmiar puli. Pula mniejsza niż threads (Lz77PoolStart) i tak ogranicza
+// równoległość, a nadmiarowe kopie ruszyłyby dopiero po wyczerpaniu pracy —
+// ich zerowy czas pracy zawyżałby nierównowagę (ComputeBatchStats).
+static int PoolWorkersFor(int threads)
+{
+    return std::max(1, std::min(threads, Pool().Acquire(threads)));
+}
+
+static const KernelEntry* FindKernelById(uint32_t id)
+{
+    for (const KernelEntry& e : g_kernels)
+        if (e.info.id == id) return &e;
+    return nullptr;
+}
+
+// Rozwinięcie LOGIC_KERNEL_DEFAULT / LOGIC_KERNEL_FASTEST do wpisu rejestru.
+static const KernelEntry* ResolveKernel(uint32_t kernel, bool useASM)
+{
+    EnsureKernelRegistry();
+    if (kernel == LOGIC_KERNEL_DEFAULT)
+        return FindKernelById(useASM ? LOGIC_KERNEL_ASM : LOGIC_KERNEL_CPP);
+    if (kernel == LOGIC_KERNEL_FASTEST) {
+        const KernelEntry* best = nullptr;
+        std::lock_guard<std::mutex> lock(g_kernelMtx);
+        for (const KernelEntry& e : g_kernels)
+            if (e.info.compressMBps > 0.0 && (!best || e.info.compressMBps > best->info.compressMBps))
+                best = &e;
+        return best ? best : FindKernelById(LOGIC_KERNEL_CPP);
+    }
+    return FindKernelById(kernel);
+}
+
+// ============================================================
+// AcquireKernel — kernel dla jednej partii plików (Start*, Lz77Decode*).
+// Zwraca false z komunikatem, gdy kernel jest niedostępny. Ani poziom SIMD,
+// ani struktura wyszukiwania dopasowań nie są stanem DLL — wątki partii
+// ustawiają poziom dla siebie (KernelSimdScope), a kompresja przekazuje
+// strukturę w każdym wywołaniu (KernelMatchFinder).
+// ============================================================
+static bool AcquireKernel(uint32_t kernel, bool useASM,
+    const KernelEntry*& entry,
+    std::wstring& errorOut)
+{
+    entry = ResolveKernel(kernel, useASM);
+    if (!entry) {
+        std::wstringstream ss;
+        ss << L"Kernel LZ77 niedostepny (id " << kernel << L")";
+        if (!g_kernelErrors.empty()) ss << L": " << g_kernelErrors;
+        errorOut = ss.str();
+        return false;
+    }
+    return true;
+}
+
+// ============================================================
+// KernelSimdScope — poziom SIMD wariantu "cpp-*" dla wywołań CppDll.dll
+// z bieżącego wątku (lz77_set_thread_simd_level); destruktor przywraca
+// poziom procesu (wybór CPUID), więc wątek puli nie przenosi go do kolejnej
+// partii. Równoległe partie z różnymi wariantami nie nadpisują sobie wyboru.
+// ============================================================
+class KernelSimdScope {
+public:
+    explicit KernelSimdScope(const KernelEntry* entry)
+        : m_set(entry && entry->info.simdLevel >= 0 ? entry->api.setThreadSimdLevel : nullptr)
+    {
+        if (m_set) m_set(entry->info.simdLevel);
+    }
+    ~KernelSimdScope()
+    {
+        if (m_set) m_set(-1);
+    }
+
+    KernelSimdScope(const KernelSimdScope&) = delete;
+    KernelSimdScope& operator=(const KernelSimdScope&) = delete;
+
+private:
+    LZ77SetSimdLevelFunc m_set;
+};
+
+// Struktura wyszukiwania dopasowań kernela (LOGIC_MATCH_FINDER_*) dla
+// compressEx / streamBeginEx; kubełki tylko dla "cpp-bucket".
+static int KernelMatchFinder(const KernelEntry* entry)
+{
+    return (entry->info.caps & LOGIC_KERNEL_CAP_BUCKET) ? LOGIC_MATCH_FINDER_BUCKET : LOGIC_MATCH_FINDER_CHAIN;
+}
+
+// Zapis pomiaru partii: bytes danych pikseli w us mikrosekund czasu kernela
+// (suma po wątkach). Pusta partia nie zmienia poprzedniego pomiaru.
+static void RecordKernelThroughput(const KernelEntry* entry, bool compress, uint64_t bytes, int64_t us)
+{
+    if (!entry || bytes == 0 || us <= 0) return;
+    double mbps = static_cast<double>(bytes) / static_cast<double>(us);
+    std::lock_guard<std::mutex> lock(g_kernelMtx);
+    KernelEntry& e = const_cast<KernelEntry&>(*entry);
+    (compress ? e.info.compressMBps : e.info.decompressMBps) = mbps;
+}
+
+// Nazwa kernela do logu, np. "cpp-avx2 (CppDll.dll)".
+static std::wstring KernelLabel(const KernelEntry& entry)
+{
+    std::string label = std::string(entry.info.name) + " (" + entry.info.module + ")";
+    return std::wstring(label.begin(), label.end());
+}
+
+// ============================================================
+// Dekodery obrazów (opis przy Lz77ImageProbeFunc w logic.h).
+//
+// Dekodery czytają cały plik z pamięci (widok MappedFile lub blok odczytu
+// asynchronicznego) i nie mają stanu — w przeciwieństwie do GDI+, który
+// szereguje dekodowanie wewnętrznie, skalują się z liczbą wątków.
+// Rejestr: wbudowane dekodery, potem zewnętrzne (Lz77RegisterImageDecoder).
+// Wpisy są tylko dopisywane — czytelnik bierze liczbę wpisów (acquire)
+// i czyta je bez blokady.
+// ============================================================
+static inline uint32_t ReadLe16(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8);
+}
+
+static inline uint32_t ReadLe32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));   // x86/x64 — little-endian
+    return v;
+}
+
+static inline uint32_t PackArgb(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    return (static_cast<uint32_t>(a) << 24) | (static_cast<uint32_t>(r) << 16) |
+        (static_cast<uint32_t>(g) << 8) | b;
+}
+
+// ------------------------------------------------------------
+// BMP: BITMAPFILEHEADER (14 B) + BITMAPINFOHEADER lub V4/V5 (biSize >= 40).
+// Wiersze wyrównane do 4 bajtów; dodatnia wysokość = wiersze od dołu.
+// ------------------------------------------------------------
+struct BmpLayout {
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;         // 24 lub 32
+    bool     topDown;
+    bool     alpha;       // 32 bpp z maską alfa — bez niej alfa = 255 (jak GDI+)
+    uint64_t offset;      // początek pikseli (bfOffBits)
+    uint64_t stride;      // bajtów na wiersz w pliku
+};
+
+static bool ParseBmp(const uint8_t* data, uint64_t bytes, BmpLayout& bmp)
+{
+    const uint32_t BI_RGB = 0, BI_BITFIELDS = 3;
+    if (bytes < 54 || data[0] != 'B' || data[1] != 'M') return false;
+
+    uint32_t infoSize = ReadLe32(data + 14);
+    int32_t  w = static_cast<int32_t>(ReadLe32(data + 18));
+    int32_t  h = static_cast<int32_t>(ReadLe32(data + 22));
+    uint32_t planes = ReadLe16(data + 26);
+    uint32_t bpp = ReadLe16(data + 28);
+    uint32_t compression = ReadLe32(data + 30);
+    if (infoSize < 40 || planes != 1 || w <= 0 || h == 0 || h == INT32_MIN) return false;
+
+    bmp.alpha = false;
+    if (bpp == 24 && compression == BI_RGB) {
+        // 3 bajty B, G, R na piksel.
+    }
+    else if (bpp == 32 && compression == BI_RGB) {
+        // Czwarty bajt pomijany — GDI+ wczytuje taki plik jako PixelFormat32bppRGB.
+    }
+    else if (bpp == 32 && compression == BI_BITFIELDS) {
+        // Maski za BITMAPINFOHEADER (biSize 40) lub w nagłówku V4/V5 — te same offsety.
+        if (bytes < 66) return false;
+        uint32_t alphaMask = (infoSize >= 56 && bytes >= 70) ? ReadLe32(data + 66) : 0;
+        if (ReadLe32(data + 54) != 0x00FF0000u || ReadLe32(data + 58) != 0x0000FF00u ||
+            ReadLe32(data + 62) != 0x000000FFu || (alphaMask != 0 && alphaMask != 0xFF000000u))
+            return false;
+        bmp.alpha = alphaMask != 0;
+    }
+    else {
+        return false;   // paleta, RLE, 16 bpp, JPEG/PNG w BMP — GDI+
+    }
+
+    bmp.width = static_cast<uint32_t>(w);
+    bmp.height = h < 0 ? static_cast<uint32_t>(-static_cast<int64_t>(h)) : static_cast<uint32_t>(h);
+    bmp.bpp = bpp;
+    bmp.topDown = h < 0;
+    bmp.offset = ReadLe32(data + 10);
+    bmp.stride = (static_cast<uint64_t>(bmp.width) * bpp + 31) / 32 * 4;
+
+    // Ostatni wiersz może nie mieć wyrównania na końcu pliku.
+    uint64_t rowBytes = static_cast<uint64_t>(bmp.width) * (bpp / 8);
+    return bmp.offset >= 54 && bmp.offset <= bytes && bytes - bmp.offset >= rowBytes &&
+        (bytes - bmp.offset - rowBytes) / bmp.stride >= bmp.height - 1;
+}
+
+static bool __stdcall ProbeBmp(const uint8_t* data, uint64_t bytes, uint32_t* outWidth, uint32_t* outHeight)
+{
+    BmpLayout bmp{};
+    if (!ParseBmp(data, bytes, bmp)) return false;
+    *outWidth = bmp.width;
+    *outHeight = bmp.height;
+    return true;
+}
+
+static bool __stdcall DecodeBmp(const uint8_t* data, uint64_t bytes, uint32_t width, uint32_t height, uint32_t* dst)
+{
+    BmpLayout bmp{};
+    if (!ParseBmp(data, bytes, bmp) || bmp.width != width || bmp.height != height) return false;
+
+    // 32 bpp z alfą i wierszami od góry ma układ bufora obrazu — jedna kopia.
+    if (bmp.bpp == 32 && bmp.alpha && bmp.topDown) {
+        memcpy(dst, data + bmp.offset, static_cast<size_t>(width) * height * sizeof(uint32_t));
+        return true;
+    }
+
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* src = data + bmp.offset + (bmp.topDown ? y : height - 1 - y) * bmp.stride;
+        uint32_t* row = dst + static_cast<size_t>(y) * width;
+        if (bmp.bpp == 32) {
+            memcpy(row, src, static_cast<size_t>(width) * sizeof(uint32_t));
+            if (!bmp.alpha)
+                for (uint32_t x = 0; x < width; ++x)
+                    row[x] |= 0xFF000000u;
+        }
+        else {
+            for (uint32_t x = 0; x < width; ++x, src += 3)
+                row[x] = PackArgb(src[2], src[1], src[0], 0xFF);
+        }
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// PPM (P6) i PAM (P7) — jak w lz77img (Lz77Cli/image_io.cpp): słowa nagłówka
+// rozdzielone białymi znakami, komentarze od '#' do końca wiersza.
+// ------------------------------------------------------------
+struct PnmLayout {
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;       // 3 = RGB, 4 = RGBA
+    uint64_t offset;      // początek pikseli
+};
+
+static bool NextPnmToken(const uint8_t* data, uint64_t bytes, uint64_t& pos, std::string& token)
+{
+    token.clear();
+    while (pos < bytes) {
+        if (data[pos] == '#') {
+            while (pos < bytes && data[pos] != '\n') ++pos;
+        }
+        else if (isspace(data[pos])) {
+            ++pos;
+        }
+        else {
+            break;
+        }
+    }
+    // Słowa nagłówka są krótkie — dłuższe oznaczają inny plik.
+    while (pos < bytes && !isspace(data[pos]) && data[pos] != '#' && token.size() < 16)
+        token += static_cast<char>(data[pos++]);
+    return !token.empty();
+}
+
+// Liczba dziesiętna z zakresu 1..0xFFFFFFFF.
+static bool ParsePnmNumber(const std::string& token, uint32_t& value)
+{
+    if (token.empty() || token.size() > 10 ||
+        !std::all_of(token.begin(), token.end(), [](char c) { return c >= '0' && c <= '9'; }))
+        return false;
+    unsigned long long v = std::stoull(token);
+    if (v == 0 || v > 0xFFFFFFFFull) return false;
+    value = static_cast<uint32_t>(v);
+    return true;
+}
+
+static bool ParsePnm(const uint8_t* data, uint64_t bytes, PnmLayout& pnm)
+{
+    if (bytes < 3 || data[0] != 'P' || (data[1] != '6' && data[1] != '7') || !isspace(data[2]))
+        return false;
+
+    uint64_t pos = 2;
+    std::string token, maxval;
+    pnm.width = pnm.height = pnm.depth = 0;
+    if (data[1] == '6') {
+        std::string w, h;
+        if (!NextPnmToken(data, bytes, pos, w) || !NextPnmToken(data, bytes, pos, h) ||
+            !NextPnmToken(data, bytes, pos, maxval) ||
+            !ParsePnmNumber(w, pnm.width) || !ParsePnmNumber(h, pnm.height))
+            return false;
+        pnm.depth = 3;
+        pos += 1;   // po MAXVAL dokładnie jeden biały znak, potem dane
+    }
+    else {
+        // PAM: wiersze "KLUCZ wartość" aż do ENDHDR.
+        while (true) {
+            if (!NextPnmToken(data, bytes, pos, token)) return false;
+            if (token == "ENDHDR") break;
+
+            std::string value;
+            while (pos < bytes && data[pos] != '\n' && value.size() < 64) value += static_cast<char>(data[pos++]);
+            value.erase(0, value.find_first_not_of(" \t\r"));
+            value.erase(value.find_last_not_of(" \t\r") + 1);
+
+            if (token == "WIDTH" && !ParsePnmNumber(value, pnm.width)) return false;
+            if (token == "HEIGHT" && !ParsePnmNumber(value, pnm.height)) return false;
+            if (token == "DEPTH" && !ParsePnmNumber(value, pnm.depth)) return false;
+            if (token == "MAXVAL") maxval = value;
+        }
+        while (pos < bytes && data[pos] != '\n') ++pos;
+        pos += 1;   // dane zaczynają się za znakiem nowej linii po ENDHDR
+    }
+
+    pnm.offset = pos;
+    uint64_t count = static_cast<uint64_t>(pnm.width) * pnm.height;
+    return pnm.width != 0 && pnm.height != 0 && (pnm.depth == 3 || pnm.depth == 4) &&
+        maxval == "255" && pos <= bytes && (bytes - pos) / pnm.depth >= count;
+}
+
+static bool __stdcall ProbePnm(const uint8_t* data, uint64_t bytes, uint32_t* outWidth, uint32_t* outHeight)
+{
+    PnmLayout pnm{};
+    if (!ParsePnm(data, bytes, pnm)) return false;
+    *outWidth = pnm.width;
+    *outHeight = pnm.height;
+    return true;
+}
+
+static bool __stdcall DecodePnm(const uint8_t* data, uint64_t bytes, uint32_t width, uint32_t height, uint32_t* dst)
+{
+    PnmLayout pnm{};
+    if (!ParsePnm(data, bytes, pnm) || pnm.width != width || pnm.height != height) return false;
+
+    const uint8_t* src = data + pnm.offset;
+    size_t count = static_cast<size_t>(width) * height;
+    if (pnm.depth == 4) {
+        for (size_t i = 0; i < count; ++i, src += 4)
+            dst[i] = PackArgb(src[0], src[1], src[2], src[3]);
+    }
+    else {
+        for (size_t i = 0; i < count; ++i, src += 3)
+            dst[i] = PackArgb(src[0], src[1], src[2], 0xFF);
+    }
+    return true;
+}
+
+struct ImageDecoderEntry {
+    Lz77ImageProbeFunc  probe;
+    Lz77ImageDecodeFunc decode;
+};
+
+static const uint32_t LOGIC_BUILTIN_IMAGE_DECODERS = 2;
+static ImageDecoderEntry     g_imageDecoders[LOGIC_MAX_IMAGE_DECODERS] = {
+    { ProbeBmp, DecodeBmp },
+    { ProbePnm, DecodePnm },
+};
+static std::atomic<uint32_t> g_imageDecoderCount{ LOGIC_BUILTIN_IMAGE_DECODERS };
+static std::mutex            g_imageDecoderMtx;   // dopisywanie wpisów
+
+// Wymiary obrazu z pliku w pamięci; false — żaden dekoder nie rozpoznał formatu.
+static bool ProbeImageBytes(const uint8_t* data, uint64_t bytes, uint32_t& width, uint32_t& height)
+{
+    uint32_t count = g_imageDecoderCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i)
+        if (g_imageDecoders[i].probe(data, bytes, &width, &height)) return true;
+    return false;
+}
+
+// Dekodowanie pliku w pamięci pierwszym dekoderem, który rozpozna format.
+// recognized == false — format nieznany, wywołujący przechodzi na GDI+.
+static bool DecodeImageBytes(const uint8_t* data,
+    uint64_t bytes,
+    PixelBuffer& pixels,
+    uint32_t& width,
+    uint32_t& height,
+    bool& recognized)
+{
+    recognized = false;
+    uint32_t count = g_imageDecoderCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i) {
+        const ImageDecoderEntry& decoder = g_imageDecoders[i];
+        uint32_t w = 0, h = 0;
+        if (!decoder.probe(data, bytes, &w, &h)) continue;
+
+        recognized = true;
+        if (w == 0 || h == 0 || static_cast<uint64_t>(w) * h > SIZE_MAX / sizeof(uint32_t))
+            return false;
+        // Bez zerowania — dekoder zapisuje każdy piksel.
+        pixels.resize(static_cast<size_t>(w) * h);
+        if (!decoder.decode(data, bytes, w, h, pixels.data())) return false;
+        width = w;
+        height = h;
+        return true;
+    }
+    return false;
+}
+
+// ============================================================
+// WAŻNE: LoadImagePixels — wczytywanie obrazu do liniowej tablicy pikseli RGBA.
+//
+// Najpierw dekodery z rejestru (BMP, PPM, PAM i zewnętrzne — bez GDI+);
+// pozostałe formaty przez GDI+ (Gdiplus::Bitmap) — PNG, JPG, TIFF, GIF i inne.
+// Wszystkie formaty są sprowadzane do jednolitego formatu PixelFormat32bppARGB:
+//   każdy piksel = 4 bajty [Alpha, Red, Green, Blue].
+//
+// WAŻNE — obsługa Stride:
+//   Stride (bmpData.Stride) to liczba bajtów w jednym wierszu danych GDI+.
+//   Może być WIĘKSZY niż width * 4, ponieważ GDI+ wyrównuje wiersze
+//   do wielokrotności 4 bajtów. Dlatego kopiujemy wiersz po wierszu
+//   (pętla po y), a nie całość jednym memcpy — kopiowałoby padding!
+//
+// LoadBitmapPixels — wspólna część dla obrazu z pliku (LoadImagePixels)
+// i z pamięci (LoadImagePixelsFromMemory); przejmuje i zwalnia bmp.
+// ============================================================
+static bool LoadBitmapPixels(Gdiplus::Bitmap* bmp,
+    PixelBuffer& pixels,
+    uint32_t& width,
+    uint32_t& height)
+{
+    // GetLastStatus() sprawdza czy GDI+ załadował obraz poprawnie.
+    if (!bmp || bmp->GetLastStatus() != Gdiplus::Ok) {
+        delete bmp;
+        return false;
+    }
+
+    width = bmp->GetWidth();
+    height = bmp->GetHeight();
+
+    // Zabezpieczenie przed zerowymi wymiarami (uszkodzony lub pusty obraz).
+    if (width == 0 || height == 0) {
+        delete bmp;
+        return false;
+    }
+
+    // Bufor na width * height pikseli (każdy uint32_t = ARGB) z areny — bez
+    // zerowania, bo pętla poniżej nadpisuje każdy wiersz.
+    pixels.resize(static_cast<size_t>(width) * height);
+
+    Gdiplus::Rect rect(0, 0, static_cast<INT>(width), static_cast<INT>(height));
+    Gdiplus::BitmapData bmpData{};
+
+    // WAŻNE: LockBits blokuje piksele w pamięci i daje bezpośredni dostęp do danych.
+    // ImageLockModeRead — tylko odczyt (wystarczający tutaj; Write byłby nadmiarowy).
+    // PixelFormat32bppARGB — wymagamy konkretnego formatu; GDI+ skonwertuje automatycznie.
+    if (bmp->LockBits(&rect,
+        Gdiplus::ImageLockModeRead,
+        PixelFormat32bppARGB,
+        &bmpData) != Gdiplus::Ok)
+    {
+        delete bmp;
+        return false;
+    }
+
+    // WAŻNE: Kopiowanie wiersz po wierszu z uwzględnieniem Stride.
+    // bmpData.Scan0 wskazuje na pierwszy bajt danych GDI+ (wiersz 0).
+    // Każdy wiersz jest oddalony od poprzedniego o bmpData.Stride bajtów,
+    // ale my chcemy wiersz ciągły o rozmiarze width*4 bajtów.
+    for (uint32_t y = 0; y < height; ++y) {
+        memcpy(pixels.data() + y * width,
+            reinterpret_cast<const uint8_t*>(bmpData.Scan0) + y * bmpData.Stride,
+            static_cast<size_t>(width) * sizeof(uint32_t));
+    }
+
+    // WAŻNE: UnlockBits musi być wywołane zawsze po LockBits — nawet w ścieżce błędu.
+    // Brak UnlockBits powoduje zablokowanie bitmapy i wyciek zasobów GDI+.
+    bmp->UnlockBits(&bmpData);
+    delete bmp;
+    return true;
+}
+
+// Obraz wczytany wcześniej do pamięci (odczyt asynchroniczny, LOGIC_IO_ASYNC):
+// mem — blok GlobalAlloc(GMEM_MOVEABLE) z bytes bajtami pliku; funkcja przejmuje
+// go i zwalnia (strumień z fDeleteOnRelease).
+static bool LoadImagePixelsFromMemory(HGLOBAL mem,
+    uint64_t bytes,
+    PixelBuffer& pixels,
+    uint32_t& width,
+    uint32_t& height)
+{
+    // Dekodery z rejestru czytają blok wprost, bez strumienia.
+    if (const uint8_t* data = static_cast<const uint8_t*>(GlobalLock(mem))) {
+        bool recognized = false;
+        bool ok = false;
+        try {
+            ok = DecodeImageBytes(data, bytes, pixels, width, height, recognized);
+        }
+        catch (...) {
+            GlobalUnlock(mem);
+            GlobalFree(mem);
+            throw;
+        }
+        GlobalUnlock(mem);
+        if (recognized) {
+            GlobalFree(mem);
+            return ok;
+        }
+    }
+
+    IStream* stream = nullptr;
+    if (CreateStreamOnHGlobal(mem, TRUE, &stream) != S_OK) {
+        GlobalFree(mem);
+        return false;
+    }
+
+    // Rozmiar bloku GlobalAlloc może być zaokrąglony w górę — strumień ma
+    // dokładnie rozmiar pliku.
+    ULARGE_INTEGER size{};
+    size.QuadPart = bytes;
+    bool ok = false;
+    try {
+        ok = stream->SetSize(size) == S_OK &&
+            LoadBitmapPixels(Gdiplus::Bitmap::FromStream(stream), pixels, width, height);
+    }
+    catch (...) {
+        stream->Release();
+        throw;
+    }
+    stream->Release();
+    return ok;
+}
+
+// ============================================================
+// WAŻNE: GetGdiplusEncoderClsid — wyszukiwanie CLSID kodera GDI+ po MIME type.
+//
+// GDI+ identyfikuje kodeki (PNG, BMP, JPEG...) przez CLSID, a nie przez
+// nazwy plików. Aby zapisać BMP, musimy znaleźć CLSID kodera "image/bmp".
+//
+// Mechanizm:
+//   1. GetImageEncodersSize() — pyta GDI+ o liczbę i łączny rozmiar (w bajtach)
+//      tablicy dostępnych kodeków.
+//   2. GetImageEncoders() — wypełnia tablicę ImageCodecInfo wszystkimi dostępnymi
+//      kodekami (BMP, JPEG, PNG, GIF, TIFF).
+//   3. Iterujemy i porównujemy MimeType z szukanym — jeśli pasuje, kopiujemy CLSID.
+// ============================================================
+static bool GetGdiplusEncoderClsid(const wchar_t* mimeType, CLSID& clsid)
+{
+    UINT num = 0;
+    UINT size = 0;
+    Gdiplus::GetImageEncodersSize(&num, &size);
+    if (size == 0) return false;
+
+    std::vector<uint8_t> buf(size);
+    Gdiplus::GetImageEncoders(num, size,
+        reinterpret_cast<Gdiplus::ImageCodecInfo*>(buf.data()));
+
+    for (UINT i = 0; i < num; ++i) {
+        const auto& codec = reinterpret_cast<Gdiplus::ImageCodecInfo*>(buf.data())[i];
+        if (wcscmp(codec.MimeType, mimeType) == 0) {
+            clsid = codec.Clsid;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================
+// WAŻNE: SavePixelsAsBMP — zapis liniowej tablicy pikseli RGBA do pliku BMP.
+//
+// Analogicznie do LoadImagePixels, ale w kierunku odwrotnym.
+// Tworzymy nową bitmapę GDI+ w pamięci, kopiujemy piksele wiersz po wierszu
+// (znów z uwzględnieniem Stride), następnie zapisujemy przez kodek BMP.
+//
+// Używamy formatu BMP (image/bmp), bo:
+//   - jest bezstratny (brak kompresji stratnej jak JPEG),
+//   - dekoder BMP jest zawsze dostępny w GDI+,
+//   - wynik dekompresji musi być identyczny piksel-po-pikselu z oryginałem.
+//
+// stream != nullptr — plik BMP trafia do strumienia zamiast pod path
+// (EncodedImage, zapis asynchroniczny).
+// ============================================================
+static bool SavePixelsAsBMP(const std::wstring& path,
+    const PixelBuffer& pixels,
+    uint32_t width,
+    uint32_t height,
+    IStream* stream = nullptr)
+{
+    Gdiplus::Bitmap bmp(static_cast<INT>(width),
+        static_cast<INT>(height),
+        PixelFormat32bppARGB);
+
+    Gdiplus::Rect rect(0, 0, static_cast<INT>(width), static_cast<INT>(height));
+    Gdiplus::BitmapData bmpData{};
+
+    // ImageLockModeWrite — dostęp do zapisu; GDI+ blokuje bufor do czasu UnlockBits.
+    if (bmp.LockBits(&rect,
+        Gdiplus::ImageLockModeWrite,
+        PixelFormat32bppARGB,
+        &bmpData) != Gdiplus::Ok)
+        return false;
+
+    // Kopiujemy wiersz po wierszu z uwzględnieniem Stride (patrz LoadImagePixels).
+    for (uint32_t y = 0; y < height; ++y) {
+        memcpy(reinterpret_cast<uint8_t*>(bmpData.Scan0) + y * bmpData.Stride,
+            pixels.data() + y * width,
+            static_cast<size_t>(width) * sizeof(uint32_t));
+    }
+
+    bmp.UnlockBits(&bmpData);
+
+    // Szukamy CLSID dla kodera BMP i zapisujemy plik.
+    CLSID bmpClsid{};
+    if (!GetGdiplusEncoderClsid(L"image/bmp", bmpClsid))
+        return false;
+
+    if (stream)
+        return bmp.Save(stream, &bmpClsid) == Gdiplus::Ok;
+    return bmp.Save(path.c_str(), &bmpClsid) == Gdiplus::Ok;
+}
+
+// ============================================================
+// WAŻNE: MappedFile — plik odwzorowany w pamięci (CreateFileMappingW + MapViewOfFile).
+//
+// Odczyt (OpenRead): dekoder czyta tokeny wprost z widoku pliku — bez bufora
+// pośredniego i bez kopii ReadFile. System wczytuje strony przy pierwszym
+// dostępie, więc dekodowanie wycinka (Lz77DecodeRegion) sięga tylko do stron
+// bloków pokrywających wycinek.
+// Zapis (CreateWrite): mapowanie o zadanym rozmiarze od razu rozszerza plik do
+// rozmiaru docelowego — brak miejsca na dysku jest błędem CreateFileMappingW,
+// a nie wyjątkiem przy zapisie do widoku.
+//
+// Rozmiar pliku jest 64-bitowy — bez limitu DWORD pojedynczego ReadFile/WriteFile.
+// Pustego pliku nie da się odwzorować — OpenRead zwraca wtedy false.
+// ============================================================
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Odwzorowanie całego pliku tylko do odczytu.
+    bool OpenRead(const std::wstring& path)
+    {
+        Close();
+        // FILE_SHARE_READ pozwala innym procesom jednocześnie czytać plik.
+        m_file = CreateFileW(path.c_str(),
+            GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size{};
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) ||
+            size.QuadPart <= 0 || static_cast<uint64_t>(size.QuadPart) > SIZE_MAX) {
+            Close();
+            return false;
+        }
+        m_size = static_cast<uint64_t>(size.QuadPart);
+        return Map(PAGE_READONLY, FILE_MAP_READ);
+    }
+
+    // Utworzenie (lub nadpisanie — CREATE_ALWAYS) pliku o rozmiarze bytes
+    // i odwzorowanie go do zapisu.
+    bool CreateWrite(const std::wstring& path, uint64_t bytes)
+    {
+        Close();
+        if (bytes == 0 || bytes > SIZE_MAX) return false;
+        // PAGE_READWRITE wymaga uchwytu z prawem odczytu i zapisu.
+        m_file = CreateFileW(path.c_str(),
+            GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+        m_size = bytes;
+        return Map(PAGE_READWRITE, FILE_MAP_WRITE);
+    }
+
+    // Zamknięcie widoku i uchwytów; zmienione strony zapisuje system (jak po WriteFile).
+    void Close()
+    {
+        if (m_view) UnmapViewOfFile(m_view);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_view = nullptr;
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+        m_size = 0;
+    }
+
+    uint8_t* Data() const { return m_view; }
+    uint64_t Size() const { return m_size; }
+
+private:
+    bool Map(DWORD protect, DWORD access)
+    {
+        m_mapping = CreateFileMappingW(m_file, nullptr, protect,
+            static_cast<DWORD>(m_size >> 32), static_cast<DWORD>(m_size), nullptr);
+        if (m_mapping)
+            m_view = static_cast<uint8_t*>(MapViewOfFile(m_mapping, access, 0, 0, static_cast<SIZE_T>(m_size)));
+        if (!m_view) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    HANDLE   m_file = INVALID_HANDLE_VALUE;
+    HANDLE   m_mapping = nullptr;
+    uint8_t* m_view = nullptr;
+    uint64_t m_size = 0;
+};
+
+// Obraz z pliku: dekodery z rejestru czytają widok pliku, GDI+ — gdy żaden
+// nie rozpozna formatu (lub pliku nie da się odwzorować).
+static bool LoadImagePixels(const std::wstring& path,
+    PixelBuffer& pixels,
+    uint32_t& width,
+    uint32_t& height)
+{
+    {
+        MappedFile file;
+        bool recognized = false;
+        if (file.OpenRead(path)) {
+            bool ok = DecodeImageBytes(file.Data(), file.Size(), pixels, width, height, recognized);
+            if (recognized) return ok;
+        }
+    }
+    return LoadBitmapPixels(Gdiplus::Bitmap::FromFile(path.c_str()), pixels, width, height);
+}
+
+// ============================================================
+// WAŻNE: WriteCompressedFile — zapis pliku w formacie .lz77.
+//
+// Format (zgodny z Lz77FileHeader):
+//   [36 bajtów nagłówka rozszerzonego] [tabela bloków: blocks.size() * uint64]
+//   [strumienie bloków jeden za drugim]
+//   version   — format strumienia tokenów w blokach (LOGIC_FORMAT_*)
+//   blockRows — liczba wierszy obrazu w każdym bloku (ostatni może być krótszy)
+//
+// Rozmiar pliku jest znany przed zapisem (nagłówek + suma długości bloków),
+// więc plik tworzony jest od razu w docelowym rozmiarze i odwzorowywany
+// w pamięci (MappedFile::CreateWrite — CREATE_ALWAYS nadpisuje istniejący
+// plik); nagłówek, tabela bloków i strumienie kopiowane są do widoku.
+//
+// Strumień bloku może składać się z kilku fragmentów (kompresja strumieniowa,
+// BlockOutput) — zapisywane są jeden za drugim.
+//
+// CompressedFileHeader — bajty pliku przed danymi bloków (nagłówek, tabela
+// bloków, rekordy parametrów i filtrów wierszy); wspólne dla zapisu
+// synchronicznego i asynchronicznego (AsyncIo). filters->rows ma height pozycji;
+// entropy — bloki zakodowane entropijnie (LZ77_FLAG_ENTROPY).
+// ============================================================
+struct BlockOutput {
+    std::vector<ByteBuffer> chunks;   // kolejne fragmenty strumienia tokenów bloku
+
+    // Długość strumienia bloku w bajtach.
+    size_t Size() const
+    {
+        size_t bytes = 0;
+        for (const ByteBuffer& chunk : chunks)
+            bytes += chunk.size();
+        return bytes;
+    }
+};
+
+static std::vector<uint8_t> CompressedFileHeader(uint32_t width,
+    uint32_t height,
+    uint16_t version,
+    uint32_t blockRows,
+    const std::vector<BlockOutput>& blocks,
+    const LogicLevelParams* params,
+    const Lz77RowFilters* filters,
+    bool entropy)
+{
+    // Tabela bloków: rozmiar każdego strumienia; suma = compressedBytes.
+    std::vector<uint64_t> table(blocks.size());
+    uint64_t total = 0;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        table[b] = static_cast<uint64_t>(blocks[b].Size());
+        total += table[b];
+    }
+
+    // Budujemy strukturę nagłówka z magicznym znacznikiem i wymiarami.
+    Lz77FileHeader hdr{};
+    hdr.magic = LZ77_FILE_MAGIC_EXT;
+    hdr.width = width;
+    hdr.height = height;
+    hdr.compressedBytes = total;
+    hdr.version = version;
+    hdr.flags = LZ77_FLAG_BLOCKS | (params ? LZ77_FLAG_PARAMS : 0) | (filters ? LZ77_FLAG_FILTERS : 0) |
+        (entropy ? LZ77_FLAG_ENTROPY : 0);
+    hdr.blockRows = blockRows;
+    hdr.blockCount = static_cast<uint32_t>(blocks.size());
+    hdr.headerBytes = static_cast<uint32_t>(sizeof(hdr) + table.size() * sizeof(uint64_t) +
+        (params ? sizeof(LogicLevelParams) : 0) + (filters ? 1 + static_cast<size_t>(height) : 0));
+
+    // Kolejno: nagłówek, tabela bloków, parametry poziomu, filtry wierszy.
+    std::vector<uint8_t> header(hdr.headerBytes);
+    uint8_t* out = header.data();
+    memcpy(out, &hdr, sizeof(hdr));
+    out += sizeof(hdr);
+    memcpy(out, table.data(), table.size() * sizeof(uint64_t));
+    out += table.size() * sizeof(uint64_t);
+    if (params) {
+        memcpy(out, params, sizeof(*params));
+        out += sizeof(*params);
+    }
+    if (filters) {
+        *out++ = static_cast<uint8_t>(filters->transform);
+        memcpy(out, filters->rows.data(), height);
+    }
+    return header;
+}
+
+static bool WriteCompressedFile(const std::wstring& path,
+    uint32_t width,
+    uint32_t height,
+    uint16_t version,
+    uint32_t blockRows,
+    const std::vector<BlockOutput>& blocks,
+    const LogicLevelParams* params,
+    const Lz77RowFilters* filters,
+    bool entropy)
+{
+    std::vector<uint8_t> header = CompressedFileHeader(width, height, version, blockRows, blocks, params, filters,
+        entropy);
+    uint64_t total = 0;
+    for (const BlockOutput& block : blocks)
+        total += block.Size();
+
+    MappedFile file;
+    if (!file.CreateWrite(path, header.size() + total)) return false;
+
+    // Nagłówek, a za nim dane bloków.
+    uint8_t* out = file.Data();
+    memcpy(out, header.data(), header.size());
+    out += header.size();
+    for (const BlockOutput& block : blocks) {
+        for (const ByteBuffer& chunk : block.chunks) {
+            memcpy(out, chunk.data(), chunk.size());
+            out += chunk.size();
+        }
+    }
+
+    file.Close();
+    return true;
+}
+
+// ============================================================
+// WAŻNE: AsyncIo — asynchroniczny odczyt i zapis całych plików (LOGIC_IO_ASYNC).
+//
+// Port IOCP obsługiwany przez LOGIC_IO_THREADS wątków I/O:
+//   - Submit zgłasza żądanie pakietem PostQueuedCompletionStatus — nie blokuje,
+//   - wątek I/O otwiera plik z FILE_FLAG_OVERLAPPED, wiąże go z portem i zleca
+//     operacje nakładane ReadFile/WriteFile — po jednej na każde
+//     LOGIC_IO_PIECE_BYTES pliku, wszystkie naraz,
+//   - zakończenie ostatniej operacji pliku zamyka go i wywołuje done
+//     (na wątku I/O).
+// Jednocześnie obsługiwanych jest co najwyżej queueDepth plików; kolejne
+// żądania czekają w kolejce. Otwarcie i zamknięcie pliku (operacje na
+// metadanych, których WinAPI nie wykonuje asynchronicznie) rozkładają się
+// na wątki I/O, a nie blokują wątku zgłaszającego.
+//
+// Odczyt: allocate(rozmiar pliku) zwraca bufor docelowy (nullptr = błąd).
+// Zapis: pieces — kolejne fragmenty pliku; pamięć musi żyć do wywołania done.
+// Stop czeka na zakończenie wszystkich zgłoszonych żądań i kończy wątki I/O.
+// ============================================================
+static const ULONG_PTR LOGIC_IO_KEY_SUBMIT = 1;    // pakiet: nowe żądanie (OVERLAPPED* = AsyncIoRequest*)
+static const ULONG_PTR LOGIC_IO_KEY_STOP = 2;      // pakiet: koniec wątku I/O
+static const size_t    LOGIC_IO_PIECE_BYTES = 8u << 20;
+
+struct AsyncIoRequest {
+    std::wstring path;
+    bool         write = false;
+    std::vector<std::pair<const void*, size_t>> pieces;    // zapis: kolejne fragmenty pliku
+    std::function<uint8_t*(uint64_t)>          allocate;   // odczyt: bufor na cały plik
+    std::function<void(const AsyncIoRequest&)> done;       // [wątek I/O] po zamknięciu pliku
+
+    // [out] dla done
+    bool     ok = false;
+    uint64_t bytes = 0;     // rozmiar pliku
+    int64_t  us = 0;        // czas od zgłoszenia do zakończenia
+
+    // Stan wewnętrzny AsyncIo — operacja nakładana na fragment pliku.
+    // OVERLAPPED jako pierwsze pole: wskaźnik z portu wskazuje całą operację.
+    struct Op {
+        OVERLAPPED ov;
+        uint8_t*   data;
+        DWORD      bytes;
+    };
+    HANDLE              file = INVALID_HANDLE_VALUE;
+    std::vector<Op>     ops;
+    std::atomic<size_t> pending{ 0 };
+    std::atomic<bool>   failed{ false };
+    std::chrono::steady_clock::time_point submitted;
+};
+
+class AsyncIo {
+public:
+    AsyncIo() = default;
+    ~AsyncIo() { Stop(); }
+
+    AsyncIo(const AsyncIo&) = delete;
+    AsyncIo& operator=(const AsyncIo&) = delete;
+
+    // Utworzenie portu i wątków I/O; false — tryb asynchroniczny niedostępny.
+    bool Start(uint32_t queueDepth)
+    {
+        m_depth = queueDepth ? queueDepth : LOGIC_IO_DEFAULT_QUEUE_DEPTH;
+        m_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, LOGIC_IO_THREADS);
+        if (!m_port) return false;
+        try {
+            for (uint32_t t = 0; t < LOGIC_IO_THREADS; ++t)
+                m_threads.emplace_back([this]() { Run(); });
+        }
+        catch (...) {
+            Stop();
+            return false;
+        }
+        return true;
+    }
+
+    void Submit(std::unique_ptr<AsyncIoRequest> req)
+    {
+        req->submitted = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            ++m_outstanding;
+        }
+        Post(req.release());
+    }
+
+    // Oczekiwanie na wszystkie żądania i zakończenie wątków I/O.
+    void Stop()
+    {
+        if (!m_port) return;
+        {
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_idle.wait(lock, [this]() { return m_outstanding == 0; });
+        }
+        for (size_t t = 0; t < m_threads.size(); ++t)
+            PostQueuedCompletionStatus(m_port, 0, LOGIC_IO_KEY_STOP, nullptr);
+        for (std::thread& t : m_threads)
+            t.join();
+        m_threads.clear();
+        CloseHandle(m_port);
+        m_port = nullptr;
+    }
+
+    // Pomiar żądań zakończonych do tej pory (pola mode i callerWriteUs — wywołujący).
+    void FillStats(Lz77IoStats& stats)
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        stats.maxInFlight = m_maxOpen;
+        stats.reads = m_reads;
+        stats.writes = m_writes;
+        stats.bytesRead = m_bytesRead;
+        stats.bytesWritten = m_bytesWritten;
+        stats.readUs = m_readUs;
+        stats.writeUs = m_writeUs;
+    }
+
+private:
+    // Przekazanie żądania wątkom I/O (pakiet LOGIC_IO_KEY_SUBMIT).
+    void Post(AsyncIoRequest* req)
+    {
+        if (PostQueuedCompletionStatus(m_port, 0, LOGIC_IO_KEY_SUBMIT, reinterpret_cast<OVERLAPPED*>(req)))
+            return;
+
+        // Port nie przyjął pakietu — żądanie kończy się błędem bez otwarcia pliku
+        // (Finish zwalnia miejsce jak po otwarciu).
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            ++m_open;
+        }
+        req->failed = true;
+        Finish(req);
+    }
+
+    void Run()
+    {
+        while (true) {
+            DWORD       bytes = 0;
+            ULONG_PTR   key = 0;
+            OVERLAPPED* ov = nullptr;
+            BOOL ok = GetQueuedCompletionStatus(m_port, &bytes, &key, &ov, INFINITE);
+            if (key == LOGIC_IO_KEY_STOP) break;
+            if (!ov) continue;   // błąd portu bez pakietu
+
+            if (key == LOGIC_IO_KEY_SUBMIT) {
+                AsyncIoRequest* req = reinterpret_cast<AsyncIoRequest*>(ov);
+                {
+                    std::lock_guard<std::mutex> lock(m_mtx);
+                    if (m_open >= m_depth) {
+                        m_waiting.push_back(req);
+                        continue;
+                    }
+                    m_maxOpen = std::max(m_maxOpen, ++m_open);
+                }
+                Begin(req);
+                continue;
+            }
+
+            // Zakończona operacja nakładana — klucz portu to żądanie pliku.
+            AsyncIoRequest* req = reinterpret_cast<AsyncIoRequest*>(key);
+            const AsyncIoRequest::Op* op = reinterpret_cast<const AsyncIoRequest::Op*>(ov);
+            if (!ok || bytes != op->bytes) req->failed = true;
+            if (req->pending.fetch_sub(1) == 1) Finish(req);
+        }
+    }
+
+    // Otwarcie pliku i zlecenie wszystkich operacji; wywoływane z zajętym miejscem (m_open).
+    void Begin(AsyncIoRequest* req)
+    {
+        req->file = CreateFileW(req->path.c_str(),
+            req->write ? GENERIC_WRITE : GENERIC_READ,
+            req->write ? 0 : FILE_SHARE_READ, nullptr,
+            req->write ? CREATE_ALWAYS : OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | (req->write ? 0 : FILE_FLAG_SEQUENTIAL_SCAN),
+            nullptr);
+        if (req->file == INVALID_HANDLE_VALUE ||
+            !CreateIoCompletionPort(req->file, m_port, reinterpret_cast<ULONG_PTR>(req), 0) ||
+            !PlanOps(req)) {
+            req->failed = true;
+            Finish(req);
+            return;
+        }
+
+        // pending = operacje + 1: pakiety zakończenia mogą przyjść, zanim zlecone
+        // zostaną wszystkie operacje — dodatkowa jednostka należy do Begin, więc
+        // Finish wywołuje ten, kto zdejmie ostatnią (Begin lub wątek I/O).
+        size_t count = req->ops.size();
+        req->pending = count + 1;
+        size_t issued = 0;
+        for (; issued < count; ++issued) {
+            AsyncIoRequest::Op& op = req->ops[issued];
+            BOOL started = req->write
+                ? WriteFile(req->file, op.data, op.bytes, nullptr, &op.ov)
+                : ReadFile(req->file, op.data, op.bytes, nullptr, &op.ov);
+            // Zakończenie synchroniczne (TRUE) też trafia do portu.
+            if (!started && GetLastError() != ERROR_IO_PENDING) {
+                req->failed = true;
+                break;
+            }
+        }
+        size_t skipped = count - issued + 1;
+        if (req->pending.fetch_sub(skipped) == skipped) Finish(req);
+    }
+
+    // Podział pliku na operacje po LOGIC_IO_PIECE_BYTES (odczyt: po alokacji bufora).
+    bool PlanOps(AsyncIoRequest* req)
+    {
+        auto add = [req](uint8_t* data, size_t bytes, uint64_t offset) {
+            for (size_t done = 0; done < bytes; done += LOGIC_IO_PIECE_BYTES) {
+                AsyncIoRequest::Op op{};
+                uint64_t pos = offset + done;
+                op.ov.Offset = static_cast<DWORD>(pos);
+                op.ov.OffsetHigh = static_cast<DWORD>(pos >> 32);
+                op.data = data + done;
+                op.bytes = static_cast<DWORD>(std::min(LOGIC_IO_PIECE_BYTES, bytes - done));
+                req->ops.push_back(op);
+            }
+            };
+
+        if (req->write) {
+            for (const auto& piece : req->pieces) {
+                add(static_cast<uint8_t*>(const_cast<void*>(piece.first)), piece.second, req->bytes);
+                req->bytes += piece.second;
+            }
+            return true;
+        }
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(req->file, &size) || static_cast<uint64_t>(size.QuadPart) > SIZE_MAX)
+            return false;
+        req->bytes = static_cast<uint64_t>(size.QuadPart);
+        uint8_t* dst = req->allocate ? req->allocate(req->bytes) : nullptr;
+        if (!dst) return false;
+        add(dst, static_cast<size_t>(req->bytes), 0);
+        return true;
+    }
+
+    // Zamknięcie pliku, done i zwolnienie miejsca; czekające żądanie wraca do
+    // portu (bez rekurencji Begin -> Finish przy serii nieudanych otwarć).
+    void Finish(AsyncIoRequest* req)
+    {
+        if (req->file != INVALID_HANDLE_VALUE && !CloseHandle(req->file))
+            req->failed = true;
+        req->ok = !req->failed;
+        req->us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - req->submitted).count();
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            if (req->ok) {
+                (req->write ? m_writes : m_reads) += 1;
+                (req->write ? m_bytesWritten : m_bytesRead) += req->bytes;
+            }
+            (req->write ? m_writeUs : m_readUs) += req->us;
+        }
+        try {
+            if (req->done) req->done(*req);
+        }
+        catch (...) {
+            // done nie może przerwać wątku I/O.
+        }
+        delete req;
+
+        AsyncIoRequest* next = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            --m_open;
+            if (!m_waiting.empty()) {
+                next = m_waiting.front();
+                m_waiting.pop_front();
+            }
+            if (--m_outstanding == 0) m_idle.notify_all();
+        }
+        if (next) Post(next);
+    }
+
+    HANDLE   m_port = nullptr;
+    uint32_t m_depth = LOGIC_IO_DEFAULT_QUEUE_DEPTH;
+    std::vector<std::thread> m_threads;
+
+    std::mutex                  m_mtx;
+    std::condition_variable     m_idle;
+    std::deque<AsyncIoRequest*> m_waiting;       // żądania czekające na miejsce
+    uint32_t m_open = 0;                         // pliki w trakcie I/O
+    uint32_t m_maxOpen = 0;
+    size_t   m_outstanding = 0;                  // zgłoszone, a niezakończone żądania
+    uint64_t m_reads = 0;
+    uint64_t m_writes = 0;
+    uint64_t m_bytesRead = 0;
+    uint64_t m_bytesWritten = 0;
+    int64_t  m_readUs = 0;
+    int64_t  m_writeUs = 0;
+};
+
+// ============================================================
+// EncodedImage — obraz BMP zakodowany przez GDI+ do pamięci (IStream na
+// HGLOBAL, SavePixelsAsBMP); Data() / Size() — zawartość pliku do zapisu
+// asynchronicznego. Pamięć żyje do zniszczenia obiektu.
+// ============================================================
+class EncodedImage {
+public:
+    EncodedImage() = default;
+    ~EncodedImage()
+    {
+        if (m_data) GlobalUnlock(m_mem);
+        if (m_stream) m_stream->Release();
+    }
+
+    EncodedImage(const EncodedImage&) = delete;
+    EncodedImage& operator=(const EncodedImage&) = delete;
+
+    bool EncodeBMP(const PixelBuffer& pixels, uint32_t width, uint32_t height)
+    {
+        if (CreateStreamOnHGlobal(nullptr, TRUE, &m_stream) != S_OK) {
+            m_stream = nullptr;
+            return false;
+        }
+        STATSTG stat{};
+        if (!SavePixelsAsBMP(std::wstring(), pixels, width, height, m_stream) ||
+            GetHGlobalFromStream(m_stream, &m_mem) != S_OK ||
+            m_stream->Stat(&stat, STATFLAG_NONAME) != S_OK ||
+            stat.cbSize.QuadPart > SIZE_MAX)
+            return false;
+        m_size = static_cast<size_t>(stat.cbSize.QuadPart);
+        m_data = static_cast<const uint8_t*>(GlobalLock(m_mem));
+        return m_data != nullptr;
+    }
+
+    const uint8_t* Data() const { return m_data; }
+    size_t         Size() const { return m_size; }
+
+private:
+    IStream*       m_stream = nullptr;
+    HGLOBAL        m_mem = nullptr;
+    const uint8_t* m_data = nullptr;
+    size_t         m_size = 0;
+};
+
+// ============================================================
+// WAŻNE: ReadCompressedIndex — odczyt i walidacja nagłówka pliku .lz77
+// odwzorowanego w pamięci (file — fileBytes bajtów, patrz MappedFile).
+//
+// Kroki:
+//   1. Odczytuje nagłówek podstawowy (20 bajtów).
+//   2. Sprawdza magic — ochrona przed przypadkowym przetworzeniem błędnego pliku.
+//      Dla LZ77_FILE_MAGIC_EXT doczytuje pola rozszerzone (tyle, ile zapisał
+//      program, który utworzył plik) i tabelę bloków; dla LZ77_FILE_MAGIC
+//      uzupełnia je wartościami plików wersji 1.1 (Token12, jeden blok).
+//   3. Sprawdza rozmiar danych — ochrona przed uszkodzonymi plikami, które podają
+//      fałszywy compressedBytes lub rozmiary bloków: dane tokenów muszą mieścić
+//      się w pliku, a każdy blok w danych tokenów. Dekoder czyta wprost
+//      z widoku pliku, więc bez tego odczytałby pamięć za końcem widoku.
+//
+// index.offsets zawiera blockCount+1 pozycji początków bloków w danych
+// (ostatnia = compressedBytes) — także dla plików bez tabeli bloków.
+// Dane tokenów zaczynają się w pliku od offsetu hdr.headerBytes.
+// ============================================================
+static bool ReadCompressedIndex(const uint8_t* file,
+    uint64_t fileBytes,
+    Lz77FileHeader& hdr,
+    Lz77BlockIndex& index)
+{
+    hdr = Lz77FileHeader{};
+    index.params = LogicLevelParams{};
+    index.filters = Lz77RowFilters{};
+    index.entropy = false;
+
+    // Kopia bytes bajtów od pozycji pos; false, jeśli wykracza poza plik.
+    // memcpy — pola w pliku nie są wyrównane.
+    auto read = [file, fileBytes](void* dst, uint64_t pos, size_t bytes) {
+        if (pos > fileBytes || bytes > fileBytes - pos) return false;
+        memcpy(dst, file + pos, bytes);
+        return true;
+        };
+
+    // WAŻNE: Podwójna walidacja nagłówka — sprawdzamy zarówno czy plik nie jest
+    // krótszy od nagłówka, jak i magic number.
+    if (!read(&hdr, 0, LZ77_BASE_HEADER_BYTES) ||
+        (hdr.magic != LZ77_FILE_MAGIC && hdr.magic != LZ77_FILE_MAGIC_EXT))
+        return false;
+
+    std::vector<uint64_t> table;
+
+    if (hdr.magic == LZ77_FILE_MAGIC) {
+        // Plik wersji 1.1 — brak pól rozszerzonych, zawsze Token12.
+        hdr.version = LOGIC_FORMAT_TOKEN12;
+        hdr.flags = 0;
+        hdr.headerBytes = static_cast<uint32_t>(LZ77_BASE_HEADER_BYTES);
+    }
+    else {
+        uint8_t* raw = reinterpret_cast<uint8_t*>(&hdr);
+        if (!read(raw + LZ77_BASE_HEADER_BYTES, LZ77_BASE_HEADER_BYTES,
+                LZ77_EXT_MIN_HEADER_BYTES - LZ77_BASE_HEADER_BYTES) ||
+            hdr.headerBytes < LZ77_EXT_MIN_HEADER_BYTES ||
+            (hdr.flags & ~LZ77_KNOWN_FLAGS) != 0)
+            return false;
+
+        // Pozostałe znane pola — tylko tyle, ile obejmuje nagłówek zapisany w pliku.
+        if (hdr.flags & LZ77_FLAG_BLOCKS) {
+            if (!read(raw + LZ77_EXT_MIN_HEADER_BYTES, LZ77_EXT_MIN_HEADER_BYTES,
+                    sizeof(hdr) - LZ77_EXT_MIN_HEADER_BYTES))
+                return false;
+
+            // Tabela bloków musi mieścić się w nagłówku i pokrywać całą wysokość obrazu.
+            uint64_t tableBytes = static_cast<uint64_t>(hdr.blockCount) * sizeof(uint64_t);
+            if (hdr.blockRows == 0 || hdr.blockCount == 0 ||
+                hdr.blockCount != (static_cast<uint64_t>(hdr.height) + hdr.blockRows - 1) / hdr.blockRows ||
+                sizeof(hdr) + tableBytes > hdr.headerBytes)
+                return false;
+
+            table.resize(hdr.blockCount);
+            if (!read(table.data(), sizeof(hdr), static_cast<size_t>(tableBytes)))
+                return false;
+
+            // Rekord parametrów poziomu — zaraz po tabeli bloków.
+            if (hdr.flags & LZ77_FLAG_PARAMS) {
+                if (sizeof(hdr) + tableBytes + sizeof(LogicLevelParams) > hdr.headerBytes ||
+                    !read(&index.params, sizeof(hdr) + tableBytes, sizeof(LogicLevelParams)))
+                    return false;
+            }
+
+            // Rekord filtrów wierszy — po rekordzie parametrów; znane filtry i transformacja,
+            // tylko dla formatu kompaktowego.
+            if (hdr.flags & LZ77_FLAG_FILTERS) {
+                uint64_t pos = sizeof(hdr) + tableBytes + ((hdr.flags & LZ77_FLAG_PARAMS) ? sizeof(LogicLevelParams) : 0);
+                uint8_t transform = 0;
+                if (pos + 1 + hdr.height > hdr.headerBytes || hdr.version == LOGIC_FORMAT_TOKEN12)
+                    return false;
+                index.filters.rows.resize(hdr.height);
+                if (!read(&transform, pos, 1) || !read(index.filters.rows.data(), pos + 1, hdr.height) ||
+                    transform > LOGIC_TRANSFORM_YCOCG_R)
+                    return false;
+                for (uint8_t filter : index.filters.rows) {
+                    if (filter >= LOGIC_FILTER_COUNT)
+                        return false;
+                }
+                index.filters.transform = transform;
+            }
+
+            // Kodowanie entropijne — tylko strumienie formatu kompaktowego.
+            if ((hdr.flags & LZ77_FLAG_ENTROPY) && hdr.version == LOGIC_FORMAT_TOKEN12)
+                return false;
+            index.entropy = (hdr.flags & LZ77_FLAG_ENTROPY) != 0;
+        }
+        else if (hdr.flags & (LZ77_FLAG_PARAMS | LZ77_FLAG_FILTERS | LZ77_FLAG_ENTROPY)) {
+            return false;   // rekordy parametrów i filtrów oraz kodowanie entropijne tylko z tabelą bloków
+        }
+
+        // Format kompaktowy z rekordem parametrów musi mieć jego okno i długość dopasowań;
+        // format z parametrami poziomu wymaga rekordu (dekoder rozmiaru pól tokenu).
+        if (hdr.version == LOGIC_FORMAT_PACKED && (hdr.flags & LZ77_FLAG_PARAMS) &&
+            (index.params.windowPx != LOGIC_PACKED_WINDOW_PX || index.params.maxMatchPx != LOGIC_PACKED_MAX_MATCH_PX))
+            return false;
+        if (hdr.version == LOGIC_FORMAT_PACKED_EX && !(hdr.flags & LZ77_FLAG_PARAMS))
+            return false;
+
+        // Pola dopisane przez nowsze wersje programu są pomijane — dane zaczynają się od headerBytes.
+    }
+
+    // Plik bez tabeli bloków to jeden blok obejmujący cały obraz.
+    if (!(hdr.flags & LZ77_FLAG_BLOCKS)) {
+        hdr.blockRows = hdr.height;
+        hdr.blockCount = 1;
+        table.assign(1, hdr.compressedBytes);
+    }
+
+    // WAŻNE: Zerowe compressedBytes oznacza pusty plik; dane tokenów muszą mieścić się
+    // w pliku (zamiast dawnego limitu 512 MB — rozmiar pliku jest znany z mapowania).
+    if (hdr.compressedBytes == 0 || hdr.headerBytes > fileBytes ||
+        hdr.compressedBytes > fileBytes - hdr.headerBytes)
+        return false;
+
+    // Każdy blok musi mieścić się w danych tokenów (bez przepełnienia sumy),
+    // a suma rozmiarów z tabeli bloków musi zgadzać się z compressedBytes.
+    index.blockRows = hdr.blockRows;
+    index.offsets.assign(table.size() + 1, 0);
+    for (size_t b = 0; b < table.size(); ++b) {
+        if (table[b] > hdr.compressedBytes - index.offsets[b])
+            return false;
+        index.offsets[b + 1] = index.offsets[b] + table[b];
+    }
+    return index.offsets.back() == hdr.compressedBytes;
+}
+
+// ============================================================
+// WAŻNE: ReadCompressedFile — otwarcie pliku .lz77 do dekompresji.
+//
+// Plik jest odwzorowywany w pamięci (MappedFile), nagłówek i tabela bloków
+// walidowane przez ReadCompressedIndex. data wskazuje początek danych tokenów
+// w widoku pliku — ważny do zamknięcia 'file'; nic nie jest kopiowane, a strony
+// z danymi bloków wczytuje system przy pierwszym dostępie dekodera.
+// ============================================================
+static bool ReadCompressedFile(const std::wstring& path,
+    Lz77FileHeader& hdr,
+    Lz77BlockIndex& index,
+    MappedFile& file,
+    const uint8_t*& data)
+{
+    data = nullptr;
+    if (!file.OpenRead(path) || !ReadCompressedIndex(file.Data(), file.Size(), hdr, index)) {
+        file.Close();
+        return false;
+    }
+    data = file.Data() + hdr.headerBytes;
+    return true;
+}
+
+// ============================================================
+// BlockRowsFor — liczba wierszy w bloku dla obrazu o szerokości width.
+//
+// blockPixels == 0           — LOGIC_DEFAULT_BLOCK_PIXELS,
+// blockPixels == 0xFFFFFFFF  — cały obraz jako jeden blok.
+// Wynik zawsze mieści się w przedziale [1, height].
+// ============================================================
+static uint32_t BlockRowsFor(uint32_t width, uint32_t height, uint32_t blockPixels)
+{
+    if (blockPixels == 0xFFFFFFFFu) return height;
+    if (blockPixels == 0) blockPixels = LOGIC_DEFAULT_BLOCK_PIXELS;
+
+    uint32_t rows = std::max(1u, blockPixels / std::max(1u, width));
+    return std::min(rows, height);
+}
+
+// ============================================================
+// StreamDecoder — dekoder strumienia bloków wybrany według wersji formatu
+// (DecoderForVersion). Wersje 1 i 2 — funkcja z api bez parametrów;
+// wersja LOGIC_FORMAT_PACKED_EX — decompressLevel z parametrami z nagłówka.
+// Plik z filtrami wierszy — imageFn (odwrócenie filtrów zaraz po dekodowaniu);
+// plik kodowany entropijnie — entropyFn (z filtrami lub bez).
+// ============================================================
+struct StreamDecoder {
+    LZ77DecompressFunc      fn = nullptr;
+    LZ77DecompressLevelFunc levelFn = nullptr;
+    LZ77DecompressImageFunc imageFn = nullptr;
+    LZ77DecompressEntropyFunc entropyFn = nullptr;
+    LogicLevelParams        params{};
+
+    explicit operator bool() const { return fn != nullptr || levelFn != nullptr; }
+
+    void operator()(const uint8_t* src, size_t srcLen, uint32_t* dst, size_t dstCap, size_t* outLen) const
+    {
+        if (levelFn) levelFn(src, srcLen, dst, dstCap, &params, outLen);
+        else         fn(src, srcLen, dst, dstCap, outLen);
+    }
+
+    // Dekompresja bloku z odwróceniem filtrów; residuals — bufor dstCap pikseli
+    // lub nullptr (odtworzenie w miejscu, drugie przejście po bloku).
+    // Blok kodowany entropijnie bez filtrów: rowFilters nullptr.
+    void Image(const uint8_t* src, size_t srcLen, uint32_t* dst, size_t dstCap, uint32_t* residuals,
+        uint32_t width, uint32_t transform, const uint8_t* rowFilters, size_t* outLen) const
+    {
+        (entropyFn ? entropyFn : imageFn)(src, srcLen, dst, dstCap, residuals, levelFn ? &params : nullptr,
+            width, transform, rowFilters, outLen);
+    }
+};
+
+// ============================================================
+// DecompressBlock — dekompresja jednego bloku pliku.
+//
+// data wskazuje początek danych tokenów pliku (ReadCompressedFile). Blok b
+// trafia pod adres pixels (pierwszy piksel wiersza b * blockRows).
+// residuals — bufor reszt filtrów wierszy wątku (tylko pliki z filtrami);
+// nullptr lub brak pamięci — filtry odwracane w miejscu.
+// Zwraca true, jeśli odtworzono dokładnie rows * width pikseli.
+// ============================================================
+static bool DecompressBlock(const StreamDecoder& decompFn,
+    const uint8_t* data,
+    const Lz77BlockIndex& index,
+    uint32_t width,
+    uint32_t height,
+    size_t block,
+    uint32_t* pixels,
+    PixelBuffer* residuals)
+{
+    size_t firstRow = block * index.blockRows;
+    size_t rows = std::min<size_t>(index.blockRows, height - firstRow);
+    size_t expected = rows * width;
+    size_t outLen = 0;
+    const uint8_t* src = data + static_cast<size_t>(index.offsets[block]);
+    size_t srcLen = static_cast<size_t>(index.offsets[block + 1] - index.offsets[block]);
+
+    if (index.filters.rows.empty()) {
+        if (index.entropy)
+            decompFn.Image(src, srcLen, pixels, expected, nullptr, width, LOGIC_TRANSFORM_NONE, nullptr, &outLen);
+        else
+            decompFn(src, srcLen, pixels, expected, &outLen);
+        return outLen == expected;
+    }
+
+    uint32_t* work = nullptr;
+    if (residuals) {
+        try {
+            if (residuals->size() < expected) residuals->resize(expected);
+            work = residuals->data();
+        }
+        catch (const std::bad_alloc&) {
+            work = nullptr;
+        }
+    }
+    decompFn.Image(src, srcLen, pixels, expected, work, width, index.filters.transform,
+        index.filters.rows.data() + firstRow, &outLen);
+    return outLen == expected;
+}
+
+// ============================================================
+// DecompressBlocksParallel — równoległa dekompresja bloków [firstBlock, lastBlock].
+//
+// Każdy blok to niezależny strumień (okno LZ77 zaczyna się od zera na początku
+// bloku), więc wątki pobierają kolejne bloki przez fetch_add i piszą do
+// rozłącznych fragmentów pixels. pixels wskazuje pierwszy wiersz bloku firstBlock;
+// data — początek danych tokenów pliku (jak w DecompressBlock).
+// Zwraca false, jeśli którykolwiek blok jest uszkodzony lub dekoder rzucił wyjątek.
+// ============================================================
+static bool DecompressBlocksParallel(const StreamDecoder& decompFn,
+    const uint8_t* data,
+    const Lz77BlockIndex& index,
+    uint32_t width,
+    uint32_t height,
+    size_t firstBlock,
+    size_t lastBlock,
+    uint32_t* pixels,
+    int numThreads)
+{
+    size_t blockCount = lastBlock - firstBlock + 1;
+    size_t rowBase = firstBlock * index.blockRows;
+
+    std::atomic<size_t> blockIndex{ firstBlock };
+    std::atomic<bool>   ok{ true };
+
+    auto worker = [&](PixelBuffer* residuals) {
+        while (true) {
+            size_t b = blockIndex.fetch_add(1, std::memory_order_relaxed);
+            if (b > lastBlock) break;
+
+            uint32_t* out = pixels + (b * index.blockRows - rowBase) * width;
+            try {
+                if (!DecompressBlock(decompFn, data, index, width, height, b, out, residuals))
+                    ok.store(false, std::memory_order_relaxed);
+            }
+            catch (...) {
+                ok.store(false, std::memory_order_relaxed);
+            }
+        }
+        };
 
-            CompressTask task;
-            task.filePath = entry.path().wstring();
+    // Więcej wątków niż bloków nie przyspieszy dekompresji.
+    size_t actualThreads = std::min<size_t>(static_cast<size_t>(std::max(1, numThreads)), blockCount);
+    PoolGroup group;
+    if (actualThreads > 1) {
+        Pool().Acquire(static_cast<int>(actualThreads - 1));
+        group.Run(static_cast<int>(actualThreads - 1), [&](WorkerScratch& scratch) { worker(&scratch.pixels); });
+    }
+
+    // Wątek wywołujący też dekompresuje — zamiast bezczynnie czekać na zakończenie puli.
+    PixelBuffer residuals;
+    worker(&residuals);
+    group.Wait();
 
-            // Wczytaj piksele RGBA przez GDI+ (I/O — przed stoperem).
-            task.loadOk = LoadImagePixels(task.filePath, task.pixels, task.w, task.h);
+    return ok.load();
+}
 
-            if (task.loadOk) {
-                size_t pixelCount = static_cast<size_t>(task.w) * task.h;
+// ============================================================
+// DecoderForVersion — dekoder z api zgodny z wersją formatu z nagłówka
+// i parametrami poziomu z indeksu; pusty (false) dla wersji nieobsługiwanej,
+// LOGIC_FORMAT_PACKED_EX z DLL bez lz77_rgba_decompress_level lub pliku
+// z filtrami wierszy albo kodowaniem entropijnym z DLL bez
+// lz77_rgba_decompress_image / lz77_rgba_decompress_entropy (AsmDll.dll).
+// ============================================================
+static StreamDecoder DecoderForVersion(const LZ77Api& api, uint16_t version, const Lz77BlockIndex& index)
+{
+    StreamDecoder decoder;
+    if (version == LOGIC_FORMAT_TOKEN12) decoder.fn = api.decompress;
+    if (version == LOGIC_FORMAT_PACKED)  decoder.fn = api.decompressPacked;
+    if (version == LOGIC_FORMAT_PACKED_EX) {
+        decoder.levelFn = api.decompressLevel;
+        decoder.params = index.params;
+    }
+    if (!index.filters.rows.empty()) {
+        if (!api.decompressImage) return StreamDecoder{};
+        decoder.imageFn = api.decompressImage;
+    }
+    if (index.entropy) {
+        if (!api.decompressEntropy) return StreamDecoder{};
+        decoder.entropyFn = api.decompressEntropy;
+    }
+    return decoder;
+}
 
-                // Pre-alokuj bufor wyjściowy: pesymistyczny worst-case LZ77.
-                // Token literalny = ~12 B/piksel + 64 B margines na nagłówek strumienia.
-                task.dst.resize(pixelCount * 12u + 64u);
+// ============================================================
+// DecoderRequirement — przyczyna pustego dekodera z DecoderForVersion, gdy
+// plik jest poprawny, ale api nie obsługuje jego formatu (komunikat w logu
+// zamiast zgłoszenia uszkodzonego pliku); nullptr = nieobsługiwana wersja.
+// ============================================================
+static const wchar_t* DecoderRequirement(const LZ77Api& api, uint16_t version, const Lz77BlockIndex& index)
+{
+    if (version == LOGIC_FORMAT_PACKED_EX && !api.decompressLevel) return L"wymaga CppDll.dll (poziom kompresji)";
+    if (!index.filters.rows.empty() && !api.decompressImage) return L"wymaga CppDll.dll (filtry wierszy)";
+    if (index.entropy && !api.decompressEntropy) return L"wymaga CppDll.dll (kodowanie entropijne)";
+    return nullptr;
+}
 
-                // Pre-alokuj bufor roboczy: head[65536] + prev[4096] = 272 KB.
-                // Każde zadanie ma własny bufor — brak współdzielenia między wątkami.
-                task.work.resize(LOGIC_LZ77_WORK_BYTES);
+// ============================================================
+// CountPackedTokens — liczniki tokenów wyznaczone z gotowego strumienia
+// formatu kompaktowego. Używane, gdy DLL nie eksportuje
+// lz77_rgba_compress_packed_stats (AsmDll.dll); chainWalks pozostaje bez zmian.
+// ============================================================
+static void CountPackedTokens(const uint8_t* src, size_t srcLen, LogicKernelStats& stats)
+{
+    size_t pos = 0;
+    while (pos < srcLen) {
+        uint32_t flags = src[pos++];
+        for (uint32_t k = 0; k < 8 && pos < srcLen; ++k, flags >>= 1) {
+            if (flags & 1u) {
+                if (srcLen - pos < 3) return;
+                uint32_t v = static_cast<uint32_t>(src[pos + 1]) | (static_cast<uint32_t>(src[pos + 2]) << 8);
+                stats.matches += 1;
+                stats.matchPx += ((v >> 4) & 0x3Fu) + 1;
+                pos += 3;
+            }
+            else {
+                size_t run = static_cast<size_t>(src[pos]) + 1;
+                stats.literalRuns += 1;
+                stats.literalPx += run;
+                pos += 1 + run * 4;
             }
+        }
+    }
+}
+
+// ============================================================
+// Planowanie partii — kolejność LPT (longest processing time first).
+//
+// Czas przetwarzania obrazu jest w przybliżeniu proporcjonalny do liczby
+// pikseli, znanej z samego nagłówka pliku (ProbeImagePixels / nagłówek
+// .lz77). Pliki ustawiane są malejąco według width * height: największe
+// obrazy wchodzą do potoku pierwsze, a ich bloki (pod-zadania, patrz
+// BlockRowsFor) rozkładają się na wszystkie wątki. Koniec partii
+// wypełniają małe obrazy, które wyrównują obciążenie — duży obraz na końcu
+// listy nie zostawia już jednego wątku pracującego, gdy pozostałe czekają.
+// Plik z nieczytelnym nagłówkiem idzie na koniec (szybki błąd); przy
+// równych rozmiarach zachowana jest kolejność katalogu.
+// ============================================================
+static bool ProbeImagePixels(const std::wstring& path, uint64_t& pixels)
+{
+    {
+        // Dekodery z rejestru czytają tylko strony nagłówka.
+        MappedFile file;
+        uint32_t w = 0, h = 0;
+        if (file.OpenRead(path) && ProbeImageBytes(file.Data(), file.Size(), w, h)) {
+            pixels = static_cast<uint64_t>(w) * h;
+            return true;
+        }
+    }
+
+    // Image::FromFile czyta nagłówek — piksele dekodowane są dopiero przy LockBits.
+    Gdiplus::Image* img = Gdiplus::Image::FromFile(path.c_str());
+    bool ok = img && img->GetLastStatus() == Gdiplus::Ok;
+    if (ok) pixels = static_cast<uint64_t>(img->GetWidth()) * img->GetHeight();
+    delete img;
+    return ok;
+}
+
+static bool ProbeLz77Pixels(const std::wstring& path, uint64_t& pixels)
+{
+    uint32_t w = 0, h = 0;
+    if (!Lz77GetImageInfo(path.c_str(), &w, &h, nullptr, nullptr)) return false;
+    pixels = static_cast<uint64_t>(w) * h;
+    return true;
+}
+
+static void ScheduleLargestFirst(std::vector<std::wstring>& files,
+    bool (*probe)(const std::wstring&, uint64_t&))
+{
+    std::vector<std::pair<uint64_t, size_t>> order(files.size());   // (piksele, indeks)
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint64_t pixels = 0;
+        if (!probe(files[i], pixels)) pixels = 0;
+        order[i] = { pixels, i };
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [](const std::pair<uint64_t, size_t>& a, const std::pair<uint64_t, size_t>& b) { return a.first > b.first; });
+
+    std::vector<std::wstring> sorted;
+    sorted.reserve(files.size());
+    for (const auto& o : order)
+        sorted.push_back(std::move(files[o.second]));
+    files.swap(sorted);
+}
+
+// ============================================================
+// Nierównowaga obciążenia wątków partii (Lz77BatchStats).
+//
+// busyUs — czas pracy każdego wątku (wczytanie/odczyt i (de)kompresja,
+// bez czekania na muteksie i zmiennej warunkowej).
+// imbalance = 1 - średni / maksymalny czas pracy: 0 = wszystkie wątki
+// pracowały tyle samo, wartość bliska 1 = jeden wątek pracował, a reszta
+// czekała na niego.
+// ============================================================
+static Lz77BatchStats ComputeBatchStats(const std::vector<int64_t>& busyUs)
+{
+    Lz77BatchStats st{};
+    st.threads = static_cast<uint32_t>(busyUs.size());
+    int64_t sum = 0;
+    for (int64_t us : busyUs) {
+        sum += us;
+        st.maxBusyUs = std::max(st.maxBusyUs, us);
+    }
+    st.meanBusyUs = busyUs.empty() ? 0 : sum / static_cast<int64_t>(busyUs.size());
+    st.imbalance = st.maxBusyUs > 0
+        ? 1.0 - static_cast<double>(sum) / (static_cast<double>(st.maxBusyUs) * busyUs.size()) : 0.0;
+    return st;
+}
+
+// ============================================================
+// Zbiór rozszerzeń obrazkow obsługiwanych przez GDI+.
+// Używany w StartCompression do filtrowania plików podczas iteracji katalogu.
+// std::set<> zapewnia O(log n) wyszukiwanie — wydajniejsze niż liniowe
+// porównywanie dla potencjalnie dużej listy rozszerzeń.
+// ============================================================
+static const std::set<std::wstring> IMAGE_EXTENSIONS = {
+    L".png", L".jpg", L".jpeg", L".bmp",
+    L".tiff", L".tif", L".gif",
+    L".ppm", L".pam"   // dekodery wbudowane (bez GDI+)
+};
+
+// ============================================================
+// WAŻNE: StartCompression — główna funkcja kompresji, eksportowana do C#.
+//
+// Architektura — potok (producent / konsument) z ograniczoną liczbą obrazów
+// w pamięci (maxInFlight):
+//
+//   ETAP 1 — WCZYTANIE (wątki robocze):
+//     Wątek bez pracy kompresji pobiera kolejny plik z listy, o ile liczba
+//     obrazów w obiegu jest mniejsza niż maxInFlight. Dla pliku:
+//       - wczytanie pikseli RGBA przez GDI+ (LoadImagePixels),
+//       - podział na bloki po blockRows wierszy (BlockRowsFor),
+//       - alokacja bufora wyjściowego każdego bloku (worst-case LZ77),
+//       - wstawienie bloków do kolejki kompresji.
+//
+//   ETAP 2 — KOMPRESJA (wątki robocze):
+//     Jednostką pracy jest para (plik, blok) — jeden duży obraz rozkłada się
+//     na wszystkie wątki. Wątki zawsze wybierają najpierw bloki do kompresji,
+//     a dopiero potem wczytują kolejny plik. Każdy wątek ma własny bufor
+//     roboczy work (head[] + prev[]), używany dla kolejnych bloków.
+//
+//   ETAP 3 — ZAPIS (wątek wywołujący):
+//     Obraz, którego wszystkie bloki są gotowe, trafia do kolejki zapisu.
+//     Wątek wywołujący zapisuje plik .lz77 (bloki sklejane w jeden plik
+//     z tabelą bloków), wywołuje logCb i progressCb, zwalnia pamięć obrazu
+//     i zwalnia miejsce w obiegu — dopiero wtedy może zostać wczytany
+//     kolejny plik (back-pressure).
+//
+// Szczytowe zużycie pamięci zależy od maxInFlight i wielkości obrazów,
+// a nie od liczby plików w folderze. Odczyt, kompresja i zapis nakładają się
+// w czasie.
+//
+// Pomiar czasu (outElapsedMs):
+//   Mierzony jest czas ścienny, w którym trwało co najmniej jedno wywołanie
+//   compFn() — suma przedziałów aktywności kompresji. Okresy, w których
+//   wątki tylko wczytują obrazy lub czekają na zapis, nie są liczone, więc
+//   wynik nadal służy do porównania ASM vs C++. Pełny czas potoku
+//   (z I/O) podawany jest w raporcie końcowym.
+//
+// Statystyki plików (options->statsCb):
+//   Czasy wczytania, kompresji (suma bloków) i zapisu oraz liczniki tokenów
+//   każdego pliku przekazywane są z wątku zapisu przez Lz77FileStats.
+//   Liczniki pochodzą z lz77_rgba_compress_packed_stats, a gdy DLL jej
+//   nie eksportuje — z przejrzenia gotowego strumienia (bez chainWalks).
+// ============================================================
+void __stdcall StartCompression(
+    const wchar_t* sourceFolder,
+    const wchar_t* outputFolder,
+    bool             useASM,
+    int              numThreads,
+    ProgressCallback progressCb,
+    LogCallback      logCb,
+    int64_t* outElapsedMs)
+{
+    // Format domyślny bez kodowania entropijnego — pliki dekoduje każda DLL,
+    // a czas kompresji ASM i C++ obejmuje tę samą pracę. Kodowanie entropijne
+    // włącza się przez StartCompressionEx (pole entropy).
+    StartCompressionEx(sourceFolder, outputFolder, useASM, numThreads,
+        nullptr, progressCb, logCb, outElapsedMs);
+}
+
+void __stdcall StartCompressionEx(
+    const wchar_t* sourceFolder,
+    const wchar_t* outputFolder,
+    bool             useASM,
+    int              numThreads,
+    const Lz77CompressOptions* options,
+    ProgressCallback progressCb,
+    LogCallback      logCb,
+    int64_t* outElapsedMs)
+{
+    uint32_t blockPixels = options ? options->blockPixels : 0u;
+    uint32_t maxInFlight = options ? options->maxInFlight : 0u;
+    StatsCallback statsCb = options ? options->statsCb : nullptr;
+    uint32_t level = options ? options->level : 0u;
+    uint32_t kernel = options ? options->kernel : LOGIC_KERNEL_DEFAULT;
+    Lz77BatchStats* batchStats = options ? options->batchStats : nullptr;
+    uint32_t ioMode = options ? options->ioMode : LOGIC_IO_SYNC;
+    uint32_t ioQueueDepth = (options && options->ioQueueDepth) ? options->ioQueueDepth : LOGIC_IO_DEFAULT_QUEUE_DEPTH;
+    Lz77IoStats* ioStats = options ? options->ioStats : nullptr;
+    uint32_t rowFilter = options ? options->rowFilter : LOGIC_ROW_FILTER_OFF;
+    uint32_t colorTransform = options ? options->colorTransform : LOGIC_TRANSFORM_NONE;
+    uint32_t entropy = options ? options->entropy : LOGIC_ENTROPY_NONE;
+
+    // --- Kernel z rejestru (DLL załadowana raz na cały proces)
+    const KernelEntry* kernelEntry = nullptr;
+    std::wstring dllError;
+
+    if (!AcquireKernel(kernel, useASM, kernelEntry, dllError)) {
+        if (logCb) logCb((L"Blad ladowania DLL: " + dllError).c_str());
+        return;
+    }
+    const LZ77Api& api = kernelEntry->api;
+    const int matchFinder = KernelMatchFinder(kernelEntry);
+    if (logCb) logCb((L"Kernel LZ77: " + KernelLabel(*kernelEntry)).c_str());
+
+    // --- Poziom kompresji: preset z DLL (tylko CppDll.dll). Parametry poziomu
+    // zapisywane są w nagłówku każdego pliku; strumień z oknem i długością
+    // dopasowań formatu kompaktowego zachowuje wersję LOGIC_FORMAT_PACKED.
+    LogicLevelParams levelParams{};
+    bool useLevel = false;
+    if (level != 0) {
+        useLevel = api.compressLevel && api.levelParams &&
+            api.levelParams(static_cast<int>(level), &levelParams) != 0;
+        if (!useLevel && logCb)
+            logCb(L"Poziom kompresji niedostepny (AsmDll.dll lub poziom spoza 1..5) - uzyto formatu domyslnego.");
+    }
+    uint16_t formatVersion = (useLevel && (levelParams.windowPx != LOGIC_PACKED_WINDOW_PX ||
+        levelParams.maxMatchPx != LOGIC_PACKED_MAX_MATCH_PX)) ? LOGIC_FORMAT_PACKED_EX : LOGIC_FORMAT_PACKED;
+    size_t workBytes = useLevel ? LogicLevelWorkBytes(levelParams) : LOGIC_LZ77_WORK_BYTES;
+    // Liczniki z kernela (z chainWalks) — lz77_rgba_compress_level lub *_packed_stats.
+    bool kernelStats = useLevel || api.compressPackedStats != nullptr;
+
+    // Kompresja strumieniowa (CppDll.dll): wyjście bloku rośnie fragmentami po
+    // LOGIC_STREAM_CHUNK_BYTES, zamiast rezerwować LogicPackedBound (~4 B/piksel)
+    // na każdy blok — pamięć obrazu w obiegu to faktyczny rozmiar strumienia.
+    // Bez eksportów strumieniowych (AsmDll.dll) — jeden bufor na najgorszy przypadek.
+    const LogicLevelParams* streamParams = useLevel ? &levelParams : nullptr;
+    size_t streamWorkBytes = (api.streamWorkBytes && api.streamBegin && api.streamCompress)
+        ? api.streamWorkBytes(streamParams) : 0;
+    bool useStream = streamWorkBytes != 0;
+
+    // --- Kodowanie entropijne bloków (tylko CppDll.dll). Koder potrzebuje całego
+    // strumienia tokenów bloku, więc wyłącza kompresję strumieniową.
+    bool useEntropy = entropy != LOGIC_ENTROPY_NONE;
+    if (useEntropy && (!api.entropyBound || !api.entropyEncode || entropy != LOGIC_ENTROPY_HUFFMAN)) {
+        useEntropy = false;
+        if (logCb)
+            logCb(L"Kodowanie entropijne niedostepne (AsmDll.dll lub nieznany tryb) - bloki bez kodowania.");
+    }
+    if (useEntropy) useStream = false;
+    if (useStream) workBytes = streamWorkBytes;
+
+    // Bufor roboczy bloku: z lz77_work_bytes tylko tyle, ile wymaga blok — tablica hash
+    // kodera rośnie z wejściem, więc wątek kompresujący same miniatury trzyma kilka KB
+    // zamiast 272 KB. Kompresja strumieniowa i AsmDll.dll — stały workBytes.
+    auto blockWorkBytes = [&](size_t count) {
+        return (!useStream && api.workBytes) ? api.workBytes(count, useLevel ? &levelParams : nullptr) : workBytes;
+        };
+
+    // --- Filtry wierszy i transformacja kolorów (tylko CppDll.dll): blok
+    // kompresowany jest jako reszty predykcji z bufora wątku, a filtr każdego
+    // wiersza trafia do nagłówka pliku (LZ77_FLAG_FILTERS).
+    bool useFilters = rowFilter != LOGIC_ROW_FILTER_OFF || colorTransform != LOGIC_TRANSFORM_NONE;
+    if (useFilters && (!api.filterRows || rowFilter > LOGIC_ROW_FILTER_ADAPTIVE ||
+            colorTransform > LOGIC_TRANSFORM_YCOCG_R)) {
+        useFilters = false;
+        if (logCb)
+            logCb(L"Filtry wierszy niedostepne (AsmDll.dll lub nieznany filtr) - kompresja bez filtrow.");
+    }
+    uint32_t codecFilter = rowFilter == LOGIC_ROW_FILTER_ADAPTIVE ? LOGIC_FILTER_ADAPTIVE
+        : rowFilter == LOGIC_ROW_FILTER_OFF ? LOGIC_FILTER_NONE : rowFilter - 1;
+
+    // Przepustowość kernela w rejestrze mierzona jest tylko dla formatu domyślnego —
+    // poziomy, filtry i kodowanie entropijne zmieniają koszt bloku, a partie
+    // z różnymi opcjami nadpisywałyby sobie pomiar.
+    const bool measureKernel = !useLevel && !useFilters && !useEntropy;
+
+    // ============================================================
+    // Struktura zadania kompresji — jeden obraz w obiegu potoku.
+    // Tworzona przy wczytaniu obrazu, zwalniana po zapisie pliku.
+    // ============================================================
+    struct CompressTask {
+        std::wstring          filePath;   // oryginalna ścieżka (do logowania i zapisu)
+        PixelBuffer           pixels;     // wczytane piksele RGBA
+        uint32_t              w = 0;      // szerokość obrazu
+        uint32_t              h = 0;      // wysokość obrazu
+        uint32_t              blockRows = 0;  // wierszy obrazu na blok
+        std::vector<BlockOutput> blockDst;  // wyjście bloków (fragmenty z areny)
+        std::vector<size_t>   blockLen;   // [out] liczba zapisanych bajtów każdego bloku
+        // [out] 1 = compFn rzuciła wyjątek dla bloku; uint8_t zamiast vector<bool>,
+        // bo różne wątki zapisują sąsiednie elementy jednocześnie.
+        std::vector<uint8_t>  blockException;
+        std::vector<int64_t>  blockUs;    // [out] czas kompresji każdego bloku w µs
+        std::vector<int64_t>  kernelUs;   // [out] czas samych wywołań kernela bloku w µs
+        std::vector<LogicKernelStats> blockStats;  // [out] liczniki tokenów (tylko gdy statsCb)
+        Lz77RowFilters        filters;    // [out] filtr każdego wiersza (tylko gdy useFilters)
+        int64_t               loadUs = 0; // czas wczytania obrazu w µs
+        uint32_t              blocksLeft = 0;    // bloki jeszcze nieskompresowane (pod muteksem)
+        bool                  loadOk = false;    // czy wczytanie obrazu się powiodło
+    };
+
+    // Jednostka pracy wątku: blok 'block' obrazu 'task'.
+    struct CompressJob {
+        CompressTask* task;
+        uint32_t      block;
+    };
+
+    // ============================================================
+    // Lista plików — tylko ścieżki; obrazy wczytywane są dopiero w potoku.
+    // ============================================================
+    std::vector<std::wstring> files;
 
-            tasks.push_back(std::move(task));
+    try {
+        for (auto& entry : fs::directory_iterator(sourceFolder)) {
+            if (!entry.is_regular_file()) continue;
+            std::wstring ext = entry.path().extension().wstring();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
+            if (!IMAGE_EXTENSIONS.count(ext)) continue;
+            files.push_back(entry.path().wstring());
         }
     }
     catch (const std::exception& ex) {
         std::string msg(ex.what());
         std::wstring wmsg(msg.begin(), msg.end());
         if (logCb) logCb((L"Blad enumeracji folderu: " + wmsg).c_str());
-        FreeLibrary(hMod);
         return;
     }
 
-    int totalFiles = static_cast<int>(tasks.size());
+    int totalFiles = static_cast<int>(files.size());
     if (totalFiles == 0) {
         if (logCb) logCb(L"Brak plikow obrazkow w folderze zrodlowym.");
-        FreeLibrary(hMod);
         return;
     }
+    ScheduleLargestFirst(files, ProbeImagePixels);
 
     CreateDirectoryW(outputFolder, nullptr);
 
-    // Atomowy indeks zadania — wątki pobierają kolejne zadania przez fetch_add,
-    // bez potrzeby muteksu (brak modyfikacji wektora tasks w wątkach).
-    std::atomic<int> taskIndex{ 0 };
+    int actualThreads = ThreadsFor(numThreads);
+    if (maxInFlight == 0)
+        maxInFlight = LOGIC_DEFAULT_IN_FLIGHT_PER_THREAD * static_cast<uint32_t>(actualThreads);
 
     // ============================================================
-    // FAZA 2: MIERZONA — tworzenie wątków, compFn, join.
-    //
-    // WAŻNE: tstart pobierany tuż przed pierwszym emplace_back().
-    // WAŻNE: tend pobierany tuż po ostatnim join().
-    // Wątki robocze wykonują WYŁĄCZNIE wywołania compFn() na danych
-    // z pre-alokowanych buforów — zero I/O, zero logowania, zero malloc.
+    // Stan potoku — wszystkie pola chronione przez 'mtx'.
+    //   cvWork  — budzi wątki robocze (nowe bloki lub zwolnione miejsce w obiegu),
+    //   cvWrite — budzi wątek zapisu (obraz gotowy do zapisu).
     // ============================================================
-    int actualThreads = std::max(1, numThreads);
-    std::vector<std::thread> workers;
-    workers.reserve(actualThreads);
+    std::mutex              mtx;
+    std::condition_variable cvWork;
+    std::condition_variable cvWrite;
+    std::deque<CompressJob> blockQueue;   // bloki czekające na kompresję
+    std::deque<std::unique_ptr<CompressTask>> writeQueue;  // obrazy gotowe do zapisu
+    std::vector<std::unique_ptr<CompressTask>> loaded;     // obrazy w trakcie kompresji
+    size_t   nextFile = 0;     // indeks kolejnego pliku do wczytania
+    uint32_t inFlight = 0;     // obrazy wczytane, a jeszcze niezapisane
+    int      loading = 0;      // wątki w trakcie wczytywania obrazu
+    size_t   totalBlocks = 0;
 
-    // Worker operuje wyłącznie na pre-alokowanych buforach — żadnego I/O.
-    auto worker = [&]() {
-        while (true) {
-            // fetch_add — atomowe pobranie indeksu bez muteksu.
-            int idx = taskIndex.fetch_add(1, std::memory_order_relaxed);
-            if (idx >= totalFiles) break;
+    // Pomiar czasu aktywności kompresji (patrz opis funkcji).
+    int activeCompress = 0;
+    std::chrono::steady_clock::time_point activeStart;
+    std::chrono::steady_clock::duration   compressBusy{ 0 };
+
+    // Czas pracy każdego wątku (ComputeBatchStats) — indeks przydzielany przy starcie.
+    std::vector<int64_t> workerBusyUs(static_cast<size_t>(actualThreads), 0);
+    std::atomic<size_t>  workerSlot{ 0 };
+
+    // ============================================================
+    // Asynchroniczne I/O (LOGIC_IO_ASYNC):
+    //   - odczyt z wyprzedzeniem: plik i czytany jest do pamięci (HGLOBAL —
+    //     GDI+ dekoduje go przez IStream), zanim wątek roboczy po niego sięgnie;
+    //     wątek biorący plik i zgłasza odczyt plików do i + ioQueueDepth,
+    //   - zapis: wątek zapisu zgłasza plik .lz77 i od razu bierze kolejny obraz;
+    //     zakończone zapisy wracają przez writeDone (pod 'mtx').
+    // Port niedostępny — tryb synchroniczny.
+    // ============================================================
+    struct PrefetchSlot {
+        HGLOBAL  mem = nullptr;
+        uint64_t bytes = 0;
+        int      state = 0;     // 0 = w trakcie, 1 = wczytany, -1 = błąd odczytu
+    };
+    std::vector<PrefetchSlot> prefetch(files.size());
+    std::mutex                prefetchMtx;
+    std::condition_variable   prefetchCv;
+    size_t                    prefetchIssued = 0;   // pliki [0, prefetchIssued) zgłoszone
 
-            CompressTask& task = tasks[static_cast<size_t>(idx)];
-            if (!task.loadOk) continue;  // plik nie załadowany — pomiń (wylogowane w FAZIE 3)
+    struct WriteDone {
+        std::shared_ptr<CompressTask> task;
+        bool    ok;
+        int64_t us;
+    };
+    std::deque<WriteDone> writeDone;
 
-            size_t pixelCount = static_cast<size_t>(task.w) * task.h;
+    AsyncIo io;
+    bool useAsyncIo = ioMode == LOGIC_IO_ASYNC && io.Start(ioQueueDepth);
+    if (ioMode == LOGIC_IO_ASYNC && !useAsyncIo && logCb)
+        logCb(L"Asynchroniczne I/O niedostepne - uzyto trybu synchronicznego.");
 
-            try {
-                compFn(task.pixels.data(), pixelCount,
-                    task.dst.data(), task.dst.size(),
-                    task.work.data(), task.work.size(),
-                    &task.outLen);
+    // Zgłoszenie odczytu plików [prefetchIssued, end).
+    auto prefetchUpTo = [&](size_t end) {
+        size_t begin = 0;
+        {
+            std::lock_guard<std::mutex> lock(prefetchMtx);
+            end = std::min(end, files.size());
+            if (end <= prefetchIssued) return;
+            begin = prefetchIssued;
+            prefetchIssued = end;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            auto req = std::make_unique<AsyncIoRequest>();
+            req->path = files[i];
+            // Slot i należy do wątku I/O do ustawienia state (pod prefetchMtx).
+            req->allocate = [&prefetch, i](uint64_t bytes) -> uint8_t* {
+                HGLOBAL mem = GlobalAlloc(GMEM_MOVEABLE, static_cast<SIZE_T>(std::max<uint64_t>(bytes, 1)));
+                if (!mem) return nullptr;
+                prefetch[i].mem = mem;
+                return static_cast<uint8_t*>(GlobalLock(mem));
+                };
+            req->done = [&prefetch, &prefetchMtx, &prefetchCv, i](const AsyncIoRequest& r) {
+                std::lock_guard<std::mutex> lock(prefetchMtx);
+                PrefetchSlot& slot = prefetch[i];
+                if (slot.mem) {
+                    GlobalUnlock(slot.mem);
+                    if (!r.ok) {
+                        GlobalFree(slot.mem);
+                        slot.mem = nullptr;
+                    }
+                }
+                slot.bytes = r.bytes;
+                slot.state = r.ok ? 1 : -1;
+                prefetchCv.notify_all();
+                };
+            io.Submit(std::move(req));
+        }
+        };
+    if (useAsyncIo) prefetchUpTo(ioQueueDepth);
+
+    // Przekazanie obrazu do zapisu — wywoływane pod muteksem.
+    auto finishTask = [&](CompressTask* task) {
+        auto it = std::find_if(loaded.begin(), loaded.end(),
+            [task](const std::unique_ptr<CompressTask>& p) { return p.get() == task; });
+        writeQueue.push_back(std::move(*it));
+        loaded.erase(it);
+        cvWrite.notify_one();
+        };
+
+    // Wczytanie obrazu files[idx] i przygotowanie bloków — wywoływane BEZ muteksu.
+    auto loadTask = [&](size_t idx) {
+        auto task = std::make_unique<CompressTask>();
+        task->filePath = files[idx];
+        auto t0 = std::chrono::steady_clock::now();
+        try {
+            if (useAsyncIo) {
+                prefetchUpTo(idx + 1 + ioQueueDepth);
+                std::unique_lock<std::mutex> lock(prefetchMtx);
+                prefetchCv.wait(lock, [&]() { return prefetch[idx].state != 0; });
+                PrefetchSlot slot = prefetch[idx];
+                prefetch[idx].mem = nullptr;
+                lock.unlock();
+                task->loadOk = slot.state > 0 &&
+                    LoadImagePixelsFromMemory(slot.mem, slot.bytes, task->pixels, task->w, task->h);
             }
-            catch (...) {
-                task.exception = true;
+            else {
+                task->loadOk = LoadImagePixels(task->filePath, task->pixels, task->w, task->h);
+            }
+            task->loadUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - t0).count();
+
+            if (task->loadOk) {
+                task->blockRows = BlockRowsFor(task->w, task->h, blockPixels);
+                uint32_t blockCount = (task->h + task->blockRows - 1) / task->blockRows;
+
+                // Wyjście bloków alokowane jest dopiero przy kompresji (CompressBlock).
+                task->blockDst.resize(blockCount);
+                task->blockLen.assign(blockCount, 0);
+                task->blockException.assign(blockCount, 0);
+                task->blockUs.assign(blockCount, 0);
+                task->kernelUs.assign(blockCount, 0);
+                if (statsCb) task->blockStats.assign(blockCount, LogicKernelStats{});
+                if (useFilters) {
+                    task->filters.transform = colorTransform;
+                    task->filters.rows.assign(task->h, LOGIC_FILTER_NONE);
+                }
+                task->blocksLeft = blockCount;
             }
         }
+        catch (...) {
+            // Brak pamięci na obraz — plik zgłaszany jako niewczytany.
+            task->loadOk = false;
+            task->pixels.clear();
+            task->blockDst.clear();
+        }
+        return task;
         };
 
-    // --- tstart: tuż przed pierwszym emplace_back()
-    auto tstart = std::chrono::steady_clock::now();
+    // ============================================================
+    // Wątek roboczy — ETAP 1 (wczytanie) i ETAP 2 (kompresja).
+    // ============================================================
+    auto worker = [&](WorkerScratch& scratch) {
+        // Bufor roboczy wątku puli: head[] + prev[okno], najwyżej 272 KB dla okna 4096;
+        // rośnie do największego bloku wątku (blockWorkBytes). Kompresor inicjalizuje
+        // head[] przy każdym wywołaniu, więc bufor nie wymaga czyszczenia między blokami
+        // ani między partiami.
+        ByteBuffer& work = scratch.work;
+        size_t  slot = workerSlot.fetch_add(1);
+        int64_t busyUs = 0;
+        KernelSimdScope simd(kernelEntry);
 
-    for (int i = 0; i < actualThreads; ++i)
-        workers.emplace_back(worker);
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            if (!blockQueue.empty()) {
+                CompressJob job = blockQueue.front();
+                blockQueue.pop_front();
+                if (activeCompress++ == 0) activeStart = std::chrono::steady_clock::now();
+                lock.unlock();
 
-    // WAŻNE: join() musi być przed tend — czekamy na zakończenie WSZYSTKICH wątków.
-    for (auto& t : workers)
-        if (t.joinable()) t.join();
+                CompressTask& task = *job.task;
+                size_t firstRow = static_cast<size_t>(job.block) * task.blockRows;
+                size_t rows = std::min<size_t>(task.blockRows, task.h - firstRow);
+                BlockOutput& out = task.blockDst[job.block];
+                const uint32_t* src = task.pixels.data() + firstRow * task.w;
+                size_t count = rows * task.w;
+                LogicKernelStats* ks = statsCb ? &task.blockStats[job.block] : nullptr;
 
-    // --- tend: tuż po ostatnim join()
-    auto tend = std::chrono::steady_clock::now();
+                auto t0 = std::chrono::steady_clock::now();
+                try {
+                    scratch.Work(blockWorkBytes(count));
+
+                    // Reszty filtrów wierszy bloku (pierwszy wiersz bez wiersza powyżej —
+                    // bloki pozostają niezależne) zamiast pikseli.
+                    bool filtered = true;
+                    if (useFilters) {
+                        PixelBuffer& residuals = scratch.Pixels(count);
+                        filtered = api.filterRows(src, residuals.data(), task.w, rows, codecFilter,
+                            colorTransform, task.filters.rows.data() + firstRow) != 0;
+                        src = residuals.data();
+                    }
+
+                    if (!filtered) {
+                        task.blockLen[job.block] = 0;
+                    }
+                    else if (useStream) {
+                        // Fragmenty o rozmiarze min(LOGIC_STREAM_CHUNK_BYTES, granica bloku)
+                        // — mały blok mieści się w jednym fragmencie.
+                        size_t chunkBytes = std::min(LOGIC_STREAM_CHUNK_BYTES, LogicPackedBound(count));
+                        size_t total = 0;
+                        auto k0 = std::chrono::steady_clock::now();
+                        int begun = api.streamBeginEx
+                            ? api.streamBeginEx(work.data(), work.size(), src, count, task.w, streamParams, matchFinder)
+                            : api.streamBeginImage
+                            ? api.streamBeginImage(work.data(), work.size(), src, count, task.w, streamParams)
+                            : api.streamBegin(work.data(), work.size(), src, count, streamParams);
+                        int rc = begun ? LOGIC_STREAM_NEED_OUTPUT : LOGIC_STREAM_ERROR;
+                        while (rc == LOGIC_STREAM_NEED_OUTPUT) {
+                            out.chunks.emplace_back();
+                            ByteBuffer& chunk = out.chunks.back();
+                            chunk.resize(chunkBytes);
+                            size_t len = 0;
+                            rc = api.streamCompress(work.data(), chunk.data(), chunk.size(), &len, ks);
+                            chunk.resize(len);
+                            if (len == 0) out.chunks.pop_back();
+                            total += len;
+                        }
+                        task.kernelUs[job.block] = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - k0).count();
+                        task.blockLen[job.block] = (rc == LOGIC_STREAM_DONE) ? total : 0;
+                    }
+                    else {
+                        out.chunks.resize(1);
+                        ByteBuffer& dst = out.chunks[0];
+                        dst.resize(LogicPackedBound(count));
+                        auto k0 = std::chrono::steady_clock::now();
+                        if (api.compressEx) {
+                            // Jak compressImage, ze strukturą wyszukiwania kernela partii.
+                            api.compressEx(src, count, task.w,
+                                dst.data(), dst.size(),
+                                work.data(), work.size(), useLevel ? &levelParams : nullptr,
+                                matchFinder, &task.blockLen[job.block], ks);
+                        }
+                        else if (api.compressImage) {
+                            // Blok to pełne wiersze obrazu — kandydaci z wierszy powyżej
+                            // (w obrębie bloku) uzupełniają łańcuch hash.
+                            api.compressImage(src, count, task.w,
+                                dst.data(), dst.size(),
+                                work.data(), work.size(), useLevel ? &levelParams : nullptr,
+                                &task.blockLen[job.block], ks);
+                        }
+                        else if (useLevel) {
+                            api.compressLevel(src, count,
+                                dst.data(), dst.size(),
+                                work.data(), work.size(), &levelParams,
+                                &task.blockLen[job.block], ks);
+                        }
+                        else if (statsCb && api.compressPackedStats) {
+                            api.compressPackedStats(src, count,
+                                dst.data(), dst.size(),
+                                work.data(), work.size(),
+                                &task.blockLen[job.block], ks);
+                        }
+                        else {
+                            api.compressPacked(src, count,
+                                dst.data(), dst.size(),
+                                work.data(), work.size(),
+                                &task.blockLen[job.block]);
+                        }
+                        task.kernelUs[job.block] = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - k0).count();
+                        dst.resize(task.blockLen[job.block]);
+
+                        // Kodowanie entropijne do bufora wątku, który zastępuje wyjście
+                        // bloku (bez kopiowania); lz77_entropy_encode nie powiększa bloku
+                        // o więcej niż bajt trybu.
+                        if (useEntropy && task.blockLen[job.block] != 0) {
+                            size_t tokens = task.blockLen[job.block];
+                            ByteBuffer& coded = scratch.Coded(api.entropyBound(tokens));
+                            api.entropyEncode(dst.data(), tokens, useLevel ? &levelParams : nullptr,
+                                coded.data(), coded.size(), &task.blockLen[job.block]);
+                            coded.resize(task.blockLen[job.block]);
+                            std::swap(dst, coded);
+                        }
+                    }
+                }
+                catch (...) {
+                    task.blockException[job.block] = 1;
+                }
+                task.blockUs[job.block] = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+                busyUs += task.blockUs[job.block];
+
+                lock.lock();
+                if (--activeCompress == 0) compressBusy += std::chrono::steady_clock::now() - activeStart;
+                if (--task.blocksLeft == 0) finishTask(&task);
+            }
+            else if (nextFile < files.size() && inFlight < maxInFlight) {
+                size_t idx = nextFile++;
+                ++inFlight;
+                ++loading;
+                lock.unlock();
+
+                // Wczytanie obrazu (I/O) — poza muteksem, równolegle z kompresją innych bloków.
+                auto t0 = std::chrono::steady_clock::now();
+                std::unique_ptr<CompressTask> task = loadTask(idx);
+                busyUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+
+                lock.lock();
+                --loading;
+                CompressTask* raw = task.get();
+                loaded.push_back(std::move(task));
+                if (raw->loadOk && raw->blocksLeft > 0) {
+                    for (uint32_t b = 0; b < raw->blocksLeft; ++b)
+                        blockQueue.push_back({ raw, b });
+                    totalBlocks += raw->blocksLeft;
+                    cvWork.notify_all();
+                }
+                else {
+                    finishTask(raw);  // niewczytany (lub pusty) obraz — od razu do zapisu/logu
+                }
+            }
+            else if (nextFile >= files.size() && loading == 0) {
+                workerBusyUs[slot] = busyUs;   // pod muteksem
+                break;  // wszystkie pliki wczytane, a kolejka bloków pusta
+            }
+            else {
+                cvWork.wait(lock);
+            }
+        }
+        // Budzimy pozostałe wątki, aby mogły sprawdzić warunek zakończenia.
+        cvWork.notify_all();
+        };
+
+    auto tstart = std::chrono::steady_clock::now();
+
+    // Wątki robocze z puli (Lz77PoolStart) — najwyżej tyle, ile wątków ma pula.
+    PoolGroup workers;
+    actualThreads = PoolWorkersFor(actualThreads);
+    workerBusyUs.assign(static_cast<size_t>(actualThreads), 0);
+    workers.Run(actualThreads, worker);
 
     // ============================================================
-    // FAZA 3: POST — zapis wyników, logowanie, progress.
-    //
-    // Wykonywana sekwencyjnie po zatrzymaniu stopera.
-    // Zawiera wszystkie operacje I/O (zapis .lz77) i wywołania callbacków.
+    // ETAP 3: ZAPIS — wątek wywołujący zapisuje obrazy w kolejności ukończenia.
+    // W trybie LOGIC_IO_ASYNC tylko zgłasza zapis; log, statystyki i zwolnienie
+    // miejsca w obiegu następują po zakończeniu zapisu (writeDone).
     // ============================================================
-    int64_t elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-        tend - tstart).count();
-    if (outElapsedMs) *outElapsedMs = elapsedMs;
-
     int processed = 0;
-    for (auto& task : tasks) {
+    uint64_t measuredBytes = 0;   // pomiar przepustowości kernela (zapisane pliki)
+    int64_t  measuredUs = 0;
+    Lz77IoStats ioResult{};
+    ioResult.mode = useAsyncIo ? LOGIC_IO_ASYNC : LOGIC_IO_SYNC;
+
+    // Obraz do zapisu: wczytany, a każdy blok skompresowany bez wyjątku i niepusty.
+    auto writable = [](const CompressTask& task) {
+        if (!task.loadOk || task.blockDst.empty()) return false;
+        for (size_t b = 0; b < task.blockDst.size(); ++b)
+            if (task.blockException[b] != 0 || task.blockLen[b] == 0) return false;
+        return true;
+        };
+
+    // Rozmiar pliku .lz77 obrazu: nagłówek z rekordami (CompressedFileHeader —
+    // ten sam, który trafia do pliku) i strumienie bloków.
+    auto fileBytes = [&](const CompressTask& task) {
+        uint64_t bytes = CompressedFileHeader(task.w, task.h, formatVersion, task.blockRows, task.blockDst,
+            useLevel ? &levelParams : nullptr, useFilters ? &task.filters : nullptr, useEntropy).size();
+        for (const BlockOutput& block : task.blockDst)
+            bytes += block.Size();
+        return bytes;
+        };
+
+    // Log i statystyki pliku — po zapisie (written, writeUs) lub bez zapisu
+    // (obraz z błędem wcześniejszego etapu).
+    auto reportTask = [&](const CompressTask& task, bool written, int64_t writeUs) {
         std::wstring fileName = fs::path(task.filePath).filename().wstring();
         std::wstring stem = fs::path(task.filePath).stem().wstring();
 
+        // Blok z wyjątkiem lub pustym wynikiem psuje cały plik.
+        bool exception = false;
+        bool emptyBlock = false;
+        const std::vector<BlockOutput>& blocks = task.blockDst;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            exception = exception || task.blockException[b] != 0;
+            emptyBlock = emptyBlock || task.blockLen[b] == 0;
+        }
+
+        Lz77FileStats st{};
+        st.fileName = fileName.c_str();
+        st.width = task.w;
+        st.height = task.h;
+        st.loadUs = task.loadUs;
+        st.inputBytes = static_cast<uint64_t>(task.w) * task.h * sizeof(uint32_t);
+        st.chainWalks = kernelStats ? 0 : LOGIC_STATS_UNAVAILABLE;
+
         if (!task.loadOk) {
             if (logCb) logCb((L"Nie mozna wczytac obrazu: " + fileName).c_str());
         }
-        else if (task.exception) {
+        else if (exception) {
             if (logCb) logCb((L"Wyjatek podczas kompresji: " + fileName).c_str());
         }
-        else if (task.outLen == 0) {
+        else if (emptyBlock || blocks.empty()) {
             if (logCb) logCb((L"Kompresja zwrocila 0 bajtow: " + fileName).c_str());
         }
         else {
-            // Zapis pliku .lz77 (I/O — po stoperze).
-            std::wstring outFile = std::wstring(outputFolder) + L"\\" + stem + L".lz77";
-            if (!WriteCompressedFile(outFile, task.w, task.h,
-                task.dst.data(), task.outLen)) {
+            st.writeUs = writeUs;
+            if (!written) {
                 if (logCb) logCb((L"Blad zapisu: " + stem + L".lz77").c_str());
             }
             else {
                 if (logCb) logCb((L"Skompresowano: " + fileName).c_str());
+                st.ok = 1;
+                st.outputBytes = fileBytes(task);
+                if (measureKernel) {
+                    measuredBytes += st.inputBytes;
+                    for (int64_t us : task.kernelUs)
+                        measuredUs += us;
+                }
+            }
+        }
+
+        if (statsCb) {
+            for (size_t b = 0; b < task.blockUs.size(); ++b) {
+                st.compressUs += task.blockUs[b];
+                LogicKernelStats ks = task.blockStats[b];
+                // Bez liczników z kernela (AsmDll.dll) blok ma zawsze jeden fragment.
+                if (!kernelStats && task.blockDst[b].chunks.size() == 1)
+                    CountPackedTokens(task.blockDst[b].chunks[0].data(), task.blockLen[b], ks);
+                st.literalPixels += ks.literalPx;
+                st.literalRuns += ks.literalRuns;
+                st.matches += ks.matches;
+                st.matchPixels += ks.matchPx;
+                if (kernelStats) st.chainWalks += ks.chainWalks;
+            }
+            st.avgMatchLength = st.matches
+                ? static_cast<double>(st.matchPixels) / static_cast<double>(st.matches) : 0.0;
+            statsCb(&st);
+        }
+        };
+
+    while (processed < totalFiles) {
+        std::unique_ptr<CompressTask> task;
+        WriteDone done{};
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvWrite.wait(lock, [&]() { return !writeQueue.empty() || !writeDone.empty(); });
+            if (!writeDone.empty()) {
+                done = std::move(writeDone.front());
+                writeDone.pop_front();
+            }
+            else {
+                task = std::move(writeQueue.front());
+                writeQueue.pop_front();
+            }
+        }
+
+        if (done.task) {
+            // Zapis asynchroniczny zakończony.
+            reportTask(*done.task, done.ok, done.us);
+            done.task.reset();
+        }
+        else if (!writable(*task)) {
+            reportTask(*task, false, 0);
+            task.reset();
+        }
+        else {
+            // Zapis pliku .lz77 — równolegle z kompresją kolejnych obrazów.
+            std::wstring stem = fs::path(task->filePath).stem().wstring();
+            std::wstring outFile = std::wstring(outputFolder) + L"\\" + stem + L".lz77";
+            auto t0 = std::chrono::steady_clock::now();
+
+            if (useAsyncIo) {
+                // Nagłówek i fragmenty bloków żyją w żądaniu do końca zapisu.
+                std::shared_ptr<CompressTask> owner(std::move(task));
+                auto header = std::make_shared<std::vector<uint8_t>>(CompressedFileHeader(owner->w, owner->h,
+                    formatVersion, owner->blockRows, owner->blockDst, useLevel ? &levelParams : nullptr,
+                    useFilters ? &owner->filters : nullptr, useEntropy));
+
+                auto req = std::make_unique<AsyncIoRequest>();
+                req->path = outFile;
+                req->write = true;
+                req->pieces.emplace_back(header->data(), header->size());
+                for (const BlockOutput& block : owner->blockDst)
+                    for (const ByteBuffer& chunk : block.chunks)
+                        req->pieces.emplace_back(chunk.data(), chunk.size());
+                req->done = [&mtx, &writeDone, &cvWrite, owner, header](const AsyncIoRequest& r) {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    writeDone.push_back({ owner, r.ok, r.us });
+                    cvWrite.notify_one();
+                    };
+                io.Submit(std::move(req));
+                ioResult.callerWriteUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+                continue;   // obraz zostaje w obiegu do zakończenia zapisu
             }
+
+            bool written = WriteCompressedFile(outFile, task->w, task->h, formatVersion,
+                task->blockRows, task->blockDst, useLevel ? &levelParams : nullptr,
+                useFilters ? &task->filters : nullptr, useEntropy);
+            int64_t writeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - t0).count();
+            ioResult.callerWriteUs += writeUs;
+            ioResult.writeUs += writeUs;
+            if (written) {
+                ioResult.writes++;
+                ioResult.bytesWritten += fileBytes(*task);
+            }
+            ioResult.maxInFlight = 1;
+            reportTask(*task, written, writeUs);
+            task.reset();
+        }
+
+        // Zwolnienie pamięci obrazu i miejsca w obiegu — wątki mogą wczytać kolejny plik.
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            --inFlight;
         }
+        cvWork.notify_all();
 
         ++processed;
         if (progressCb) progressCb((processed * 100) / totalFiles);
     }
 
+    // Wszystkie zapisy zakończone (writeDone); Stop kończy wątki I/O.
+    if (useAsyncIo) {
+        io.Stop();
+        int64_t callerWriteUs = ioResult.callerWriteUs;
+        io.FillStats(ioResult);
+        ioResult.callerWriteUs = callerWriteUs;
+    }
+    if (ioStats) *ioStats = ioResult;
+
+    // WAŻNE: oczekiwanie na zadania puli przed zwolnieniem stanu potoku —
+    // wątki nadal go używają.
+    workers.Wait();
+
+    auto tend = std::chrono::steady_clock::now();
+    RecordKernelThroughput(kernelEntry, true, measuredBytes, measuredUs);
+    Lz77BatchStats balance = ComputeBatchStats(workerBusyUs);
+    if (batchStats) *batchStats = balance;
+
+    int64_t elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(compressBusy).count();
+    int64_t pipelineMs = std::chrono::duration_cast<std::chrono::milliseconds>(tend - tstart).count();
+    if (outElapsedMs) *outElapsedMs = elapsedMs;
+
     if (progressCb) progressCb(100);
 
     std::wstringstream rpt;
     rpt << L"--- Kompresja zakonczona ---\n"
         << L"Plikow: " << totalFiles << L"  |  "
+        << L"Blokow: " << totalBlocks << L"  |  "
         << L"Watkow: " << actualThreads << L"  |  "
-        << L"Czas algorytmu LZ77: " << elapsedMs << L" ms";
+        << L"W obiegu: " << maxInFlight << L"  |  "
+        << L"Poziom: " << (useLevel ? levelParams.level : 0u) << L"  |  "
+        << L"Czas algorytmu LZ77: " << elapsedMs << L" ms  |  "
+        << L"Czas calkowity: " << pipelineMs << L" ms  |  "
+        << L"Nierownowaga watkow: " << static_cast<int>(balance.imbalance * 100.0 + 0.5) << L"%  |  "
+        << L"I/O: " << (useAsyncIo ? L"async" : L"sync")
+        << L", zapis (watek glowny): " << ioResult.callerWriteUs / 1000 << L" ms";
     if (logCb) logCb(rpt.str().c_str());
+}
 
-    // WAŻNE: FreeLibrary po join() — wątki przestały używać kodu z DLL.
-    FreeLibrary(hMod);
+// ============================================================
+// WAŻNE: StartDecompression — główna funkcja dekompresji, eksportowana do C#.
+//
+// Symetryczna architektura potokowa jak w StartCompression
+// (ograniczona liczba obrazów w pamięci — maxInFlight):
+//
+//   ETAP 1 — ODCZYT (wątki robocze):
+//     Wątek bez pracy dekompresji odczytuje kolejny plik .lz77, o ile liczba
+//     obrazów w obiegu jest mniejsza niż maxInFlight:
+//       - odwzorowanie pliku w pamięci i walidacja nagłówka i tabeli bloków
+//         (ReadCompressedFile) — dekoder czyta tokeny wprost z widoku pliku,
+//       - alokacja bufora wyjściowego pixels (width * height pikseli),
+//       - wstawienie bloków do kolejki dekompresji.
+//
+//   ETAP 2 — DEKOMPRESJA (wątki robocze):
+//     Jednostką pracy jest para (plik, blok) z tabeli bloków. Wątki zawsze
+//     wybierają najpierw bloki do dekompresji, a dopiero potem odczytują
+//     kolejny plik.
+//
+//   ETAP 3 — ZAPIS (wątek wywołujący):
+//     Obraz, którego wszystkie bloki są gotowe, zapisywany jest jako .bmp
+//     (GDI+), po czym jego pamięć i miejsce w obiegu są zwalniane
+//     (back-pressure dla etapu odczytu).
+//
+// Pomiar czasu (outElapsedMs) — jak w StartCompression: suma przedziałów,
+// w których trwało co najmniej jedno wywołanie decompFn().
+// ============================================================
+void __stdcall StartDecompression(
+    const wchar_t* sourceFolder,
+    const wchar_t* outputFolder,
+    bool             useASM,
+    int              numThreads,
+    ProgressCallback progressCb,
+    LogCallback      logCb,
+    int64_t* outElapsedMs)
+{
+    StartDecompressionEx(sourceFolder, outputFolder, useASM, numThreads,
+        nullptr, progressCb, logCb, outElapsedMs);
 }
 
-// ============================================================
-// WAŻNE: StartDecompression — główna funkcja dekompresji, eksportowana do C#.
-//
-// Symetryczna architektura trójfazowa jak w StartCompression.
-//
-//   FAZA 1 — PRE-LOAD (przed stoperem):
-//     Dla każdego pliku .lz77:
-//       - odczyt nagłówka i danych skompresowanych (ReadCompressedFile),
-//       - pre-alokacja bufora wyjściowego pixels (width * height pikseli).
-//
-//   FAZA 2 — MIERZONA (tstart … tend):
-//     Obejmuje dokładnie i wyłącznie:
-//       - tworzenie wątków roboczych (emplace_back),
-//       - wywołania decompFn() we wszystkich wątkach,
-//       - oczekiwanie na zakończenie wątków (join()).
-//
-//   FAZA 3 — POST (po stoperze):
-//     Zapis zdekompresowanych obrazów (.bmp), logowanie, progress.
-// ============================================================
-void __stdcall StartDecompression(
+void __stdcall StartDecompressionEx(
     const wchar_t* sourceFolder,
     const wchar_t* outputFolder,
     bool             useASM,
     int              numThreads,
+    const Lz77DecompressOptions* options,
     ProgressCallback progressCb,
     LogCallback      logCb,
     int64_t* outElapsedMs)
 {
-    // --- Ladujemy JEDNA wybrana DLL (nie obie naraz)
-    HMODULE            hMod = nullptr;
-    LZ77CompressFunc   compFn = nullptr;   // wymagane przez LoadLZ77DLL, nieużywane tutaj
-    LZ77DecompressFunc decompFn = nullptr;
+    uint32_t maxInFlight = options ? options->maxInFlight : 0u;
+    uint32_t kernel = options ? options->kernel : LOGIC_KERNEL_DEFAULT;
+    Lz77BatchStats* batchStats = options ? options->batchStats : nullptr;
+    uint32_t ioMode = options ? options->ioMode : LOGIC_IO_SYNC;
+    uint32_t ioQueueDepth = (options && options->ioQueueDepth) ? options->ioQueueDepth : LOGIC_IO_DEFAULT_QUEUE_DEPTH;
+    Lz77IoStats* ioStats = options ? options->ioStats : nullptr;
+
+    // --- Kernel z rejestru (DLL załadowana raz na cały proces)
+    const KernelEntry* kernelEntry = nullptr;
     std::wstring dllError;
 
-    if (!LoadLZ77DLL(useASM, hMod, compFn, decompFn, dllError)) {
+    if (!AcquireKernel(kernel, useASM, kernelEntry, dllError)) {
         if (logCb) logCb((L"Blad ladowania DLL: " + dllError).c_str());
         return;
     }
-    if (logCb) logCb(useASM ? L"Zaladowano DLL: AsmDll.dll"
-        : L"Zaladowano DLL: CppDll.dll");
+    const LZ77Api& api = kernelEntry->api;
+    if (logCb) logCb((L"Kernel LZ77: " + KernelLabel(*kernelEntry)).c_str());
 
     // ============================================================
-    // Struktura zadania dekompresji — przechowuje wszystko, czego
-    // potrzebuje wątek roboczy (pre-wczytane dane + pre-alokowany bufor wyjściowy).
+    // Struktura zadania dekompresji — jeden obraz w obiegu potoku.
+    // Tworzona przy odczycie pliku .lz77, zwalniana po zapisie .bmp.
     // ============================================================
     struct DecompressTask {
         std::wstring          filePath;          // oryginalna ścieżka (do logowania i zapisu)
-        std::vector<uint8_t>  compData;          // pre-wczytane tokeny LZ77
+        MappedFile            compFile;          // plik .lz77 odwzorowany w pamięci
+        const uint8_t*        compData = nullptr;  // tokeny LZ77 w widoku compFile
+        Lz77BlockIndex        index;             // granice bloków w compData
         uint32_t              w = 0;             // szerokość obrazu z nagłówka
         uint32_t              h = 0;             // wysokość obrazu z nagłówka
-        std::vector<uint32_t> pixels;            // pre-alokowany bufor wyjściowy (piksele RGBA)
-        size_t                pixelCount = 0;    // oczekiwana liczba pikseli (w * h)
-        size_t                outLen = 0;        // [out] liczba odtworzonych pikseli po decompFn
+        StreamDecoder         decompFn;          // dekoder zgodny z wersją formatu z nagłówka
+        PixelBuffer           pixels;            // bufor wyjściowy (piksele RGBA)
+        // [out] stan każdego bloku: 1 = pełny blok odtworzony; uint8_t zamiast
+        // vector<bool>, bo różne wątki zapisują sąsiednie elementy jednocześnie.
+        std::vector<uint8_t>  blockOk;
+        std::vector<uint8_t>  blockException;    // [out] 1 = decompFn rzuciła wyjątek
+        std::vector<int64_t>  blockUs;           // [out] czas dekompresji każdego bloku w µs
+        uint32_t              blocksLeft = 0;    // bloki jeszcze niezdekodowane (pod muteksem)
         bool                  loadOk = false;    // czy odczyt .lz77 się powiódł
-        bool                  exception = false; // czy decompFn rzuciła wyjątek
+        const wchar_t*        loadError = nullptr; // przyczyna !loadOk dla poprawnego pliku
+        bool                  defaultFormat = false; // LOGIC_FORMAT_PACKED bez filtrów i kodowania (pomiar kernela)
+    };
+
+    // Jednostka pracy wątku: blok 'block' pliku 'task'.
+    struct DecompressJob {
+        DecompressTask* task;
+        uint32_t        block;
     };
 
     // ============================================================
-    // FAZA 1: PRE-LOAD — odczyt plików .lz77 i alokacja buforów.
+    // Lista plików — tylko ścieżki; dane wczytywane są dopiero w potoku.
     // ============================================================
-    std::vector<DecompressTask> tasks;
+    std::vector<std::wstring> files;
 
     try {
         for (auto& entry : fs::directory_iterator(sourceFolder)) {
@@ -672,130 +3337,880 @@ void __stdcall StartDecompression(
             std::wstring ext = entry.path().extension().wstring();
             std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
             if (ext != L".lz77") continue;
-
-            DecompressTask task;
-            task.filePath = entry.path().wstring();
-
-            // Odczyt pliku .lz77 (I/O — przed stoperem).
-            task.loadOk = ReadCompressedFile(task.filePath,
-                task.w, task.h, task.compData);
-
-            if (task.loadOk) {
-                task.pixelCount = static_cast<size_t>(task.w) * task.h;
-                // Pre-alokacja bufora wyjściowego — zerowanie chroni przed śmieciami
-                // w przypadku częściowej dekompresji.
-                task.pixels.assign(task.pixelCount, 0u);
-            }
-
-            tasks.push_back(std::move(task));
+            files.push_back(entry.path().wstring());
         }
     }
     catch (const std::exception& ex) {
         std::string msg(ex.what());
         std::wstring wmsg(msg.begin(), msg.end());
         if (logCb) logCb((L"Blad enumeracji folderu: " + wmsg).c_str());
-        FreeLibrary(hMod);
         return;
     }
 
-    int totalFiles = static_cast<int>(tasks.size());
+    int totalFiles = static_cast<int>(files.size());
     if (totalFiles == 0) {
         if (logCb) logCb(L"Brak plikow .lz77 w folderze zrodlowym.");
-        FreeLibrary(hMod);
         return;
     }
+    ScheduleLargestFirst(files, ProbeLz77Pixels);
 
     CreateDirectoryW(outputFolder, nullptr);
 
-    std::atomic<int> taskIndex{ 0 };
+    int actualThreads = ThreadsFor(numThreads);
+    if (maxInFlight == 0)
+        maxInFlight = LOGIC_DEFAULT_IN_FLIGHT_PER_THREAD * static_cast<uint32_t>(actualThreads);
 
     // ============================================================
-    // FAZA 2: MIERZONA — tworzenie wątków, decompFn, join.
+    // Stan potoku — wszystkie pola chronione przez 'mtx' (jak w StartCompression).
     // ============================================================
-    int actualThreads = std::max(1, numThreads);
-    std::vector<std::thread> workers;
-    workers.reserve(actualThreads);
+    std::mutex              mtx;
+    std::condition_variable cvWork;
+    std::condition_variable cvWrite;
+    std::deque<DecompressJob> blockQueue;  // bloki czekające na dekompresję
+    std::deque<std::unique_ptr<DecompressTask>> writeQueue;  // obrazy gotowe do zapisu
+    std::vector<std::unique_ptr<DecompressTask>> loaded;     // obrazy w trakcie dekompresji
+    size_t   nextFile = 0;     // indeks kolejnego pliku do odczytu
+    uint32_t inFlight = 0;     // obrazy wczytane, a jeszcze niezapisane
+    int      loading = 0;      // wątki w trakcie odczytu pliku
+    size_t   totalBlocks = 0;
 
-    // Worker operuje wyłącznie na pre-alokowanych buforach — żadnego I/O.
-    auto worker = [&]() {
-        while (true) {
-            int idx = taskIndex.fetch_add(1, std::memory_order_relaxed);
-            if (idx >= totalFiles) break;
+    int activeDecompress = 0;
+    std::chrono::steady_clock::time_point activeStart;
+    std::chrono::steady_clock::duration   decompressBusy{ 0 };
 
-            DecompressTask& task = tasks[static_cast<size_t>(idx)];
-            if (!task.loadOk) continue;  // plik nie załadowany — pomiń (wylogowane w FAZIE 3)
+    std::vector<int64_t> workerBusyUs(static_cast<size_t>(actualThreads), 0);
+    std::atomic<size_t>  workerSlot{ 0 };
 
-            try {
-                decompFn(task.compData.data(), task.compData.size(),
-                    task.pixels.data(), task.pixelCount,
-                    &task.outLen);
+    // Asynchroniczny zapis .bmp (LOGIC_IO_ASYNC) — jak w StartCompression; pliki
+    // .lz77 są czytane przez odwzorowanie w pamięci (MappedFile) w obu trybach.
+    struct WriteDone {
+        std::wstring stem;
+        bool         ok;
+    };
+    std::deque<WriteDone> writeDone;
+
+    AsyncIo io;
+    bool useAsyncIo = ioMode == LOGIC_IO_ASYNC && io.Start(ioQueueDepth);
+    if (ioMode == LOGIC_IO_ASYNC && !useAsyncIo && logCb)
+        logCb(L"Asynchroniczne I/O niedostepne - uzyto trybu synchronicznego.");
+
+    // Przekazanie obrazu do zapisu — wywoływane pod muteksem.
+    auto finishTask = [&](DecompressTask* task) {
+        auto it = std::find_if(loaded.begin(), loaded.end(),
+            [task](const std::unique_ptr<DecompressTask>& p) { return p.get() == task; });
+        writeQueue.push_back(std::move(*it));
+        loaded.erase(it);
+        cvWrite.notify_one();
+        };
+
+    // Odczyt pliku .lz77 i alokacja bufora wyjściowego — wywoływane BEZ muteksu.
+    auto loadTask = [&](const std::wstring& path) {
+        auto task = std::make_unique<DecompressTask>();
+        task->filePath = path;
+        try {
+            Lz77FileHeader hdr{};
+            task->loadOk = ReadCompressedFile(path, hdr, task->index, task->compFile, task->compData);
+
+            // Wybór dekodera według wersji formatu; nieznana wersja = plik nieobsługiwany.
+            if (task->loadOk) {
+                task->w = hdr.width;
+                task->h = hdr.height;
+                task->decompFn = DecoderForVersion(api, hdr.version, task->index);
+                task->loadOk = static_cast<bool>(task->decompFn);
+                if (!task->loadOk) task->loadError = DecoderRequirement(api, hdr.version, task->index);
+                task->defaultFormat = hdr.version == LOGIC_FORMAT_PACKED &&
+                    task->index.filters.rows.empty() && !task->index.entropy;
             }
-            catch (...) {
-                task.exception = true;
+
+            if (task->loadOk) {
+                // Bez zerowania: każdy blok nadpisuje swoje wiersze w całości, a obraz
+                // z niepełnym blokiem (blockOk == 0) nie jest zapisywany.
+                task->pixels.resize(static_cast<size_t>(task->w) * task->h);
+
+                uint32_t blockCount = static_cast<uint32_t>(task->index.offsets.size() - 1);
+                task->blockOk.assign(blockCount, 0);
+                task->blockException.assign(blockCount, 0);
+                task->blockUs.assign(blockCount, 0);
+                task->blocksLeft = blockCount;
             }
         }
+        catch (...) {
+            // Brak pamięci na obraz — plik zgłaszany jako niewczytany.
+            task->loadOk = false;
+            task->compFile.Close();
+            task->compData = nullptr;
+            task->pixels.clear();
+        }
+        return task;
         };
 
-    // --- tstart: tuż przed pierwszym emplace_back()
-    auto tstart = std::chrono::steady_clock::now();
+    // ============================================================
+    // Wątek roboczy — ETAP 1 (odczyt) i ETAP 2 (dekompresja).
+    // ============================================================
+    auto worker = [&](WorkerScratch& scratch) {
+        size_t  slot = workerSlot.fetch_add(1);
+        int64_t busyUs = 0;
+        KernelSimdScope simd(kernelEntry);
+
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            if (!blockQueue.empty()) {
+                DecompressJob job = blockQueue.front();
+                blockQueue.pop_front();
+                if (activeDecompress++ == 0) activeStart = std::chrono::steady_clock::now();
+                lock.unlock();
 
-    for (int i = 0; i < actualThreads; ++i)
-        workers.emplace_back(worker);
+                DecompressTask& task = *job.task;
+                size_t firstRow = static_cast<size_t>(job.block) * task.index.blockRows;
 
-    // WAŻNE: join() musi być przed tend — czekamy na zakończenie WSZYSTKICH wątków.
-    for (auto& t : workers)
-        if (t.joinable()) t.join();
+                auto t0 = std::chrono::steady_clock::now();
+                try {
+                    task.blockOk[job.block] = DecompressBlock(task.decompFn, task.compData,
+                        task.index, task.w, task.h, job.block,
+                        task.pixels.data() + firstRow * task.w, &scratch.pixels) ? 1 : 0;
+                }
+                catch (...) {
+                    task.blockException[job.block] = 1;
+                }
+                task.blockUs[job.block] = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+                busyUs += task.blockUs[job.block];
 
-    // --- tend: tuż po ostatnim join()
-    auto tend = std::chrono::steady_clock::now();
+                lock.lock();
+                if (--activeDecompress == 0) decompressBusy += std::chrono::steady_clock::now() - activeStart;
+                if (--task.blocksLeft == 0) finishTask(&task);
+            }
+            else if (nextFile < files.size() && inFlight < maxInFlight) {
+                size_t idx = nextFile++;
+                ++inFlight;
+                ++loading;
+                lock.unlock();
+
+                // Odczyt pliku (I/O) — poza muteksem, równolegle z dekompresją innych bloków.
+                auto t0 = std::chrono::steady_clock::now();
+                std::unique_ptr<DecompressTask> task = loadTask(files[idx]);
+                busyUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+
+                lock.lock();
+                --loading;
+                DecompressTask* raw = task.get();
+                loaded.push_back(std::move(task));
+                if (raw->loadOk && raw->blocksLeft > 0) {
+                    for (uint32_t b = 0; b < raw->blocksLeft; ++b)
+                        blockQueue.push_back({ raw, b });
+                    totalBlocks += raw->blocksLeft;
+                    cvWork.notify_all();
+                }
+                else {
+                    finishTask(raw);  // nieczytelny plik — od razu do logu
+                }
+            }
+            else if (nextFile >= files.size() && loading == 0) {
+                workerBusyUs[slot] = busyUs;   // pod muteksem
+                break;  // wszystkie pliki odczytane, a kolejka bloków pusta
+            }
+            else {
+                cvWork.wait(lock);
+            }
+        }
+        // Budzimy pozostałe wątki, aby mogły sprawdzić warunek zakończenia.
+        cvWork.notify_all();
+        };
+
+    auto tstart = std::chrono::steady_clock::now();
+
+    PoolGroup workers;
+    actualThreads = PoolWorkersFor(actualThreads);
+    workerBusyUs.assign(static_cast<size_t>(actualThreads), 0);
+    workers.Run(actualThreads, worker);
 
     // ============================================================
-    // FAZA 3: POST — zapis wyników, logowanie, progress.
+    // ETAP 3: ZAPIS — wątek wywołujący zapisuje obrazy w kolejności ukończenia.
+    // W trybie LOGIC_IO_ASYNC koduje BMP do pamięci i tylko zgłasza zapis;
+    // obraz zwalnia miejsce w obiegu po zakończeniu zapisu (writeDone).
     // ============================================================
-    int64_t elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-        tend - tstart).count();
-    if (outElapsedMs) *outElapsedMs = elapsedMs;
-
     int processed = 0;
-    for (auto& task : tasks) {
-        std::wstring fileName = fs::path(task.filePath).filename().wstring();
-        std::wstring stem = fs::path(task.filePath).stem().wstring();
+    uint64_t measuredBytes = 0;   // pomiar przepustowości kernela (poprawne pliki)
+    int64_t  measuredUs = 0;
+    Lz77IoStats ioResult{};
+    ioResult.mode = useAsyncIo ? LOGIC_IO_ASYNC : LOGIC_IO_SYNC;
 
-        if (!task.loadOk) {
-            if (logCb) logCb((L"Nie mozna wczytac lub uszkodzony: " + fileName).c_str());
-        }
-        else if (task.exception) {
-            if (logCb) logCb((L"Wyjatek podczas dekompresji: " + fileName).c_str());
+    while (processed < totalFiles) {
+        std::unique_ptr<DecompressTask> task;
+        WriteDone done{};
+        bool hasDone = false;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvWrite.wait(lock, [&]() { return !writeQueue.empty() || !writeDone.empty(); });
+            if (!writeDone.empty()) {
+                done = std::move(writeDone.front());
+                writeDone.pop_front();
+                hasDone = true;
+            }
+            else {
+                task = std::move(writeQueue.front());
+                writeQueue.pop_front();
+            }
         }
-        else if (task.outLen != task.pixelCount) {
-            // WAŻNE: outLen musi dokładnie równać się pixelCount.
-            // Niezgodność wskazuje na uszkodzone dane lub błąd w DLL.
-            if (logCb) logCb((L"Niezgodna liczba pikseli po dekompresji: " + fileName).c_str());
+
+        if (hasDone) {
+            // Zapis asynchroniczny zakończony.
+            if (!done.ok) {
+                if (logCb) logCb((L"Blad zapisu BMP: " + done.stem).c_str());
+            }
+            else {
+                if (logCb) logCb((L"Zdekompresowano: " + done.stem + L".bmp").c_str());
+            }
         }
         else {
-            // Zapis zdekompresowanego obrazu jako .bmp (I/O — po stoperze).
-            std::wstring outFile = std::wstring(outputFolder) + L"\\" + stem + L".bmp";
-            if (!SavePixelsAsBMP(outFile, task.pixels, task.w, task.h)) {
-                if (logCb) logCb((L"Blad zapisu BMP: " + stem).c_str());
+            std::wstring fileName = fs::path(task->filePath).filename().wstring();
+            std::wstring stem = fs::path(task->filePath).stem().wstring();
+
+            bool exception = std::count(task->blockException.begin(), task->blockException.end(), 1) != 0;
+            bool complete = std::count(task->blockOk.begin(), task->blockOk.end(), 0) == 0;
+
+            if (!task->loadOk && task->loadError) {
+                if (logCb) logCb((L"Nie mozna zdekompresowac " + fileName + L" - " + task->loadError).c_str());
+            }
+            else if (!task->loadOk) {
+                if (logCb) logCb((L"Nie mozna wczytac lub uszkodzony: " + fileName).c_str());
+            }
+            else if (exception) {
+                if (logCb) logCb((L"Wyjatek podczas dekompresji: " + fileName).c_str());
+            }
+            else if (!complete) {
+                // WAŻNE: każdy blok musi odtworzyć dokładnie rows * width pikseli.
+                // Niezgodność wskazuje na uszkodzone dane lub błąd w DLL.
+                if (logCb) logCb((L"Niezgodna liczba pikseli po dekompresji: " + fileName).c_str());
             }
             else {
-                if (logCb) logCb((L"Zdekompresowano: " + stem + L".bmp").c_str());
+                // Zapis zdekompresowanego obrazu jako .bmp — równolegle z dekompresją kolejnych plików.
+                std::wstring outFile = std::wstring(outputFolder) + L"\\" + stem + L".bmp";
+                if (task->defaultFormat) {
+                    measuredBytes += static_cast<uint64_t>(task->w) * task->h * sizeof(uint32_t);
+                    for (int64_t us : task->blockUs)
+                        measuredUs += us;
+                }
+
+                auto t0 = std::chrono::steady_clock::now();
+                if (useAsyncIo) {
+                    // Zakodowany BMP żyje w żądaniu do końca zapisu; piksele już niepotrzebne.
+                    auto image = std::make_shared<EncodedImage>();
+                    bool encoded = image->EncodeBMP(task->pixels, task->w, task->h);
+                    task.reset();
+                    if (encoded) {
+                        auto req = std::make_unique<AsyncIoRequest>();
+                        req->path = outFile;
+                        req->write = true;
+                        req->pieces.emplace_back(image->Data(), image->Size());
+                        req->done = [&mtx, &writeDone, &cvWrite, image, stem](const AsyncIoRequest& r) {
+                            std::lock_guard<std::mutex> lock(mtx);
+                            writeDone.push_back({ stem, r.ok });
+                            cvWrite.notify_one();
+                            };
+                        io.Submit(std::move(req));
+                        ioResult.callerWriteUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - t0).count();
+                        continue;   // obraz zostaje w obiegu do zakończenia zapisu
+                    }
+                    if (logCb) logCb((L"Blad zapisu BMP: " + stem).c_str());
+                }
+                else {
+                    bool written = SavePixelsAsBMP(outFile, task->pixels, task->w, task->h);
+                    int64_t writeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - t0).count();
+                    ioResult.callerWriteUs += writeUs;
+                    ioResult.writeUs += writeUs;
+                    ioResult.maxInFlight = 1;
+                    if (!written) {
+                        if (logCb) logCb((L"Blad zapisu BMP: " + stem).c_str());
+                    }
+                    else {
+                        if (logCb) logCb((L"Zdekompresowano: " + stem + L".bmp").c_str());
+                        ioResult.writes++;
+                        if (ioStats) {
+                            std::error_code ec;
+                            uintmax_t bytes = fs::file_size(outFile, ec);
+                            if (!ec) ioResult.bytesWritten += bytes;
+                        }
+                    }
+                }
             }
         }
 
+        // Zwolnienie pamięci obrazu i miejsca w obiegu — wątki mogą odczytać kolejny plik.
+        task.reset();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            --inFlight;
+        }
+        cvWork.notify_all();
+
         ++processed;
         if (progressCb) progressCb((processed * 100) / totalFiles);
     }
 
+    // Wszystkie zapisy zakończone (writeDone); Stop kończy wątki I/O.
+    if (useAsyncIo) {
+        io.Stop();
+        int64_t callerWriteUs = ioResult.callerWriteUs;
+        io.FillStats(ioResult);
+        ioResult.callerWriteUs = callerWriteUs;
+    }
+    if (ioStats) *ioStats = ioResult;
+
+    // WAŻNE: oczekiwanie na zadania puli przed zwolnieniem stanu potoku —
+    // wątki nadal go używają.
+    workers.Wait();
+
+    auto tend = std::chrono::steady_clock::now();
+    RecordKernelThroughput(kernelEntry, false, measuredBytes, measuredUs);
+    Lz77BatchStats balance = ComputeBatchStats(workerBusyUs);
+    if (batchStats) *batchStats = balance;
+
+    int64_t elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(decompressBusy).count();
+    int64_t pipelineMs = std::chrono::duration_cast<std::chrono::milliseconds>(tend - tstart).count();
+    if (outElapsedMs) *outElapsedMs = elapsedMs;
+
     if (progressCb) progressCb(100);
 
     std::wstringstream rpt;
     rpt << L"--- Dekompresja zakonczona ---\n"
         << L"Plikow: " << totalFiles << L"  |  "
+        << L"Blokow: " << totalBlocks << L"  |  "
         << L"Watkow: " << actualThreads << L"  |  "
-        << L"Czas algorytmu LZ77: " << elapsedMs << L" ms";
+        << L"W obiegu: " << maxInFlight << L"  |  "
+        << L"Czas algorytmu LZ77: " << elapsedMs << L" ms  |  "
+        << L"Czas calkowity: " << pipelineMs << L" ms  |  "
+        << L"Nierownowaga watkow: " << static_cast<int>(balance.imbalance * 100.0 + 0.5) << L"%  |  "
+        << L"I/O: " << (useAsyncIo ? L"async" : L"sync")
+        << L", zapis (watek glowny): " << ioResult.callerWriteUs / 1000 << L" ms";
     if (logCb) logCb(rpt.str().c_str());
+}
+
+// ============================================================
+// Lz77GetImageInfo — odczyt samego nagłówka i tabeli bloków pliku .lz77.
+// ============================================================
+bool __stdcall Lz77GetImageInfo(
+    const wchar_t* path,
+    uint32_t* outWidth,
+    uint32_t* outHeight,
+    uint32_t* outBlockRows,
+    uint32_t* outBlockCount)
+{
+    Lz77FileHeader hdr{};
+    Lz77BlockIndex index;
+    MappedFile     file;
+    const uint8_t* data = nullptr;
+    if (!path || !ReadCompressedFile(path, hdr, index, file, data)) return false;
+
+    if (outWidth)      *outWidth = hdr.width;
+    if (outHeight)     *outHeight = hdr.height;
+    if (outBlockRows)  *outBlockRows = index.blockRows;
+    if (outBlockCount) *outBlockCount = static_cast<uint32_t>(index.offsets.size() - 1);
+    return true;
+}
+
+// ============================================================
+// Lz77DecodeImage — dekompresja całego pliku .lz77 do bufora wywołującego.
+//
+// Bloki dekodowane są równolegle (DecompressBlocksParallel); plik zapisany
+// bez tabeli bloków to jeden blok, więc dekoduje go jeden wątek.
+// ============================================================
+bool __stdcall Lz77DecodeImage(
+    const wchar_t* path,
+    bool           useASM,
+    int            numThreads,
+    uint32_t* dst,
+    size_t         dstCount)
+{
+    const KernelEntry* kernelEntry = nullptr;
+    std::wstring dllError;
+    if (!dst || !AcquireKernel(LOGIC_KERNEL_DEFAULT, useASM, kernelEntry, dllError)) return false;
+    const LZ77Api& api = kernelEntry->api;
+
+    bool ok = false;
+    try {
+        Lz77FileHeader hdr{};
+        Lz77BlockIndex index;
+        MappedFile     file;
+        const uint8_t* data = nullptr;
+        StreamDecoder  decompFn;
+
+        if (ReadCompressedFile(path, hdr, index, file, data) &&
+            (decompFn = DecoderForVersion(api, hdr.version, index)) &&
+            dstCount >= static_cast<size_t>(hdr.width) * hdr.height) {
+            ok = DecompressBlocksParallel(decompFn, data, index, hdr.width, hdr.height,
+                0, index.offsets.size() - 2, dst, ThreadsFor(numThreads));
+        }
+    }
+    catch (...) {
+        ok = false;
+    }
+    return ok;
+}
+
+// ============================================================
+// Lz77DecodeRegion — dekompresja prostokąta (x, y, width, height) obrazu.
+//
+// Dekodowane są tylko bloki pokrywające wiersze [y, y + height) — równolegle,
+// do bufora tymczasowego; plik jest odwzorowany w pamięci, więc z dysku
+// wczytywane są wyłącznie strony tych bloków. Następnie żądane kolumny
+// kopiowane są wierszami do dst (width * height pikseli, wiersz za wierszem).
+// Prostokąt wychodzący poza obraz jest odrzucany.
+// ============================================================
+bool __stdcall Lz77DecodeRegion(
+    const wchar_t* path,
+    bool           useASM,
+    int            numThreads,
+    uint32_t       x,
+    uint32_t       y,
+    uint32_t       width,
+    uint32_t       height,
+    uint32_t* dst,
+    size_t         dstCount)
+{
+    if (!dst || width == 0 || height == 0 ||
+        dstCount < static_cast<size_t>(width) * height) return false;
+
+    const KernelEntry* kernelEntry = nullptr;
+    std::wstring dllError;
+    if (!AcquireKernel(LOGIC_KERNEL_DEFAULT, useASM, kernelEntry, dllError)) return false;
+    const LZ77Api& api = kernelEntry->api;
+
+    bool ok = false;
+    try {
+        Lz77FileHeader hdr{};
+        Lz77BlockIndex index;
+        MappedFile     file;
+        const uint8_t* data = nullptr;
+        StreamDecoder  decompFn;
+
+        if (path && ReadCompressedFile(path, hdr, index, file, data) &&
+            static_cast<uint64_t>(x) + width <= hdr.width &&
+            static_cast<uint64_t>(y) + height <= hdr.height) {
+            // Bloki pokrywające wycinek.
+            uint32_t imgW = hdr.width, imgH = hdr.height, blockRows = index.blockRows;
+            size_t firstBlock = y / blockRows;
+            size_t lastBlock = (static_cast<size_t>(y) + height - 1) / blockRows;
+
+            if ((decompFn = DecoderForVersion(api, hdr.version, index))) {
+                size_t firstRow = firstBlock * blockRows;
+                size_t lastRow = std::min<size_t>((lastBlock + 1) * blockRows, imgH);
+                PixelBuffer strip;
+                strip.resize((lastRow - firstRow) * imgW);
+
+                ok = DecompressBlocksParallel(decompFn, data, index, imgW, imgH,
+                    firstBlock, lastBlock, strip.data(), ThreadsFor(numThreads));
+
+                for (uint32_t row = 0; ok && row < height; ++row) {
+                    const uint32_t* src = strip.data() + (y + row - firstRow) * imgW + x;
+                    std::copy(src, src + width, dst + static_cast<size_t>(row) * width);
+                }
+            }
+        }
+    }
+    catch (...) {
+        ok = false;
+    }
+    return ok;
+}
+
+// ============================================================
+// Eksporty rejestru kerneli (opis w logic.h).
+// ============================================================
+uint32_t __stdcall Lz77KernelCount()
+{
+    EnsureKernelRegistry();
+    return static_cast<uint32_t>(g_kernels.size());
+}
+
+bool __stdcall Lz77GetKernelInfo(uint32_t index, Lz77KernelInfo* out)
+{
+    EnsureKernelRegistry();
+    if (!out || index >= g_kernels.size()) return false;
+    std::lock_guard<std::mutex> lock(g_kernelMtx);
+    *out = g_kernels[index].info;
+    return true;
+}
 
-    // WAŻNE: FreeLibrary po join() — wątki przestały używać kodu z DLL.
-    FreeLibrary(hMod);
-}
\ No newline at end of file
+uint32_t __stdcall Lz77FindKernel(const char* name)
+{
+    EnsureKernelRegistry();
+    if (!name) return LOGIC_KERNEL_DEFAULT;
+    if (strcmp(name, "fastest") == 0) return LOGIC_KERNEL_FASTEST;
+    for (const KernelEntry& e : g_kernels)
+        if (strcmp(e.info.name, name) == 0) return e.info.id;
+    return LOGIC_KERNEL_DEFAULT;
+}
+
+uint32_t __stdcall Lz77ResolveKernel(uint32_t kernel, bool useASM)
+{
+    const KernelEntry* entry = ResolveKernel(kernel, useASM);
+    return entry ? entry->info.id : LOGIC_KERNEL_DEFAULT;
+}
+
+// ============================================================
+// Kalibracja — Lz77Calibrate.
+//
+// Próbka: początkowe obrazy z folderu (do samplePixels pikseli; ostatni
+// obraz przycinany do pełnych wierszy), podzielone na bloki jak w
+// StartCompression (BlockRowsFor z domyślnym rozmiarem bloku).
+//
+// 1) Każdy kernel z rejestru kompresuje i dekompresuje całą próbkę jednym
+//    wątkiem (format kompaktowy, po przebiegu rozgrzewającym na pierwszym
+//    bloku). Kernel, który nie odtworzy próbki bit w bit, jest pomijany.
+// 2) Najszybszy kernel kompresji mierzony jest przy 1, 2, 4, ... wątkach
+//    (oraz przy maxThreads). Punkt nasycenia to ostatnia liczba wątków,
+//    po której następny krok dał co najmniej LOGIC_CALIBRATION_MIN_GAIN
+//    przyrostu przepustowości — dalej ogranicza przepustowość pamięci
+//    lub liczba rdzeni. Wybrana liczba wątków to najmniejsza, która daje
+//    co najmniej LOGIC_CALIBRATION_KEEP przepustowości maksymalnej.
+// ============================================================
+struct CalibrationBlock {
+    const uint32_t* px;
+    size_t          count;
+};
+
+static const double LOGIC_CALIBRATION_MIN_GAIN = 1.10;
+static const double LOGIC_CALIBRATION_KEEP = 0.95;
+
+static int64_t MicrosSince(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+// Kompresja bloku próbki w formacie domyślnym strukturą wyszukiwania kernela.
+static void CompressCalibrationBlock(const LZ77Api& api, int matchFinder, const CalibrationBlock& b,
+    uint8_t* dst, size_t dstCap, void* work, size_t workCap, size_t* len)
+{
+    if (api.compressEx)
+        api.compressEx(b.px, b.count, 0, dst, dstCap, work, workCap, nullptr, matchFinder, len, nullptr);
+    else
+        api.compressPacked(b.px, b.count, dst, dstCap, work, workCap, len);
+}
+
+// Jednowątkowy przebieg kernela przez całą próbkę z weryfikacją odtworzenia.
+static bool TimeKernelSingle(const LZ77Api& api, int matchFinder,
+    const std::vector<CalibrationBlock>& blocks,
+    size_t maxCount,
+    int64_t& compressUs,
+    int64_t& decompressUs)
+{
+    std::vector<uint8_t>  work(LOGIC_LZ77_WORK_BYTES);
+    std::vector<uint8_t>  dst(LogicPackedBound(maxCount));
+    std::vector<uint32_t> back(maxCount);
+    size_t len = 0;
+    size_t outLen = 0;
+
+    // Rozgrzanie: pamięć podręczna, strony buforów, leniwe wiązanie importów.
+    CompressCalibrationBlock(api, matchFinder, blocks[0], dst.data(), dst.size(),
+        work.data(), work.size(), &len);
+
+    compressUs = 0;
+    decompressUs = 0;
+    for (const CalibrationBlock& b : blocks) {
+        auto t0 = std::chrono::steady_clock::now();
+        CompressCalibrationBlock(api, matchFinder, b, dst.data(), dst.size(), work.data(), work.size(), &len);
+        compressUs += MicrosSince(t0);
+
+        t0 = std::chrono::steady_clock::now();
+        api.decompressPacked(dst.data(), len, back.data(), b.count, &outLen);
+        decompressUs += MicrosSince(t0);
+
+        if (len == 0 || outLen != b.count || !std::equal(b.px, b.px + b.count, back.begin()))
+            return false;
+    }
+    return true;
+}
+
+// Przepustowość kompresji (MB/s, łącznie) przy threads wątkach. Próbka
+// powtarzana jest tak, by każdy wątek dostał co najmniej 4 bloki.
+// Własne wątki zamiast puli — pomiar wymaga dokładnej liczby wątków.
+static double MeasureThreads(const KernelEntry* kernel,
+    const std::vector<CalibrationBlock>& blocks,
+    size_t maxCount,
+    int threads)
+{
+    const LZ77Api& api = kernel->api;
+    const int matchFinder = KernelMatchFinder(kernel);
+    size_t rounds = (static_cast<size_t>(threads) * 4 + blocks.size() - 1) / blocks.size();
+    size_t jobs = rounds * blocks.size();
+    uint64_t bytes = 0;
+    for (const CalibrationBlock& b : blocks)
+        bytes += b.count * sizeof(uint32_t);
+    bytes *= rounds;
+
+    // Bufory alokowane przed pomiarem — mierzony jest sam kernel.
+    std::vector<std::vector<uint8_t>> work(threads, std::vector<uint8_t>(LOGIC_LZ77_WORK_BYTES));
+    std::vector<std::vector<uint8_t>> dst(threads, std::vector<uint8_t>(LogicPackedBound(maxCount)));
+    std::atomic<size_t> next{ 0 };
+
+    auto worker = [&](int t) {
+        KernelSimdScope simd(kernel);
+        while (true) {
+            size_t j = next.fetch_add(1, std::memory_order_relaxed);
+            if (j >= jobs) break;
+            const CalibrationBlock& b = blocks[j % blocks.size()];
+            size_t len = 0;
+            CompressCalibrationBlock(api, matchFinder, b, dst[t].data(), dst[t].size(),
+                work[t].data(), work[t].size(), &len);
+        }
+        };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int t = 0; t < threads; ++t)
+        workers.emplace_back(worker, t);
+    for (auto& t : workers)
+        t.join();
+    int64_t us = std::max<int64_t>(1, MicrosSince(t0));
+    return static_cast<double>(bytes) / static_cast<double>(us);
+}
+
+static void SaveCalibrationProfile(const std::wstring& path,
+    const Lz77CalibrationResult& result,
+    const std::string& bestName)
+{
+    CreateDirectoryW(fs::path(path).parent_path().wstring().c_str(), nullptr);
+
+    const wchar_t* file = path.c_str();
+    WritePrivateProfileStringW(L"machine", L"cpus", std::to_wstring(std::thread::hardware_concurrency()).c_str(), file);
+    WritePrivateProfileStringW(L"machine", L"simd", std::to_wstring(MachineSimdLevel()).c_str(), file);
+    WritePrivateProfileStringW(L"best", L"kernel", std::wstring(bestName.begin(), bestName.end()).c_str(), file);
+    WritePrivateProfileStringW(L"best", L"threads", std::to_wstring(result.threads).c_str(), file);
+    WritePrivateProfileStringW(L"best", L"saturation", std::to_wstring(result.saturationThreads).c_str(), file);
+
+    std::lock_guard<std::mutex> lock(g_kernelMtx);
+    for (const KernelEntry& e : g_kernels) {
+        std::wstringstream value;
+        value << e.info.compressMBps << L"," << e.info.decompressMBps;
+        std::wstring name(e.info.name, e.info.name + strlen(e.info.name));
+        WritePrivateProfileStringW(L"kernels", name.c_str(), value.str().c_str(), file);
+    }
+}
+
+bool __stdcall Lz77Calibrate(
+    const wchar_t* sourceFolder,
+    const Lz77CalibrateOptions* options,
+    LogCallback logCb,
+    Lz77CalibrationResult* out)
+{
+    uint32_t samplePixels = (options && options->samplePixels) ? options->samplePixels : LOGIC_CALIBRATION_SAMPLE_PIXELS;
+    int maxThreads = (options && options->maxThreads) ? static_cast<int>(options->maxThreads)
+        : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    EnsureKernelRegistry();
+    if (g_kernels.empty()) {
+        if (logCb) logCb((L"Blad ladowania DLL: " + g_kernelErrors).c_str());
+        return false;
+    }
+
+    // --- Próbka z folderu wejściowego
+    struct SampleImage {
+        PixelBuffer pixels;
+        uint32_t w = 0;
+        uint32_t h = 0;
+    };
+    std::vector<SampleImage> images;
+    std::vector<CalibrationBlock> blocks;
+    size_t total = 0;
+    size_t maxCount = 0;
+
+    try {
+        for (auto& entry : fs::directory_iterator(sourceFolder)) {
+            if (total >= samplePixels) break;
+            if (!entry.is_regular_file()) continue;
+            std::wstring ext = entry.path().extension().wstring();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
+            if (!IMAGE_EXTENSIONS.count(ext)) continue;
+
+            SampleImage img;
+            if (!LoadImagePixels(entry.path().wstring(), img.pixels, img.w, img.h) || img.w == 0 || img.h == 0)
+                continue;
+            uint32_t rows = static_cast<uint32_t>(std::min<size_t>(img.h,
+                std::max<size_t>(1, (samplePixels - total + img.w - 1) / img.w)));
+            img.h = rows;
+            img.pixels.resize(static_cast<size_t>(img.w) * rows);
+            total += img.pixels.size();
+            images.push_back(std::move(img));
+        }
+    }
+    catch (const std::exception& ex) {
+        std::string msg(ex.what());
+        std::wstring wmsg(msg.begin(), msg.end());
+        if (logCb) logCb((L"Blad enumeracji folderu: " + wmsg).c_str());
+        return false;
+    }
+    if (images.empty()) {
+        if (logCb) logCb(L"Brak plikow obrazkow do kalibracji.");
+        return false;
+    }
+
+    for (const SampleImage& img : images) {
+        uint32_t blockRows = BlockRowsFor(img.w, img.h, 0);
+        for (uint32_t row = 0; row < img.h; row += blockRows) {
+            uint32_t rows = std::min(blockRows, img.h - row);
+            blocks.push_back({ img.pixels.data() + static_cast<size_t>(row) * img.w,
+                static_cast<size_t>(rows) * img.w });
+            maxCount = std::max(maxCount, blocks.back().count);
+        }
+    }
+
+    // --- 1) Każdy kernel jednym wątkiem
+    const KernelEntry* best = nullptr;
+    double bestMBps = 0.0;
+    for (const KernelEntry& e : g_kernels) {
+        const KernelEntry* kernel = nullptr;
+        std::wstring err;
+        int64_t compressUs = 0, decompressUs = 0;
+        if (!AcquireKernel(e.info.id, false, kernel, err)) continue;
+        bool ok = false;
+        try {
+            KernelSimdScope simd(kernel);
+            ok = TimeKernelSingle(kernel->api, KernelMatchFinder(kernel), blocks, maxCount, compressUs, decompressUs);
+        }
+        catch (...) {
+            ok = false;
+        }
+        if (!ok) {
+            if (logCb) logCb((L"Kalibracja: kernel pominiety (blad odtworzenia): " + KernelLabel(e)).c_str());
+            continue;
+        }
+        RecordKernelThroughput(kernel, true, total * sizeof(uint32_t), compressUs);
+        RecordKernelThroughput(kernel, false, total * sizeof(uint32_t), decompressUs);
+
+        Lz77KernelInfo info{};
+        {
+            std::lock_guard<std::mutex> lock(g_kernelMtx);
+            info = e.info;
+        }
+        if (logCb) {
+            std::wstringstream ss;
+            ss << L"Kalibracja: " << KernelLabel(e) << L"  kompresja " << info.compressMBps
+                << L" MB/s  dekompresja " << info.decompressMBps << L" MB/s (1 watek)";
+            logCb(ss.str().c_str());
+        }
+        if (!best || info.compressMBps > bestMBps) {
+            best = &e;
+            bestMBps = info.compressMBps;
+        }
+    }
+    if (!best) {
+        if (logCb) logCb(L"Kalibracja: zaden kernel nie odtworzyl probki.");
+        return false;
+    }
+
+    // --- 2) Skalowanie najszybszego kernela z liczbą wątków
+    const KernelEntry* kernel = nullptr;
+    std::wstring err;
+    AcquireKernel(best->info.id, false, kernel, err);
+
+    std::vector<int> counts;
+    for (int t = 1; t < maxThreads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    std::vector<double> mbps;
+    for (int t : counts) {
+        mbps.push_back(MeasureThreads(kernel, blocks, maxCount, t));
+        if (logCb) {
+            std::wstringstream ss;
+            ss << L"Kalibracja: " << t << L" watkow  " << mbps.back() << L" MB/s";
+            logCb(ss.str().c_str());
+        }
+    }
+
+    size_t saturation = counts.size() - 1;
+    for (size_t i = 1; i < counts.size(); ++i) {
+        if (mbps[i] < mbps[i - 1] * LOGIC_CALIBRATION_MIN_GAIN) {
+            saturation = i - 1;
+            break;
+        }
+    }
+    double peak = *std::max_element(mbps.begin(), mbps.end());
+    size_t chosen = 0;
+    while (mbps[chosen] < peak * LOGIC_CALIBRATION_KEEP)
+        ++chosen;
+
+    Lz77CalibrationResult result{};
+    result.kernel = best->info.id;
+    result.threads = static_cast<uint32_t>(counts[chosen]);
+    result.saturationThreads = static_cast<uint32_t>(counts[saturation]);
+    result.singleThreadMBps = bestMBps;
+    result.compressMBps = mbps[chosen];
+    if (out) *out = result;
+
+    // --- Zapis profilu i użycie go w tym procesie
+    g_profileThreads.store(result.threads);
+    std::wstring path = CalibrationProfilePath();
+    if (!path.empty())
+        SaveCalibrationProfile(path, result, best->info.name);
+
+    if (logCb) {
+        std::wstringstream ss;
+        ss << L"--- Kalibracja zakonczona ---\n"
+            << L"Kernel: " << KernelLabel(*best) << L"  |  "
+            << L"Watkow: " << result.threads << L"  |  "
+            << L"Nasycenie: " << result.saturationThreads << L" watkow  |  "
+            << L"Kompresja: " << result.compressMBps << L" MB/s  |  "
+            << L"Profil: " << (path.empty() ? std::wstring(L"(brak LOCALAPPDATA)") : path);
+        logCb(ss.str().c_str());
+    }
+    return true;
+}
+
+// ============================================================
+// Eksporty puli wątków (opis przy WorkerPool).
+// ============================================================
+bool __stdcall Lz77PoolStart(int numThreads)
+{
+    return Pool().Start(ThreadsFor(numThreads));
+}
+
+int __stdcall Lz77PoolSize()
+{
+    return Pool().Size();
+}
+
+void __stdcall Lz77PoolShutdown()
+{
+    Pool().Shutdown();
+}
+
+// ============================================================
+// Eksporty areny buforów (opis przy BufferArena).
+// ============================================================
+bool __stdcall Lz77ArenaConfigure(uint64_t maxCachedBytes, bool largePages)
+{
+    return Arena().Configure(maxCachedBytes, largePages);
+}
+
+uint64_t __stdcall Lz77ArenaCachedBytes()
+{
+    return Arena().CachedBytes();
+}
+
+void __stdcall Lz77ArenaTrim()
+{
+    Arena().TrimTo(0);
+}
+
+// ============================================================
+// Lz77RegisterImageDecoder — dopisanie dekodera do rejestru (opis przy
+// g_imageDecoders). Wpis zapisywany jest przed publikacją liczby wpisów.
+// ============================================================
+bool __stdcall Lz77RegisterImageDecoder(Lz77ImageProbeFunc probe, Lz77ImageDecodeFunc decode)
+{
+    if (!probe || !decode) return false;
+
+    std::lock_guard<std::mutex> lock(g_imageDecoderMtx);
+    uint32_t count = g_imageDecoderCount.load(std::memory_order_relaxed);
+    if (count >= LOGIC_MAX_IMAGE_DECODERS) return false;
+    g_imageDecoders[count] = { probe, decode };
+    g_imageDecoderCount.store(count + 1, std::memory_order_release);
+    return true;
+}
@@ -20,6 +20,9 @@
 // WAŻNE: automatyczne linkowanie biblioteki GDI+ (Windows Imaging).
 // GDI+ jest używane do odczytu/zapisu obrazów w wielu formatach (PNG, JPG, BMP...).
 #pragma comment(lib, "gdiplus.lib")
+// Strumienie w pamięci (CreateStreamOnHGlobal) — obrazy kodowane/dekodowane
+// przez GDI+ bez pliku w trybie LOGIC_IO_ASYNC.
+#pragma comment(lib, "ole32.lib")
 
 #include <string>
 #include <sstream>
@@ -27,6 +30,8 @@
 #include <deque>    // kolejka zadań dla workerów (FIFO)
 #include <set>      // zbiór dozwolonych rozszerzeń plików
 #include <mutex>    // synchronizacja dostępu do zasobów współdzielonych
+#include <condition_variable>  // oczekiwanie etapów potoku na dane
+#include <memory>   // std::unique_ptr — zadania potoku
 #include <thread>   // wielowątkowość
 #include <atomic>   // bezpieczne operacje na licznikach z wielu wątków
 #include <chrono>   // precyzyjny pomiar czasu (steady_clock)
@@ -71,6 +76,265 @@ using LZ77DecompressFunc = void(*)(const uint8_t*, size_t,
     uint32_t*, size_t,
     size_t*);
 
+// ============================================================
+// LogicKernelStats — liczniki jednego wywołania kompresora (układ zgodny
+// z lz77_stats z lz77.h; powielony, by Logic.dll nie zależała od nagłówka DLL):
+//   literalPx   — piksele zapisane jako literały
+//   literalRuns — liczba serii literałów (tokenów literałowych)
+//   matches     — liczba dopasowań
+//   matchPx     — piksele pokryte dopasowaniami
+//   chainWalks  — liczba odwiedzonych kandydatów łańcucha hash
+// ============================================================
+struct LogicKernelStats {
+    uint64_t literalPx;
+    uint64_t literalRuns;
+    uint64_t matches;
+    uint64_t matchPx;
+    uint64_t chainWalks;
+};
+
+// LZ77CompressStatsFunc — jak LZ77CompressFunc, dodatkowo wypełnia liczniki.
+using LZ77CompressStatsFunc = void(*)(const uint32_t*, size_t,
+    uint8_t*, size_t,
+    void*, size_t,
+    size_t*, LogicKernelStats*);
+
+// ============================================================
+// LogicLevelParams — parametry poziomu kompresji (układ zgodny z lz77_params
+// z lz77.h; ten sam układ ma rekord parametrów w nagłówku pliku .lz77):
+//   windowPx   — rozmiar okna w pikselach (potęga 2, 256..65536)
+//   maxMatchPx — maks. długość dopasowania (potęga 2, 2..65536)
+//   maxChain   — maks. liczba kandydatów łańcucha hash (tylko koder)
+//   level      — numer presetu (1..5) lub 0 dla parametrów własnych
+//   parse      — sposób wyboru dopasowań, LOGIC_PARSE_* (tylko koder)
+// ============================================================
+struct LogicLevelParams {
+    uint32_t windowPx;
+    uint32_t maxMatchPx;
+    uint32_t maxChain;
+    uint32_t level;
+    uint32_t parse;
+};
+
+// Sposoby wyboru dopasowań — wartości zgodne z LZ77_PARSE_* w lz77.h.
+static const uint32_t LOGIC_PARSE_GREEDY = 0;
+static const uint32_t LOGIC_PARSE_LAZY = 1;
+static const uint32_t LOGIC_PARSE_LAZY2 = 2;
+static const uint32_t LOGIC_PARSE_OPTIMAL = 3;
+
+// Parametry formatu LOGIC_FORMAT_PACKED — strumień poziomu z takim oknem
+// i długością dopasowań jest identyczny ze strumieniem formatu kompaktowego.
+static const uint32_t LOGIC_PACKED_WINDOW_PX = 4096;
+static const uint32_t LOGIC_PACKED_MAX_MATCH_PX = 64;
+
+// Kompresja / dekompresja z parametrami poziomu oraz pobranie presetu poziomu
+// (lz77_rgba_compress_level, lz77_rgba_decompress_level, lz77_level_params).
+using LZ77CompressLevelFunc = void(*)(const uint32_t*, size_t,
+    uint8_t*, size_t,
+    void*, size_t,
+    const LogicLevelParams*, size_t*, LogicKernelStats*);
+using LZ77DecompressLevelFunc = void(*)(const uint8_t*, size_t,
+    uint32_t*, size_t,
+    const LogicLevelParams*, size_t*);
+using LZ77LevelParamsFunc = int(*)(int, LogicLevelParams*);
+
+// Poziom SIMD kerneli CppDll.dll (lz77_cpu_simd_level, lz77_set_thread_simd_level).
+using LZ77CpuSimdLevelFunc = int(*)();
+using LZ77SetSimdLevelFunc = int(*)(int);
+
+// Kompresja ze strukturą wyszukiwania dopasowań wybraną dla wywołania
+// (lz77_rgba_compress_ex, lz77_stream_begin_ex): argumenty jak
+// LZ77CompressImageFunc / LZ77StreamBeginImageFunc i LOGIC_MATCH_FINDER_*.
+// Szerokość 0 i parametry nullptr = format LOGIC_FORMAT_PACKED.
+using LZ77CompressExFunc = void(*)(const uint32_t*, size_t, size_t,
+    uint8_t*, size_t,
+    void*, size_t,
+    const LogicLevelParams*, int, size_t*, LogicKernelStats*);
+using LZ77StreamBeginExFunc = int(*)(void*, size_t, const uint32_t*, size_t, size_t, const LogicLevelParams*, int);
+
+// Struktury wyszukiwania dopasowań — wartości zgodne z LZ77_MATCH_FINDER_* w lz77.h.
+static const int LOGIC_MATCH_FINDER_CHAIN = 0;
+static const int LOGIC_MATCH_FINDER_BUCKET = 1;
+
+// Granica rozmiaru wyjścia i kompresja strumieniowa (lz77_compress_bound,
+// lz77_stream_work_bytes, lz77_stream_begin, lz77_stream_compress).
+// Parametry poziomu nullptr = format LOGIC_FORMAT_PACKED.
+using LZ77CompressBoundFunc = size_t(*)(uint16_t, size_t);
+using LZ77StreamWorkBytesFunc = size_t(*)(const LogicLevelParams*);
+using LZ77StreamBeginFunc = int(*)(void*, size_t, const uint32_t*, size_t, const LogicLevelParams*);
+using LZ77StreamCompressFunc = int(*)(void*, uint8_t*, size_t, size_t*, LogicKernelStats*);
+
+// Faktyczny bufor roboczy kompresji bloku o podanej liczbie pikseli (lz77_work_bytes);
+// tablica hash kodera rośnie z wejściem, więc małe obrazy potrzebują kilku KB.
+using LZ77WorkBytesFunc = size_t(*)(size_t, const LogicLevelParams*);
+
+// Kompresja obrazu o znanej szerokości (lz77_rgba_compress_image,
+// lz77_stream_begin_image): koder sprawdza też piksele z poprzednich wierszy
+// (offset w, w ± 1, 2w w granicach okna). Format strumienia bez zmian —
+// dekompresja jak dla compressLevel / compressPacked.
+using LZ77CompressImageFunc = void(*)(const uint32_t*, size_t, size_t,
+    uint8_t*, size_t,
+    void*, size_t,
+    const LogicLevelParams*, size_t*, LogicKernelStats*);
+using LZ77StreamBeginImageFunc = int(*)(void*, size_t, const uint32_t*, size_t, size_t, const LogicLevelParams*);
+
+// Filtry wierszy przed kompresją i dekompresja z ich odwróceniem
+// (lz77_filter_rows, lz77_rgba_decompress_image). Kody filtrów i transformacji
+// zgodne z LZ77_FILTER_* / LZ77_TRANSFORM_* w lz77.h; bufor reszt nullptr —
+// odtwarzanie w miejscu po dekodowaniu.
+using LZ77FilterRowsFunc = int(*)(const uint32_t*, uint32_t*, size_t, size_t, uint32_t, uint32_t, uint8_t*);
+using LZ77DecompressImageFunc = void(*)(const uint8_t*, size_t,
+    uint32_t*, size_t, uint32_t*,
+    const LogicLevelParams*, size_t, uint32_t, const uint8_t*, size_t*);
+
+// Kodowanie entropijne strumienia tokenów formatu kompaktowego (kody Huffmana,
+// lz77_entropy_bound, lz77_entropy_encode) i dekompresja bloku po nim
+// (lz77_rgba_decompress_entropy — sygnatura jak LZ77DecompressImageFunc;
+// bez filtrów: transformacja LOGIC_TRANSFORM_NONE i rowFilters nullptr).
+using LZ77EntropyBoundFunc = size_t(*)(size_t);
+using LZ77EntropyEncodeFunc = void(*)(const uint8_t*, size_t, const LogicLevelParams*, uint8_t*, size_t, size_t*);
+using LZ77DecompressEntropyFunc = LZ77DecompressImageFunc;
+
+static const uint32_t LOGIC_FILTER_NONE = 0;
+static const uint32_t LOGIC_FILTER_SUB = 1;
+static const uint32_t LOGIC_FILTER_UP = 2;
+static const uint32_t LOGIC_FILTER_AVERAGE = 3;
+static const uint32_t LOGIC_FILTER_PAETH = 4;
+static const uint32_t LOGIC_FILTER_COUNT = 5;
+static const uint32_t LOGIC_FILTER_ADAPTIVE = 0xFF;
+
+static const uint32_t LOGIC_TRANSFORM_NONE = 0;
+static const uint32_t LOGIC_TRANSFORM_YCOCG_R = 1;
+
+// Wyniki lz77_stream_compress — wartości zgodne z LZ77_STREAM_* w lz77.h.
+static const int LOGIC_STREAM_DONE = 0;
+static const int LOGIC_STREAM_NEED_OUTPUT = 1;
+static const int LOGIC_STREAM_ERROR = -1;
+
+// Największy fragment wyjścia kompresji strumieniowej w partii; mniejsze bloki
+// dostają jeden fragment o rozmiarze LogicPackedBound.
+static const size_t LOGIC_STREAM_CHUNK_BYTES = 256u << 10;
+
+// ============================================================
+// LZ77Api — komplet funkcji pobranych z jednej DLL (CppDll.dll lub AsmDll.dll).
+//
+// Każda DLL eksportuje dwie pary funkcji o identycznych sygnaturach:
+//   compress / decompress             — format Token12 (LZ77_FORMAT_TOKEN12),
+//   compressPacked / decompressPacked — format kompaktowy (LZ77_FORMAT_PACKED).
+// Nowe pliki zapisywane są w formacie kompaktowym; Token12 pozostaje
+// do odczytu plików utworzonych przez wcześniejsze wersje programu.
+//
+// compressPackedStats jest opcjonalne (eksportuje je tylko CppDll.dll);
+// gdy brak, liczniki tokenów wyznaczane są z gotowego strumienia.
+// Funkcje poziomów (compressLevel, decompressLevel, levelParams), wyboru
+// poziomu SIMD wątku (cpuSimdLevel, setThreadSimdLevel), kompresji z wyborem struktury
+// wyszukiwania dopasowań (compressEx, streamBeginEx), rozmiaru bufora roboczego bloku
+// (workBytes) i kompresji strumieniowej (compressBound, stream*), kompresji obrazu z kandydatami z poprzednich
+// wierszy (compressImage, streamBeginImage), filtrów wierszy (filterRows,
+// decompressImage) i kodowania entropijnego (entropyBound, entropyEncode,
+// decompressEntropy) również eksportuje tylko CppDll.dll — AsmDll.dll obsługuje
+// wyłącznie poziom domyślny, pliki bez filtrów i kodowania entropijnego oraz
+// bufor wyjściowy na najgorszy przypadek.
+// ============================================================
+struct LZ77Api {
+    LZ77CompressFunc   compress = nullptr;
+    LZ77DecompressFunc decompress = nullptr;
+    LZ77CompressFunc   compressPacked = nullptr;
+    LZ77DecompressFunc decompressPacked = nullptr;
+    LZ77CompressStatsFunc compressPackedStats = nullptr;
+    LZ77CompressLevelFunc   compressLevel = nullptr;
+    LZ77DecompressLevelFunc decompressLevel = nullptr;
+    LZ77LevelParamsFunc     levelParams = nullptr;
+    LZ77CpuSimdLevelFunc    cpuSimdLevel = nullptr;
+    LZ77SetSimdLevelFunc    setThreadSimdLevel = nullptr;
+    LZ77CompressBoundFunc   compressBound = nullptr;
+    LZ77WorkBytesFunc       workBytes = nullptr;
+    LZ77StreamWorkBytesFunc streamWorkBytes = nullptr;
+    LZ77StreamBeginFunc     streamBegin = nullptr;
+    LZ77StreamCompressFunc  streamCompress = nullptr;
+    LZ77CompressImageFunc   compressImage = nullptr;
+    LZ77StreamBeginImageFunc streamBeginImage = nullptr;
+    LZ77FilterRowsFunc      filterRows = nullptr;
+    LZ77DecompressImageFunc decompressImage = nullptr;
+    LZ77EntropyBoundFunc    entropyBound = nullptr;
+    LZ77EntropyEncodeFunc   entropyEncode = nullptr;
+    LZ77DecompressEntropyFunc decompressEntropy = nullptr;
+    LZ77CompressExFunc      compressEx = nullptr;
+    LZ77StreamBeginExFunc   streamBeginEx = nullptr;
+};
+
+// ============================================================
+// Rejestr kerneli LZ77 — implementacje kompresji/dekompresji dostępne
+// w procesie (Lz77KernelCount, Lz77GetKernelInfo, Lz77FindKernel).
+//
+// Rejestr budowany jest raz, przy pierwszym użyciu: CppDll.dll i AsmDll.dll
+// są ładowane jednokrotnie i pozostają w pamięci do końca procesu, więc
+// kolejne partie plików nie płacą za LoadLibrary/GetProcAddress.
+// DLL, której brak, nie jest błędem — jej kernele po prostu nie występują.
+//
+// Identyfikatory kerneli są stałe między wersjami (nowe dopisywane na końcu):
+//   LOGIC_KERNEL_CPP         — "cpp": CppDll.dll, poziom SIMD wybrany przez CPUID
+//   LOGIC_KERNEL_ASM         — "asm": AsmDll.dll
+//   LOGIC_KERNEL_CPP_SCALAR..LOGIC_KERNEL_CPP_AVX512 — "cpp-scalar", "cpp-sse2",
+//                              "cpp-avx2", "cpp-avx512": CppDll.dll z wymuszonym
+//                              poziomem SIMD; tylko poziomy obsługiwane przez CPU
+//   LOGIC_KERNEL_CPP_BUCKET  — "cpp-bucket": CppDll.dll z wyszukiwaniem dopasowań
+//                              w kubełkach (lz77_rgba_compress_ex) zamiast łańcuchów
+//                              hash; ten sam format, zwykle szybszy, słabszy stopień
+//                              kompresji na głębokich poziomach
+// Wartości specjalne pola kernel w opcjach StartCompressionEx/StartDecompressionEx:
+//   LOGIC_KERNEL_DEFAULT     — wybór według flagi useASM (jak dotychczas)
+//   LOGIC_KERNEL_FASTEST     — kernel o najwyższej zmierzonej przepustowości
+//                              kompresji; przed pierwszym pomiarem "cpp"
+//
+// Przepustowość mierzona jest przy każdej partii formatu domyślnego — bez
+// poziomu, filtrów wierszy i kodowania entropijnego (MB/s danych pikseli na
+// jeden wątek, suma czasów samych wywołań kernela) i zapamiętywana w rejestrze.
+//
+// UWAGA: poziom SIMD jest ustawieniem globalnym CppDll.dll. Równoległe partie
+// z różnymi wariantami "cpp-*" mogą nawzajem zmieniać poziom — wynik
+// kompresji jest identyczny na każdym poziomie, zmienia się tylko szybkość.
+// Struktura wyszukiwania dopasowań przekazywana jest w każdym wywołaniu
+// kompresji partii, więc równoległe partie jej sobie nie zmieniają.
+// ============================================================
+static const uint32_t LOGIC_KERNEL_DEFAULT = 0;
+static const uint32_t LOGIC_KERNEL_CPP = 1;
+static const uint32_t LOGIC_KERNEL_ASM = 2;
+static const uint32_t LOGIC_KERNEL_CPP_SCALAR = 3;
+static const uint32_t LOGIC_KERNEL_CPP_SSE2 = 4;
+static const uint32_t LOGIC_KERNEL_CPP_AVX2 = 5;
+static const uint32_t LOGIC_KERNEL_CPP_AVX512 = 6;
+static const uint32_t LOGIC_KERNEL_CPP_BUCKET = 7;
+static const uint32_t LOGIC_KERNEL_FASTEST = 0xFFFFFFFFu;
+
+// Zdolności kernela (Lz77KernelInfo.caps).
+static const uint32_t LOGIC_KERNEL_CAP_TOKEN12 = 0x01;  // format Token12 (odczyt starych plików)
+static const uint32_t LOGIC_KERNEL_CAP_PACKED = 0x02;   // format kompaktowy
+static const uint32_t LOGIC_KERNEL_CAP_LEVELS = 0x04;   // poziomy kompresji i LOGIC_FORMAT_PACKED_EX
+static const uint32_t LOGIC_KERNEL_CAP_STATS = 0x08;    // liczniki tokenów z kernela (z chainWalks)
+static const uint32_t LOGIC_KERNEL_CAP_SIMD = 0x10;     // wymuszony poziom SIMD (simdLevel)
+static const uint32_t LOGIC_KERNEL_CAP_BUCKET = 0x20;   // wyszukiwanie dopasowań w kubełkach
+
+// ============================================================
+// Lz77KernelInfo — opis kernela z rejestru (układ sekwencyjny — P/Invoke).
+//   id             — LOGIC_KERNEL_*
+//   caps           — bity LOGIC_KERNEL_CAP_*
+//   simdLevel      — wymuszony poziom SIMD (LZ77_SIMD_*); -1 = wybór CPUID
+//                    lub kernel bez poziomów SIMD (ASM)
+//   name / module  — nazwa kernela i DLL (ASCII, zakończone zerem)
+//   compressMBps / decompressMBps — ostatnia zmierzona przepustowość
+//                    na wątek; 0 = jeszcze nie zmierzono
+// ============================================================
+struct Lz77KernelInfo {
+    uint32_t id;
+    uint32_t caps;
+    int32_t  simdLevel;
+    char     name[32];
+    char     module[32];
+    double   compressMBps;
+    double   decompressMBps;
+};
+
 // ============================================================
 // WAŻNE: Minimalny rozmiar bufora roboczego wymaganego przez
 // lz77_rgba_compress.
@@ -87,38 +351,387 @@ using LZ77DecompressFunc = void(*)(const uint8_t*, size_t,
 // Suma: (65536 + 4096) * 4 bajty = 272 KB.
 //
 // Wartość powielona tutaj celowo, aby Logic.dll NIE zależała od nagłówka DLL.
+// To bufor na dowolne wejście (i wymaganie AsmDll.dll); CppDll.dll podaje
+// faktyczne wymaganie bloku przez LZ77Api::workBytes.
 // ============================================================
 static const size_t LOGIC_LZ77_WORK_BYTES = (65536u + 4096u) * sizeof(uint32_t);
 
+// Bufor roboczy dla parametrów poziomu: head[65536] + prev[windowPx], a dla
+// LOGIC_PARSE_OPTIMAL dodatkowo tablice segmentu 16384 pikseli
+// (powielone z lz77_params_work_bytes z tego samego powodu).
+static inline size_t LogicLevelWorkBytes(const LogicLevelParams& params)
+{
+    const size_t segment = 16384;
+    size_t bytes = (65536u + static_cast<size_t>(params.windowPx)) * sizeof(uint32_t);
+    if (params.parse == LOGIC_PARSE_OPTIMAL)
+        bytes += segment * sizeof(uint64_t) + (segment + 1) * 2 * sizeof(uint32_t) +
+            segment * 3 * sizeof(uint32_t) + (segment + 1) * (sizeof(uint16_t) + sizeof(uint8_t));
+    return bytes;
+}
+
+// ============================================================
+// Wersje formatu strumienia tokenów — wartości zgodne z LZ77_FORMAT_* w lz77.h
+// (powielone z tego samego powodu co LOGIC_LZ77_WORK_BYTES).
+// ============================================================
+static const uint16_t LOGIC_FORMAT_TOKEN12 = 1;
+static const uint16_t LOGIC_FORMAT_PACKED = 2;
+static const uint16_t LOGIC_FORMAT_PACKED_EX = 3;   // kompaktowy z parametrami poziomu (LZ77_FLAG_PARAMS)
+
+// ============================================================
+// Pesymistyczny rozmiar wyjścia formatu kompaktowego dla pixelCount pikseli.
+//
+// Najgorszy przypadek to same literały: 4 bajty na piksel, 1 bajt licznika
+// na każdą serię 256 pikseli i 1 bajt flag na każde 8 tokenów.
+// Tokeny dopasowań zawsze zajmują mniej niż piksele, które opisują.
+// Równy lz77_compress_bound(LZ77_FORMAT_PACKED) + 64 B zapasu — używany dla
+// kerneli bez kompresji strumieniowej (AsmDll.dll).
+// ============================================================
+static inline size_t LogicPackedBound(size_t pixelCount)
+{
+    size_t runs = (pixelCount + 255u) / 256u;
+    return pixelCount * 4u + runs + (runs + 7u) / 8u + 64u;
+}
+
 // ============================================================
 // WAŻNE: Nagłówek własnego formatu binarnego pliku .lz77.
 //
 // Każdy skompresowany plik ma następującą strukturę:
-//   [uint32  magic]           — identyfikator formatu; wartość 0x4C5A3737 = "LZ77"
-//                               w ASCII; służy do weryfikacji integralności pliku
+//   [uint32  magic]           — identyfikator formatu:
+//                               0x4C5A3737 = "LZ77" — nagłówek podstawowy (20 bajtów),
+//                                            dane w formacie Token12 (pliki wersji 1.1),
+//                               0x4C5A3758 = "LZ7X" — nagłówek rozszerzony (pola poniżej)
 //   [uint32  width]           — szerokość oryginalnego obrazu w pikselach
 //   [uint32  height]          — wysokość oryginalnego obrazu w pikselach
 //   [uint64  compressedBytes] — liczba bajtów danych tokenów LZ77 po nagłówku
-//   [compressedBytes bajtów]  — dane tokenów LZ77 (ciągłe)
+//   --- tylko nagłówek rozszerzony ---
+//   [uint16  version]         — format strumienia tokenów (LOGIC_FORMAT_*)
+//   [uint16  flags]           — bity LZ77_FLAG_* (opcje kontenera)
+//   [uint32  headerBytes]     — pełny rozmiar nagłówka razem z tabelą bloków; dane
+//                               tokenów zaczynają się od tego offsetu, co pozwala
+//                               dopisywać kolejne pola
+//   [uint32  blockRows]       — liczba wierszy obrazu w jednym bloku (LZ77_FLAG_BLOCKS)
+//   [uint32  blockCount]      — liczba bloków = ceil(height / blockRows)
+//   [uint64  blockBytes[blockCount]] — tabela bloków: rozmiar strumienia każdego bloku
+//   [LogicLevelParams params] — tylko z LZ77_FLAG_PARAMS (20 bajtów): okno, maks.
+//                               długość dopasowania, głębokość łańcucha, poziom
+//                               i sposób wyboru dopasowań;
+//                               wymagane dla wersji LOGIC_FORMAT_PACKED_EX
+//   [uint8   transform]       — tylko z LZ77_FLAG_FILTERS: transformacja kolorów
+//                               (LOGIC_TRANSFORM_*) zastosowana przed kompresją
+//   [uint8   rowFilters[height]] — filtr każdego wiersza (LOGIC_FILTER_*); bloki
+//                               filtrowane są osobno (pierwszy wiersz bloku bez
+//                               wiersza powyżej), więc pozostają niezależne
+//   [compressedBytes bajtów]  — strumienie bloków zapisane jeden za drugim;
+//                               z LZ77_FLAG_ENTROPY każdy blok zakodowany
+//                               entropijnie (lz77_entropy_encode)
+//
+// Każdy blok to niezależny strumień tokenów (okno LZ77 zaczyna się od zera),
+// więc bloki mogą być kompresowane i dekompresowane równolegle.
+// Nagłówek rozszerzony zapisany przez wersję bez bloków kończy się na headerBytes
+// (28 bajtów) — brakujące pola przyjmują wartości "jeden blok na cały obraz".
 //
 // UWAGA: #pragma pack(push, 1) wyłącza wyrównanie (padding) pól struktury,
-// gwarantując, że sizeof(Lz77FileHeader) == 4+4+4+8 = 20 bajtów,
+// gwarantując, że sizeof(Lz77FileHeader) == 4+4+4+8+2+2+4+4+4 = 36 bajtów,
 // niezależnie od platformy i ustawień kompilatora. Jest to konieczne,
-// bo nagłówek jest zapisywany i odczytywany jako surowy blok bajtów (ReadFile/WriteFile).
+// bo nagłówek jest kopiowany do i z widoku pliku .lz77 jako surowy blok bajtów.
+//
+// Przenośna kopia tych definicji (lz77img, Linux) znajduje się w
+// CppLib/lz77_container.h — przy zmianie formatu trzeba zmienić oba pliki.
 // ============================================================
 #pragma pack(push, 1)
 struct Lz77FileHeader {
-    uint32_t magic;             // 0x4C5A3737 — "LZ77" w ASCII; znacznik początku pliku
+    uint32_t magic;             // LZ77_FILE_MAGIC lub LZ77_FILE_MAGIC_EXT; znacznik początku pliku
     uint32_t width;             // szerokość obrazu w pikselach
     uint32_t height;            // wysokość obrazu w pikselach
     uint64_t compressedBytes;   // rozmiar danych tokenów LZ77 następujących po nagłówku
+    uint16_t version;           // format tokenów (LOGIC_FORMAT_*); dla LZ77_FILE_MAGIC zawsze Token12
+    uint16_t flags;             // bity LZ77_FLAG_*
+    uint32_t headerBytes;       // rozmiar nagłówka w bajtach (offset danych tokenów)
+    uint32_t blockRows;         // wierszy obrazu na blok (tylko z LZ77_FLAG_BLOCKS)
+    uint32_t blockCount;        // liczba wpisów tabeli bloków (tylko z LZ77_FLAG_BLOCKS)
 };
 #pragma pack(pop)
 
+// Flagi nagłówka rozszerzonego. Plik z nieznaną flagą jest odrzucany przy odczycie.
+static const uint16_t LZ77_FLAG_BLOCKS = 0x0001;   // dane podzielone na bloki z tabelą bloków
+static const uint16_t LZ77_FLAG_PARAMS = 0x0002;   // po tabeli bloków rekord LogicLevelParams (wymaga LZ77_FLAG_BLOCKS)
+static const uint16_t LZ77_FLAG_FILTERS = 0x0004;  // dalej rekord filtrów wierszy (wymaga LZ77_FLAG_BLOCKS)
+static const uint16_t LZ77_FLAG_ENTROPY = 0x0008;  // bloki zakodowane entropijnie (wymaga LZ77_FLAG_BLOCKS, nie Token12)
+static const uint16_t LZ77_KNOWN_FLAGS = LZ77_FLAG_BLOCKS | LZ77_FLAG_PARAMS | LZ77_FLAG_FILTERS | LZ77_FLAG_ENTROPY;
+
 // Stała magiczna — "LZ77" zakodowane jako 4 bajty little-endian.
-// Używana zarówno przy zapisie (WriteCompressedFile) jak i walidacji odczytu (ReadCompressedFile).
+// Używana przy walidacji odczytu plików z nagłówkiem podstawowym (ReadCompressedFile).
 static const uint32_t LZ77_FILE_MAGIC = 0x4C5A3737u;
 
+// Stała magiczna nagłówka rozszerzonego — "LZ7X"; zapisywana przez WriteCompressedFile.
+static const uint32_t LZ77_FILE_MAGIC_EXT = 0x4C5A3758u;
+
+// Rozmiar nagłówka podstawowego (pola magic .. compressedBytes) oraz minimalny
+// rozmiar nagłówka rozszerzonego (do pola headerBytes włącznie).
+static const size_t LZ77_BASE_HEADER_BYTES = 20;
+static const size_t LZ77_EXT_MIN_HEADER_BYTES = 28;
+
+// ============================================================
+// Lz77BlockIndex — indeks bloków odczytanego pliku .lz77 (budowany przez
+// ReadCompressedFile z tabeli bloków).
+//   blockRows — wierszy obrazu na blok (ostatni blok może być krótszy)
+//   offsets   — blockCount + 1 pozycji: blok b zajmuje bajty
+//               [offsets[b], offsets[b + 1]) danych tokenów
+// Plik bez tabeli bloków jest opisany jako jeden blok na cały obraz.
+//   params    — parametry poziomu z nagłówka (LZ77_FLAG_PARAMS); same zera,
+//               gdy plik ich nie zawiera
+//   filters   — rekord LZ77_FLAG_FILTERS; pusty rows, gdy plik go nie zawiera
+//   entropy   — LZ77_FLAG_ENTROPY: bloki dekodowane przez decompressEntropy
+// ============================================================
+struct Lz77RowFilters {
+    uint32_t             transform = 0;
+    std::vector<uint8_t> rows;
+};
+
+struct Lz77BlockIndex {
+    uint32_t              blockRows = 0;
+    std::vector<uint64_t> offsets;
+    LogicLevelParams      params{};
+    Lz77RowFilters        filters;
+    bool                  entropy = false;
+};
+
+// ============================================================
+// Tryb blokowy kompresji.
+//
+// Obraz dzielony jest na poziome pasy po blockRows wierszy, tak aby blok miał
+// około LOGIC_DEFAULT_BLOCK_PIXELS pikseli (co najmniej jeden wiersz).
+// Bloki — a nie całe pliki — są jednostką pracy wątków, dzięki czemu jeden
+// bardzo duży obraz wykorzystuje wszystkie numThreads wątków.
+// Koszt podziału to utrata historii okna (4096 px) na początku każdego bloku.
+// ============================================================
+static const uint32_t LOGIC_DEFAULT_BLOCK_PIXELS = 1u << 20;
+
+// ============================================================
+// Potok kompresji — domyślna liczba obrazów w obiegu (wczytanych, a jeszcze
+// niezapisanych) na każdy wątek roboczy. Ogranicza szczytowe zużycie pamięci
+// niezależnie od liczby plików w folderze.
+// ============================================================
+static const uint32_t LOGIC_DEFAULT_IN_FLIGHT_PER_THREAD = 2;
+
+// ============================================================
+// Lz77FileStats — statystyki jednego skompresowanego pliku, przekazywane
+// do StatsCallback (układ sekwencyjny, wyrównanie domyślne — P/Invoke).
+//   fileName       — nazwa pliku źródłowego (ważna tylko w trakcie callbacku)
+//   ok             — 1 = plik zapisany, 0 = błąd (pozostałe pola częściowe)
+//   loadUs         — wczytanie i dekodowanie obrazu (GDI+), w µs
+//   compressUs     — suma czasów kompresji bloków (czas CPU wszystkich wątków)
+//   writeUs        — zapis pliku .lz77, w µs
+//   inputBytes     — rozmiar pikseli (width * height * 4)
+//   outputBytes    — rozmiar pliku .lz77 (nagłówek, tablica bloków, rekordy
+//                    parametrów i filtrów wierszy oraz dane bloków)
+//   literalPixels / literalRuns / matches / matchPixels — liczniki tokenów
+//   chainWalks     — odwiedzeni kandydaci łańcucha hash;
+//                    LOGIC_STATS_UNAVAILABLE, gdy kernel ich nie raportuje (ASM)
+//   avgMatchLength — matchPixels / matches (0, gdy brak dopasowań)
+// ============================================================
+static const uint64_t LOGIC_STATS_UNAVAILABLE = UINT64_MAX;
+
+struct Lz77FileStats {
+    const wchar_t* fileName;
+    uint32_t width;
+    uint32_t height;
+    int32_t  ok;
+    int64_t  loadUs;
+    int64_t  compressUs;
+    int64_t  writeUs;
+    uint64_t inputBytes;
+    uint64_t outputBytes;
+    uint64_t literalPixels;
+    uint64_t literalRuns;
+    uint64_t matches;
+    uint64_t matchPixels;
+    uint64_t chainWalks;
+    double   avgMatchLength;
+};
+
+// StatsCallback — wywoływany z wątku zapisu po zakończeniu każdego pliku.
+using StatsCallback = void(__stdcall*)(const Lz77FileStats* stats);
+
+// ============================================================
+// Lz77BatchStats — obciążenie wątków partii (wypełniane po zakończeniu
+// StartCompressionEx / StartDecompressionEx).
+//   threads    — liczba wątków roboczych partii
+//   maxBusyUs  — czas pracy najdłużej pracującego wątku [us]
+//   meanBusyUs — średni czas pracy wątku [us]
+//   imbalance  — 1 - meanBusyUs / maxBusyUs; 0 = równe obciążenie,
+//                blisko 1 = jeden wątek pracował, pozostałe czekały
+// Czas pracy obejmuje wczytanie/odczyt plików i (de)kompresję bloków,
+// bez czekania na kolejkę.
+// ============================================================
+struct Lz77BatchStats {
+    uint32_t threads;
+    int64_t  maxBusyUs;
+    int64_t  meanBusyUs;
+    double   imbalance;
+};
+
+// ============================================================
+// Tryb wejścia/wyjścia plików partii (pole ioMode opcji Start*Ex).
+//   LOGIC_IO_SYNC  — zapis plików wynikowych na wątku wywołującym, plik po
+//                    pliku; obrazy wejściowe czytane przez GDI+ na wątkach
+//                    roboczych (tryb domyślny, jak StartCompression)
+//   LOGIC_IO_ASYNC — port IOCP z LOGIC_IO_THREADS wątkami I/O i operacjami
+//                    nakładanymi (FILE_FLAG_OVERLAPPED): do ioQueueDepth plików
+//                    jednocześnie w trakcie odczytu lub zapisu (0 =
+//                    LOGIC_IO_DEFAULT_QUEUE_DEPTH). Wątek wywołujący tylko
+//                    koduje nagłówek (.lz77) lub obraz (.bmp) w pamięci
+//                    i zgłasza zapis; kompresja dodatkowo czyta z wyprzedzeniem
+//                    ioQueueDepth kolejnych plików wejściowych, a wątki robocze
+//                    dekodują obraz z pamięci.
+// Pliki .lz77 dekompresji są w obu trybach odwzorowywane w pamięci.
+// ============================================================
+static const uint32_t LOGIC_IO_SYNC = 0;
+static const uint32_t LOGIC_IO_ASYNC = 1;
+static const uint32_t LOGIC_IO_DEFAULT_QUEUE_DEPTH = 32;
+static const uint32_t LOGIC_IO_THREADS = 4;
+
+// ============================================================
+// Lz77IoStats — pomiar wejścia/wyjścia partii (wypełniane po zakończeniu
+// StartCompressionEx / StartDecompressionEx), do porównania trybów.
+//   mode         — użyty tryb (LOGIC_IO_*)
+//   maxInFlight  — największa liczba plików jednocześnie w trakcie I/O
+//   reads        — pliki odczytane przez backend asynchroniczny (w trybie
+//                  LOGIC_IO_SYNC 0 — obraz czyta GDI+)
+//   writes       — zapisane pliki wynikowe
+//   bytesRead    — bajty odczytane przez backend asynchroniczny
+//   bytesWritten — bajty zapisanych plików wynikowych
+//   readUs       — suma czasów odczytu plików (od zgłoszenia do zakończenia)
+//   writeUs      — suma czasów zapisu plików (od zgłoszenia do zakończenia)
+//   callerWriteUs — czas wątku wywołującego spędzony na zapisie; w trybie
+//                  LOGIC_IO_ASYNC tylko kodowanie w pamięci i zgłoszenie
+// ============================================================
+struct Lz77IoStats {
+    uint32_t mode;
+    uint32_t maxInFlight;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+    int64_t  readUs;
+    int64_t  writeUs;
+    int64_t  callerWriteUs;
+};
+
+// ============================================================
+// Lz77CompressOptions — opcje StartCompressionEx (układ sekwencyjny,
+// wyrównanie domyślne — P/Invoke).
+//   blockPixels — docelowa liczba pikseli bloku; 0 = LOGIC_DEFAULT_BLOCK_PIXELS,
+//                 0xFFFFFFFF = cały obraz jako jeden blok (brak podziału)
+//   maxInFlight — maks. liczba obrazów jednocześnie w pamięci (wczytanych,
+//                 a jeszcze niezapisanych); 0 = LOGIC_DEFAULT_IN_FLIGHT_PER_THREAD
+//                 * numThreads
+//   level       — poziom kompresji 1..5 (lz77_level_params); 0 = format
+//                 domyślny bez rekordu parametrów (jak StartCompression).
+//                 Poziomy wymagają CppDll.dll — z AsmDll.dll używany jest
+//                 format domyślny
+//   statsCb     — opcjonalny callback ze statystykami pliku; nullptr = brak
+//   kernel      — kernel z rejestru (LOGIC_KERNEL_*); LOGIC_KERNEL_DEFAULT =
+//                 według useASM
+//   batchStats  — opcjonalne wyjście z obciążeniem wątków; nullptr = brak
+//   ioMode      — tryb wejścia/wyjścia plików (LOGIC_IO_*)
+//   ioQueueDepth — maks. liczba plików w trakcie I/O (LOGIC_IO_ASYNC);
+//                 0 = LOGIC_IO_DEFAULT_QUEUE_DEPTH
+//   ioStats     — opcjonalne wyjście z pomiarem I/O; nullptr = brak
+//   rowFilter   — filtr wierszy przed kompresją: LOGIC_ROW_FILTER_OFF = bez
+//                 filtrów, LOGIC_FILTER_* + 1 = ten sam filtr dla każdego
+//                 wiersza, LOGIC_ROW_FILTER_ADAPTIVE = wybór dla każdego wiersza
+//   colorTransform — transformacja kolorów przed kompresją (LOGIC_TRANSFORM_*)
+//                 Filtry i transformacja zapisywane są w pliku (LZ77_FLAG_FILTERS)
+//                 i wymagają CppDll.dll — z AsmDll.dll pliki zapisywane są bez nich
+//   entropy     — kodowanie entropijne bloków po kompresji (LOGIC_ENTROPY_*);
+//                 wymaga CppDll.dll i wyłącza kompresję strumieniową (koder
+//                 potrzebuje całego strumienia tokenów bloku); pliki z kodowaniem
+//                 dekoduje tylko CppDll.dll
+//
+// Pliki przetwarzane są od największego (width * height z nagłówka),
+// a obrazy dzielone na bloki — duży obraz nie zostaje na końcu partii
+// na jednym wątku.
+// ============================================================
+struct Lz77CompressOptions {
+    uint32_t blockPixels;
+    uint32_t maxInFlight;
+    uint32_t level;
+    StatsCallback statsCb;
+    uint32_t kernel;
+    Lz77BatchStats* batchStats;
+    uint32_t ioMode;
+    uint32_t ioQueueDepth;
+    Lz77IoStats* ioStats;
+    uint32_t rowFilter;
+    uint32_t colorTransform;
+    uint32_t entropy;
+};
+
+// Wartości Lz77CompressOptions.rowFilter (zero — etap filtrów wyłączony).
+static const uint32_t LOGIC_ROW_FILTER_OFF = 0;
+static const uint32_t LOGIC_ROW_FILTER_ADAPTIVE = LOGIC_FILTER_COUNT + 1;
+
+// Wartości Lz77CompressOptions.entropy.
+static const uint32_t LOGIC_ENTROPY_NONE = 0;
+static const uint32_t LOGIC_ENTROPY_HUFFMAN = 1;
+
+// ============================================================
+// Lz77DecompressOptions — opcje StartDecompressionEx.
+//   maxInFlight — maks. liczba obrazów jednocześnie w pamięci (odczytanych,
+//                 a jeszcze niezapisanych); 0 = LOGIC_DEFAULT_IN_FLIGHT_PER_THREAD
+//                 * numThreads
+//   kernel      — kernel z rejestru, jak w Lz77CompressOptions
+//   batchStats  — jak w Lz77CompressOptions
+//   ioMode, ioQueueDepth, ioStats — jak w Lz77CompressOptions
+// ============================================================
+struct Lz77DecompressOptions {
+    uint32_t maxInFlight;
+    uint32_t kernel;
+    Lz77BatchStats* batchStats;
+    uint32_t ioMode;
+    uint32_t ioQueueDepth;
+    Lz77IoStats* ioStats;
+};
+
+// ============================================================
+// Kalibracja (Lz77Calibrate) — pomiar kerneli i liczby wątków na próbce
+// obrazów z folderu wejściowego; wynik zapisywany jest w profilu
+// %LOCALAPPDATA%\Lz77\calibration.ini i używany przez kolejne wywołania:
+//   - pomiary kerneli — przez LOGIC_KERNEL_FASTEST (pole kernel opcji),
+//   - liczba wątków — przez numThreads <= 0 w Start* i Lz77Decode*.
+// Profil zapisany na innej maszynie (liczba procesorów, poziom SIMD) jest
+// pomijany.
+//
+// Lz77CalibrateOptions (może być nullptr — wartości domyślne):
+//   samplePixels — rozmiar próbki w pikselach; 0 = LOGIC_CALIBRATION_SAMPLE_PIXELS
+//   maxThreads   — największa sprawdzana liczba wątków; 0 = liczba procesorów
+//                  logicznych
+//
+// Lz77CalibrationResult:
+//   kernel            — najszybszy kernel kompresji (LOGIC_KERNEL_*)
+//   threads           — wybrana liczba wątków (najmniejsza dająca >= 95%
+//                       przepustowości maksymalnej)
+//   saturationThreads — liczba wątków, powyżej której przyrost przepustowości
+//                       spada poniżej 10% (nasycenie pamięci lub rdzeni)
+//   singleThreadMBps  — przepustowość kompresji kernela na jednym wątku
+//   compressMBps      — przepustowość łączna przy threads wątkach
+// ============================================================
+static const uint32_t LOGIC_CALIBRATION_SAMPLE_PIXELS = 4u << 20;
+
+struct Lz77CalibrateOptions {
+    uint32_t samplePixels;
+    uint32_t maxThreads;
+};
+
+struct Lz77CalibrationResult {
+    uint32_t kernel;
+    uint32_t threads;
+    uint32_t saturationThreads;
+    double   singleThreadMBps;
+    double   compressMBps;
+};
+
 // ============================================================
 // WAŻNE: Typy callbacków dla warstwy C# (P/Invoke).
 //
@@ -135,6 +748,33 @@ static const uint32_t LZ77_FILE_MAGIC = 0x4C5A3737u;
 using ProgressCallback = void(__stdcall*)(int percent);
 using LogCallback = void(__stdcall*)(const wchar_t* message);
 
+// ============================================================
+// Dekodery obrazów — wczytanie plików wejściowych kompresji bez GDI+.
+//
+// Format rozpoznawany jest po zawartości pliku (nie po rozszerzeniu), a
+// piksele trafiają wprost do bufora obrazu potoku. Wbudowane dekodery:
+//   BMP — bez kompresji (BI_RGB) 24 i 32 bpp oraz 32 bpp BI_BITFIELDS
+//         z maskami 0x00FF0000 / 0x0000FF00 / 0x000000FF (alfa 0xFF000000
+//         lub brak); wiersze z dołu do góry i z góry na dół
+//   PPM — binarny (P6), MAXVAL 255; alfa = 255
+//   PAM — P7, DEPTH 3 lub 4 (RGB_ALPHA — surowe RGBA z nagłówkiem), MAXVAL 255
+// Pozostałe pliki (PNG, JPG, TIFF, GIF, BMP z paletą lub RLE) wczytuje GDI+.
+//
+// Lz77RegisterImageDecoder dopisuje dekoder zewnętrzny, sprawdzany po
+// wbudowanych, a przed GDI+. Jego funkcje wywoływane są równocześnie
+// z wielu wątków roboczych:
+//   Lz77ImageProbeFunc  — rozpoznanie formatu i wymiary obrazu z nagłówka;
+//                         data — cały plik (bytes bajtów); false = nie ten format
+//   Lz77ImageDecodeFunc — piksele 0xAARRGGBB do dst (width * height,
+//                         wiersz za wierszem od góry); false = plik uszkodzony
+// ============================================================
+using Lz77ImageProbeFunc = bool(__stdcall*)(const uint8_t* data, uint64_t bytes,
+    uint32_t* outWidth, uint32_t* outHeight);
+using Lz77ImageDecodeFunc = bool(__stdcall*)(const uint8_t* data, uint64_t bytes,
+    uint32_t width, uint32_t height, uint32_t* dst);
+
+static const uint32_t LOGIC_MAX_IMAGE_DECODERS = 16;   // wbudowane + zewnętrzne
+
 // ============================================================
 // WAŻNE: Eksporty DLL wywołane z C# przez P/Invoke.
 //
@@ -154,12 +794,17 @@ extern "C" {
     //   sourceFolder  — folder z plikami obrazów (PNG/JPG/BMP/TIFF/GIF)
     //   outputFolder  — folder docelowy dla plików .lz77
     //   useASM        — true = użyj AsmDll.dll, false = użyj CppDll.dll
-    //   numThreads    — liczba wątków roboczych (wartość z suwaka GUI; min. 1)
+    //   numThreads    — liczba wątków roboczych (wartość z suwaka GUI);
+    //                   <= 0 = z profilu kalibracji (Lz77Calibrate), a bez
+    //                   profilu liczba procesorów logicznych
     //   progressCb    — callback wywoływany po zakończeniu każdego pliku
     //                   (argument: procent ukończenia 0..100)
     //   logCb         — callback z komunikatami tekstowymi (logi postępu i błędów)
-    //   outElapsedMs  — [out] TYLKO czas wywołań lz77_rgba_compress w ms
-    //                   (bez czasu I/O; używany do porównania ASM vs C++)
+    //   outElapsedMs  — [out] czas, w którym trwała kompresja LZ77, w ms
+    //                   (bez okresów samego I/O; używany do porównania ASM vs C++)
+    //
+    // Pliki zapisywane są bez kodowania entropijnego (LOGIC_ENTROPY_NONE) —
+    // dekoduje je każda DLL; kodowanie włącza pole entropy StartCompressionEx.
     // ----------------------------------------------------------
     __declspec(dllexport)
         void __stdcall StartCompression(
@@ -172,6 +817,23 @@ extern "C" {
             int64_t* outElapsedMs   // [out] czas samego algorytmu LZ77 w ms
         );
 
+    // ----------------------------------------------------------
+    // StartCompressionEx — jak StartCompression, z dodatkowymi opcjami.
+    //   options — może być nullptr (wartości domyślne; w odróżnieniu od
+    //             StartCompression bez kodowania entropijnego)
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        void __stdcall StartCompressionEx(
+            const wchar_t* sourceFolder,
+            const wchar_t* outputFolder,
+            bool             useASM,
+            int              numThreads,
+            const Lz77CompressOptions* options,
+            ProgressCallback progressCb,
+            LogCallback      logCb,
+            int64_t* outElapsedMs
+        );
+
     // ----------------------------------------------------------
     // StartDecompression — dekompresuje wszystkie pliki .lz77 z sourceFolder
     // do plików .bmp w outputFolder.
@@ -180,7 +842,7 @@ extern "C" {
     //   sourceFolder  — folder z plikami .lz77
     //   outputFolder  — folder docelowy dla zdekompresowanych obrazów .bmp
     //   pozostałe     — jak w StartCompression
-    //   outElapsedMs  — [out] TYLKO czas wywołań lz77_rgba_decompress w ms
+    //   outElapsedMs  — [out] czas, w którym trwała dekompresja LZ77, w ms
     // ----------------------------------------------------------
     __declspec(dllexport)
         void __stdcall StartDecompression(
@@ -192,4 +854,176 @@ extern "C" {
             LogCallback      logCb,
             int64_t* outElapsedMs   // [out] czas samego algorytmu LZ77 w ms
         );
+
+    // ----------------------------------------------------------
+    // StartDecompressionEx — jak StartDecompression, z dodatkowymi opcjami.
+    //   options — może być nullptr (wartości domyślne, jak StartDecompression)
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        void __stdcall StartDecompressionEx(
+            const wchar_t* sourceFolder,
+            const wchar_t* outputFolder,
+            bool             useASM,
+            int              numThreads,
+            const Lz77DecompressOptions* options,
+            ProgressCallback progressCb,
+            LogCallback      logCb,
+            int64_t* outElapsedMs
+        );
+
+    // ----------------------------------------------------------
+    // Lz77GetImageInfo — wymiary obrazu i układ bloków pliku .lz77
+    // (czyta tylko nagłówek i tabelę bloków).
+    //   outWidth / outHeight         — wymiary obrazu w pikselach
+    //   outBlockRows / outBlockCount — wierszy na blok / liczba bloków
+    // Każdy wskaźnik wyjściowy może być nullptr. Zwraca false dla pliku
+    // nieistniejącego lub uszkodzonego.
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        bool __stdcall Lz77GetImageInfo(
+            const wchar_t* path,
+            uint32_t* outWidth,
+            uint32_t* outHeight,
+            uint32_t* outBlockRows,
+            uint32_t* outBlockCount
+        );
+
+    // ----------------------------------------------------------
+    // Lz77DecodeImage — dekompresja jednego pliku .lz77 do bufora dst
+    // (width * height pikseli RGBA), bloki dekodowane równolegle.
+    //   numThreads — liczba wątków (nie więcej niż bloków; <= 0 jak
+    //                w StartCompression)
+    //   dstCount   — pojemność dst w pikselach
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        bool __stdcall Lz77DecodeImage(
+            const wchar_t* path,
+            bool           useASM,
+            int            numThreads,
+            uint32_t* dst,
+            size_t         dstCount
+        );
+
+    // ----------------------------------------------------------
+    // Lz77DecodeRegion — dekompresja prostokąta (x, y, width, height)
+    // obrazu do dst (width * height pikseli, wiersz za wierszem).
+    // Odczytywane i dekodowane są tylko bloki pokrywające wiersze wycinka.
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        bool __stdcall Lz77DecodeRegion(
+            const wchar_t* path,
+            bool           useASM,
+            int            numThreads,
+            uint32_t       x,
+            uint32_t       y,
+            uint32_t       width,
+            uint32_t       height,
+            uint32_t* dst,
+            size_t         dstCount
+        );
+
+    // ----------------------------------------------------------
+    // Lz77KernelCount — liczba kerneli w rejestrze; pierwsze wywołanie
+    // (dowolnej funkcji rejestru lub Start*) ładuje DLL-e kerneli.
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        uint32_t __stdcall Lz77KernelCount();
+
+    // ----------------------------------------------------------
+    // Lz77GetKernelInfo — opis kernela o indeksie 0..Lz77KernelCount()-1
+    // (razem z ostatnimi pomiarami). Zwraca false dla indeksu spoza zakresu.
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        bool __stdcall Lz77GetKernelInfo(
+            uint32_t        index,
+            Lz77KernelInfo* out
+        );
+
+    // ----------------------------------------------------------
+    // Lz77FindKernel — identyfikator kernela o podanej nazwie ("cpp",
+    // "asm", "cpp-avx2", ...) lub "fastest"; LOGIC_KERNEL_DEFAULT (0),
+    // gdy kernela nie ma w rejestrze.
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        uint32_t __stdcall Lz77FindKernel(const char* name);
+
+    // ----------------------------------------------------------
+    // Lz77ResolveKernel — identyfikator kernela, którego użyje Start*
+    // dla danej wartości pola kernel i flagi useASM (rozwija
+    // LOGIC_KERNEL_DEFAULT i LOGIC_KERNEL_FASTEST); 0, gdy niedostępny.
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        uint32_t __stdcall Lz77ResolveKernel(
+            uint32_t kernel,
+            bool     useASM
+        );
+
+    // ----------------------------------------------------------
+    // Lz77Calibrate — kalibracja kerneli i liczby wątków na próbce obrazów
+    // z sourceFolder (opis przy Lz77CalibrateOptions). Przebieg i wynik
+    // raportowane są przez logCb. out może być nullptr.
+    // Zwraca false, gdy brak obrazów lub żaden kernel nie odtworzył próbki.
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        bool __stdcall Lz77Calibrate(
+            const wchar_t* sourceFolder,
+            const Lz77CalibrateOptions* options,
+            LogCallback    logCb,
+            Lz77CalibrationResult* out
+        );
+
+    // ----------------------------------------------------------
+    // Pula wątków roboczych Logic.dll — wspólna dla wszystkich partii
+    // (opis przy WorkerPool w logic.cpp). Bez Lz77PoolStart pula startuje
+    // przy pierwszej partii i rośnie do zamówionej liczby wątków.
+    //
+    // Lz77PoolStart    — (ponowny) start puli z numThreads wątkami
+    //                    (<= 0 jak w StartCompression); rozmiar jawny nie
+    //                    zmienia się przy kolejnych partiach. Zwraca false,
+    //                    gdy nie udało się utworzyć wszystkich wątków.
+    // Lz77PoolSize     — bieżąca liczba wątków puli (0 = zatrzymana)
+    // Lz77PoolShutdown — zakończenie wątków po wykonaniu zgłoszonej pracy;
+    //                    wywołać przed FreeLibrary(Logic.dll)
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        bool __stdcall Lz77PoolStart(int numThreads);
+
+    __declspec(dllexport)
+        int __stdcall Lz77PoolSize();
+
+    __declspec(dllexport)
+        void __stdcall Lz77PoolShutdown();
+
+    // ----------------------------------------------------------
+    // Arena buforów Logic.dll — pamięć pikseli, tokenów i buforów roboczych
+    // partii, odzyskiwana między obrazami i partiami (opis przy BufferArena
+    // w logic.cpp).
+    //
+    // Lz77ArenaConfigure   — limit pamięci podręcznej areny w bajtach
+    //                        (0 = LOGIC_ARENA_DEFAULT_CACHED_BYTES, 1 GB) i duże
+    //                        strony. Zwraca true, gdy duże strony są włączone
+    //                        (wymagają uprawnienia SeLockMemoryPrivilege).
+    // Lz77ArenaCachedBytes — łączny rozmiar wolnych buforów w arenie
+    // Lz77ArenaTrim        — zwrócenie wolnych buforów systemowi
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        bool __stdcall Lz77ArenaConfigure(uint64_t maxCachedBytes, bool largePages);
+
+    __declspec(dllexport)
+        uint64_t __stdcall Lz77ArenaCachedBytes();
+
+    __declspec(dllexport)
+        void __stdcall Lz77ArenaTrim();
+
+    // ----------------------------------------------------------
+    // Lz77RegisterImageDecoder — dopisanie dekodera obrazów (opis przy
+    // Lz77ImageProbeFunc); obowiązuje od kolejnego wczytywanego pliku do
+    // końca procesu. Zwraca false dla nullptr lub pełnego rejestru
+    // (LOGIC_MAX_IMAGE_DECODERS).
+    // ----------------------------------------------------------
+    __declspec(dllexport)
+        bool __stdcall Lz77RegisterImageDecoder(
+            Lz77ImageProbeFunc  probe,
+            Lz77ImageDecodeFunc decode
+        );
 }
\ No newline at end of file
@@ -0,0 +1,429 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// lz77bench — powtarzalny benchmark jąder kompresji LZ77.
+//
+// Wywołuje bezpośrednio lz77_rgba_compress / lz77_rgba_decompress (oraz
+// warianty _packed) na syntetycznym korpusie (corpus.h), bez I/O i bez
+// GDI+. Dla każdego jądra, formatu i liczby wątków 1..N raportuje:
+//   - MB/s i Mpx/s (MB = 10^6 bajtów nieskompresowanych pikseli, w*h*4),
+//   - stopień kompresji (bajty wyjścia / bajty pikseli),
+//   - opóźnienie p50 / p99 pojedynczego obrazu w mikrosekundach.
+// Wyniki w JSON (stdout lub --output) bez znaczników czasu — pliki z dwóch
+// wersji programu można porównywać narzędziem diff.
+//
+// Jądra: "cpp" (CppLib, linkowane statycznie); pod Windows dodatkowe
+// jądra z DLL (--dll asm=AsmDll.dll), ładowane jak w Logic.dll.
+//
+// Kod wyjścia: 0 = OK, 1 = błąd weryfikacji (dekompresja != oryginał),
+// 2 = niepoprawne argumenty.
+// ============================================================
+
+#include "corpus.h"
+#include "lz77.h"
+#include "lz77_container.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+using CompressFn = void(*)(const uint32_t*, size_t, uint8_t*, size_t, void*, size_t, size_t*);
+using DecompressFn = void(*)(const uint8_t*, size_t, uint32_t*, size_t, size_t*);
+
+// Jądro: komplet funkcji jednej implementacji (jak LZ77Api w Logic.dll).
+struct Kernel {
+    std::string  name;
+    CompressFn   compress = nullptr;
+    DecompressFn decompress = nullptr;
+    CompressFn   compressPacked = nullptr;
+    DecompressFn decompressPacked = nullptr;
+    int          simdLevel = -1;     // LZ77_SIMD_* dla jąder lz77core; -1 = wybór automatyczny / DLL
+    int          matchFinder = LZ77_MATCH_FINDER_CHAIN;   // LZ77_MATCH_FINDER_* (lz77_rgba_compress_ex, tylko packed)
+};
+
+static const char* const SIMD_NAMES[] = { "scalar", "sse2", "avx2", "avx512" };
+
+// Format strumienia: nazwa w JSON; packed = warianty _packed funkcji jądra.
+struct Format {
+    std::string name;
+    bool        packed;
+};
+
+// Jeden wiersz wyników.
+struct Result {
+    std::string kernel;
+    std::string format;
+    std::string op;          // "compress" / "decompress"
+    int         threads = 1;
+    std::string category;    // kategoria korpusu lub "all"
+    size_t      images = 0;  // liczba wywołań (obrazy * powtórzenia)
+    uint64_t    pixels = 0;
+    uint64_t    rawBytes = 0;
+    uint64_t    packedBytes = 0;
+    double      wallUs = 0;
+    double      p50Us = 0;
+    double      p99Us = 0;
+    bool        verified = true;
+};
+
+// Percentyl metodą najbliższej rangi (lat posortowane rosnąco).
+static double Percentile(const std::vector<double>& lat, double p)
+{
+    if (lat.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p / 100.0 * lat.size() + 0.999999);
+    rank = std::clamp<size_t>(rank, 1, lat.size());
+    return lat[rank - 1];
+}
+
+// Dokładny pesymistyczny rozmiar wyjścia formatu (lz77_compress_bound).
+static size_t OutputBound(bool packed, size_t pixelCount)
+{
+    return lz77_compress_bound(packed ? LZ77_FORMAT_PACKED : LZ77_FORMAT_TOKEN12, pixelCount);
+}
+
+// ============================================================
+// RunPass — jedno przejście (kompresja lub dekompresja) całego korpusu
+// 'repeat' razy na 'threads' wątkach. Obrazy rozdzielane przez fetch_add,
+// każdy wątek ma własny bufor roboczy. latUs[i] — czasy wywołań obrazu i.
+// ============================================================
+struct PassOutput {
+    double                           wallUs = 0;
+    std::vector<std::vector<double>> latUs;   // [obraz][powtórzenie]
+};
+
+static PassOutput RunPass(const std::vector<CorpusImage>& corpus,
+    const Kernel& kernel,
+    bool packed,
+    bool compress,
+    int threads,
+    int repeat,
+    std::vector<std::vector<uint8_t>>& streams,
+    std::vector<size_t>& streamLen,
+    std::vector<std::vector<uint32_t>>& decoded)
+{
+    CompressFn   compFn = packed ? kernel.compressPacked : kernel.compress;
+    DecompressFn decompFn = packed ? kernel.decompressPacked : kernel.decompress;
+
+    size_t jobs = corpus.size() * static_cast<size_t>(repeat);
+    PassOutput out;
+    out.latUs.assign(corpus.size(), std::vector<double>(static_cast<size_t>(repeat), 0.0));
+
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        std::vector<uint8_t> work(LZ77_WORK_NEED_BYTES);
+        while (true) {
+            size_t job = next.fetch_add(1, std::memory_order_relaxed);
+            if (job >= jobs) break;
+            size_t i = job % corpus.size();
+            size_t rep = job / corpus.size();
+            const CorpusImage& img = corpus[i];
+            size_t count = img.pixels.size();
+
+            auto t0 = std::chrono::steady_clock::now();
+            if (compress && packed && kernel.matchFinder != LZ77_MATCH_FINDER_CHAIN) {
+                lz77_rgba_compress_ex(img.pixels.data(), count, 0, streams[i].data(), streams[i].size(),
+                    work.data(), work.size(), nullptr, kernel.matchFinder, &streamLen[i], nullptr);
+            }
+            else if (compress) {
+                compFn(img.pixels.data(), count, streams[i].data(), streams[i].size(),
+                    work.data(), work.size(), &streamLen[i]);
+            }
+            else {
+                size_t outLen = 0;
+                decompFn(streams[i].data(), streamLen[i], decoded[i].data(), count, &outLen);
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            out.latUs[i][rep] = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        }
+        };
+
+    auto tstart = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    auto tend = std::chrono::steady_clock::now();
+
+    out.wallUs = std::chrono::duration<double, std::micro>(tend - tstart).count();
+    return out;
+}
+
+// Wiersz wyników dla podzbioru obrazów (filter == "" — wszystkie).
+static Result Summarize(const std::vector<CorpusImage>& corpus, const PassOutput& pass,
+    const std::vector<size_t>& streamLen, const std::string& filter, double wallUs, int repeat)
+{
+    Result r;
+    r.category = filter.empty() ? "all" : filter;
+    std::vector<double> lat;
+    double latSum = 0;
+    for (size_t i = 0; i < corpus.size(); ++i) {
+        if (!filter.empty() && corpus[i].category != filter) continue;
+        r.images += static_cast<size_t>(repeat);
+        r.pixels += corpus[i].pixels.size() * static_cast<uint64_t>(repeat);
+        r.rawBytes += corpus[i].pixels.size() * sizeof(uint32_t) * static_cast<uint64_t>(repeat);
+        r.packedBytes += streamLen[i] * static_cast<uint64_t>(repeat);
+        for (double l : pass.latUs[i]) { lat.push_back(l); latSum += l; }
+    }
+    std::sort(lat.begin(), lat.end());
+    // Dla podzbioru kategorii (1 wątek) czas = suma wywołań tej kategorii.
+    r.wallUs = filter.empty() ? wallUs : latSum;
+    r.p50Us = Percentile(lat, 50.0);
+    r.p99Us = Percentile(lat, 99.0);
+    return r;
+}
+
+static void PrintUsage(FILE* out)
+{
+    fputs(
+        "Uzycie: lz77bench [opcje]\n"
+        "  -t, --threads N       maks. liczba watkow; mierzone 1..N (domyslnie liczba rdzeni)\n"
+        "  -r, --repeat N        powtorzenia kazdego obrazu (domyslnie 3)\n"
+        "      --seed N          ziarno korpusu (domyslnie 1)\n"
+        "      --scale X         mnoznik wymiarow obrazow (domyslnie 1.0)\n"
+        "      --formats LISTA   token12,packed (domyslnie oba)\n"
+        "      --simd all        jadra cpp na kazdym poziomie SIMD obslugiwanym przez procesor\n"
+        "                        (cpp-scalar, cpp-sse2, cpp-avx2, cpp-avx512)\n"
+        "      --finder all      dodatkowe jadro cpp-bucket (wyszukiwanie w kubelkach,\n"
+        "                        tylko format packed)\n"
+#ifdef _WIN32
+        "      --dll NAZWA=PLIK  dodatkowe jadro z DLL, np. asm=AsmDll.dll\n"
+#endif
+        "  -o, --output PLIK     zapis JSON do pliku (domyslnie stdout)\n"
+        "  -q, --quiet           bez tabeli wynikow na stderr\n",
+        out);
+}
+
+#ifdef _WIN32
+// Jądro z DLL — nazwy eksportów jak w LoadLZ77DLL (Logic.dll).
+static bool LoadKernelDll(const std::string& name, const std::string& path, Kernel& kernel)
+{
+    HMODULE mod = LoadLibraryA(path.c_str());
+    if (!mod) return false;
+    kernel.name = name;
+    kernel.compress = reinterpret_cast<CompressFn>(GetProcAddress(mod, "lz77_rgba_compress"));
+    kernel.decompress = reinterpret_cast<DecompressFn>(GetProcAddress(mod, "lz77_rgba_decompress"));
+    kernel.compressPacked = reinterpret_cast<CompressFn>(GetProcAddress(mod, "lz77_rgba_compress_packed"));
+    kernel.decompressPacked = reinterpret_cast<DecompressFn>(GetProcAddress(mod, "lz77_rgba_decompress_packed"));
+    // Biblioteka pozostaje załadowana do końca procesu.
+    return kernel.compress && kernel.decompress && kernel.compressPacked && kernel.decompressPacked;
+}
+#endif
+
+static std::string JsonNumber(double v)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.3f", v);
+    return buf;
+}
+
+int main(int argc, char** argv)
+{
+    int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int repeat = 3;
+    uint32_t seed = 1;
+    double scale = 1.0;
+    bool quiet = false;
+    std::string outputPath;
+    std::vector<Format> formats = { { "token12", false }, { "packed", true } };
+
+    std::vector<Kernel> kernels;
+    Kernel cpp;
+    cpp.name = "cpp";
+    cpp.compress = lz77_rgba_compress;
+    cpp.decompress = lz77_rgba_decompress;
+    cpp.compressPacked = lz77_rgba_compress_packed;
+    cpp.decompressPacked = lz77_rgba_decompress_packed;
+    kernels.push_back(cpp);
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool hasValue = value != nullptr;
+
+        if (arg == "-h" || arg == "--help") { PrintUsage(stdout); return 0; }
+        else if (arg == "-q" || arg == "--quiet") quiet = true;
+        else if ((arg == "-t" || arg == "--threads") && hasValue) { maxThreads = atoi(value); ++i; }
+        else if ((arg == "-r" || arg == "--repeat") && hasValue) { repeat = atoi(value); ++i; }
+        else if (arg == "--seed" && hasValue) { seed = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (arg == "--scale" && hasValue) { scale = atof(value); ++i; }
+        else if ((arg == "-o" || arg == "--output") && hasValue) { outputPath = value; ++i; }
+        else if (arg == "--formats" && hasValue) {
+            std::string list = value;
+            ++i;
+            formats.clear();
+            if (list.find("token12") != std::string::npos) formats.push_back({ "token12", false });
+            if (list.find("packed") != std::string::npos) formats.push_back({ "packed", true });
+        }
+        else if (arg == "--simd" && hasValue && strcmp(value, "all") == 0) {
+            ++i;
+            for (int level = LZ77_SIMD_SCALAR; level <= lz77_cpu_simd_level(); ++level) {
+                Kernel k = cpp;
+                k.name = std::string("cpp-") + SIMD_NAMES[level];
+                k.simdLevel = level;
+                kernels.push_back(k);
+            }
+        }
+        else if (arg == "--finder" && hasValue && strcmp(value, "all") == 0) {
+            ++i;
+            Kernel k = cpp;
+            k.name = "cpp-bucket";
+            k.matchFinder = LZ77_MATCH_FINDER_BUCKET;
+            kernels.push_back(k);
+        }
+#ifdef _WIN32
+        else if (arg == "--dll" && hasValue) {
+            std::string spec = value;
+            ++i;
+            size_t eq = spec.find('=');
+            Kernel k;
+            if (eq == std::string::npos || !LoadKernelDll(spec.substr(0, eq), spec.substr(eq + 1), k)) {
+                fprintf(stderr, "Nie mozna zaladowac jadra: %s\n", spec.c_str());
+                return 2;
+            }
+            kernels.push_back(k);
+        }
+#endif
+        else {
+            fprintf(stderr, "Nieznana opcja lub brak wartosci: %s\n", arg.c_str());
+            PrintUsage(stderr);
+            return 2;
+        }
+    }
+
+    if (maxThreads < 1 || repeat < 1 || scale <= 0.0 || formats.empty()) {
+        fprintf(stderr, "Niepoprawne parametry\n");
+        return 2;
+    }
+
+    std::vector<CorpusImage> corpus = BuildCorpus(seed, scale);
+
+    std::vector<Result> results;
+    bool allVerified = true;
+
+    for (const Kernel& kernel : kernels) {
+        lz77_set_simd_level(kernel.simdLevel);
+        for (const Format& format : formats) {
+            // Token12 zawsze z łańcuchami hash — wynik cpp-bucket byłby kopią cpp.
+            if (!format.packed && kernel.matchFinder != LZ77_MATCH_FINDER_CHAIN)
+                continue;
+            std::vector<std::vector<uint8_t>>  streams(corpus.size());
+            std::vector<size_t>                streamLen(corpus.size(), 0);
+            std::vector<std::vector<uint32_t>> decoded(corpus.size());
+            for (size_t i = 0; i < corpus.size(); ++i) {
+                streams[i].resize(OutputBound(format.packed, corpus[i].pixels.size()));
+                decoded[i].assign(corpus[i].pixels.size(), 0u);
+            }
+
+            // Przebieg rozgrzewkowy (niemierzony) — strony buforów i cache instrukcji.
+            RunPass(corpus, kernel, format.packed, true, 1, 1, streams, streamLen, decoded);
+
+            for (int threads = 1; threads <= maxThreads; ++threads) {
+                for (int op = 0; op < 2; ++op) {
+                    bool compress = (op == 0);
+                    PassOutput pass = RunPass(corpus, kernel, format.packed, compress,
+                        threads, repeat, streams, streamLen, decoded);
+
+                    bool verified = true;
+                    if (!compress) {
+                        for (size_t i = 0; i < corpus.size(); ++i)
+                            verified = verified && decoded[i] == corpus[i].pixels;
+                        allVerified = allVerified && verified;
+                    }
+
+                    auto add = [&](const std::string& filter) {
+                        Result r = Summarize(corpus, pass, streamLen, filter, pass.wallUs, repeat);
+                        r.kernel = kernel.name;
+                        r.format = format.name;
+                        r.op = compress ? "compress" : "decompress";
+                        r.threads = threads;
+                        r.verified = verified;
+                        results.push_back(r);
+                        };
+
+                    add("");
+                    // Charakterystyka kategorii — tylko dla jednego wątku, gdzie
+                    // suma czasów wywołań jest czasem rzeczywistym.
+                    if (threads == 1)
+                        for (const std::string& category : CorpusCategories()) add(category);
+                }
+            }
+        }
+    }
+
+    // --- JSON
+    std::string json = "{\n  \"schema\": 1,\n  \"tool\": \"lz77bench\",\n";
+    json += "  \"config\": {\"seed\": " + std::to_string(seed) + ", \"scale\": " + JsonNumber(scale) +
+        ", \"repeat\": " + std::to_string(repeat) + ", \"max_threads\": " + std::to_string(maxThreads) +
+        ", \"cpu_simd\": \"" + SIMD_NAMES[lz77_cpu_simd_level()] + "\"},\n";
+    json += "  \"corpus\": [";
+    for (size_t i = 0; i < corpus.size(); ++i) {
+        json += std::string(i ? ", " : "") + "{\"name\": \"" + corpus[i].name + "\", \"category\": \"" +
+            corpus[i].category + "\", \"width\": " + std::to_string(corpus[i].width) +
+            ", \"height\": " + std::to_string(corpus[i].height) + "}";
+    }
+    json += "],\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        double sec = r.wallUs / 1e6;
+        json += "    {\"kernel\": \"" + r.kernel + "\", \"format\": \"" + r.format + "\", \"op\": \"" + r.op +
+            "\", \"threads\": " + std::to_string(r.threads) + ", \"category\": \"" + r.category +
+            "\", \"images\": " + std::to_string(r.images) +
+            ", \"pixels\": " + std::to_string(r.pixels) +
+            ", \"raw_bytes\": " + std::to_string(r.rawBytes) +
+            ", \"compressed_bytes\": " + std::to_string(r.packedBytes) +
+            ", \"ratio\": " + JsonNumber(r.rawBytes ? static_cast<double>(r.packedBytes) / r.rawBytes : 0.0) +
+            ", \"wall_us\": " + JsonNumber(r.wallUs) +
+            ", \"mb_per_s\": " + JsonNumber(sec > 0 ? r.rawBytes / 1e6 / sec : 0.0) +
+            ", \"mpix_per_s\": " + JsonNumber(sec > 0 ? r.pixels / 1e6 / sec : 0.0) +
+            ", \"p50_us\": " + JsonNumber(r.p50Us) +
+            ", \"p99_us\": " + JsonNumber(r.p99Us) +
+            ", \"verified\": " + (r.verified ? "true" : "false") + "}" +
+            (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json += "  ]\n}\n";
+
+    if (outputPath.empty()) {
+        fputs(json.c_str(), stdout);
+    }
+    else {
+        FILE* f = fopen(outputPath.c_str(), "wb");
+        if (!f || fwrite(json.data(), 1, json.size(), f) != json.size()) {
+            fprintf(stderr, "Blad zapisu: %s\n", outputPath.c_str());
+            if (f) fclose(f);
+            return 2;
+        }
+        fclose(f);
+    }
+
+    // --- Tabela czytelna dla człowieka
+    if (!quiet) {
+        fprintf(stderr, "%-10s %-8s %-10s %3s %-10s %10s %10s %8s %10s %10s\n",
+            "kernel", "format", "op", "thr", "category", "MB/s", "Mpx/s", "ratio", "p50 us", "p99 us");
+        for (const Result& r : results) {
+            double sec = r.wallUs / 1e6;
+            fprintf(stderr, "%-10s %-8s %-10s %3d %-10s %10.1f %10.2f %8.4f %10.1f %10.1f%s\n",
+                r.kernel.c_str(), r.format.c_str(), r.op.c_str(), r.threads, r.category.c_str(),
+                sec > 0 ? r.rawBytes / 1e6 / sec : 0.0, sec > 0 ? r.pixels / 1e6 / sec : 0.0,
+                r.rawBytes ? static_cast<double>(r.packedBytes) / r.rawBytes : 0.0,
+                r.p50Us, r.p99Us, r.verified ? "" : "  BLAD WERYFIKACJI");
+        }
+    }
+
+    return allVerified ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#include "corpus.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+const std::vector<std::string>& CorpusCategories()
+{
+    static const std::vector<std::string> categories = {
+        "flat", "gradient", "noise", "screenshot", "photo"
+    };
+    return categories;
+}
+
+static inline uint32_t Argb(uint32_t r, uint32_t g, uint32_t b)
+{
+    return 0xFF000000u | ((r & 0xFF) << 16) | ((g & 0xFF) << 8) | (b & 0xFF);
+}
+
+static void FillFlat(CorpusImage& img, std::mt19937& rng)
+{
+    std::fill(img.pixels.begin(), img.pixels.end(), Argb(rng(), rng(), rng()));
+}
+
+static void FillGradient(CorpusImage& img, std::mt19937&)
+{
+    for (uint32_t y = 0; y < img.height; ++y)
+        for (uint32_t x = 0; x < img.width; ++x)
+            img.pixels[static_cast<size_t>(y) * img.width + x] =
+                Argb(x * 255 / img.width, y * 255 / img.height, (x + y) & 0xFF);
+}
+
+static void FillNoise(CorpusImage& img, std::mt19937& rng)
+{
+    for (uint32_t& p : img.pixels) p = rng();
+}
+
+// ============================================================
+// Zrzut ekranu: tło, kilka okien z paskiem tytułu i wiersze "tekstu"
+// złożone z 16 losowych glifów 6x10 — glify powtarzają się, jak litery.
+// ============================================================
+static void FillScreenshot(CorpusImage& img, std::mt19937& rng)
+{
+    const uint32_t background = Argb(0x2B, 0x57, 0x9A);
+    std::fill(img.pixels.begin(), img.pixels.end(), background);
+
+    const uint32_t glyphW = 6, glyphH = 10, glyphCount = 16;
+    std::vector<uint16_t> glyphs(glyphCount * glyphH);
+    for (uint16_t& row : glyphs) row = static_cast<uint16_t>(rng() & 0x3F);
+
+    auto rect = [&](uint32_t x0, uint32_t y0, uint32_t w, uint32_t h, uint32_t color) {
+        for (uint32_t y = y0; y < std::min(y0 + h, img.height); ++y)
+            for (uint32_t x = x0; x < std::min(x0 + w, img.width); ++x)
+                img.pixels[static_cast<size_t>(y) * img.width + x] = color;
+        };
+
+    uint32_t windows = 3 + rng() % 4;
+    for (uint32_t wi = 0; wi < windows; ++wi) {
+        uint32_t w = img.width / 4 + rng() % (img.width / 2);
+        uint32_t h = img.height / 4 + rng() % (img.height / 2);
+        uint32_t x0 = rng() % (img.width - w / 2);
+        uint32_t y0 = rng() % (img.height - h / 2);
+
+        rect(x0, y0, w, h, Argb(0xF0, 0xF0, 0xF0));
+        rect(x0, y0, w, 22, Argb(0x33, 0x33, 0x40 + wi * 16));
+
+        // Wiersze tekstu wewnątrz okna.
+        const uint32_t ink = Argb(0x10, 0x10, 0x10);
+        for (uint32_t ty = y0 + 30; ty + glyphH < std::min(y0 + h, img.height); ty += glyphH + 4) {
+            uint32_t lineLen = (w - 16) / glyphW * (50 + rng() % 50) / 100;
+            for (uint32_t gi = 0; gi < lineLen; ++gi) {
+                uint32_t g = rng() % glyphCount;
+                uint32_t gx = x0 + 8 + gi * glyphW;
+                if (gx + glyphW >= img.width) break;
+                for (uint32_t yy = 0; yy < glyphH; ++yy)
+                    for (uint32_t xx = 0; xx < glyphW; ++xx)
+                        if (glyphs[g * glyphH + yy] & (1u << xx))
+                            img.pixels[static_cast<size_t>(ty + yy) * img.width + gx + xx] = ink;
+            }
+        }
+    }
+}
+
+// ============================================================
+// "Zdjęcie": suma kilku sinusoid 2D o losowych częstotliwościach i fazach
+// plus szum +-3 na kanał — brak dokładnych powtórzeń, jak w realnych zdjęciach.
+// ============================================================
+static void FillPhoto(CorpusImage& img, std::mt19937& rng)
+{
+    struct Wave { double fx, fy, phase, amp; };
+    std::vector<Wave> waves[3];
+    for (auto& channel : waves)
+        for (int k = 0; k < 4; ++k)
+            channel.push_back({ (rng() % 1000) / 1000.0 * 0.02, (rng() % 1000) / 1000.0 * 0.02,
+                (rng() % 6283) / 1000.0, 20.0 + rng() % 20 });
+
+    for (uint32_t y = 0; y < img.height; ++y) {
+        for (uint32_t x = 0; x < img.width; ++x) {
+            uint32_t c[3];
+            for (int ch = 0; ch < 3; ++ch) {
+                double v = 128.0;
+                for (const Wave& w : waves[ch])
+                    v += w.amp * std::sin(w.fx * x + w.fy * y + w.phase);
+                int n = static_cast<int>(v) + static_cast<int>(rng() % 7) - 3;
+                c[ch] = static_cast<uint32_t>(std::clamp(n, 0, 255));
+            }
+            img.pixels[static_cast<size_t>(y) * img.width + x] = Argb(c[0], c[1], c[2]);
+        }
+    }
+}
+
+std::vector<CorpusImage> BuildCorpus(uint32_t seed, double scale)
+{
+    static const uint32_t sizes[][2] = { { 256, 256 }, { 1024, 768 }, { 1920, 1080 } };
+
+    std::vector<CorpusImage> corpus;
+    uint32_t index = 0;
+    for (const std::string& category : CorpusCategories()) {
+        for (const auto& size : sizes) {
+            CorpusImage img;
+            img.category = category;
+            img.width = std::max(16u, static_cast<uint32_t>(size[0] * scale));
+            img.height = std::max(16u, static_cast<uint32_t>(size[1] * scale));
+            img.name = category + "_" + std::to_string(img.width) + "x" + std::to_string(img.height);
+            img.pixels.resize(static_cast<size_t>(img.width) * img.height);
+
+            // Osobne ziarno dla każdego obrazu — obraz nie zależy od kolejności generowania.
+            std::mt19937 rng(seed * 1000003u + index++);
+            if (category == "flat")            FillFlat(img, rng);
+            else if (category == "gradient")   FillGradient(img, rng);
+            else if (category == "noise")      FillNoise(img, rng);
+            else if (category == "screenshot") FillScreenshot(img, rng);
+            else                               FillPhoto(img, rng);
+
+            corpus.push_back(std::move(img));
+        }
+    }
+    return corpus;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#pragma once
+
+// ============================================================
+// Syntetyczny korpus testowy benchmarku lz77bench.
+//
+// Obrazy generowane są deterministycznie z ziarna (std::mt19937 — sekwencja
+// zdefiniowana przez standard, identyczna na każdej platformie), więc wyniki
+// z różnych wersji programu można porównywać bezpośrednio.
+//
+// Kategorie:
+//   flat       — jednolite wypełnienie (najlepszy przypadek dla LZ77)
+//   gradient   — gradient poziomy i pionowy (każdy piksel w wierszu inny)
+//   noise      — losowy szum (najgorszy przypadek, same literały)
+//   screenshot — płaskie tło, okna, paski i powtarzające się "glify" tekstu
+//   photo      — gładkie pole niskiej częstotliwości z lekkim szumem
+// ============================================================
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct CorpusImage {
+    std::string           category;
+    std::string           name;     // kategoria + wymiary, np. "photo_1024x768"
+    uint32_t              width = 0;
+    uint32_t              height = 0;
+    std::vector<uint32_t> pixels;   // 0xAARRGGBB, jak w GDI+
+};
+
+// Nazwy kategorii w stałej kolejności.
+const std::vector<std::string>& CorpusCategories();
+
+// Pełny korpus: każda kategoria w każdym z rozmiarów; scale mnoży wymiary
+// (scale = 1: 256x256, 1024x768, 1920x1080).
+std::vector<CorpusImage> BuildCorpus(uint32_t seed, double scale);
@@ -0,0 +1,136 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#include "async_io.h"
+#include "image_io.h"
+#include <algorithm>
+
+// ============================================================
+// IoThreads
+// ============================================================
+IoThreads::IoThreads(uint32_t threads, uint32_t queueDepth)
+    : m_depth(std::max(1u, queueDepth))
+{
+    threads = std::max(1u, threads);
+    m_threads.reserve(threads);
+    for (uint32_t i = 0; i < threads; ++i)
+        m_threads.emplace_back(&IoThreads::Run, this);
+}
+
+IoThreads::~IoThreads()
+{
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+    m_cvWork.notify_all();
+    for (std::thread& t : m_threads)
+        t.join();
+}
+
+void IoThreads::Submit(std::function<void()> op)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_cvDone.wait(lock, [&]() { return m_inFlight < m_depth; });
+        ++m_inFlight;
+        m_maxInFlight = std::max(m_maxInFlight, m_inFlight);
+        m_ops.push_back(std::move(op));
+    }
+    m_cvWork.notify_one();
+}
+
+void IoThreads::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_cvDone.wait(lock, [&]() { return m_inFlight == 0; });
+}
+
+uint32_t IoThreads::MaxInFlight()
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_maxInFlight;
+}
+
+void IoThreads::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_cvWork.wait(lock, [&]() { return m_stop || !m_ops.empty(); });
+        if (m_ops.empty()) break;   // m_stop i kolejka pusta
+
+        std::function<void()> op = std::move(m_ops.front());
+        m_ops.pop_front();
+        lock.unlock();
+        // Operacja sama zgłasza swoje błędy (FileReadAhead, zapis w potoku);
+        // wyjątek nie może zatrzymać wątku I/O.
+        try {
+            op();
+        }
+        catch (...) {
+        }
+        op = nullptr;
+        lock.lock();
+
+        --m_inFlight;
+        m_cvDone.notify_all();
+    }
+}
+
+// ============================================================
+// FileReadAhead
+// ============================================================
+FileReadAhead::FileReadAhead(IoThreads& io, const std::vector<std::filesystem::path>& paths)
+    : m_io(io), m_paths(paths), m_slots(paths.size())
+{
+}
+
+void FileReadAhead::PrefetchUpTo(size_t end)
+{
+    size_t first = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        end = std::min(end, m_paths.size());
+        if (end <= m_next) return;
+        first = m_next;
+        m_next = end;
+    }
+
+    for (size_t idx = first; idx < end; ++idx) {
+        m_io.Submit([this, idx]() {
+            std::vector<uint8_t> bytes;
+            bool ok = false;
+            try {
+                ok = ReadFileBytes(m_paths[idx], bytes);
+            }
+            catch (const std::bad_alloc&) {
+                bytes.clear();
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mtx);
+                m_slots[idx].bytes.swap(bytes);
+                m_slots[idx].ok = ok;
+                m_slots[idx].done = true;
+            }
+            m_cv.notify_all();
+            });
+    }
+}
+
+bool FileReadAhead::Take(size_t idx, std::vector<uint8_t>& bytes)
+{
+    PrefetchUpTo(idx + 1);
+
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_cv.wait(lock, [&]() { return m_slots[idx].done; });
+    bytes.swap(m_slots[idx].bytes);
+    std::vector<uint8_t>().swap(m_slots[idx].bytes);
+    return m_slots[idx].ok;
+}
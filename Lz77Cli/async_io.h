@@ -0,0 +1,99 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#pragma once
+
+// ============================================================
+// Asynchroniczne I/O narzędzia lz77img (--io async) — przenośny odpowiednik
+// portu IOCP z Logic.dll (LOGIC_IO_ASYNC) na zwykłych wątkach: operacje
+// plikowe są blokujące, ale wykonują je osobne wątki I/O, a nie wątki
+// robocze ani wątek wywołujący. Bez io_uring — nie wymaga liburing ani
+// jądra z jego obsługą, działa też pod Windows.
+// ============================================================
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Liczba wątków I/O i domyślna głębokość kolejki (--io-depth 0) — wartości
+// zgodne z LOGIC_IO_THREADS / LOGIC_IO_DEFAULT_QUEUE_DEPTH z logic.h.
+static const uint32_t LZ77_IO_THREADS = 4;
+static const uint32_t LZ77_IO_DEFAULT_QUEUE_DEPTH = 32;
+
+// ============================================================
+// IoThreads — pula wątków I/O wykonujących operacje zgłoszone przez Submit.
+// W toku (zgłoszonych i niezakończonych) jest najwyżej queueDepth operacji —
+// Submit czeka na miejsce, jak zgłoszenie przy pełnej kolejce portu IOCP.
+// Destruktor czeka na zakończenie zgłoszonych operacji.
+// Operacje nie mogą same wywoływać Submit ani na siebie czekać.
+// ============================================================
+class IoThreads {
+public:
+    IoThreads(uint32_t threads, uint32_t queueDepth);
+    ~IoThreads();
+
+    IoThreads(const IoThreads&) = delete;
+    IoThreads& operator=(const IoThreads&) = delete;
+
+    void Submit(std::function<void()> op);
+
+    // Oczekiwanie na zakończenie wszystkich zgłoszonych operacji.
+    void Wait();
+
+    uint32_t QueueDepth() const { return m_depth; }
+    uint32_t MaxInFlight();
+
+private:
+    void Run();
+
+    std::mutex              m_mtx;
+    std::condition_variable m_cvWork;    // nowa operacja lub zatrzymanie
+    std::condition_variable m_cvDone;    // zakończona operacja (miejsce w kolejce)
+    std::deque<std::function<void()>> m_ops;
+    std::vector<std::thread> m_threads;
+    uint32_t m_depth = 1;
+    uint32_t m_inFlight = 0;
+    uint32_t m_maxInFlight = 0;
+    bool     m_stop = false;
+};
+
+// ============================================================
+// FileReadAhead — odczyt plików wejściowych z wyprzedzeniem przez IoThreads
+// (jak prefetchUpTo w StartCompressionEx): PrefetchUpTo(end) zgłasza odczyt
+// kolejnych niezgłoszonych plików o indeksach < end, Take(idx) czeka na
+// odczyt pliku idx i przekazuje jego zawartość (false — błąd odczytu).
+// Każdy plik pobierany jest najwyżej raz. Obiekt musi żyć do zakończenia
+// zgłoszonych odczytów (IoThreads::Wait).
+// ============================================================
+class FileReadAhead {
+public:
+    FileReadAhead(IoThreads& io, const std::vector<std::filesystem::path>& paths);
+
+    void PrefetchUpTo(size_t end);
+    bool Take(size_t idx, std::vector<uint8_t>& bytes);
+
+private:
+    struct Slot {
+        bool                 done = false;
+        bool                 ok = false;
+        std::vector<uint8_t> bytes;
+    };
+
+    IoThreads&              m_io;
+    const std::vector<std::filesystem::path>& m_paths;
+    std::mutex              m_mtx;
+    std::condition_variable m_cv;
+    std::vector<Slot>       m_slots;
+    size_t                  m_next = 0;   // pierwszy niezgłoszony plik
+};
@@ -0,0 +1,304 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#include "image_io.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+
+ImageFormat ImageFormatFromPath(const std::filesystem::path& path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+        [](unsigned char c) { return static_cast<char>(tolower(c)); });
+
+    if (ext == ".ppm") return ImageFormat::Ppm;
+    if (ext == ".pam") return ImageFormat::Pam;
+    if (ext == ".rgba" || ext == ".raw") return ImageFormat::Raw;
+    return ImageFormat::Unknown;
+}
+
+// Odczyt całego pliku do pamięci.
+bool ReadFileBytes(const std::filesystem::path& path, std::vector<uint8_t>& bytes)
+{
+#ifdef _WIN32
+    FILE* f = _wfopen(path.c_str(), L"rb");
+#else
+    FILE* f = fopen(path.c_str(), "rb");
+#endif
+    if (!f) return false;
+
+    bytes.clear();
+    uint8_t chunk[1 << 16];
+    size_t n = 0;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        bytes.insert(bytes.end(), chunk, chunk + n);
+
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+// ============================================================
+// Tokenizer nagłówka PPM: słowa rozdzielone białymi znakami,
+// komentarze od '#' do końca wiersza.
+// ============================================================
+static bool NextPnmToken(const std::vector<uint8_t>& bytes, size_t& pos, std::string& token)
+{
+    token.clear();
+    while (pos < bytes.size()) {
+        if (bytes[pos] == '#') {
+            while (pos < bytes.size() && bytes[pos] != '\n') ++pos;
+        }
+        else if (isspace(bytes[pos])) {
+            ++pos;
+        }
+        else {
+            break;
+        }
+    }
+    while (pos < bytes.size() && !isspace(bytes[pos]) && bytes[pos] != '#')
+        token += static_cast<char>(bytes[pos++]);
+    return !token.empty();
+}
+
+// Liczba dziesiętna z zakresu 1..0xFFFFFFFF.
+static bool ParseDimension(const std::string& token, uint32_t& value)
+{
+    if (token.empty() || token.size() > 10 ||
+        !std::all_of(token.begin(), token.end(), [](char c) { return c >= '0' && c <= '9'; }))
+        return false;
+    unsigned long long v = std::stoull(token);
+    if (v == 0 || v > 0xFFFFFFFFull) return false;
+    value = static_cast<uint32_t>(v);
+    return true;
+}
+
+static inline uint32_t PackArgb(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    return (static_cast<uint32_t>(a) << 24) | (static_cast<uint32_t>(r) << 16) |
+        (static_cast<uint32_t>(g) << 8) | b;
+}
+
+// ============================================================
+// Rozpakowanie pikseli o 'depth' kanałach (3 = RGB, 4 = RGBA) od pozycji pos.
+// ============================================================
+static bool UnpackPixels(const std::vector<uint8_t>& bytes, size_t pos, uint32_t depth,
+    uint32_t width, uint32_t height, std::vector<uint32_t>& pixels, std::string& error)
+{
+    uint64_t count = static_cast<uint64_t>(width) * height;
+    if (bytes.size() < pos || (bytes.size() - pos) / depth < count) {
+        error = "plik krotszy niz wynika z wymiarow obrazu";
+        return false;
+    }
+
+    pixels.resize(static_cast<size_t>(count));
+    const uint8_t* src = bytes.data() + pos;
+    for (size_t i = 0; i < pixels.size(); ++i, src += depth)
+        pixels[i] = PackArgb(src[0], src[1], src[2], depth == 4 ? src[3] : 0xFF);
+    return true;
+}
+
+static bool LoadPpm(const std::vector<uint8_t>& bytes, std::vector<uint32_t>& pixels,
+    uint32_t& width, uint32_t& height, std::string& error)
+{
+    size_t pos = 0;
+    std::string magic, w, h, maxval;
+    if (!NextPnmToken(bytes, pos, magic) || magic != "P6") {
+        error = "obslugiwany jest tylko binarny PPM (P6)";
+        return false;
+    }
+    if (!NextPnmToken(bytes, pos, w) || !NextPnmToken(bytes, pos, h) || !NextPnmToken(bytes, pos, maxval) ||
+        !ParseDimension(w, width) || !ParseDimension(h, height)) {
+        error = "niepoprawny naglowek PPM";
+        return false;
+    }
+    if (maxval != "255") {
+        error = "obslugiwany jest tylko MAXVAL 255";
+        return false;
+    }
+    // Po MAXVAL dokładnie jeden biały znak, potem dane.
+    return UnpackPixels(bytes, pos + 1, 3, width, height, pixels, error);
+}
+
+// ============================================================
+// PAM: wiersze "KLUCZ wartość" aż do ENDHDR; wymagane WIDTH, HEIGHT, DEPTH, MAXVAL.
+// ============================================================
+static bool LoadPam(const std::vector<uint8_t>& bytes, std::vector<uint32_t>& pixels,
+    uint32_t& width, uint32_t& height, std::string& error)
+{
+    size_t pos = 0;
+    std::string token;
+    if (!NextPnmToken(bytes, pos, token) || token != "P7") {
+        error = "niepoprawny naglowek PAM";
+        return false;
+    }
+
+    uint32_t depth = 0;
+    std::string maxval;
+    width = height = 0;
+    while (true) {
+        if (!NextPnmToken(bytes, pos, token)) {
+            error = "brak ENDHDR w naglowku PAM";
+            return false;
+        }
+        if (token == "ENDHDR") break;
+
+        // Wartość klucza to reszta wiersza (TUPLTYPE może mieć kilka słów).
+        std::string value;
+        while (pos < bytes.size() && bytes[pos] != '\n') value += static_cast<char>(bytes[pos++]);
+        value.erase(0, value.find_first_not_of(" \t\r"));
+        value.erase(value.find_last_not_of(" \t\r") + 1);
+
+        if (token == "WIDTH" && !ParseDimension(value, width)) width = 0;
+        else if (token == "HEIGHT" && !ParseDimension(value, height)) height = 0;
+        else if (token == "DEPTH" && !ParseDimension(value, depth)) depth = 0;
+        else if (token == "MAXVAL") maxval = value;
+    }
+
+    if (width == 0 || height == 0 || (depth != 3 && depth != 4)) {
+        error = "PAM: wymagane WIDTH, HEIGHT i DEPTH 3 lub 4";
+        return false;
+    }
+    if (maxval != "255") {
+        error = "obslugiwany jest tylko MAXVAL 255";
+        return false;
+    }
+    // ENDHDR kończy się znakiem nowej linii, po którym zaczynają się dane.
+    while (pos < bytes.size() && bytes[pos] != '\n') ++pos;
+    return UnpackPixels(bytes, pos + 1, depth, width, height, pixels, error);
+}
+
+// ============================================================
+// Format pliku wejściowego według rozszerzenia; Raw wymaga wymiarów (--size).
+// ============================================================
+static bool CheckLoadFormat(const std::filesystem::path& path,
+    uint32_t rawWidth,
+    uint32_t rawHeight,
+    ImageFormat& format,
+    std::string& error)
+{
+    format = ImageFormatFromPath(path);
+    if (format == ImageFormat::Unknown) {
+        error = "nieobslugiwane rozszerzenie pliku";
+        return false;
+    }
+    if (format == ImageFormat::Raw && (rawWidth == 0 || rawHeight == 0)) {
+        error = "plik surowy RGBA wymaga opcji --size SZERxWYS";
+        return false;
+    }
+    return true;
+}
+
+// ============================================================
+// Dekodowanie zawartości pliku w formacie sprawdzonym przez CheckLoadFormat.
+// ============================================================
+static bool DecodeImage(ImageFormat format,
+    const std::vector<uint8_t>& bytes,
+    uint32_t rawWidth,
+    uint32_t rawHeight,
+    std::vector<uint32_t>& pixels,
+    uint32_t& width,
+    uint32_t& height,
+    std::string& error)
+{
+    if (format == ImageFormat::Ppm) return LoadPpm(bytes, pixels, width, height, error);
+    if (format == ImageFormat::Pam) return LoadPam(bytes, pixels, width, height, error);
+
+    width = rawWidth;
+    height = rawHeight;
+    if (bytes.size() != static_cast<uint64_t>(width) * height * 4u) {
+        error = "rozmiar pliku surowego nie zgadza sie z --size";
+        return false;
+    }
+    return UnpackPixels(bytes, 0, 4, width, height, pixels, error);
+}
+
+bool LoadImageFile(const std::filesystem::path& path,
+    uint32_t rawWidth,
+    uint32_t rawHeight,
+    std::vector<uint32_t>& pixels,
+    uint32_t& width,
+    uint32_t& height,
+    std::string& error)
+{
+    ImageFormat format = ImageFormat::Unknown;
+    if (!CheckLoadFormat(path, rawWidth, rawHeight, format, error))
+        return false;
+
+    std::vector<uint8_t> bytes;
+    if (!ReadFileBytes(path, bytes)) {
+        error = "nie mozna odczytac pliku";
+        return false;
+    }
+    return DecodeImage(format, bytes, rawWidth, rawHeight, pixels, width, height, error);
+}
+
+bool LoadImageBytes(const std::filesystem::path& path,
+    const std::vector<uint8_t>& bytes,
+    uint32_t rawWidth,
+    uint32_t rawHeight,
+    std::vector<uint32_t>& pixels,
+    uint32_t& width,
+    uint32_t& height,
+    std::string& error)
+{
+    ImageFormat format = ImageFormat::Unknown;
+    if (!CheckLoadFormat(path, rawWidth, rawHeight, format, error))
+        return false;
+    return DecodeImage(format, bytes, rawWidth, rawHeight, pixels, width, height, error);
+}
+
+bool SaveImageFile(const std::filesystem::path& path,
+    ImageFormat format,
+    const std::vector<uint32_t>& pixels,
+    uint32_t width,
+    uint32_t height)
+{
+    std::string header;
+    uint32_t depth = 4;
+    if (format == ImageFormat::Ppm) {
+        header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+        depth = 3;
+    }
+    else if (format == ImageFormat::Pam) {
+        header = "P7\nWIDTH " + std::to_string(width) + "\nHEIGHT " + std::to_string(height) +
+            "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+    }
+    else if (format != ImageFormat::Raw) {
+        return false;
+    }
+
+    // Konwersja 0xAARRGGBB -> R,G,B[,A] wierszami, aby nie kopiować całego obrazu naraz.
+    std::vector<uint8_t> row(static_cast<size_t>(width) * depth);
+
+#ifdef _WIN32
+    FILE* f = _wfopen(path.c_str(), L"wb");
+#else
+    FILE* f = fopen(path.c_str(), "wb");
+#endif
+    if (!f) return false;
+
+    bool ok = fwrite(header.data(), 1, header.size(), f) == header.size();
+    for (uint32_t y = 0; ok && y < height; ++y) {
+        const uint32_t* src = pixels.data() + static_cast<size_t>(y) * width;
+        uint8_t* dst = row.data();
+        for (uint32_t x = 0; x < width; ++x, dst += depth) {
+            dst[0] = static_cast<uint8_t>(src[x] >> 16);
+            dst[1] = static_cast<uint8_t>(src[x] >> 8);
+            dst[2] = static_cast<uint8_t>(src[x]);
+            if (depth == 4) dst[3] = static_cast<uint8_t>(src[x] >> 24);
+        }
+        ok = fwrite(row.data(), 1, row.size(), f) == row.size();
+    }
+
+    ok = (fclose(f) == 0) && ok;
+    return ok;
+}
\ No newline at end of file
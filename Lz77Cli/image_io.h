@@ -0,0 +1,69 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#pragma once
+
+// ============================================================
+// Odczyt i zapis obrazów bez GDI+ — formaty obsługiwane przez lz77img:
+//   .ppm          — PPM binarny (P6), MAXVAL 255; alfa = 255
+//   .pam          — PAM (P7), DEPTH 3 (RGB) lub 4 (RGB_ALPHA), MAXVAL 255
+//   .rgba / .raw  — surowe piksele R,G,B,A (4 bajty na piksel); wymiary
+//                   muszą być podane osobno (opcja --size)
+//
+// WAŻNE: Piksele w pamięci mają układ uint32_t 0xAARRGGBB — identyczny
+// z PixelFormat32bppARGB z GDI+, którego używa Logic.dll. Dzięki temu plik
+// .lz77 zapisany pod Linuksem dekompresuje się pod Windows do tego samego
+// obrazu (i odwrotnie).
+// ============================================================
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+enum class ImageFormat {
+    Unknown,
+    Ppm,
+    Pam,
+    Raw
+};
+
+// Format według rozszerzenia pliku (wielkość liter bez znaczenia).
+ImageFormat ImageFormatFromPath(const std::filesystem::path& path);
+
+// Wczytanie obrazu. rawWidth / rawHeight — wymiary dla formatu Raw (ignorowane
+// dla PPM/PAM). Przy błędzie zwraca false i opis w 'error'.
+bool LoadImageFile(const std::filesystem::path& path,
+    uint32_t rawWidth,
+    uint32_t rawHeight,
+    std::vector<uint32_t>& pixels,
+    uint32_t& width,
+    uint32_t& height,
+    std::string& error);
+
+// Jak LoadImageFile, ale z zawartością pliku odczytaną wcześniej (ReadFileBytes)
+// — dla odczytu z wyprzedzeniem na wątkach I/O. 'path' wyznacza tylko format.
+bool LoadImageBytes(const std::filesystem::path& path,
+    const std::vector<uint8_t>& bytes,
+    uint32_t rawWidth,
+    uint32_t rawHeight,
+    std::vector<uint32_t>& pixels,
+    uint32_t& width,
+    uint32_t& height,
+    std::string& error);
+
+// Odczyt całego pliku do pamięci (bez interpretacji zawartości).
+bool ReadFileBytes(const std::filesystem::path& path, std::vector<uint8_t>& bytes);
+
+// Zapis obrazu w podanym formacie (PPM traci kanał alfa).
+bool SaveImageFile(const std::filesystem::path& path,
+    ImageFormat format,
+    const std::vector<uint32_t>& pixels,
+    uint32_t width,
+    uint32_t height);
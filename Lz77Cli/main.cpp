@@ -0,0 +1,438 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// lz77img — narzędzie wiersza poleceń (bez GDI+ i WinAPI) do kompresji
+// obrazów do plików .lz77 i ich dekompresji. Przeznaczone do pracy wsadowej
+// (np. serwery Linux): wynik sygnalizowany kodem wyjścia, statystyki
+// w formacie tekstowym lub JSON na stdout, komunikaty na stderr.
+//
+// Kody wyjścia:
+//   0 — wszystkie pliki przetworzone poprawnie
+//   1 — co najmniej jeden plik zakończył się błędem
+//   2 — niepoprawne argumenty wywołania
+//   3 — brak plików wejściowych lub nie można utworzyć katalogu wyjściowego
+// ============================================================
+
+#include "pipeline.h"
+#include "lz77_container.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const int EXIT_OK = 0;
+static const int EXIT_FILE_ERRORS = 1;
+static const int EXIT_USAGE = 2;
+static const int EXIT_IO = 3;
+
+enum class StatsMode {
+    None,
+    Text,
+    Json
+};
+
+static void PrintUsage(FILE* out)
+{
+    fputs(
+        "Uzycie:\n"
+        "  lz77img compress   [opcje] -o KATALOG WEJSCIE...\n"
+        "  lz77img decompress [opcje] -o KATALOG WEJSCIE...\n"
+        "\n"
+        "WEJSCIE to plik lub katalog. Kompresja: .ppm (P6), .pam (P7), .rgba/.raw;\n"
+        "dekompresja: .lz77.\n"
+        "\n"
+        "Opcje:\n"
+        "  -o, --output KATALOG     katalog wyjsciowy (tworzony w razie potrzeby)\n"
+        "  -t, --threads N          liczba watkow (domyslnie liczba rdzeni)\n"
+        "      --block-pixels N     pikseli na blok; 0 = domyslnie, 'none' = bez podzialu\n"
+        "      --in-flight N        maks. liczba obrazow w pamieci; 0 = 2 na watek\n"
+        "      --level N            poziom kompresji 1..5 (1 = fast .. 5 = ultra);\n"
+        "                           domyslnie format zgodny z poziomem 2 bez zapisu parametrow\n"
+        "      --parse greedy|lazy|lazy2|optimal\n"
+        "                           wybor dopasowan (domyslnie wg poziomu); format bez zmian\n"
+        "      --finder chain|bucket\n"
+        "                           wyszukiwanie dopasowan: lancuchy hash (domyslnie) lub\n"
+        "                           kubelki z odciskami pikseli; format bez zmian\n"
+        "      --filter none|sub|up|avg|paeth|adaptive\n"
+        "                           filtr wierszy przed kompresja (adaptive = wybor dla\n"
+        "                           kazdego wiersza); zapisywany w pliku\n"
+        "      --color none|ycocg   transformacja kolorow YCoCg-R (bezstratna) przed kompresja\n"
+        "      --entropy none|huffman\n"
+        "                           kodowanie entropijne tokenow (kody Huffmana) po kompresji\n"
+        "      --size SZERxWYS      wymiary plikow surowych .rgba/.raw\n"
+        "      --format pam|ppm|rgba  format obrazow po dekompresji (domyslnie pam)\n"
+        "      --io sync|async      zapis plikow na watku glownym (domyslnie) lub na\n"
+        "                           watkach I/O z odczytem wejscia z wyprzedzeniem\n"
+        "      --io-depth N         maks. operacji I/O w toku przy --io async;\n"
+        "                           0 = 32\n"
+        "      --stats text|json|none statystyki na stdout (domyslnie text)\n"
+        "  -q, --quiet              bez komunikatow o kolejnych plikach\n"
+        "  -h, --help               ta pomoc\n"
+        "\n"
+        "Kody wyjscia: 0 = OK, 1 = bledy plikow, 2 = bledne argumenty,\n"
+        "              3 = brak wejscia lub katalogu wyjsciowego\n",
+        out);
+}
+
+// Liczba dziesiętna bez znaku mieszcząca się w uint32_t.
+static bool ParseU32(const char* text, uint32_t& value)
+{
+    if (!text || !*text || strlen(text) > 10) return false;
+    for (const char* p = text; *p; ++p)
+        if (*p < '0' || *p > '9') return false;
+    unsigned long long v = strtoull(text, nullptr, 10);
+    if (v > 0xFFFFFFFFull) return false;
+    value = static_cast<uint32_t>(v);
+    return true;
+}
+
+// Rozwinięcie argumentów: pliki brane wprost, z katalogów — pliki o pasującym
+// rozszerzeniu (posortowane, aby kolejność była powtarzalna).
+static bool CollectInputs(const std::vector<std::string>& args, bool compress,
+    std::vector<fs::path>& inputs)
+{
+    auto accepted = [compress](const fs::path& p) {
+        if (compress) return ImageFormatFromPath(p) != ImageFormat::Unknown;
+        std::string ext = p.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(),
+            [](unsigned char c) { return static_cast<char>(tolower(c)); });
+        return ext == ".lz77";
+        };
+
+    std::error_code ec;
+    for (const std::string& arg : args) {
+        fs::path p(arg);
+        if (fs::is_directory(p, ec)) {
+            std::vector<fs::path> found;
+            for (auto& entry : fs::directory_iterator(p, ec))
+                if (entry.is_regular_file(ec) && accepted(entry.path()))
+                    found.push_back(entry.path());
+            std::sort(found.begin(), found.end());
+            inputs.insert(inputs.end(), found.begin(), found.end());
+        }
+        else if (fs::is_regular_file(p, ec)) {
+            inputs.push_back(p);
+        }
+        else {
+            fprintf(stderr, "Brak pliku lub katalogu: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Łańcuch w cudzysłowach z ucieczką znaków wymaganą przez JSON.
+static std::string JsonString(const std::string& s)
+{
+    std::string out = "\"";
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += static_cast<char>(c); }
+        else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }
+        else out += static_cast<char>(c);
+    }
+    return out + "\"";
+}
+
+static void PrintStats(StatsMode mode, bool compress, const RunStats& stats)
+{
+    uint64_t inBytes = 0, outBytes = 0, pixels = 0;
+    size_t failed = 0;
+    for (const FileStats& f : stats.files) {
+        if (!f.ok) { ++failed; continue; }
+        inBytes += f.inputBytes;
+        outBytes += f.outputBytes;
+        pixels += static_cast<uint64_t>(f.width) * f.height;
+    }
+
+    double codecSec = stats.codecUs / 1e6;
+    double mbPerSec = codecSec > 0 ? (compress ? inBytes : outBytes) / 1e6 / codecSec : 0.0;
+    double mpixPerSec = codecSec > 0 ? pixels / 1e6 / codecSec : 0.0;
+    double ratio = inBytes ? static_cast<double>(compress ? outBytes : inBytes) /
+        static_cast<double>(compress ? inBytes : outBytes) : 0.0;
+
+    if (mode == StatsMode::Text) {
+        printf("--- %s zakonczona ---\n", compress ? "Kompresja" : "Dekompresja");
+        printf("Plikow: %zu  |  Bledow: %zu  |  Blokow: %zu  |  Watkow: %d  |  W obiegu: %u\n",
+            stats.files.size(), failed, stats.blocks, stats.threads, stats.maxInFlight);
+        printf("Czas algorytmu LZ77: %.3f ms  |  Czas calkowity: %.3f ms\n",
+            stats.codecUs / 1e3, stats.totalUs / 1e3);
+        if (stats.asyncIo)
+            printf("I/O: async  |  Glebokosc kolejki: %u  |  Maks. operacji w toku: %u\n",
+                stats.ioQueueDepth, stats.ioMaxInFlight);
+        else
+            printf("I/O: sync\n");
+        printf("Wejscie: %llu B  |  Wyjscie: %llu B  |  Stopien kompresji: %.4f  |  %.1f MB/s  |  %.1f Mpx/s\n",
+            static_cast<unsigned long long>(inBytes), static_cast<unsigned long long>(outBytes),
+            ratio, mbPerSec, mpixPerSec);
+        return;
+    }
+
+    if (mode != StatsMode::Json) return;
+
+    printf("{\"mode\":\"%s\",\"files\":%zu,\"failed\":%zu,\"blocks\":%zu,\"threads\":%d,"
+        "\"in_flight\":%u,\"io\":\"%s\",\"io_queue_depth\":%u,\"io_max_in_flight\":%u,\"codec_us\":%lld,\"total_us\":%lld,\"input_bytes\":%llu,"
+        "\"output_bytes\":%llu,\"pixels\":%llu,\"ratio\":%.6f,\"mb_per_s\":%.3f,"
+        "\"mpix_per_s\":%.3f,\"items\":[",
+        compress ? "compress" : "decompress", stats.files.size(), failed, stats.blocks,
+        stats.threads, stats.maxInFlight, stats.asyncIo ? "async" : "sync",
+        stats.ioQueueDepth, stats.ioMaxInFlight,
+        static_cast<long long>(stats.codecUs), static_cast<long long>(stats.totalUs),
+        static_cast<unsigned long long>(inBytes), static_cast<unsigned long long>(outBytes),
+        static_cast<unsigned long long>(pixels), ratio, mbPerSec, mpixPerSec);
+
+    for (size_t i = 0; i < stats.files.size(); ++i) {
+        const FileStats& f = stats.files[i];
+        printf("%s{\"name\":%s,\"ok\":%s,\"width\":%u,\"height\":%u,\"blocks\":%u,"
+            "\"input_bytes\":%llu,\"output_bytes\":%llu",
+            i ? "," : "", JsonString(f.name).c_str(), f.ok ? "true" : "false",
+            f.width, f.height, f.blocks,
+            static_cast<unsigned long long>(f.inputBytes), static_cast<unsigned long long>(f.outputBytes));
+        if (!f.ok) printf(",\"error\":%s", JsonString(f.error).c_str());
+        printf("}");
+    }
+    printf("]}\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        PrintUsage(stderr);
+        return EXIT_USAGE;
+    }
+
+    std::string command = argv[1];
+    if (command == "-h" || command == "--help") {
+        PrintUsage(stdout);
+        return EXIT_OK;
+    }
+    if (command != "compress" && command != "decompress") {
+        fprintf(stderr, "Nieznane polecenie: %s\n", command.c_str());
+        PrintUsage(stderr);
+        return EXIT_USAGE;
+    }
+    bool compress = (command == "compress");
+
+    CliOptions options;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    StatsMode statsMode = StatsMode::Text;
+    std::vector<std::string> positional;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        uint32_t n = 0;
+
+        // Opcje z wartością zużywają kolejny argument.
+        auto needValue = [&]() {
+            if (!value) {
+                fprintf(stderr, "Brak wartosci dla opcji %s\n", arg.c_str());
+                return false;
+            }
+            ++i;
+            return true;
+            };
+
+        if (arg == "-h" || arg == "--help") {
+            PrintUsage(stdout);
+            return EXIT_OK;
+        }
+        else if (arg == "-q" || arg == "--quiet") {
+            options.quiet = true;
+        }
+        else if (arg == "-o" || arg == "--output") {
+            if (!needValue()) return EXIT_USAGE;
+            options.outputDir = value;
+        }
+        else if (arg == "-t" || arg == "--threads") {
+            if (!needValue() || !ParseU32(value, n) || n == 0 || n > 1024) {
+                fprintf(stderr, "Niepoprawna liczba watkow\n");
+                return EXIT_USAGE;
+            }
+            options.threads = static_cast<int>(n);
+        }
+        else if (arg == "--block-pixels") {
+            if (!needValue()) return EXIT_USAGE;
+            if (strcmp(value, "none") == 0) options.blockPixels = 0xFFFFFFFFu;
+            else if (ParseU32(value, n)) options.blockPixels = n;
+            else {
+                fprintf(stderr, "Niepoprawna wartosc --block-pixels\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (arg == "--in-flight") {
+            if (!needValue() || !ParseU32(value, n)) {
+                fprintf(stderr, "Niepoprawna wartosc --in-flight\n");
+                return EXIT_USAGE;
+            }
+            options.maxInFlight = n;
+        }
+        else if (arg == "--level") {
+            if (!needValue() || !ParseU32(value, n) ||
+                n < static_cast<uint32_t>(LZ77_LEVEL_MIN) || n > static_cast<uint32_t>(LZ77_LEVEL_MAX)) {
+                fprintf(stderr, "Niepoprawna wartosc --level (1..5)\n");
+                return EXIT_USAGE;
+            }
+            options.level = static_cast<int>(n);
+        }
+        else if (arg == "--parse") {
+            if (!needValue()) return EXIT_USAGE;
+            std::string p = value;
+            if (p == "greedy") options.parse = static_cast<int>(LZ77_PARSE_GREEDY);
+            else if (p == "lazy") options.parse = static_cast<int>(LZ77_PARSE_LAZY);
+            else if (p == "lazy2") options.parse = static_cast<int>(LZ77_PARSE_LAZY2);
+            else if (p == "optimal") options.parse = static_cast<int>(LZ77_PARSE_OPTIMAL);
+            else {
+                fprintf(stderr, "Niepoprawna wartosc --parse (greedy|lazy|lazy2|optimal)\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (arg == "--finder") {
+            if (!needValue()) return EXIT_USAGE;
+            std::string f = value;
+            if (f == "chain") options.matchFinder = LZ77_MATCH_FINDER_CHAIN;
+            else if (f == "bucket") options.matchFinder = LZ77_MATCH_FINDER_BUCKET;
+            else {
+                fprintf(stderr, "Niepoprawna wartosc --finder (chain|bucket)\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (arg == "--filter") {
+            if (!needValue()) return EXIT_USAGE;
+            std::string f = value;
+            if (f == "none") options.filter = static_cast<int>(LZ77_FILTER_NONE);
+            else if (f == "sub") options.filter = static_cast<int>(LZ77_FILTER_SUB);
+            else if (f == "up") options.filter = static_cast<int>(LZ77_FILTER_UP);
+            else if (f == "avg") options.filter = static_cast<int>(LZ77_FILTER_AVERAGE);
+            else if (f == "paeth") options.filter = static_cast<int>(LZ77_FILTER_PAETH);
+            else if (f == "adaptive") options.filter = static_cast<int>(LZ77_FILTER_ADAPTIVE);
+            else {
+                fprintf(stderr, "Niepoprawna wartosc --filter (none|sub|up|avg|paeth|adaptive)\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (arg == "--color") {
+            if (!needValue()) return EXIT_USAGE;
+            std::string c = value;
+            if (c == "none") options.transform = LZ77_TRANSFORM_NONE;
+            else if (c == "ycocg") options.transform = LZ77_TRANSFORM_YCOCG_R;
+            else {
+                fprintf(stderr, "Niepoprawna wartosc --color (none|ycocg)\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (arg == "--entropy") {
+            if (!needValue()) return EXIT_USAGE;
+            std::string e = value;
+            if (e == "none") options.entropy = false;
+            else if (e == "huffman") options.entropy = true;
+            else {
+                fprintf(stderr, "Niepoprawna wartosc --entropy (none|huffman)\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (arg == "--io") {
+            if (!needValue()) return EXIT_USAGE;
+            std::string m = value;
+            if (m == "sync") options.asyncIo = false;
+            else if (m == "async") options.asyncIo = true;
+            else {
+                fprintf(stderr, "Niepoprawna wartosc --io (sync|async)\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (arg == "--io-depth") {
+            if (!needValue() || !ParseU32(value, n) || n > 4096) {
+                fprintf(stderr, "Niepoprawna wartosc --io-depth (0..4096)\n");
+                return EXIT_USAGE;
+            }
+            options.ioQueueDepth = n;
+        }
+        else if (arg == "--size") {
+            if (!needValue()) return EXIT_USAGE;
+            std::string s = value;
+            size_t x = s.find_first_of("xX");
+            uint32_t w = 0, h = 0;
+            if (x == std::string::npos || !ParseU32(s.substr(0, x).c_str(), w) ||
+                !ParseU32(s.substr(x + 1).c_str(), h) || w == 0 || h == 0) {
+                fprintf(stderr, "Niepoprawna wartosc --size (oczekiwano SZERxWYS)\n");
+                return EXIT_USAGE;
+            }
+            options.rawWidth = w;
+            options.rawHeight = h;
+        }
+        else if (arg == "--format") {
+            if (!needValue()) return EXIT_USAGE;
+            std::string f = value;
+            if (f == "pam") options.outFormat = ImageFormat::Pam;
+            else if (f == "ppm") options.outFormat = ImageFormat::Ppm;
+            else if (f == "rgba" || f == "raw") options.outFormat = ImageFormat::Raw;
+            else {
+                fprintf(stderr, "Nieznany format: %s\n", value);
+                return EXIT_USAGE;
+            }
+        }
+        else if (arg == "--stats") {
+            if (!needValue()) return EXIT_USAGE;
+            std::string m = value;
+            if (m == "text") statsMode = StatsMode::Text;
+            else if (m == "json") statsMode = StatsMode::Json;
+            else if (m == "none") statsMode = StatsMode::None;
+            else {
+                fprintf(stderr, "Nieznany tryb statystyk: %s\n", value);
+                return EXIT_USAGE;
+            }
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            fprintf(stderr, "Nieznana opcja: %s\n", arg.c_str());
+            return EXIT_USAGE;
+        }
+        else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (options.outputDir.empty() || positional.empty()) {
+        fprintf(stderr, "Wymagane: -o KATALOG oraz co najmniej jedno WEJSCIE\n");
+        return EXIT_USAGE;
+    }
+
+    std::vector<fs::path> inputs;
+    if (!CollectInputs(positional, compress, inputs))
+        return EXIT_IO;
+    if (inputs.empty()) {
+        fprintf(stderr, "Brak plikow wejsciowych\n");
+        return EXIT_IO;
+    }
+
+    std::error_code ec;
+    fs::create_directories(options.outputDir, ec);
+    if (!fs::is_directory(options.outputDir, ec)) {
+        fprintf(stderr, "Nie mozna utworzyc katalogu: %s\n", options.outputDir.string().c_str());
+        return EXIT_IO;
+    }
+
+    RunStats stats;
+    if (compress) RunCompression(options, inputs, stats);
+    else          RunDecompression(options, inputs, stats);
+
+    PrintStats(statsMode, compress, stats);
+
+    bool anyFailed = std::any_of(stats.files.begin(), stats.files.end(),
+        [](const FileStats& f) { return !f.ok; });
+    return anyFailed ? EXIT_FILE_ERRORS : EXIT_OK;
+}
\ No newline at end of file
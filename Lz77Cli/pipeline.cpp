@@ -0,0 +1,486 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#include "pipeline.h"
+#include "async_io.h"
+#include "lz77.h"
+#include "lz77_container.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// ============================================================
+// RunPipeline — wspólny szkielet potoku dla obu trybów.
+//
+// Task musi mieć pole 'uint32_t blocksLeft' — ustawiane przez load() na
+// liczbę bloków (0 = plik niewczytany, od razu do zapisu/raportu).
+//   load(idx)               — wczytanie pliku (wątek roboczy, bez muteksu)
+//   runBlock(task, b, work) — przetworzenie bloku b (wątek roboczy, bez muteksu);
+//                             work to bufor roboczy wątku (workBytes bajtów;
+//                             0 = pusty) — runBlock może go powiększyć (tablice
+//                             kodera bloku, piksele filtrowanego bloku)
+//   write(task)             — zapis wyniku (wątek wywołujący; z io — wątki I/O,
+//                             kilka plików naraz, stats.files pod muteksem)
+// io — wątki I/O trybu --io async (nullptr = zapis synchroniczny); po powrocie
+// wszystkie zgłoszone operacje są zakończone.
+// Pola RunStats blocks / threads / maxInFlight / codecUs / totalUs / io*
+// wypełniane są tutaj; files — przez write().
+// ============================================================
+template <class Task>
+static void RunPipeline(size_t fileCount,
+    const CliOptions& options,
+    size_t workBytes,
+    const std::function<std::unique_ptr<Task>(size_t)>& load,
+    const std::function<void(Task&, uint32_t, std::vector<uint8_t>&)>& runBlock,
+    const std::function<void(std::unique_ptr<Task>)>& write,
+    IoThreads* io,
+    RunStats& stats)
+{
+    int actualThreads = std::max(1, options.threads);
+    uint32_t maxInFlight = options.maxInFlight;
+    if (maxInFlight == 0)
+        maxInFlight = LZ77_DEFAULT_IN_FLIGHT_PER_THREAD * static_cast<uint32_t>(actualThreads);
+
+    struct Job {
+        Task*    task;
+        uint32_t block;
+    };
+
+    std::mutex              mtx;
+    std::condition_variable cvWork;
+    std::condition_variable cvWrite;
+    std::deque<Job>         blockQueue;
+    std::deque<std::unique_ptr<Task>>  writeQueue;
+    std::vector<std::unique_ptr<Task>> loaded;
+    size_t   nextFile = 0;
+    uint32_t inFlight = 0;
+    int      loading = 0;
+    size_t   totalBlocks = 0;
+
+    int active = 0;
+    std::chrono::steady_clock::time_point activeStart;
+    std::chrono::steady_clock::duration   busy{ 0 };
+
+    // Przekazanie zadania do zapisu — pod muteksem.
+    auto finishTask = [&](Task* task) {
+        auto it = std::find_if(loaded.begin(), loaded.end(),
+            [task](const std::unique_ptr<Task>& p) { return p.get() == task; });
+        writeQueue.push_back(std::move(*it));
+        loaded.erase(it);
+        cvWrite.notify_one();
+        };
+
+    auto worker = [&]() {
+        std::vector<uint8_t> work(workBytes);
+
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            if (!blockQueue.empty()) {
+                Job job = blockQueue.front();
+                blockQueue.pop_front();
+                if (active++ == 0) activeStart = std::chrono::steady_clock::now();
+                lock.unlock();
+
+                runBlock(*job.task, job.block, work);
+
+                lock.lock();
+                if (--active == 0) busy += std::chrono::steady_clock::now() - activeStart;
+                if (--job.task->blocksLeft == 0) finishTask(job.task);
+            }
+            else if (nextFile < fileCount && inFlight < maxInFlight) {
+                size_t idx = nextFile++;
+                ++inFlight;
+                ++loading;
+                lock.unlock();
+
+                std::unique_ptr<Task> task = load(idx);
+
+                lock.lock();
+                --loading;
+                Task* raw = task.get();
+                loaded.push_back(std::move(task));
+                if (raw->blocksLeft > 0) {
+                    for (uint32_t b = 0; b < raw->blocksLeft; ++b)
+                        blockQueue.push_back({ raw, b });
+                    totalBlocks += raw->blocksLeft;
+                    cvWork.notify_all();
+                }
+                else {
+                    finishTask(raw);
+                }
+            }
+            else if (nextFile >= fileCount && loading == 0) {
+                break;
+            }
+            else {
+                cvWork.wait(lock);
+            }
+        }
+        cvWork.notify_all();
+        };
+
+    auto tstart = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    workers.reserve(actualThreads);
+    for (int i = 0; i < actualThreads; ++i)
+        workers.emplace_back(worker);
+
+    for (size_t processed = 0; processed < fileCount; ++processed) {
+        std::unique_ptr<Task> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvWrite.wait(lock, [&]() { return !writeQueue.empty(); });
+            task = std::move(writeQueue.front());
+            writeQueue.pop_front();
+        }
+
+        // Zapis kończy się zwolnieniem miejsca w obiegu — wątki robocze
+        // mogą wczytać kolejny plik.
+        auto release = [&]() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                --inFlight;
+            }
+            cvWork.notify_all();
+            };
+
+        if (!io) {
+            write(std::move(task));
+            release();
+            continue;
+        }
+
+        // std::function wymaga kopiowalnej operacji — zadanie przekazywane
+        // jako wskaźnik, właścicielem staje się write().
+        Task* raw = task.release();
+        io->Submit([&write, release, raw]() {
+            write(std::unique_ptr<Task>(raw));
+            release();
+            });
+    }
+
+    for (auto& t : workers)
+        if (t.joinable()) t.join();
+    if (io) io->Wait();
+
+    auto tend = std::chrono::steady_clock::now();
+
+    stats.blocks = totalBlocks;
+    stats.threads = actualThreads;
+    stats.maxInFlight = maxInFlight;
+    stats.codecUs = std::chrono::duration_cast<std::chrono::microseconds>(busy).count();
+    stats.totalUs = std::chrono::duration_cast<std::chrono::microseconds>(tend - tstart).count();
+    stats.asyncIo = io != nullptr;
+    stats.ioQueueDepth = io ? io->QueueDepth() : 0;
+    stats.ioMaxInFlight = io ? io->MaxInFlight() : 0;
+}
+
+// Komunikat na stderr (pomijany z --quiet).
+static void Log(const CliOptions& options, const std::string& message)
+{
+    if (!options.quiet) fprintf(stderr, "%s\n", message.c_str());
+}
+
+// Wątki I/O trybu --io async (nullptr — zapis synchroniczny).
+static std::unique_ptr<IoThreads> MakeIoThreads(const CliOptions& options)
+{
+    if (!options.asyncIo) return nullptr;
+    uint32_t depth = options.ioQueueDepth ? options.ioQueueDepth : LZ77_IO_DEFAULT_QUEUE_DEPTH;
+    return std::make_unique<IoThreads>(LZ77_IO_THREADS, depth);
+}
+
+// ============================================================
+// RunCompression — obraz -> plik .lz77 (format kompaktowy, bloki pasów wierszy).
+// ============================================================
+void RunCompression(const CliOptions& options,
+    const std::vector<std::filesystem::path>& inputs,
+    RunStats& stats)
+{
+    struct Task {
+        FileStats             st;
+        std::filesystem::path path;
+        std::vector<uint32_t> pixels;
+        uint32_t              blockRows = 0;
+        std::vector<std::vector<uint8_t>> blockDst;
+        std::vector<size_t>   blockLen;
+        Lz77RowFilters        filters;     // rows — filtr każdego wiersza (z --filter / --color)
+        uint32_t              blocksLeft = 0;
+    };
+
+    // Filtry wierszy: --filter bez --color lub sama transformacja kolorów (filtr NONE).
+    bool useFilters = options.filter >= 0 || options.transform != LZ77_TRANSFORM_NONE;
+    uint32_t filter = options.filter >= 0 ? static_cast<uint32_t>(options.filter) : LZ77_FILTER_NONE;
+
+    // --io async: pliki wejściowe czytane z wyprzedzeniem o głębokość kolejki
+    // (jak prefetchUpTo w StartCompressionEx), wątek roboczy tylko dekoduje obraz.
+    std::unique_ptr<IoThreads> io = MakeIoThreads(options);
+    std::unique_ptr<FileReadAhead> readAhead;
+    if (io) readAhead = std::make_unique<FileReadAhead>(*io, inputs);
+
+    auto load = [&](size_t idx) {
+        auto task = std::make_unique<Task>();
+        task->path = inputs[idx];
+        task->st.name = inputs[idx].filename().string();
+        try {
+            bool loaded = false;
+            if (readAhead) {
+                readAhead->PrefetchUpTo(idx + 1 + io->QueueDepth());
+                std::vector<uint8_t> bytes;
+                if (!readAhead->Take(idx, bytes))
+                    task->st.error = "nie mozna odczytac pliku";
+                else
+                    loaded = LoadImageBytes(task->path, bytes, options.rawWidth, options.rawHeight,
+                        task->pixels, task->st.width, task->st.height, task->st.error);
+            }
+            else {
+                loaded = LoadImageFile(task->path, options.rawWidth, options.rawHeight,
+                    task->pixels, task->st.width, task->st.height, task->st.error);
+            }
+            if (!loaded)
+                return task;
+
+            uint32_t w = task->st.width, h = task->st.height;
+            task->blockRows = Lz77BlockRowsFor(w, h, options.blockPixels);
+            uint32_t blockCount = (h + task->blockRows - 1) / task->blockRows;
+
+            task->blockDst.resize(blockCount);
+            task->blockLen.assign(blockCount, 0);
+            for (uint32_t b = 0; b < blockCount; ++b) {
+                uint32_t rows = std::min(task->blockRows, h - b * task->blockRows);
+                size_t bound = Lz77PackedBound(static_cast<size_t>(w) * rows);
+                task->blockDst[b].resize(options.entropy ? lz77_entropy_bound(bound) : bound);
+            }
+            if (useFilters) {
+                task->filters.transform = options.transform;
+                task->filters.rows.assign(h, 0);
+            }
+            task->st.blocks = blockCount;
+            task->st.inputBytes = static_cast<uint64_t>(w) * h * sizeof(uint32_t);
+            task->blocksLeft = blockCount;
+        }
+        catch (const std::bad_alloc&) {
+            task->st.error = "brak pamieci";
+            task->pixels.clear();
+            task->blockDst.clear();
+            task->filters.rows.clear();
+            task->blocksLeft = 0;
+        }
+        return task;
+        };
+
+    // Poziom kompresji: parametry zapisywane w nagłówku; strumień z oknem
+    // i długością dopasowań formatu kompaktowego zachowuje wersję LZ77_FORMAT_PACKED.
+    // --parse bez --level zmienia tylko wybór dopasowań poziomu domyślnego.
+    lz77_params params{};
+    bool useLevel = (options.level != 0 || options.parse >= 0) &&
+        lz77_level_params(options.level != 0 ? options.level : LZ77_LEVEL_DEFAULT, &params) != 0;
+    if (useLevel && options.parse >= 0 && params.parse != static_cast<uint32_t>(options.parse)) {
+        params.parse = static_cast<uint32_t>(options.parse);
+        params.level = 0;
+    }
+    uint16_t version = (useLevel && (params.window_px != LZ77_PACKED_WINDOW_PX ||
+        params.max_match_px != LZ77_PACKED_MAX_MATCH_PX)) ? LZ77_FORMAT_PACKED_EX : LZ77_FORMAT_PACKED;
+    auto runBlock = [&](Task& task, uint32_t b, std::vector<uint8_t>& work) {
+        size_t firstRow = static_cast<size_t>(b) * task.blockRows;
+        size_t rows = std::min<size_t>(task.blockRows, task.st.height - firstRow);
+        size_t count = rows * task.st.width;
+        const uint32_t* src = task.pixels.data() + firstRow * task.st.width;
+
+        // Bufor wątku: tablice kodera (lz77_work_bytes — rosną z blokiem), filtrowany blok
+        // (--filter/--color) i strumień tokenów przed kodowaniem entropijnym (--entropy).
+        // Blok filtrowany jest bez wiersza powyżej, więc bloki dekompresują się niezależnie.
+        size_t workBytes = lz77_work_bytes(count, useLevel ? &params : nullptr);
+        size_t residualBytes = useFilters ? count * sizeof(uint32_t) : 0;
+        size_t tokenBytes = options.entropy ? Lz77PackedBound(count) : 0;
+        try {
+            if (work.size() < workBytes + residualBytes + tokenBytes)
+                work.resize(workBytes + residualBytes + tokenBytes);
+        }
+        catch (const std::bad_alloc&) {
+            task.blockLen[b] = 0;
+            return;
+        }
+        if (useFilters) {
+            uint32_t* residuals = reinterpret_cast<uint32_t*>(work.data() + workBytes);
+            lz77_filter_rows(src, residuals, task.st.width, rows, filter, options.transform,
+                task.filters.rows.data() + firstRow);
+            src = residuals;
+        }
+
+        // Blok to pełne wiersze — koder sprawdza też piksele z wierszy powyżej;
+        // struktura wyszukiwania dopasowań z --finder.
+        uint8_t* tokens = options.entropy ? work.data() + workBytes + residualBytes : task.blockDst[b].data();
+        size_t tokenCap = options.entropy ? tokenBytes : task.blockDst[b].size();
+        size_t tokenLen = 0;
+        lz77_rgba_compress_ex(src, count, task.st.width, tokens, tokenCap,
+            work.data(), workBytes, useLevel ? &params : nullptr, options.matchFinder, &tokenLen, nullptr);
+
+        task.blockLen[b] = tokenLen;
+        if (options.entropy && tokenLen != 0)
+            lz77_entropy_encode(tokens, tokenLen, useLevel ? &params : nullptr,
+                task.blockDst[b].data(), task.blockDst[b].size(), &task.blockLen[b]);
+        };
+
+    std::mutex statsMtx;   // write() z --io async działa na kilku wątkach I/O
+    auto write = [&](std::unique_ptr<Task> task) {
+        FileStats& st = task->st;
+        if (st.error.empty()) {
+            std::vector<Lz77BlockSpan> blocks;
+            for (size_t b = 0; b < task->blockDst.size(); ++b) {
+                if (task->blockLen[b] == 0) st.error = "kompresja zwrocila 0 bajtow";
+                blocks.push_back({ task->blockDst[b].data(), task->blockLen[b] });
+            }
+
+            std::filesystem::path out = options.outputDir / task->path.stem();
+            out += ".lz77";
+            if (st.error.empty() && !Lz77WriteContainer(out, st.width, st.height, version,
+                task->blockRows, blocks, useLevel ? &params : nullptr, useFilters ? &task->filters : nullptr,
+                options.entropy, &st.outputBytes))
+                st.error = "blad zapisu " + out.string();
+        }
+
+        st.ok = st.error.empty();
+        std::lock_guard<std::mutex> lock(statsMtx);
+        Log(options, st.ok ? "Skompresowano: " + st.name : "Blad: " + st.name + ": " + st.error);
+        stats.files.push_back(std::move(st));
+        };
+
+    RunPipeline<Task>(inputs.size(), options, 0, load, runBlock, write, io.get(), stats);
+}
+
+// ============================================================
+// RunDecompression — plik .lz77 -> obraz (options.outFormat).
+// ============================================================
+void RunDecompression(const CliOptions& options,
+    const std::vector<std::filesystem::path>& inputs,
+    RunStats& stats)
+{
+    struct Task {
+        FileStats             st;
+        std::filesystem::path path;
+        Lz77MappedFile        compFile;            // plik .lz77 odwzorowany w pamięci
+        const uint8_t*        compData = nullptr;  // tokeny w widoku compFile
+        Lz77BlockIndex        index;
+        uint16_t              version = 0;
+        std::vector<uint32_t> pixels;
+        std::vector<uint8_t>  blockOk;   // uint8_t — sąsiednie elementy zapisują różne wątki
+        uint32_t              blocksLeft = 0;
+    };
+
+    auto load = [&](size_t idx) {
+        auto task = std::make_unique<Task>();
+        task->path = inputs[idx];
+        task->st.name = inputs[idx].filename().string();
+        try {
+            Lz77FileHeader hdr{};
+            if (!Lz77ReadContainer(task->path, hdr, task->index, task->compFile, task->compData)) {
+                task->st.error = "nie mozna wczytac lub uszkodzony";
+                return task;
+            }
+            if (hdr.version != LZ77_FORMAT_TOKEN12 && hdr.version != LZ77_FORMAT_PACKED &&
+                hdr.version != LZ77_FORMAT_PACKED_EX) {
+                task->st.error = "nieznana wersja formatu " + std::to_string(hdr.version);
+                return task;
+            }
+
+            task->version = hdr.version;
+            task->st.width = hdr.width;
+            task->st.height = hdr.height;
+            task->st.inputBytes = hdr.compressedBytes;
+            task->pixels.assign(static_cast<size_t>(hdr.width) * hdr.height, 0u);
+
+            uint32_t blockCount = static_cast<uint32_t>(task->index.offsets.size() - 1);
+            task->blockOk.assign(blockCount, 0);
+            task->st.blocks = blockCount;
+            task->blocksLeft = blockCount;
+        }
+        catch (const std::bad_alloc&) {
+            task->st.error = "brak pamieci";
+            task->compFile.Close();
+            task->compData = nullptr;
+            task->pixels.clear();
+            task->blocksLeft = 0;
+        }
+        return task;
+        };
+
+    auto runBlock = [](Task& task, uint32_t b, std::vector<uint8_t>& work) {
+        size_t firstRow = static_cast<size_t>(b) * task.index.blockRows;
+        size_t rows = std::min<size_t>(task.index.blockRows, task.st.height - firstRow);
+        size_t expected = rows * task.st.width;
+        size_t outLen = 0;
+
+        const uint8_t* src = task.compData + task.index.offsets[b];
+        size_t srcLen = static_cast<size_t>(task.index.offsets[b + 1] - task.index.offsets[b]);
+        uint32_t* dst = task.pixels.data() + firstRow * task.st.width;
+        const Lz77RowFilters& filters = task.index.filters;
+        const lz77_params* params = task.version == LZ77_FORMAT_PACKED_EX ? &task.index.params : nullptr;
+        if (!filters.rows.empty()) {
+            // Reszty dekodowane do bufora wątku, wiersze odtwarzane do obrazu w trakcie
+            // dekodowania; bez pamięci na bufor — odtwarzanie w miejscu po dekodowaniu.
+            uint32_t* residuals = nullptr;
+            try {
+                if (work.size() < expected * sizeof(uint32_t))
+                    work.resize(expected * sizeof(uint32_t));
+                residuals = reinterpret_cast<uint32_t*>(work.data());
+            }
+            catch (const std::bad_alloc&) {
+            }
+            if (task.index.entropy)
+                lz77_rgba_decompress_entropy(src, srcLen, dst, expected, residuals, params, task.st.width,
+                    filters.transform, filters.rows.data() + firstRow, &outLen);
+            else
+                lz77_rgba_decompress_image(src, srcLen, dst, expected, residuals, params, task.st.width,
+                    filters.transform, filters.rows.data() + firstRow, &outLen);
+        }
+        else if (task.index.entropy)
+            lz77_rgba_decompress_entropy(src, srcLen, dst, expected, nullptr, params, task.st.width,
+                LZ77_TRANSFORM_NONE, nullptr, &outLen);
+        else if (task.version == LZ77_FORMAT_PACKED_EX)
+            lz77_rgba_decompress_level(src, srcLen, dst, expected, &task.index.params, &outLen);
+        else if (task.version == LZ77_FORMAT_PACKED)
+            lz77_rgba_decompress_packed(src, srcLen, dst, expected, &outLen);
+        else
+            lz77_rgba_decompress(src, srcLen, dst, expected, &outLen);
+        task.blockOk[b] = (outLen == expected) ? 1 : 0;
+        };
+
+    const char* ext = options.outFormat == ImageFormat::Ppm ? ".ppm"
+        : options.outFormat == ImageFormat::Raw ? ".rgba" : ".pam";
+
+    std::unique_ptr<IoThreads> io = MakeIoThreads(options);
+    std::mutex statsMtx;   // write() z --io async działa na kilku wątkach I/O
+    auto write = [&](std::unique_ptr<Task> task) {
+        FileStats& st = task->st;
+        if (st.error.empty() && std::count(task->blockOk.begin(), task->blockOk.end(), 0) != 0)
+            st.error = "niezgodna liczba pikseli po dekompresji";
+
+        if (st.error.empty()) {
+            std::filesystem::path out = options.outputDir / task->path.stem();
+            out += ext;
+            if (!SaveImageFile(out, options.outFormat, task->pixels, st.width, st.height))
+                st.error = "blad zapisu " + out.string();
+            st.outputBytes = static_cast<uint64_t>(st.width) * st.height * sizeof(uint32_t);
+        }
+
+        st.ok = st.error.empty();
+        std::lock_guard<std::mutex> lock(statsMtx);
+        Log(options, st.ok ? "Zdekompresowano: " + st.name : "Blad: " + st.name + ": " + st.error);
+        stats.files.push_back(std::move(st));
+        };
+
+    RunPipeline<Task>(inputs.size(), options, 0, load, runBlock, write, io.get(), stats);
+}
\ No newline at end of file
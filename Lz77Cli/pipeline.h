@@ -0,0 +1,81 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#pragma once
+
+// ============================================================
+// Potok kompresji / dekompresji narzędzia lz77img.
+//
+// Semantyka wątków jak w StartCompression / StartDecompression z Logic.dll:
+//   - jednostką pracy jest para (plik, blok) z podziału na pasy wierszy,
+//   - wątki robocze wczytują kolejny plik tylko wtedy, gdy nie ma bloków do
+//     przetworzenia i w obiegu jest mniej niż maxInFlight obrazów,
+//   - wątek wywołujący zapisuje gotowe pliki i zwalnia ich pamięć; z --io async
+//     tylko zgłasza zapis wątkom I/O (async_io.h), a kompresja czyta pliki
+//     wejściowe z wyprzedzeniem — jak LOGIC_IO_ASYNC. Obraz jest w obiegu do
+//     zakończenia zapisu.
+// ============================================================
+
+#include "image_io.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+struct CliOptions {
+    int         threads = 1;          // liczba wątków roboczych (min. 1)
+    uint32_t    blockPixels = 0;      // 0 = LZ77_DEFAULT_BLOCK_PIXELS, 0xFFFFFFFF = bez podziału
+    uint32_t    maxInFlight = 0;      // 0 = LZ77_DEFAULT_IN_FLIGHT_PER_THREAD * threads
+    int         level = 0;            // poziom kompresji 1..5 (--level); 0 = format domyślny bez rekordu parametrów
+    int         parse = -1;           // LZ77_PARSE_* (--parse); -1 = zgodnie z presetem poziomu
+    int         matchFinder = 0;      // LZ77_MATCH_FINDER_* (--finder); 0 = łańcuchy hash
+    int         filter = -1;          // LZ77_FILTER_* lub LZ77_FILTER_ADAPTIVE (--filter); -1 = bez filtrów
+    uint32_t    transform = 0;        // LZ77_TRANSFORM_* (--color)
+    bool        entropy = false;      // kodowanie entropijne bloków (--entropy huffman)
+    uint32_t    rawWidth = 0;         // wymiary plików surowych RGBA (--size)
+    uint32_t    rawHeight = 0;
+    ImageFormat outFormat = ImageFormat::Pam;  // format obrazów po dekompresji
+    bool        quiet = false;        // bez komunikatów na stderr
+    bool        asyncIo = false;      // odczyt/zapis na wątkach I/O (--io async)
+    uint32_t    ioQueueDepth = 0;     // maks. operacji I/O w toku (--io-depth); 0 = LZ77_IO_DEFAULT_QUEUE_DEPTH
+    std::filesystem::path outputDir;
+};
+
+// Wynik przetworzenia jednego pliku.
+struct FileStats {
+    std::string name;
+    uint32_t    width = 0;
+    uint32_t    height = 0;
+    uint32_t    blocks = 0;
+    uint64_t    inputBytes = 0;   // kompresja: piksele (w*h*4); dekompresja: dane tokenów
+    uint64_t    outputBytes = 0;  // kompresja: plik .lz77; dekompresja: piksele (w*h*4)
+    bool        ok = false;
+    std::string error;
+};
+
+// Wynik całego przebiegu (kolejność plików = kolejność zakończenia zapisu).
+struct RunStats {
+    std::vector<FileStats> files;
+    size_t   blocks = 0;
+    int      threads = 0;
+    uint32_t maxInFlight = 0;
+    int64_t  codecUs = 0;   // czas, w którym trwało co najmniej jedno wywołanie kodeka
+    int64_t  totalUs = 0;   // pełny czas potoku z I/O
+    bool     asyncIo = false;
+    uint32_t ioQueueDepth = 0;    // użyta głębokość kolejki (--io async)
+    uint32_t ioMaxInFlight = 0;   // największa liczba operacji I/O jednocześnie w toku
+};
+
+void RunCompression(const CliOptions& options,
+    const std::vector<std::filesystem::path>& inputs,
+    RunStats& stats);
+
+void RunDecompression(const CliOptions& options,
+    const std::vector<std::filesystem::path>& inputs,
+    RunStats& stats);
@@ -0,0 +1,109 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// bucket_test — kubełki z odciskami pikseli (LZ77_MATCH_FINDER_BUCKET):
+//   - każdy poziom odtwarza obraz, także obraz 90000 px i długie serie
+//     jednolitego koloru,
+//   - bufor dokładnie z lz77_work_bytes (kubełki wyrównywane w buforze),
+//   - strumień najwyżej 5% dłuższy niż z łańcuchami hash,
+//   - nieznana wartość finder działa jak LZ77_MATCH_FINDER_CHAIN,
+//   - fragmenty lz77_stream_begin_ex z kubełkami są identyczne
+//     z lz77_rgba_compress_ex.
+// ============================================================
+
+#include "test_util.h"
+
+static std::vector<uint8_t> CompressEx(const TestImage& img, const lz77_params* params, int finder,
+    size_t workCap, size_t workShift)
+{
+    size_t count = img.px.size();
+    std::vector<uint8_t> work(workCap + workShift);
+    std::vector<uint8_t> dst(lz77_compress_bound(LZ77_FORMAT_PACKED_EX, count));
+    size_t outLen = 0;
+    lz77_rgba_compress_ex(img.px.data(), count, img.width, dst.data(), dst.size(), work.data() + workShift, workCap,
+        params, finder, &outLen, nullptr);
+    dst.resize(outLen);
+    return dst;
+}
+
+static void TestFinder(const TestImage& img, int level)
+{
+    lz77_params params{};
+    lz77_level_params(level, &params);
+    const lz77_params* p = level ? &params : nullptr;
+    std::string what = img.name + " poziom " + std::to_string(level);
+    size_t need = lz77_work_bytes(img.px.size(), p);
+
+    const std::vector<uint8_t> bucket = CompressEx(img, p, LZ77_MATCH_FINDER_BUCKET, need, 0);
+    const std::vector<uint8_t> chain = CompressEx(img, p, LZ77_MATCH_FINDER_CHAIN, need, 0);
+    Check(!bucket.empty() && bucket.size() * 100 <= chain.size() * 105, what + ": kubelki " +
+        std::to_string(bucket.size()) + " B, lancuchy " + std::to_string(chain.size()) + " B");
+
+    // Kubełki wyrównywane są do linii 64 B wewnątrz bufora — ten sam wynik
+    // dla bufora zaczynającego się pod innym adresem.
+    Check(CompressEx(img, p, LZ77_MATCH_FINDER_BUCKET, need, 8) == bucket, what +
+        ": wynik zalezy od adresu bufora roboczego");
+    Check(CompressEx(img, p, 7, need, 0) == chain, what + ": nieznany finder rozny od LZ77_MATCH_FINDER_CHAIN");
+}
+
+static void TestStream(const TestImage& img, int level)
+{
+    lz77_params params{};
+    lz77_level_params(level, &params);
+    const lz77_params* p = level ? &params : nullptr;
+    const std::vector<uint8_t> once = CompressEx(img, p, LZ77_MATCH_FINDER_BUCKET, lz77_work_bytes(img.px.size(), p), 0);
+
+    std::vector<uint8_t> work(lz77_stream_work_bytes(p));
+    for (size_t chunk : { size_t(1), size_t(7), size_t(4093) }) {
+        std::string what = img.name + " poziom " + std::to_string(level) + " fragmenty " + std::to_string(chunk) + " B";
+        if (!Check(lz77_stream_begin_ex(work.data(), work.size(), img.px.data(), img.px.size(), img.width, p,
+            LZ77_MATCH_FINDER_BUCKET) == 1, what + ": lz77_stream_begin_ex nie powiodl sie"))
+            continue;
+        std::vector<uint8_t> joined;
+        std::vector<uint8_t> buf(chunk);
+        int rc = LZ77_STREAM_NEED_OUTPUT;
+        while (rc == LZ77_STREAM_NEED_OUTPUT) {
+            size_t len = 0;
+            rc = lz77_stream_compress(work.data(), buf.data(), buf.size(), &len, nullptr);
+            joined.insert(joined.end(), buf.begin(), buf.begin() + len);
+        }
+        Check(rc == LZ77_STREAM_DONE && joined == once, what + ": polaczone fragmenty rozne od lz77_rgba_compress_ex");
+    }
+}
+
+int main(int, char**)
+{
+    const TestImage large = MakeLargeImage(1);
+    const TestImage images[] = {
+        MakeImage("obraz61x37", 61, 37, 5, 2),
+        MakeImage("szum29x23", 29, 23, 60, 3),
+        MakeImage("jednolity400x200", 400, 200, 0, 4),
+        large,
+    };
+
+    size_t roundTrips = 0;
+    for (const TestImage& img : images) {
+        for (int level = 0; level <= LZ77_LEVEL_MAX; ++level) {
+            Config cfg = PackedConfig(level, -1);
+            cfg.finder = LZ77_MATCH_FINDER_BUCKET;
+            RoundTrip(img, cfg, img.height);
+            RoundTrip(img, cfg, Lz77BlockRowsFor(img.width, img.height, 3000));
+            roundTrips += 2;
+            if (img.px.size() > 1000)
+                TestFinder(img, level);
+        }
+    }
+
+    const TestImage stream = MakeImage("obraz600x500", 600, 500, 8, 5);
+    for (int level : { 0, 3, 5 })
+        TestStream(stream, level);
+
+    return Finish("bucket_test", std::to_string(roundTrips) + " kompresji i dekompresji");
+}
@@ -0,0 +1,101 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// container_test — kontener .lz77 biblioteki lz77core:
+//   - Lz77WriteContainer / Lz77ReadContainer z jednym i wieloma blokami
+//     (Token12 i format kompaktowy) — nagłówek i obraz jak przed zapisem,
+//     rozmiar pliku zgłaszany przez Lz77WriteContainer,
+//   - Lz77BlockRowsFor dla skrajnych wymiarów,
+//   - plik nieistniejący, pusty, skrócony lub z przestawionym bitem nagłówka.
+// ============================================================
+
+#include "test_util.h"
+
+static void TestBlockRows()
+{
+    Check(Lz77BlockRowsFor(100, 50, 0xFFFFFFFFu) == 50, "Lz77BlockRowsFor: bez podzialu");
+    Check(Lz77BlockRowsFor(100, 50, 1000) == 10, "Lz77BlockRowsFor: 1000 px przy szerokosci 100");
+    Check(Lz77BlockRowsFor(5000, 50, 1000) == 1, "Lz77BlockRowsFor: wiersz szerszy niz blok");
+    Check(Lz77BlockRowsFor(0, 50, 1000) == 50, "Lz77BlockRowsFor: szerokosc 0");
+    Check(Lz77BlockRowsFor(1024, 4096, 0) == LZ77_DEFAULT_BLOCK_PIXELS / 1024, "Lz77BlockRowsFor: wartosc domyslna");
+}
+
+// Rozmiar zgłoszony przez Lz77WriteContainer jest rozmiarem pliku na dysku.
+static void TestFileBytes(const fs::path& dir, const TestImage& img, const Config& cfg, uint32_t blockRows)
+{
+    Encoded enc;
+    if (!Check(EncodeImage(img, cfg, blockRows, enc), img.name + ": kompresja nie powiodla sie"))
+        return;
+    std::vector<Lz77BlockSpan> spans;
+    for (const std::vector<uint8_t>& block : enc.blocks)
+        spans.push_back({ block.data(), block.size() });
+
+    fs::path path = dir / "size.lz77";
+    uint64_t fileBytes = 0;
+    if (Check(Lz77WriteContainer(path, img.width, img.height, cfg.version, blockRows, spans,
+        nullptr, nullptr, false, &fileBytes), img.name + ": blad zapisu")) {
+        std::error_code ec;
+        Check(fileBytes == fs::file_size(path, ec), img.name + " " + Describe(cfg) +
+            ": rozmiar zgloszony przez Lz77WriteContainer rozni sie od pliku");
+    }
+    fs::remove(path);
+}
+
+static void TestMissingAndEmpty(const fs::path& dir)
+{
+    Lz77FileHeader hdr{};
+    Lz77BlockIndex index;
+    Lz77MappedFile file;
+    const uint8_t* data = nullptr;
+    Check(!Lz77ReadContainer(dir / "brak.lz77", hdr, index, file, data), "przyjeto nieistniejacy plik");
+
+    fs::path path = dir / "pusty.lz77";
+    WriteBytes(path, nullptr, 0);
+    Check(!Lz77ReadContainer(path, hdr, index, file, data), "przyjeto pusty plik");
+    fs::remove(path);
+}
+
+int main(int argc, char** argv)
+{
+    fs::path dir;
+    if (!TestDir(argc, argv, "container_test", dir)) return 1;
+
+    const TestImage images[] = {
+        MakeImage("obraz61x37", 61, 37, 5, 1),
+        MakeImage("szum29x23", 29, 23, 60, 2),
+        MakeImage("kolumna1x50", 1, 50, 10, 3),
+        MakeImage("pasek130x3", 130, 3, 10, 4),
+        MakeLargeImage(5),
+    };
+    const Config configs[] = { Token12Config(), PackedConfig(0, -1) };
+
+    size_t roundTrips = 0;
+    for (const TestImage& img : images) {
+        for (const Config& cfg : configs) {
+            for (uint32_t blockPixels : { 0xFFFFFFFFu, 500u, 20000u }) {
+                uint32_t blockRows = Lz77BlockRowsFor(img.width, img.height, blockPixels);
+                TestFileRoundTrip(dir, img, cfg, blockRows);
+                TestFileBytes(dir, img, cfg, blockRows);
+                ++roundTrips;
+            }
+        }
+    }
+
+    TestBlockRows();
+    TestMissingAndEmpty(dir);
+
+    const TestImage small = MakeImage("obraz23x19", 23, 19, 10, 6);
+    for (const Config& cfg : configs) {
+        TestFileCorruption(dir, small, cfg, 6);
+        TestFileCorruption(dir, small, cfg, small.height);
+    }
+
+    return Finish("container_test", std::to_string(roundTrips) + " zapisow i odczytow");
+}
@@ -0,0 +1,168 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// entropy_test — kodowanie entropijne (lz77_entropy_encode,
+// lz77_rgba_decompress_entropy):
+//   - każdy poziom z kodowaniem odtwarza obraz, także obraz 90000 px,
+//   - zakodowany strumień mieści się w lz77_entropy_bound, szum zapisywany jest
+//     bez zmian (1 bajt więcej), strumień z powtórzeniami się skraca,
+//   - strumień tokenów ucięty w środku tokenu i za mały bufor wyjścia dają 0,
+//   - pliki z LZ77_FLAG_ENTROPY zapisują się i odczytują; odrzucane są: flaga
+//     bez tabeli bloków, flaga przy formacie Token12, pliki i bloki uszkodzone.
+// ============================================================
+
+#include "test_util.h"
+
+// Strumień tokenów formatu kompaktowego (jeden blok, bez kandydatów z wierszy).
+static std::vector<uint8_t> PackedTokens(const TestImage& img, const lz77_params* params)
+{
+    size_t count = img.px.size();
+    std::vector<uint8_t> work(lz77_work_bytes(count, params));
+    std::vector<uint8_t> dst(lz77_compress_bound(LZ77_FORMAT_PACKED_EX, count));
+    size_t outLen = 0;
+    lz77_rgba_compress_ex(img.px.data(), count, 0, dst.data(), dst.size(), work.data(), work.size(),
+        params, LZ77_MATCH_FINDER_CHAIN, &outLen, nullptr);
+    dst.resize(outLen);
+    return dst;
+}
+
+static size_t EntropyEncode(const std::vector<uint8_t>& tokens, size_t len, const lz77_params* params, size_t cap)
+{
+    std::vector<uint8_t> dst(cap);
+    size_t outLen = 0;
+    lz77_entropy_encode(tokens.data(), len, params, dst.data(), cap, &outLen);
+    return outLen;
+}
+
+static void TestEncoder(const TestImage& img, bool expectSmaller)
+{
+    const std::vector<uint8_t> tokens = PackedTokens(img, nullptr);
+    size_t bound = lz77_entropy_bound(tokens.size());
+    Check(bound == tokens.size() + 1, img.name + ": lz77_entropy_bound != src_len + 1");
+
+    size_t coded = EntropyEncode(tokens, tokens.size(), nullptr, bound);
+    if (!Check(coded != 0 && coded <= bound, img.name + ": zakodowany strumien poza granica"))
+        return;
+    if (expectSmaller)
+        Check(coded < tokens.size(), img.name + ": kodowanie nie skrocilo strumienia");
+    else
+        Check(coded == tokens.size() + 1, img.name + ": strumien szumu nie zapisany bez zmian");
+    Check(EntropyEncode(tokens, tokens.size(), nullptr, coded - 1) == 0, img.name + ": zakodowano do za malego bufora");
+
+    // Pierwszy token to seria literałów (bajt flag, licznik, piksele) — ucięcie po
+    // bajcie flag i liczniku wypada w jego środku.
+    Check(EntropyEncode(tokens, 2, nullptr, bound) == 0, img.name + ": zakodowano strumien uciety w srodku tokenu");
+}
+
+// Nagłówek rozszerzony bez tabeli bloków (LZ77_EXT_MIN_HEADER_BYTES) i jeden strumień.
+static bool ReadNoBlocksFile(const fs::path& path, const TestImage& img, uint16_t version, uint16_t flags,
+    const std::vector<uint8_t>& stream)
+{
+    Lz77FileHeader hdr{};
+    hdr.magic = LZ77_FILE_MAGIC_EXT;
+    hdr.width = img.width;
+    hdr.height = img.height;
+    hdr.compressedBytes = stream.size();
+    hdr.version = version;
+    hdr.flags = flags;
+    hdr.headerBytes = static_cast<uint32_t>(LZ77_EXT_MIN_HEADER_BYTES);
+
+    std::vector<uint8_t> bytes(LZ77_EXT_MIN_HEADER_BYTES);
+    memcpy(bytes.data(), &hdr, LZ77_EXT_MIN_HEADER_BYTES);
+    bytes.insert(bytes.end(), stream.begin(), stream.end());
+    WriteBytes(path, bytes.data(), bytes.size());
+
+    Lz77BlockIndex index;
+    Lz77MappedFile file;
+    const uint8_t* data = nullptr;
+    bool accepted = Lz77ReadContainer(path, hdr, index, file, data);
+    file.Close();
+    fs::remove(path);
+    return accepted;
+}
+
+static void TestHeaderFlags(const fs::path& dir, const TestImage& img)
+{
+    const std::vector<uint8_t> tokens = PackedTokens(img, nullptr);
+    std::vector<uint8_t> coded(lz77_entropy_bound(tokens.size()));
+    size_t codedLen = 0;
+    lz77_entropy_encode(tokens.data(), tokens.size(), nullptr, coded.data(), coded.size(), &codedLen);
+    coded.resize(codedLen);
+
+    fs::path path = dir / "naglowek.lz77";
+    Check(ReadNoBlocksFile(path, img, LZ77_FORMAT_PACKED, 0, tokens),
+        "odrzucono plik bez tabeli blokow (format kompaktowy)");
+    Check(!ReadNoBlocksFile(path, img, LZ77_FORMAT_PACKED, LZ77_FLAG_ENTROPY, coded),
+        "przyjeto LZ77_FLAG_ENTROPY bez tabeli blokow");
+
+    // Token12 z flagą kodowania entropijnego — zapis poprawnego pliku i ustawienie flagi.
+    Config token12 = Token12Config();
+    Encoded enc;
+    if (!Check(EncodeImage(img, token12, img.height, enc) && WriteEncoded(path, img, token12, img.height, enc),
+        "Token12: kompresja lub zapis nie powiodly sie"))
+        return;
+    std::vector<uint8_t> bytes = ReadBytes(path);
+    Lz77FileHeader hdr{};
+    memcpy(&hdr, bytes.data(), sizeof(hdr));
+    hdr.flags |= LZ77_FLAG_ENTROPY;
+    memcpy(bytes.data(), &hdr, sizeof(hdr));
+    WriteBytes(path, bytes.data(), bytes.size());
+    bool accepted = false;
+    ReadAndDecode(path, nullptr, accepted);
+    Check(!accepted, "przyjeto LZ77_FLAG_ENTROPY przy formacie Token12");
+    fs::remove(path);
+}
+
+int main(int argc, char** argv)
+{
+    fs::path dir;
+    if (!TestDir(argc, argv, "entropy_test", dir)) return 1;
+
+    const TestImage large = MakeLargeImage(1);
+    const TestImage noise = MakeImage("szum64x64", 64, 64, 100, 2);
+    const TestImage images[] = {
+        MakeImage("obraz61x37", 61, 37, 5, 3),
+        MakeImage("jednolity97x13", 97, 13, 0, 4),
+        noise,
+        large,
+    };
+
+    TestEncoder(large, true);
+    TestEncoder(noise, false);
+    TestHeaderFlags(dir, images[0]);
+
+    size_t roundTrips = 0;
+    for (const TestImage& img : images) {
+        for (int level = 0; level <= LZ77_LEVEL_MAX; ++level) {
+            for (int finder : { LZ77_MATCH_FINDER_CHAIN, LZ77_MATCH_FINDER_BUCKET }) {
+                Config cfg = PackedConfig(level, -1);
+                cfg.entropy = true;
+                cfg.finder = finder;
+                RoundTrip(img, cfg, img.height);
+                TestFileRoundTrip(dir, img, cfg, Lz77BlockRowsFor(img.width, img.height, 1000));
+                roundTrips += 2;
+            }
+        }
+    }
+
+    const TestImage small = MakeImage("obraz23x19", 23, 19, 10, 5);
+    Config level3 = PackedConfig(3, -1);
+    level3.entropy = true;
+    Config filtered = PackedConfig(4, -1);
+    filtered.filter = static_cast<int>(LZ77_FILTER_ADAPTIVE);
+    filtered.transform = LZ77_TRANSFORM_YCOCG_R;
+    filtered.entropy = true;
+    for (const Config& cfg : { level3, filtered }) {
+        TestFileCorruption(dir, small, cfg, 6);
+        TestBlockCorruption(small, cfg, 6);
+    }
+
+    return Finish("entropy_test", std::to_string(roundTrips) + " kompresji i dekompresji");
+}
@@ -0,0 +1,151 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// filter_test — filtry wierszy i transformacja YCoCg-R:
+//   - lz77_unfilter_rows odwraca lz77_filter_rows dla każdego filtra
+//     i transformacji (pełne 32-bitowe piksele, szerokości nie będące
+//     wielokrotnością jądra SSE2), row_filters zgodne z wybranym filtrem,
+//   - pierwszy wiersz wywołania nie zależy od pikseli spoza niego,
+//   - nieznany filtr lub transformacja są odrzucane,
+//   - lz77_rgba_decompress_image z buforem reszt i bez niego,
+//   - pliki z rekordem filtrów zapisują się, odczytują i dekompresują;
+//     uszkodzone są odrzucane.
+// ============================================================
+
+#include "test_util.h"
+
+static const uint32_t FILTERS[] = { LZ77_FILTER_NONE, LZ77_FILTER_SUB, LZ77_FILTER_UP, LZ77_FILTER_AVERAGE,
+    LZ77_FILTER_PAETH, LZ77_FILTER_ADAPTIVE };
+
+static void TestInverse(const TestImage& img)
+{
+    size_t count = img.px.size();
+    for (uint32_t filter : FILTERS) {
+        for (uint32_t transform = LZ77_TRANSFORM_NONE; transform <= LZ77_TRANSFORM_YCOCG_R; ++transform) {
+            std::string what = img.name + " filtr " + std::to_string(filter) + " transformacja " +
+                std::to_string(transform);
+            std::vector<uint32_t> residuals(count);
+            std::vector<uint8_t> rows(img.height, 0xEE);
+            if (!Check(lz77_filter_rows(img.px.data(), residuals.data(), img.width, img.height, filter, transform,
+                rows.data()) == 1, what + ": lz77_filter_rows odrzucil argumenty"))
+                continue;
+
+            for (uint8_t row : rows) {
+                if (filter == LZ77_FILTER_ADAPTIVE ? row >= LZ77_FILTER_COUNT : row != filter) {
+                    Fail(what + ": niezgodny filtr wiersza " + std::to_string(row));
+                    break;
+                }
+            }
+
+            // Pierwszy wiersz — bez wiersza powyżej: ten sam wynik dla samego wiersza.
+            std::vector<uint32_t> first(img.width);
+            std::vector<uint8_t> firstRow(1);
+            lz77_filter_rows(img.px.data(), first.data(), img.width, 1, rows[0], transform, firstRow.data());
+            Check(std::equal(first.begin(), first.end(), residuals.begin()), what + ": pierwszy wiersz zalezy od innych");
+
+            std::vector<uint32_t> restored = residuals;
+            Check(lz77_unfilter_rows(restored.data(), img.width, img.height, transform, rows.data()) == 1 &&
+                restored == img.px, what + ": lz77_unfilter_rows nie odtworzyl obrazu");
+        }
+    }
+
+    // Sama transformacja (row_filters == NULL).
+    std::vector<uint32_t> residuals(count);
+    std::vector<uint8_t> rows(img.height);
+    lz77_filter_rows(img.px.data(), residuals.data(), img.width, img.height, LZ77_FILTER_NONE,
+        LZ77_TRANSFORM_YCOCG_R, rows.data());
+    Check(lz77_unfilter_rows(residuals.data(), img.width, img.height, LZ77_TRANSFORM_YCOCG_R, nullptr) == 1 &&
+        residuals == img.px, img.name + ": sama transformacja nie odwrocona");
+}
+
+static void TestInvalid()
+{
+    uint32_t px[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    uint32_t out[8];
+    uint8_t rows[2];
+    Check(lz77_filter_rows(px, out, 4, 2, LZ77_FILTER_COUNT, LZ77_TRANSFORM_NONE, rows) == 0, "przyjeto filtr 5");
+    Check(lz77_filter_rows(px, out, 4, 2, LZ77_FILTER_NONE, LZ77_TRANSFORM_YCOCG_R + 1, rows) == 0,
+        "przyjeto nieznana transformacje");
+    uint8_t bad[2] = { LZ77_FILTER_NONE, LZ77_FILTER_COUNT };
+    Check(lz77_unfilter_rows(px, 4, 2, LZ77_TRANSFORM_NONE, bad) == 0, "lz77_unfilter_rows przyjal filtr 5");
+    Check(lz77_unfilter_rows(px, 4, 2, LZ77_TRANSFORM_YCOCG_R + 1, nullptr) == 0,
+        "lz77_unfilter_rows przyjal nieznana transformacje");
+}
+
+// Dekompresja z buforem reszt (work_px) i w miejscu (work_px == NULL) daje ten sam obraz.
+static void TestDecompressImage(const TestImage& img, int level)
+{
+    Config cfg = PackedConfig(level, -1);
+    cfg.filter = static_cast<int>(LZ77_FILTER_ADAPTIVE);
+    cfg.transform = LZ77_TRANSFORM_YCOCG_R;
+    Encoded enc;
+    if (!Check(EncodeImage(img, cfg, img.height, enc), img.name + ": kompresja nie powiodla sie"))
+        return;
+
+    size_t count = img.px.size();
+    const lz77_params* params = cfg.version == LZ77_FORMAT_PACKED_EX ? &cfg.params : nullptr;
+    std::vector<uint32_t> withWork(count), inPlace(count), work(count);
+    size_t len1 = 0, len2 = 0;
+    lz77_rgba_decompress_image(enc.blocks[0].data(), enc.blocks[0].size(), withWork.data(), count, work.data(),
+        params, img.width, cfg.transform, enc.filters.rows.data(), &len1);
+    lz77_rgba_decompress_image(enc.blocks[0].data(), enc.blocks[0].size(), inPlace.data(), count, nullptr,
+        params, img.width, cfg.transform, enc.filters.rows.data(), &len2);
+    Check(len1 == count && withWork == img.px, img.name + ": dekompresja z buforem reszt");
+    Check(len2 == count && inPlace == img.px, img.name + ": dekompresja w miejscu");
+}
+
+int main(int argc, char** argv)
+{
+    fs::path dir;
+    if (!TestDir(argc, argv, "filter_test", dir)) return 1;
+
+    const TestImage images[] = {
+        MakeImage("obraz61x37", 61, 37, 5, 2),
+        MakeImage("szum33x9", 33, 9, 100, 1),
+        MakeImage("kolumna1x50", 1, 50, 10, 3),
+        MakeImage("pasek130x3", 130, 3, 10, 4),
+        MakeLargeImage(5),
+    };
+
+    for (const TestImage& img : images)
+        TestInverse(img);
+    TestInvalid();
+    TestDecompressImage(images[0], 0);
+    TestDecompressImage(images[4], 5);
+
+    size_t roundTrips = 0;
+    for (const TestImage& img : images) {
+        for (int level : { 0, 1, 3, 5 }) {
+            for (uint32_t filter : FILTERS) {
+                for (uint32_t transform = LZ77_TRANSFORM_NONE; transform <= LZ77_TRANSFORM_YCOCG_R; ++transform) {
+                    Config cfg = PackedConfig(level, -1);
+                    cfg.filter = static_cast<int>(filter);
+                    cfg.transform = transform;
+                    TestFileRoundTrip(dir, img, cfg, Lz77BlockRowsFor(img.width, img.height, 500));
+                    RoundTrip(img, cfg, img.height);
+                    roundTrips += 2;
+                }
+            }
+        }
+    }
+
+    const TestImage small = MakeImage("obraz23x19", 23, 19, 10, 6);
+    Config paeth = PackedConfig(0, -1);
+    paeth.filter = static_cast<int>(LZ77_FILTER_PAETH);
+    Config adaptive = PackedConfig(4, -1);
+    adaptive.filter = static_cast<int>(LZ77_FILTER_ADAPTIVE);
+    adaptive.transform = LZ77_TRANSFORM_YCOCG_R;
+    for (const Config& cfg : { paeth, adaptive }) {
+        TestFileCorruption(dir, small, cfg, 6);
+        TestBlockCorruption(small, cfg, 6);
+    }
+
+    return Finish("filter_test", std::to_string(roundTrips) + " kompresji i dekompresji");
+}
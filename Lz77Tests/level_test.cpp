@@ -0,0 +1,127 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// level_test — poziomy kompresji 1..5 (lz77_level_params, lz77_rgba_compress_level):
+//   - presety poprawne, poziomy spoza zakresu i parametry spoza zakresów odrzucane,
+//   - poziom 2 identyczny bajt w bajt z lz77_rgba_compress_packed,
+//   - każdy poziom odtwarza obraz, także obraz 90000 px w jednym bloku
+//     (okna 16384..65536 px, dopasowania do 65536 px),
+//   - na takim obrazie poziomy 3, 4 i 5 dają kolejno krótsze strumienie,
+//   - plik z rekordem parametrów (wersja 2 dla poziomów 1 i 2, wersja 3 dla
+//     poziomów 3..5) zapisuje się i odczytuje; uszkodzony jest odrzucany.
+// ============================================================
+
+#include "test_util.h"
+
+static void TestPresets()
+{
+    lz77_params params{};
+    Check(lz77_level_params(LZ77_LEVEL_MIN - 1, &params) == 0, "przyjeto poziom 0");
+    Check(lz77_level_params(LZ77_LEVEL_MAX + 1, &params) == 0, "przyjeto poziom 6");
+
+    for (int level = LZ77_LEVEL_MIN; level <= LZ77_LEVEL_MAX; ++level) {
+        std::string what = "poziom " + std::to_string(level);
+        if (!Check(lz77_level_params(level, &params) == 1, what + ": brak presetu"))
+            continue;
+        Check(params.level == static_cast<uint32_t>(level), what + ": pole level");
+        Check(lz77_params_valid(&params) == 1, what + ": lz77_params_valid odrzuca preset");
+        Check(lz77_params_work_bytes(&params) >= lz77_work_bytes(1u << 20, &params), what +
+            ": lz77_work_bytes wieksze niz lz77_params_work_bytes");
+    }
+
+    lz77_level_params(LZ77_LEVEL_DEFAULT, &params);
+    lz77_params bad = params;
+    bad.window_px = 3000;
+    Check(lz77_params_valid(&bad) == 0, "przyjeto okno 3000 px");
+    bad = params;
+    bad.max_match_px = 1;
+    Check(lz77_params_valid(&bad) == 0, "przyjeto dopasowanie 1 px");
+    bad = params;
+    bad.max_chain = 0;
+    Check(lz77_params_valid(&bad) == 0, "przyjeto lancuch 0");
+    bad = params;
+    bad.parse = LZ77_PARSE_OPTIMAL + 1;
+    Check(lz77_params_valid(&bad) == 0, "przyjeto nieznany sposob parsowania");
+
+    // Nieprawidłowe parametry — *out_len = 0 w kompresji i dekompresji.
+    uint32_t px[16] = {};
+    std::vector<uint8_t> work(LZ77_WORK_NEED_BYTES);
+    uint8_t dst[256];
+    size_t outLen = 1;
+    lz77_rgba_compress_level(px, 16, dst, sizeof(dst), work.data(), work.size(), &bad, &outLen, nullptr);
+    Check(outLen == 0, "lz77_rgba_compress_level przyjal nieprawidlowe parametry");
+    bad = params;
+    bad.window_px = 3000;
+    outLen = 1;
+    lz77_rgba_decompress_level(dst, sizeof(dst), px, 16, &bad, &outLen);
+    Check(outLen == 0, "lz77_rgba_decompress_level przyjal nieprawidlowe parametry");
+}
+
+// Poziom 2 to format kompaktowy — bajty jak z lz77_rgba_compress_packed.
+static void TestDefaultLevel(const TestImage& img)
+{
+    lz77_params params{};
+    lz77_level_params(LZ77_LEVEL_DEFAULT, &params);
+    size_t count = img.px.size();
+    std::vector<uint8_t> work(lz77_params_work_bytes(&params));
+    std::vector<uint8_t> level(lz77_compress_bound(LZ77_FORMAT_PACKED, count));
+    std::vector<uint8_t> packed(level.size());
+    size_t levelLen = 0, packedLen = 0;
+    lz77_rgba_compress_level(img.px.data(), count, level.data(), level.size(), work.data(), work.size(),
+        &params, &levelLen, nullptr);
+    lz77_rgba_compress_packed(img.px.data(), count, packed.data(), packed.size(), work.data(), work.size(), &packedLen);
+    Check(levelLen != 0 && levelLen == packedLen && memcmp(level.data(), packed.data(), levelLen) == 0,
+        img.name + ": poziom 2 rozni sie od lz77_rgba_compress_packed");
+}
+
+int main(int argc, char** argv)
+{
+    fs::path dir;
+    if (!TestDir(argc, argv, "level_test", dir)) return 1;
+
+    TestPresets();
+
+    const TestImage large = MakeLargeImage(11);
+    const TestImage images[] = {
+        MakeImage("obraz61x37", 61, 37, 5, 1),
+        MakeImage("szum29x23", 29, 23, 60, 2),
+        MakeImage("kolumna1x50", 1, 50, 10, 3),
+        large,
+    };
+
+    size_t roundTrips = 0;
+    size_t sizes[LZ77_LEVEL_MAX + 1] = {};
+    for (const TestImage& img : images) {
+        TestDefaultLevel(img);
+        for (int level = LZ77_LEVEL_MIN; level <= LZ77_LEVEL_MAX; ++level) {
+            Config cfg = PackedConfig(level, -1);
+            size_t size = 0;
+            RoundTrip(img, cfg, img.height, &size);
+            RoundTrip(img, cfg, Lz77BlockRowsFor(img.width, img.height, 500));
+            TestFileRoundTrip(dir, img, cfg, Lz77BlockRowsFor(img.width, img.height, 20000));
+            roundTrips += 3;
+            if (&img == &images[3]) sizes[level] = size;
+        }
+    }
+
+    // Dłuższe okno i dopasowania poziomów 3..5 obejmują powtórzenia z odległości
+    // ponad 4096 px, niedostępne dla formatu kompaktowego.
+    for (int level = 3; level <= LZ77_LEVEL_MAX; ++level)
+        Check(sizes[level] < sizes[level - 1], large.name + ": poziom " + std::to_string(level) +
+            " nie krotszy od poziomu " + std::to_string(level - 1));
+
+    const TestImage small = MakeImage("obraz23x19", 23, 19, 10, 4);
+    for (int level : { 1, 3, 5 }) {
+        TestFileCorruption(dir, small, PackedConfig(level, -1), 6);
+        TestBlockCorruption(small, PackedConfig(level, -1), 6);
+    }
+
+    return Finish("level_test", std::to_string(roundTrips) + " kompresji i dekompresji");
+}
@@ -0,0 +1,66 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// parse_test — sposoby wyboru dopasowań (lz77_params.parse):
+//   - każdy poziom z każdym sposobem odtwarza obraz, także obraz 90000 px
+//     w jednym bloku (kilka segmentów LZ77_PARSE_OPTIMAL po 16384 px)
+//     i obrazy o długości segmentu oraz o piksel dłuższe,
+//   - liczniki lz77_stats obejmują wszystkie piksele,
+//   - LZ77_PARSE_OPTIMAL nie daje dłuższego strumienia niż LZ77_PARSE_GREEDY.
+// ============================================================
+
+#include "test_util.h"
+
+static const uint32_t PARSES[] = { LZ77_PARSE_GREEDY, LZ77_PARSE_LAZY, LZ77_PARSE_LAZY2, LZ77_PARSE_OPTIMAL };
+
+// Strumień jednego bloku (cały obraz) z licznikami; 0 — błąd.
+static size_t CompressWithStats(const TestImage& img, const lz77_params& params, lz77_stats& stats)
+{
+    size_t count = img.px.size();
+    std::vector<uint8_t> work(lz77_work_bytes(count, &params));
+    std::vector<uint8_t> dst(lz77_compress_bound(LZ77_FORMAT_PACKED_EX, count));
+    size_t outLen = 0;
+    lz77_rgba_compress_level(img.px.data(), count, dst.data(), dst.size(), work.data(), work.size(),
+        &params, &outLen, &stats);
+    return outLen;
+}
+
+int main(int, char**)
+{
+    const TestImage images[] = {
+        MakeImage("obraz61x37", 61, 37, 5, 1),
+        MakeImage("szum29x23", 29, 23, 60, 2),
+        MakeImage("segment128x128", 128, 128, 10, 3),
+        MakeImage("segment16385x1", 16385, 1, 10, 4),
+        MakeLargeImage(5),
+    };
+
+    size_t roundTrips = 0;
+    for (const TestImage& img : images) {
+        for (int level = LZ77_LEVEL_MIN; level <= LZ77_LEVEL_MAX; ++level) {
+            size_t sizes[4] = {};
+            for (size_t p = 0; p < 4; ++p) {
+                Config cfg = PackedConfig(level, static_cast<int>(PARSES[p]));
+                std::string what = img.name + " " + Describe(cfg);
+                RoundTrip(img, cfg, img.height, &sizes[p]);
+                RoundTrip(img, cfg, Lz77BlockRowsFor(img.width, img.height, 5000));
+                roundTrips += 2;
+
+                lz77_stats stats{};
+                Check(CompressWithStats(img, cfg.params, stats) != 0, what + ": kompresja nie powiodla sie");
+                Check(stats.literal_px + stats.match_px == img.px.size(), what + ": liczniki nie obejmuja obrazu");
+            }
+            Check(sizes[3] <= sizes[0], img.name + " poziom " + std::to_string(level) +
+                ": optimal dluzszy niz greedy");
+        }
+    }
+
+    return Finish("parse_test", std::to_string(roundTrips) + " kompresji i dekompresji");
+}
@@ -0,0 +1,107 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// row_test — kandydaci z wierszy powyżej (lz77_rgba_compress_image):
+//   - obraz odtwarzany dla szerokości 1, 7, 300 i szerokości, przy których
+//     dwa wiersze (40000 px) lub jeden wiersz (70000 px) wychodzą poza okno,
+//   - na obrazie z wierszami powtarzającymi wiersz powyżej strumień nie jest
+//     dłuższy niż bez kandydatów (width == 0), a przy łańcuchu 1 (poziom 1) —
+//     krótszy,
+//   - width == 0 daje strumień lz77_rgba_compress_level / _packed.
+// ============================================================
+
+#include "test_util.h"
+
+// Szum, w którym każdy piksel poza changePercent powtarza piksel powyżej.
+static TestImage MakeVerticalImage(const char* name, uint32_t width, uint32_t height, int changePercent, uint32_t seed)
+{
+    TestImage img{ name, width, height, {} };
+    img.px.resize(static_cast<size_t>(width) * height);
+    uint32_t state = seed;
+    for (size_t i = 0; i < img.px.size(); ++i) {
+        uint32_t r = NextRandom(state);
+        img.px[i] = (i < width || static_cast<int>(r % 100) < changePercent) ? NextRandom(state) : img.px[i - width];
+    }
+    return img;
+}
+
+// Strumień jednego bloku; width == 0 — bez kandydatów z wierszy.
+static std::vector<uint8_t> CompressImage(const TestImage& img, size_t width, const lz77_params* params)
+{
+    size_t count = img.px.size();
+    std::vector<uint8_t> work(lz77_work_bytes(count, params));
+    std::vector<uint8_t> dst(lz77_compress_bound(LZ77_FORMAT_PACKED_EX, count));
+    size_t outLen = 0;
+    lz77_rgba_compress_image(img.px.data(), count, width, dst.data(), dst.size(), work.data(), work.size(),
+        params, &outLen, nullptr);
+    dst.resize(outLen);
+    return dst;
+}
+
+static void TestWithoutWidth(const TestImage& img)
+{
+    size_t count = img.px.size();
+    for (int level = 0; level <= LZ77_LEVEL_MAX; ++level) {
+        lz77_params params{};
+        lz77_level_params(level, &params);
+        const lz77_params* p = level ? &params : nullptr;
+        std::vector<uint8_t> work(lz77_work_bytes(count, p));
+        std::vector<uint8_t> plain(lz77_compress_bound(LZ77_FORMAT_PACKED_EX, count));
+        size_t plainLen = 0;
+        if (p)
+            lz77_rgba_compress_level(img.px.data(), count, plain.data(), plain.size(), work.data(), work.size(),
+                p, &plainLen, nullptr);
+        else
+            lz77_rgba_compress_packed(img.px.data(), count, plain.data(), plain.size(), work.data(), work.size(),
+                &plainLen);
+        plain.resize(plainLen);
+        Check(CompressImage(img, 0, p) == plain, img.name + " poziom " + std::to_string(level) +
+            ": width == 0 rozni sie od kompresji bez obrazu");
+    }
+}
+
+int main(int, char**)
+{
+    const TestImage vertical = MakeVerticalImage("pionowy300x300", 300, 300, 20, 1);
+    const TestImage images[] = {
+        MakeVerticalImage("kolumna1x400", 1, 400, 20, 2),
+        MakeVerticalImage("waski7x300", 7, 300, 20, 3),
+        vertical,
+        MakeVerticalImage("szeroki40000x3", 40000, 3, 20, 4),
+        MakeVerticalImage("szeroki70000x2", 70000, 2, 20, 5),
+        MakeImage("obraz61x37", 61, 37, 5, 6),
+    };
+
+    size_t roundTrips = 0;
+    for (const TestImage& img : images) {
+        for (int level = 0; level <= LZ77_LEVEL_MAX; ++level) {
+            Config cfg = PackedConfig(level, -1);
+            RoundTrip(img, cfg, img.height);
+            RoundTrip(img, cfg, 2);
+            roundTrips += 2;
+        }
+    }
+
+    for (int level = 0; level <= LZ77_LEVEL_MAX; ++level) {
+        lz77_params params{};
+        lz77_level_params(level, &params);
+        const lz77_params* p = level ? &params : nullptr;
+        size_t rows = CompressImage(vertical, vertical.width, p).size();
+        size_t plain = CompressImage(vertical, 0, p).size();
+        std::string what = vertical.name + " poziom " + std::to_string(level);
+        Check(rows != 0 && rows <= plain, what + ": kandydaci z wierszy wydluzyli strumien");
+        if (level == LZ77_LEVEL_MIN)
+            Check(rows < plain, what + ": kandydaci z wierszy nie skrocili strumienia przy lancuchu 1");
+    }
+
+    TestWithoutWidth(vertical);
+
+    return Finish("row_test", std::to_string(roundTrips) + " kompresji i dekompresji");
+}
@@ -0,0 +1,91 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// simd_test — jądra SIMD (LZ77_SIMD_*): na każdym poziomie obsługiwanym przez
+// procesor kompresja daje strumień identyczny bajt w bajt z jądrem skalarnym,
+// a dekompresja odtwarza obraz. Poziom wymuszany jest tylko dla wątku testu
+// (lz77_set_thread_simd_level); ujemny poziom przywraca poziom procesu.
+// ============================================================
+
+#include "test_util.h"
+
+static std::vector<Config> SimdConfigs()
+{
+    std::vector<Config> configs;
+    configs.push_back(Token12Config());
+    configs.push_back(PackedConfig(0, -1));
+    configs.push_back(PackedConfig(3, -1));
+    configs.push_back(PackedConfig(5, -1));
+    configs.push_back(PackedConfig(4, static_cast<int>(LZ77_PARSE_GREEDY)));
+    Config bucket = PackedConfig(4, -1);
+    bucket.finder = LZ77_MATCH_FINDER_BUCKET;
+    configs.push_back(bucket);
+    Config filtered = PackedConfig(0, -1);
+    filtered.filter = static_cast<int>(LZ77_FILTER_ADAPTIVE);
+    filtered.transform = LZ77_TRANSFORM_YCOCG_R;
+    filtered.entropy = true;
+    configs.push_back(filtered);
+    return configs;
+}
+
+int main(int, char**)
+{
+    int cpuLevel = lz77_cpu_simd_level();
+    int processLevel = lz77_simd_level();
+    Check(cpuLevel >= LZ77_SIMD_SCALAR && cpuLevel <= LZ77_SIMD_AVX512, "lz77_cpu_simd_level poza zakresem");
+
+    const TestImage images[] = {
+        MakeImage("obraz61x37", 61, 37, 5, 1),
+        MakeImage("szum29x23", 29, 23, 60, 2),
+        MakeImage("jednolity97x13", 97, 13, 0, 3),
+        MakeLargeImage(4),
+    };
+    const std::vector<Config> configs = SimdConfigs();
+
+    // Strumienie jądra skalarnego — wzorzec dla pozostałych poziomów.
+    Check(lz77_set_thread_simd_level(LZ77_SIMD_SCALAR) == LZ77_SIMD_SCALAR, "nie ustawiono poziomu skalarnego");
+    std::vector<Encoded> reference;
+    for (const TestImage& img : images) {
+        for (const Config& cfg : configs) {
+            Encoded enc;
+            Check(EncodeImage(img, cfg, img.height, enc), img.name + " " + Describe(cfg) + ": kompresja nie powiodla sie");
+            reference.push_back(std::move(enc));
+        }
+    }
+
+    size_t compared = 0;
+    for (int level = LZ77_SIMD_SCALAR; level <= cpuLevel; ++level) {
+        std::string where = "SIMD " + std::to_string(level);
+        if (!Check(lz77_set_thread_simd_level(level) == level && lz77_simd_level() == level,
+            where + ": poziom nie zostal ustawiony"))
+            continue;
+
+        size_t r = 0;
+        for (const TestImage& img : images) {
+            for (const Config& cfg : configs) {
+                std::string what = where + " " + img.name + " " + Describe(cfg);
+                Encoded enc;
+                Check(EncodeImage(img, cfg, img.height, enc) && enc.blocks == reference[r].blocks &&
+                    enc.filters.rows == reference[r].filters.rows, what + ": strumien rozny od jadra skalarnego");
+                Check(DecodeEncoded(img, cfg, img.height, reference[r]), what +
+                    ": obraz po dekompresji rozni sie od oryginalu");
+                ++r;
+                ++compared;
+            }
+        }
+    }
+
+    // Ujemny poziom wątku — z powrotem poziom procesu.
+    Check(lz77_set_thread_simd_level(-1) == processLevel && lz77_simd_level() == processLevel,
+        "ujemny poziom nie przywrocil poziomu procesu");
+
+    return Finish("simd_test", "poziom procesora " + std::to_string(cpuLevel) + ", " +
+        std::to_string(compared) + " porownan");
+}
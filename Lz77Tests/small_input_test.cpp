@@ -0,0 +1,107 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// small_input_test — bufor roboczy dopasowany do wejścia (lz77_work_bytes):
+//   - rozmiar nie maleje z liczbą pikseli i nie przekracza
+//     lz77_params_work_bytes (LZ77_WORK_NEED_BYTES dla params == NULL),
+//   - params == NULL obejmuje pełną tablicę head[] (Token12 jak AsmDll.dll),
+//   - kompresja z buforem dokładnie tej wielkości (kończącym się przed stroną
+//     bez dostępu) daje strumień jak z pełnym buforem i odtwarza obraz —
+//     dla 0..300 pikseli i granic tablic (4096, 65536 px),
+//   - nieprawidłowe parametry — 0.
+// ============================================================
+
+#include "test_util.h"
+
+static std::vector<size_t> Counts()
+{
+    std::vector<size_t> counts;
+    for (size_t n = 0; n <= 300; ++n) counts.push_back(n);
+    for (size_t n : { 511, 512, 513, 1000, 4095, 4096, 4097, 16384, 32769, 65535, 65536, 65537, 200000 })
+        counts.push_back(n);
+    return counts;
+}
+
+// Kompresja count pikseli z buforem roboczym workCap bajtów w GuardedBuffer.
+// lz77_work_bytes nie musi być wielokrotnością 16 (zapas na wyrównanie kubełków),
+// a tablice łańcuchów i parsowania optymalnego wymagają adresu wyrównanego jak
+// z malloc — bufor kończy się najwyżej 15 bajtów przed stroną bez dostępu.
+static std::vector<uint8_t> Compress(const uint32_t* px, size_t count, const lz77_params* params,
+    bool token12, size_t workCap)
+{
+    GuardedBuffer work((workCap + 15) & ~static_cast<size_t>(15));
+    std::vector<uint8_t> dst(lz77_compress_bound(token12 ? LZ77_FORMAT_TOKEN12 : LZ77_FORMAT_PACKED_EX, count) + 1);
+    size_t outLen = 0;
+    if (token12)
+        lz77_rgba_compress(px, count, dst.data(), dst.size(), work.Data(), workCap, &outLen);
+    else if (params)
+        lz77_rgba_compress_level(px, count, dst.data(), dst.size(), work.Data(), workCap, params, &outLen, nullptr);
+    else
+        lz77_rgba_compress_packed(px, count, dst.data(), dst.size(), work.Data(), workCap, &outLen);
+    dst.resize(outLen);
+    return dst;
+}
+
+static bool Decode(const std::vector<uint8_t>& stream, const uint32_t* px, size_t count,
+    const lz77_params* params, bool token12)
+{
+    GuardedBuffer out(count * sizeof(uint32_t));
+    size_t outLen = 0;
+    if (token12)
+        lz77_rgba_decompress(stream.data(), stream.size(), out.Pixels(), count, &outLen);
+    else if (params)
+        lz77_rgba_decompress_level(stream.data(), stream.size(), out.Pixels(), count, params, &outLen);
+    else
+        lz77_rgba_decompress_packed(stream.data(), stream.size(), out.Pixels(), count, &outLen);
+    return outLen == count && (count == 0 || memcmp(out.Data(), px, count * sizeof(uint32_t)) == 0);
+}
+
+int main(int, char**)
+{
+    const std::vector<size_t> counts = Counts();
+    const TestImage img = MakeImage("obraz500x400", 500, 400, 5, 1);
+
+    size_t checked = 0;
+    for (int level = 0; level <= LZ77_LEVEL_MAX; ++level) {
+        for (int token12 = 0; token12 < (level == 0 ? 2 : 1); ++token12) {
+            lz77_params params{};
+            lz77_level_params(level, &params);
+            const lz77_params* p = level ? &params : nullptr;
+            size_t fullCap = p ? lz77_params_work_bytes(p) : LZ77_WORK_NEED_BYTES;
+            std::string mode = token12 ? "Token12" : "poziom " + std::to_string(level);
+
+            size_t previous = 0;
+            for (size_t count : counts) {
+                std::string what = mode + " " + std::to_string(count) + " px";
+                size_t need = lz77_work_bytes(count, p);
+                Check(need >= previous && need <= fullCap, what + ": lz77_work_bytes = " + std::to_string(need));
+                if (!p)
+                    Check(count == 0 || need >= 65536 * sizeof(uint32_t), what + ": bez pelnej tablicy head[]");
+                previous = need;
+
+                const uint32_t* px = img.px.data();
+                std::vector<uint8_t> exact = Compress(px, count, p, token12 != 0, need);
+                Check(count == 0 ? exact.empty() : !exact.empty(), what + ": dlugosc strumienia");
+                Check(exact == Compress(px, count, p, token12 != 0, fullCap), what +
+                    ": strumien zalezy od wielkosci bufora roboczego");
+                Check(count == 0 || Decode(exact, px, count, p, token12 != 0), what +
+                    ": obraz po dekompresji rozni sie od oryginalu");
+                ++checked;
+            }
+        }
+    }
+
+    lz77_params bad{};
+    lz77_level_params(LZ77_LEVEL_DEFAULT, &bad);
+    bad.window_px = 3000;
+    Check(lz77_work_bytes(100, &bad) == 0, "lz77_work_bytes przyjal nieprawidlowe parametry");
+
+    return Finish("small_input_test", std::to_string(checked) + " rozmiarow wejscia");
+}
@@ -0,0 +1,168 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// stream_test — kompresja strumieniowa i lz77_compress_bound:
+//   - fragmenty po 1, 7 i 4093 bajty z lz77_stream_begin / _image / _ex,
+//     połączone, są identyczne z jednorazowym lz77_rgba_compress_packed,
+//     lz77_rgba_compress_level, lz77_rgba_compress_image i lz77_rgba_compress_ex
+//     na obrazie 300000 px (granice segmentów, okna, pełna tablica hash),
+//   - fragment o pojemności 0, wywołanie po zakończeniu, za mały bufor roboczy,
+//   - szum: strumień każdego formatu ma dokładnie lz77_compress_bound bajtów
+//     i mieści się w buforze tej pojemności, a o bajt mniejszy nie wystarcza.
+// ============================================================
+
+#include "test_util.h"
+
+// Sposób rozpoczęcia strumienia i odpowiadająca mu kompresja jednorazowa.
+enum class StreamKind { Plain, Image, Ex };
+
+struct StreamCase {
+    std::string  name;
+    StreamKind   kind;
+    bool         useLevel;
+    int          level;
+};
+
+static bool BeginStream(const StreamCase& sc, std::vector<uint8_t>& work, const TestImage& img,
+    const lz77_params* params)
+{
+    switch (sc.kind) {
+    case StreamKind::Plain:
+        return lz77_stream_begin(work.data(), work.size(), img.px.data(), img.px.size(), params) == 1;
+    case StreamKind::Image:
+        return lz77_stream_begin_image(work.data(), work.size(), img.px.data(), img.px.size(),
+            img.width, params) == 1;
+    default:
+        return lz77_stream_begin_ex(work.data(), work.size(), img.px.data(), img.px.size(),
+            img.width, params, LZ77_MATCH_FINDER_CHAIN) == 1;
+    }
+}
+
+static std::vector<uint8_t> CompressOnce(const StreamCase& sc, const TestImage& img, const lz77_params* params)
+{
+    size_t count = img.px.size();
+    std::vector<uint8_t> work(lz77_work_bytes(count, params));
+    std::vector<uint8_t> dst(lz77_compress_bound(LZ77_FORMAT_PACKED_EX, count));
+    size_t outLen = 0;
+    if (sc.kind == StreamKind::Ex)
+        lz77_rgba_compress_ex(img.px.data(), count, img.width, dst.data(), dst.size(), work.data(), work.size(),
+            params, LZ77_MATCH_FINDER_CHAIN, &outLen, nullptr);
+    else if (sc.kind == StreamKind::Image)
+        lz77_rgba_compress_image(img.px.data(), count, img.width, dst.data(), dst.size(), work.data(), work.size(),
+            params, &outLen, nullptr);
+    else if (params)
+        lz77_rgba_compress_level(img.px.data(), count, dst.data(), dst.size(), work.data(), work.size(),
+            params, &outLen, nullptr);
+    else
+        lz77_rgba_compress_packed(img.px.data(), count, dst.data(), dst.size(), work.data(), work.size(), &outLen);
+    dst.resize(outLen);
+    return dst;
+}
+
+static void TestChunks(const TestImage& img, const StreamCase& sc)
+{
+    lz77_params levelParams{};
+    lz77_level_params(sc.level, &levelParams);
+    const lz77_params* params = sc.useLevel ? &levelParams : nullptr;
+    const std::vector<uint8_t> once = CompressOnce(sc, img, params);
+    if (!Check(!once.empty(), img.name + " " + sc.name + ": kompresja jednorazowa nie powiodla sie"))
+        return;
+
+    std::vector<uint8_t> work(lz77_stream_work_bytes(params));
+    for (size_t chunk : { size_t(1), size_t(7), size_t(4093) }) {
+        std::string what = img.name + " " + sc.name + " fragmenty " + std::to_string(chunk) + " B";
+        if (!Check(BeginStream(sc, work, img, params), what + ": lz77_stream_begin nie powiodl sie"))
+            continue;
+
+        std::vector<uint8_t> joined;
+        std::vector<uint8_t> buf(chunk);
+        int rc = LZ77_STREAM_NEED_OUTPUT;
+        bool fullChunks = true;
+        while (rc == LZ77_STREAM_NEED_OUTPUT) {
+            size_t len = 0;
+            rc = lz77_stream_compress(work.data(), buf.data(), buf.size(), &len, nullptr);
+            if (rc == LZ77_STREAM_NEED_OUTPUT && len != chunk) fullChunks = false;
+            joined.insert(joined.end(), buf.begin(), buf.begin() + len);
+        }
+        Check(rc == LZ77_STREAM_DONE, what + ": strumien nie zakonczony LZ77_STREAM_DONE");
+        Check(fullChunks, what + ": niepelny fragment przed koncem strumienia");
+        Check(joined == once, what + ": polaczone fragmenty rozne od kompresji jednorazowej");
+
+        size_t len = 1;
+        Check(lz77_stream_compress(work.data(), buf.data(), buf.size(), &len, nullptr) == LZ77_STREAM_ERROR &&
+            len == 0, what + ": wywolanie po zakonczeniu nie zwrocilo LZ77_STREAM_ERROR");
+    }
+
+    // Fragment o pojemności 0 nie kończy ani nie psuje strumienia.
+    std::vector<uint8_t> buf(4096);
+    size_t len = 1;
+    BeginStream(sc, work, img, params);
+    Check(lz77_stream_compress(work.data(), buf.data(), 0, &len, nullptr) == LZ77_STREAM_NEED_OUTPUT && len == 0,
+        img.name + " " + sc.name + ": fragment 0 B");
+
+    std::vector<uint8_t> small(lz77_stream_work_bytes(params) - 1);
+    Check(!BeginStream(sc, small, img, params), img.name + " " + sc.name + ": przyjeto za maly bufor roboczy");
+}
+
+// Szum bez powtórzeń: strumień osiąga lz77_compress_bound.
+static void TestBound(const TestImage& noise)
+{
+    size_t count = noise.px.size();
+    std::vector<uint8_t> work(LZ77_WORK_NEED_BYTES);
+    lz77_params level5{};
+    lz77_level_params(LZ77_LEVEL_MAX, &level5);
+    std::vector<uint8_t> work5(lz77_params_work_bytes(&level5));
+
+    for (uint16_t format : { LZ77_FORMAT_TOKEN12, LZ77_FORMAT_PACKED, LZ77_FORMAT_PACKED_EX }) {
+        std::string what = noise.name + " format " + std::to_string(format);
+        size_t bound = lz77_compress_bound(format, count);
+        for (size_t cap : { bound, bound - 1 }) {
+            std::vector<uint8_t> dst(cap);
+            size_t outLen = 0;
+            if (format == LZ77_FORMAT_TOKEN12)
+                lz77_rgba_compress(noise.px.data(), count, dst.data(), cap, work.data(), work.size(), &outLen);
+            else if (format == LZ77_FORMAT_PACKED)
+                lz77_rgba_compress_packed(noise.px.data(), count, dst.data(), cap, work.data(), work.size(), &outLen);
+            else
+                lz77_rgba_compress_level(noise.px.data(), count, dst.data(), cap, work5.data(), work5.size(),
+                    &level5, &outLen, nullptr);
+            if (cap == bound)
+                Check(outLen == bound, what + ": strumien szumu (" + std::to_string(outLen) +
+                    " B) rozny od granicy " + std::to_string(bound) + " B");
+            else
+                Check(outLen == 0, what + ": strumien zmiescil sie w buforze mniejszym od granicy");
+        }
+    }
+
+    Check(lz77_compress_bound(0, count) == 0 && lz77_compress_bound(LZ77_FORMAT_PACKED_EX + 1, count) == 0,
+        "lz77_compress_bound przyjal nieznany format");
+    Check(lz77_compress_bound(LZ77_FORMAT_TOKEN12, SIZE_MAX / 4) == 0 &&
+        lz77_compress_bound(LZ77_FORMAT_PACKED, SIZE_MAX / 2) == 0, "lz77_compress_bound bez kontroli przepelnienia");
+}
+
+int main(int, char**)
+{
+    const TestImage image = MakeImage("obraz600x500", 600, 500, 8, 1);
+    const StreamCase cases[] = {
+        { "packed", StreamKind::Plain, false, 0 },
+        { "level3", StreamKind::Plain, true, 3 },
+        { "level5", StreamKind::Plain, true, 5 },
+        { "image", StreamKind::Image, false, 0 },
+        { "image level4", StreamKind::Image, true, 4 },
+        { "ex", StreamKind::Ex, false, 0 },
+        { "ex level5", StreamKind::Ex, true, 5 },
+    };
+    for (const StreamCase& sc : cases)
+        TestChunks(image, sc);
+
+    TestBound(MakeImage("szum600x500", 600, 500, 100, 2));
+
+    return Finish("stream_test", std::to_string(sizeof(cases) / sizeof(cases[0])) + " rodzajow strumienia");
+}
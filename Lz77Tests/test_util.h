@@ -0,0 +1,583 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+#pragma once
+
+// ============================================================
+// Wspólne narzędzia testów Lz77Tests/*_test.cpp (uruchamianych przez ctest).
+//
+// Każdy test to osobny program: argument 1 — katalog plików tymczasowych
+// (TestDir; domyślnie podkatalog katalogu tymczasowego systemu), kod wyjścia
+// 0 = OK, 1 = błąd testu (Finish).
+//
+// Strumienie bloków i bufory dekodera kończą się tuż przed stroną bez dostępu
+// (GuardedBuffer) — odczyt lub zapis za końcem przerywa test błędem ochrony.
+// ============================================================
+
+#include "lz77.h"
+#include "lz77_container.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Bez filtrów wierszy (Config.filter).
+static const int NO_FILTER = -1;
+
+// Powyżej tej liczby pikseli nagłówek z przestawionym bitem nie jest dekodowany
+// (np. przestawiony bit wysokości) — sprawdzana jest tylko spójność indeksu.
+static const uint64_t MAX_DECODE_PIXELS = 1u << 22;
+
+inline int g_failures = 0;
+
+inline void Fail(const std::string& what)
+{
+    if (g_failures++ < 20)
+        fprintf(stderr, "BLAD: %s\n", what.c_str());
+}
+
+// Warunek testu — przy niespełnionym komunikat przez Fail.
+inline bool Check(bool condition, const std::string& what)
+{
+    if (!condition) Fail(what);
+    return condition;
+}
+
+// ============================================================
+// GuardedBuffer — bufor kończący się tuż przed stroną bez dostępu
+// (mmap + mprotect; pod Windows VirtualAlloc + VirtualProtect).
+// ============================================================
+class GuardedBuffer {
+public:
+    explicit GuardedBuffer(size_t bytes)
+    {
+        size_t page = PageSize();
+        size_t dataPages = (bytes + page - 1) / page;
+        m_mapBytes = (dataPages + 1) * page;
+#ifdef _WIN32
+        m_map = static_cast<uint8_t*>(VirtualAlloc(nullptr, m_mapBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+        DWORD old = 0;
+        if (!m_map || !VirtualProtect(m_map + dataPages * page, page, PAGE_NOACCESS, &old))
+            throw std::bad_alloc();
+#else
+        void* map = mmap(nullptr, m_mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) throw std::bad_alloc();
+        m_map = static_cast<uint8_t*>(map);
+        if (mprotect(m_map + dataPages * page, page, PROT_NONE) != 0) throw std::bad_alloc();
+#endif
+        m_data = m_map + dataPages * page - bytes;
+    }
+
+    ~GuardedBuffer()
+    {
+#ifdef _WIN32
+        VirtualFree(m_map, 0, MEM_RELEASE);
+#else
+        munmap(m_map, m_mapBytes);
+#endif
+    }
+
+    GuardedBuffer(const GuardedBuffer&) = delete;
+    GuardedBuffer& operator=(const GuardedBuffer&) = delete;
+
+    uint8_t* Data() const { return m_data; }
+    uint32_t* Pixels() const { return reinterpret_cast<uint32_t*>(m_data); }
+
+private:
+    static size_t PageSize()
+    {
+#ifdef _WIN32
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    uint8_t* m_map = nullptr;
+    uint8_t* m_data = nullptr;
+    size_t   m_mapBytes = 0;
+};
+
+// ============================================================
+// Obrazy testowe — deterministyczne (xorshift32), z powtórzeniami
+// w wierszu i między wierszami (dopasowania) oraz szumem (literały).
+// MakeLargeImage — ponad 65536 pikseli w jednym bloku: okna poziomów 3..5,
+// kilka segmentów LZ77_PARSE_OPTIMAL (16384 px) i pełna tablica hash.
+// ============================================================
+struct TestImage {
+    std::string           name;
+    uint32_t              width;
+    uint32_t              height;
+    std::vector<uint32_t> px;
+};
+
+inline uint32_t NextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+inline TestImage MakeImage(const char* name, uint32_t width, uint32_t height, int noisePercent, uint32_t seed)
+{
+    TestImage img{ name, width, height, {} };
+    img.px.resize(static_cast<size_t>(width) * height);
+    uint32_t state = seed;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            size_t i = static_cast<size_t>(y) * width + x;
+            uint32_t r = NextRandom(state);
+            if (static_cast<int>(r % 100) < noisePercent)
+                img.px[i] = NextRandom(state);
+            else if (x >= 4 && (r >> 8) % 3 == 0)
+                img.px[i] = img.px[i - 4];                       // powtórzenie w wierszu
+            else if (y > 0 && (r >> 8) % 3 == 1)
+                img.px[i] = img.px[i - width];                   // wiersz powyżej
+            else
+                img.px[i] = 0xFF000000u | ((x * 4) & 0xFF) << 16 | ((y * 3) & 0xFF) << 8 | ((x + y) & 0xFF);
+        }
+    }
+    return img;
+}
+
+// Obraz 300x300 (90000 px): co 3000 px fragment 1500 px powtórzony z odległości
+// 5000..45000 px — poza oknem 4096 px formatu kompaktowego, dopasowania
+// dłuższe niż 64 i 256 px tylko dla poziomów 3..5.
+inline TestImage MakeLargeImage(uint32_t seed)
+{
+    TestImage img = MakeImage("duzy300x300", 300, 300, 8, seed);
+    uint32_t state = seed * 7919u + 1u;
+    for (size_t i = 6000; i + 1500 <= img.px.size(); i += 3000) {
+        size_t distance = 5000 + NextRandom(state) % 40000;
+        if (distance > i) distance = i;
+        std::copy(img.px.begin() + (i - distance), img.px.begin() + (i - distance + 1500), img.px.begin() + i);
+    }
+    return img;
+}
+
+// ============================================================
+// Config — jedna kombinacja ustawień kompresji (jak opcje lz77img).
+// ============================================================
+struct Config {
+    uint16_t    version = LZ77_FORMAT_PACKED;
+    bool        useLevel = false;                 // rekord parametrów poziomu
+    lz77_params params{};
+    int         filter = NO_FILTER;               // LZ77_FILTER_* lub LZ77_FILTER_ADAPTIVE
+    uint32_t    transform = LZ77_TRANSFORM_NONE;
+    bool        entropy = false;
+    int         finder = LZ77_MATCH_FINDER_CHAIN;
+};
+
+inline std::string Describe(const Config& cfg)
+{
+    std::string s = cfg.version == LZ77_FORMAT_TOKEN12 ? "token12" : "packed";
+    if (cfg.useLevel)
+        s += " level=" + std::to_string(cfg.params.level) + " parse=" + std::to_string(cfg.params.parse);
+    if (cfg.filter != NO_FILTER)
+        s += " filter=" + std::to_string(cfg.filter) + " transform=" + std::to_string(cfg.transform);
+    if (cfg.entropy) s += " entropy";
+    if (cfg.finder != LZ77_MATCH_FINDER_CHAIN) s += " finder=" + std::to_string(cfg.finder);
+    return s;
+}
+
+// Format i parametry jak w lz77img: wersja 3 (LZ77_FORMAT_PACKED_EX), gdy okno
+// lub maks. dopasowanie poziomu różnią się od formatu kompaktowego.
+inline Config PackedConfig(int level, int parse)
+{
+    Config cfg;
+    if (level == 0 && parse < 0) return cfg;
+
+    cfg.useLevel = true;
+    lz77_level_params(level != 0 ? level : LZ77_LEVEL_DEFAULT, &cfg.params);
+    if (parse >= 0 && cfg.params.parse != static_cast<uint32_t>(parse)) {
+        cfg.params.parse = static_cast<uint32_t>(parse);
+        cfg.params.level = 0;
+    }
+    if (cfg.params.window_px != LZ77_PACKED_WINDOW_PX || cfg.params.max_match_px != LZ77_PACKED_MAX_MATCH_PX)
+        cfg.version = LZ77_FORMAT_PACKED_EX;
+    return cfg;
+}
+
+inline Config Token12Config()
+{
+    Config cfg;
+    cfg.version = LZ77_FORMAT_TOKEN12;
+    return cfg;
+}
+
+// ============================================================
+// Kompresja obrazu blokami po blockRows wierszy (jak runBlock w lz77img).
+// ============================================================
+struct Encoded {
+    std::vector<std::vector<uint8_t>> blocks;
+    Lz77RowFilters                    filters;
+};
+
+inline bool EncodeImage(const TestImage& img, const Config& cfg, uint32_t blockRows, Encoded& enc)
+{
+    const lz77_params* params = cfg.useLevel ? &cfg.params : nullptr;
+    if (cfg.filter != NO_FILTER) {
+        enc.filters.transform = cfg.transform;
+        enc.filters.rows.assign(img.height, 0);
+    }
+
+    for (uint32_t firstRow = 0; firstRow < img.height; firstRow += blockRows) {
+        size_t rows = std::min<size_t>(blockRows, img.height - firstRow);
+        size_t count = rows * img.width;
+        const uint32_t* src = img.px.data() + static_cast<size_t>(firstRow) * img.width;
+
+        std::vector<uint32_t> residuals;
+        if (cfg.filter != NO_FILTER) {
+            residuals.resize(count);
+            if (!lz77_filter_rows(src, residuals.data(), img.width, rows, static_cast<uint32_t>(cfg.filter),
+                cfg.transform, enc.filters.rows.data() + firstRow))
+                return false;
+            src = residuals.data();
+        }
+
+        std::vector<uint8_t> work(lz77_work_bytes(count, params));
+        std::vector<uint8_t> tokens(lz77_compress_bound(cfg.version, count));
+        size_t tokenLen = 0;
+        if (cfg.version == LZ77_FORMAT_TOKEN12)
+            lz77_rgba_compress(src, count, tokens.data(), tokens.size(), work.data(), work.size(), &tokenLen);
+        else
+            lz77_rgba_compress_ex(src, count, img.width, tokens.data(), tokens.size(),
+                work.data(), work.size(), params, cfg.finder, &tokenLen, nullptr);
+        if (tokenLen == 0) return false;
+        tokens.resize(tokenLen);
+
+        if (cfg.entropy) {
+            std::vector<uint8_t> coded(lz77_entropy_bound(tokenLen));
+            size_t codedLen = 0;
+            lz77_entropy_encode(tokens.data(), tokenLen, params, coded.data(), coded.size(), &codedLen);
+            if (codedLen == 0) return false;
+            coded.resize(codedLen);
+            tokens.swap(coded);
+        }
+        enc.blocks.push_back(std::move(tokens));
+    }
+    return true;
+}
+
+// Indeks bloków, jaki Lz77ReadContainer zbudowałby dla zakodowanego obrazu.
+inline Lz77BlockIndex IndexFor(const Config& cfg, uint32_t blockRows, const Encoded& enc)
+{
+    Lz77BlockIndex index;
+    index.blockRows = blockRows;
+    index.offsets.push_back(0);
+    for (const std::vector<uint8_t>& block : enc.blocks)
+        index.offsets.push_back(index.offsets.back() + block.size());
+    if (cfg.useLevel) index.params = cfg.params;
+    index.filters = enc.filters;
+    index.entropy = cfg.entropy;
+    return index;
+}
+
+inline bool WriteEncoded(const fs::path& path, const TestImage& img, const Config& cfg,
+    uint32_t blockRows, const Encoded& enc)
+{
+    std::vector<Lz77BlockSpan> spans;
+    for (const std::vector<uint8_t>& block : enc.blocks)
+        spans.push_back({ block.data(), block.size() });
+    return Lz77WriteContainer(path, img.width, img.height, cfg.version, blockRows, spans,
+        cfg.useLevel ? &cfg.params : nullptr, cfg.filter != NO_FILTER ? &enc.filters : nullptr, cfg.entropy);
+}
+
+// ============================================================
+// DecodeBlock — dekompresja bloku jak w lz77img (RunDecompression):
+// strumień kopiowany do GuardedBuffer, wyjście i reszty w GuardedBuffer.
+// dst — miejsce na piksele bloku (może być nullptr); zwraca *out_len dekodera.
+// ============================================================
+inline size_t DecodeBlock(uint16_t version, const Lz77BlockIndex& index, uint32_t width, uint32_t firstRow,
+    const uint8_t* stream, size_t streamLen, size_t expected, uint32_t* dst)
+{
+    GuardedBuffer src(streamLen);
+    if (streamLen != 0) memcpy(src.Data(), stream, streamLen);
+    GuardedBuffer out(expected * sizeof(uint32_t));
+    size_t outLen = 0;
+
+    const Lz77RowFilters& filters = index.filters;
+    const lz77_params* params = version == LZ77_FORMAT_PACKED_EX ? &index.params : nullptr;
+    if (!filters.rows.empty()) {
+        GuardedBuffer residuals(expected * sizeof(uint32_t));
+        if (index.entropy)
+            lz77_rgba_decompress_entropy(src.Data(), streamLen, out.Pixels(), expected, residuals.Pixels(),
+                params, width, filters.transform, filters.rows.data() + firstRow, &outLen);
+        else
+            lz77_rgba_decompress_image(src.Data(), streamLen, out.Pixels(), expected, residuals.Pixels(),
+                params, width, filters.transform, filters.rows.data() + firstRow, &outLen);
+    }
+    else if (index.entropy)
+        lz77_rgba_decompress_entropy(src.Data(), streamLen, out.Pixels(), expected, nullptr, params, width,
+            LZ77_TRANSFORM_NONE, nullptr, &outLen);
+    else if (version == LZ77_FORMAT_PACKED_EX)
+        lz77_rgba_decompress_level(src.Data(), streamLen, out.Pixels(), expected, &index.params, &outLen);
+    else if (version == LZ77_FORMAT_PACKED)
+        lz77_rgba_decompress_packed(src.Data(), streamLen, out.Pixels(), expected, &outLen);
+    else
+        lz77_rgba_decompress(src.Data(), streamLen, out.Pixels(), expected, &outLen);
+
+    if (dst && outLen == expected && expected != 0)
+        memcpy(dst, out.Data(), expected * sizeof(uint32_t));
+    return outLen;
+}
+
+// Liczba pikseli bloku b (firstRow — [out] jego pierwszy wiersz).
+inline size_t BlockPixels(uint32_t width, uint32_t height, uint32_t blockRows, uint32_t b, uint32_t& firstRow)
+{
+    firstRow = b * blockRows;
+    return static_cast<size_t>(std::min(blockRows, height - firstRow)) * width;
+}
+
+// Dekompresja wszystkich bloków bez kontenera — obraz musi być identyczny z wejściem.
+inline bool DecodeEncoded(const TestImage& img, const Config& cfg, uint32_t blockRows, const Encoded& enc)
+{
+    Lz77BlockIndex index = IndexFor(cfg, blockRows, enc);
+    std::vector<uint32_t> pixels(img.px.size());
+    for (uint32_t b = 0; b < enc.blocks.size(); ++b) {
+        uint32_t firstRow = 0;
+        size_t expected = BlockPixels(img.width, img.height, blockRows, b, firstRow);
+        if (DecodeBlock(cfg.version, index, img.width, firstRow, enc.blocks[b].data(), enc.blocks[b].size(),
+            expected, pixels.data() + static_cast<size_t>(firstRow) * img.width) != expected)
+            return false;
+    }
+    return pixels == img.px;
+}
+
+// Kompresja i dekompresja obrazu bez kontenera; size — [out, opcjonalnie] suma bloków.
+inline bool RoundTrip(const TestImage& img, const Config& cfg, uint32_t blockRows, size_t* size = nullptr)
+{
+    Encoded enc;
+    bool ok = Check(EncodeImage(img, cfg, blockRows, enc), img.name + " " + Describe(cfg) +
+        ": kompresja nie powiodla sie") &&
+        Check(DecodeEncoded(img, cfg, blockRows, enc), img.name + " " + Describe(cfg) +
+            ": obraz po dekompresji rozni sie od oryginalu");
+    if (size) {
+        *size = 0;
+        for (const std::vector<uint8_t>& block : enc.blocks) *size += block.size();
+    }
+    return ok;
+}
+
+// ============================================================
+// Pliki .lz77 — indeks przyjęty przez Lz77ReadContainer musi opisywać dane
+// w granicach pliku.
+// ============================================================
+inline bool IndexConsistent(const Lz77FileHeader& hdr, const Lz77BlockIndex& index,
+    const Lz77MappedFile& file, const uint8_t* data)
+{
+    if (index.offsets.size() < 2 || index.offsets.front() != 0 || index.offsets.back() != hdr.compressedBytes)
+        return false;
+    if (!std::is_sorted(index.offsets.begin(), index.offsets.end())) return false;
+    if (data != file.Data() + hdr.headerBytes || hdr.headerBytes + hdr.compressedBytes > file.Size())
+        return false;
+
+    uint64_t blockCount = index.offsets.size() - 1;
+    if (index.blockRows == 0 || (blockCount - 1) * index.blockRows >= hdr.height ||
+        blockCount * index.blockRows < hdr.height)
+        return false;
+    return index.filters.rows.empty() || index.filters.rows.size() == hdr.height;
+}
+
+// Odczyt pliku i dekompresja wszystkich bloków; pixels — obraz (może być nullptr).
+// Zwraca false, gdy plik odrzucono lub blok nie zdekodował się w całości.
+inline bool ReadAndDecode(const fs::path& path, std::vector<uint32_t>* pixels, bool& accepted)
+{
+    Lz77FileHeader hdr{};
+    Lz77BlockIndex index;
+    Lz77MappedFile file;
+    const uint8_t* data = nullptr;
+    accepted = Lz77ReadContainer(path, hdr, index, file, data);
+    if (!accepted) return false;
+
+    if (!IndexConsistent(hdr, index, file, data)) {
+        Fail(path.filename().string() + ": niespojny indeks blokow");
+        return false;
+    }
+    if (hdr.version != LZ77_FORMAT_TOKEN12 && hdr.version != LZ77_FORMAT_PACKED &&
+        hdr.version != LZ77_FORMAT_PACKED_EX)
+        return false;
+    if (static_cast<uint64_t>(hdr.width) * hdr.height > MAX_DECODE_PIXELS) return false;
+
+    if (pixels) pixels->assign(static_cast<size_t>(hdr.width) * hdr.height, 0u);
+    bool ok = true;
+    for (uint32_t b = 0; b + 1 < index.offsets.size(); ++b) {
+        uint32_t firstRow = 0;
+        size_t expected = BlockPixels(hdr.width, hdr.height, index.blockRows, b, firstRow);
+        size_t outLen = DecodeBlock(hdr.version, index, hdr.width, firstRow, data + index.offsets[b],
+            static_cast<size_t>(index.offsets[b + 1] - index.offsets[b]), expected,
+            pixels ? pixels->data() + static_cast<size_t>(firstRow) * hdr.width : nullptr);
+        ok = ok && outLen == expected;
+    }
+    return ok;
+}
+
+inline std::vector<uint8_t> ReadBytes(const fs::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+inline void WriteBytes(const fs::path& path, const uint8_t* data, size_t size)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+// ============================================================
+// Zapis, odczyt i dekompresja pliku .lz77 — nagłówek zgodny z zapisanym,
+// obraz identyczny z wejściem.
+// ============================================================
+inline void TestFileRoundTrip(const fs::path& dir, const TestImage& img, const Config& cfg, uint32_t blockRows)
+{
+    std::string what = img.name + " " + Describe(cfg);
+    Encoded enc;
+    if (!EncodeImage(img, cfg, blockRows, enc)) {
+        Fail(what + ": kompresja nie powiodla sie");
+        return;
+    }
+    fs::path path = dir / "roundtrip.lz77";
+    if (!WriteEncoded(path, img, cfg, blockRows, enc)) {
+        Fail(what + ": blad zapisu");
+        return;
+    }
+
+    Lz77FileHeader hdr{};
+    Lz77BlockIndex index;
+    {
+        Lz77MappedFile file;
+        const uint8_t* data = nullptr;
+        if (!Lz77ReadContainer(path, hdr, index, file, data)) {
+            Fail(what + ": Lz77ReadContainer odrzucil poprawny plik");
+            return;
+        }
+    }
+    if (hdr.width != img.width || hdr.height != img.height || hdr.version != cfg.version ||
+        index.blockRows != blockRows || index.offsets.size() != enc.blocks.size() + 1 ||
+        index.entropy != cfg.entropy || index.filters.rows != enc.filters.rows ||
+        (cfg.filter != NO_FILTER && index.filters.transform != cfg.transform) ||
+        (cfg.useLevel && memcmp(&index.params, &cfg.params, sizeof(lz77_params)) != 0)) {
+        Fail(what + ": naglowek po odczycie rozni sie od zapisanego");
+        return;
+    }
+
+    std::vector<uint32_t> pixels;
+    bool accepted = false;
+    if (!ReadAndDecode(path, &pixels, accepted) || pixels != img.px)
+        Fail(what + ": obraz po dekompresji rozni sie od oryginalu");
+    fs::remove(path);
+}
+
+// ============================================================
+// Uszkodzony plik: każde skrócenie jest odrzucane przez Lz77ReadContainer;
+// plik z przestawionym bitem nagłówka jest odrzucany albo daje spójny indeks
+// bloków, który dekoduje się bez wyjścia poza bufory.
+// ============================================================
+inline void TestFileCorruption(const fs::path& dir, const TestImage& img, const Config& cfg, uint32_t blockRows)
+{
+    std::string what = img.name + " " + Describe(cfg);
+    Encoded enc;
+    fs::path path = dir / "corrupt.lz77";
+    if (!EncodeImage(img, cfg, blockRows, enc) || !WriteEncoded(path, img, cfg, blockRows, enc)) {
+        Fail(what + ": kompresja lub zapis nie powiodly sie");
+        return;
+    }
+    const std::vector<uint8_t> bytes = ReadBytes(path);
+    size_t headerBytes = bytes.size();
+    for (const std::vector<uint8_t>& block : enc.blocks)
+        headerBytes -= block.size();
+
+    for (size_t len = 0; len < bytes.size(); ++len) {
+        WriteBytes(path, bytes.data(), len);
+        Lz77FileHeader hdr{};
+        Lz77BlockIndex index;
+        Lz77MappedFile file;
+        const uint8_t* data = nullptr;
+        if (Lz77ReadContainer(path, hdr, index, file, data))
+            Fail(what + ": przyjeto plik skrocony do " + std::to_string(len) + " B");
+    }
+
+    std::vector<uint8_t> copy = bytes;
+    for (size_t bit = 0; bit < headerBytes * 8; ++bit) {
+        copy[bit / 8] ^= static_cast<uint8_t>(1u << (bit % 8));
+        WriteBytes(path, copy.data(), copy.size());
+        bool accepted = false;
+        ReadAndDecode(path, nullptr, accepted);
+        copy[bit / 8] = bytes[bit / 8];
+    }
+    fs::remove(path);
+}
+
+// ============================================================
+// Uszkodzony blok: każde skrócenie strumienia bloku jest odrzucane przez
+// dekoder (*out_len != liczba pikseli bloku); przestawiony bit nie powoduje
+// wyjścia poza bufory.
+// ============================================================
+inline void TestBlockCorruption(const TestImage& img, const Config& cfg, uint32_t blockRows)
+{
+    std::string what = img.name + " " + Describe(cfg);
+    Encoded enc;
+    if (!EncodeImage(img, cfg, blockRows, enc)) {
+        Fail(what + ": kompresja nie powiodla sie");
+        return;
+    }
+    Lz77BlockIndex index = IndexFor(cfg, blockRows, enc);
+    for (uint32_t b = 0; b < enc.blocks.size(); ++b) {
+        uint32_t firstRow = 0;
+        size_t expected = BlockPixels(img.width, img.height, blockRows, b, firstRow);
+        std::vector<uint8_t> block = enc.blocks[b];
+        for (size_t len = 0; len < block.size(); ++len) {
+            if (DecodeBlock(cfg.version, index, img.width, firstRow, block.data(), len, expected, nullptr) == expected)
+                Fail(what + ": blok " + std::to_string(b) + " skrocony do " + std::to_string(len) +
+                    " B zdekodowany w calosci");
+        }
+        for (size_t bit = 0; bit < block.size() * 8; ++bit) {
+            block[bit / 8] ^= static_cast<uint8_t>(1u << (bit % 8));
+            DecodeBlock(cfg.version, index, img.width, firstRow, block.data(), block.size(), expected, nullptr);
+            block[bit / 8] = enc.blocks[b][bit / 8];
+        }
+    }
+}
+
+// ============================================================
+// Katalog plików tymczasowych testu i zakończenie programu testu.
+// ============================================================
+inline bool TestDir(int argc, char** argv, const char* name, fs::path& dir)
+{
+    dir = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path() / name;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) fprintf(stderr, "Nie mozna utworzyc katalogu %s\n", dir.string().c_str());
+    return !ec;
+}
+
+inline int Finish(const char* name, const std::string& summary)
+{
+    printf("%s: %s, bledow: %d\n", name, summary.c_str(), g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
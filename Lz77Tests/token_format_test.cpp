@@ -0,0 +1,104 @@
+﻿/********************************************************************************
+ * TEMAT PROJEKTU: Algorytm LZ77 do kompresji obrazków
+ * OPIS ALGORYTMU: Implementacja algorytmu LZ77 do kompresji obrazków – odpowiednik kodu asemblerowego MASM x64 napisany w C++
+ * DATA WYKONANIA: luty 2026 r.
+ * SEMESTR / ROK AKADEMICKI: Semestr Zimowy 2025/2026
+ * AUTOR: Maciej Guja
+ * AKTUALNA WERSJA: 1.1
+ ********************************************************************************/
+
+// ============================================================
+// token_format_test — formaty tokenów Token12 (lz77_rgba_compress)
+// i kompaktowy (lz77_rgba_compress_packed):
+//   - kompresja i dekompresja dają obraz identyczny z wejściem,
+//   - format kompaktowy nie jest dłuższy od Token12,
+//   - lz77_rgba_compress_packed_stats daje te same bajty i spójne liczniki,
+//   - strumień pod adresem niewyrównanym dekoduje się tak samo,
+//   - skrócony strumień jest odrzucany, przestawiony bit nie wychodzi poza bufory.
+// ============================================================
+
+#include "test_util.h"
+
+// Dekompresja strumienia skopiowanego pod adres przesunięty o shift bajtów.
+static std::vector<uint32_t> DecodeShifted(uint16_t version, const std::vector<uint8_t>& stream,
+    size_t count, size_t shift)
+{
+    std::vector<uint8_t> copy(stream.size() + shift);
+    memcpy(copy.data() + shift, stream.data(), stream.size());
+    std::vector<uint32_t> pixels(count);
+    size_t outLen = 0;
+    if (version == LZ77_FORMAT_TOKEN12)
+        lz77_rgba_decompress(copy.data() + shift, stream.size(), pixels.data(), count, &outLen);
+    else
+        lz77_rgba_decompress_packed(copy.data() + shift, stream.size(), pixels.data(), count, &outLen);
+    if (outLen != count) pixels.clear();
+    return pixels;
+}
+
+static void TestFormats(const TestImage& img)
+{
+    size_t count = img.px.size();
+    std::vector<uint8_t> work(LZ77_WORK_NEED_BYTES);
+
+    std::vector<uint8_t> token12(lz77_compress_bound(LZ77_FORMAT_TOKEN12, count));
+    size_t token12Len = 0;
+    lz77_rgba_compress(img.px.data(), count, token12.data(), token12.size(), work.data(), work.size(), &token12Len);
+    token12.resize(token12Len);
+
+    std::vector<uint8_t> packed(lz77_compress_bound(LZ77_FORMAT_PACKED, count));
+    size_t packedLen = 0;
+    lz77_rgba_compress_packed(img.px.data(), count, packed.data(), packed.size(), work.data(), work.size(), &packedLen);
+    packed.resize(packedLen);
+
+    if (!Check(token12Len != 0 && packedLen != 0, img.name + ": kompresja zwrocila 0 bajtow"))
+        return;
+    Check(token12Len % 12 == 0, img.name + ": dlugosc strumienia Token12 nie jest wielokrotnoscia 12");
+    Check(packedLen <= token12Len, img.name + ": format kompaktowy dluzszy od Token12");
+
+    std::vector<uint8_t> withStats(packed.size() + 16);
+    size_t statsLen = 0;
+    lz77_stats stats{};
+    lz77_rgba_compress_packed_stats(img.px.data(), count, withStats.data(), withStats.size(),
+        work.data(), work.size(), &statsLen, &stats);
+    Check(statsLen == packedLen && memcmp(withStats.data(), packed.data(), packedLen) == 0,
+        img.name + ": lz77_rgba_compress_packed_stats rozni sie od lz77_rgba_compress_packed");
+    Check(stats.literal_px + stats.match_px == count && stats.matches <= stats.match_px &&
+        stats.literal_runs <= stats.literal_px,
+        img.name + ": niespojne liczniki lz77_stats");
+
+    for (size_t shift = 0; shift < 4; ++shift) {
+        std::string where = img.name + " przesuniecie " + std::to_string(shift);
+        Check(DecodeShifted(LZ77_FORMAT_TOKEN12, token12, count, shift) == img.px, where + ": Token12 rozny od oryginalu");
+        Check(DecodeShifted(LZ77_FORMAT_PACKED, packed, count, shift) == img.px, where + ": kompaktowy rozny od oryginalu");
+    }
+}
+
+int main(int, char**)
+{
+    const TestImage images[] = {
+        MakeImage("piksel1x1", 1, 1, 0, 1),
+        MakeImage("obraz61x37", 61, 37, 5, 2),
+        MakeImage("szum29x23", 29, 23, 60, 3),
+        MakeImage("szum100", 97, 41, 100, 4),
+        MakeImage("kolumna1x50", 1, 50, 10, 5),
+        MakeImage("jednolity200x200", 200, 200, 0, 6),
+        MakeLargeImage(7),
+    };
+    const Config configs[] = { Token12Config(), PackedConfig(0, -1) };
+
+    size_t roundTrips = 0;
+    for (const TestImage& img : images) {
+        TestFormats(img);
+        for (const Config& cfg : configs) {
+            RoundTrip(img, cfg, Lz77BlockRowsFor(img.width, img.height, 0xFFFFFFFFu));
+            RoundTrip(img, cfg, Lz77BlockRowsFor(img.width, img.height, 500));
+            roundTrips += 2;
+        }
+    }
+
+    const TestImage small = MakeImage("obraz23x19", 23, 19, 10, 8);
+    for (const Config& cfg : configs)
+        TestBlockCorruption(small, cfg, 6);
+
+    return Finish("token_format_test", std::to_string(roundTrips) + " kompresji i dekompresji");
+}
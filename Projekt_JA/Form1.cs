@@ -23,9 +23,11 @@ namespace Projekt_JA
         // Kontrolki dodawane w kodzie (nie w Designerze):
         //   progressBar – pasek postepu (0-100)
         //   logTextBox  – pole tekstowe z logiem operacji
+        //   checkBoxEntropy – kodowanie entropijne blokow (tylko C++, kompresja)
         // ============================================================
         private ProgressBar progressBar = null!;
         private TextBox logTextBox = null!;
+        private CheckBox checkBoxEntropy = null!;
 
         // ============================================================
         // P/Invoke – wywolania do Logic.dll
@@ -41,6 +43,10 @@ namespace Projekt_JA
         //   progressCb    – callback (percent: int)
         //   logCb         – callback (message: wstring)
         //
+        // StartCompressionEx:
+        //   jak StartCompression + options (Lz77CompressOptions z logic.h);
+        //   GUI ustawia tylko pole entropy (kodowanie entropijne bloków)
+        //
         // StartDecompression:
         //   sourceFolder  – folder tymczasowy z wypakowanymi plikami .lz77
         //   outputFolder  – folder wynikowy dla zdekompresowanych .bmp
@@ -65,6 +71,41 @@ namespace Projekt_JA
             LogCallback logCb,
             out long outElapsedMs);
 
+        // Uklad pol jak struct Lz77CompressOptions w logic.h (callbacki
+        // i wskazniki na statystyki jako IntPtr — GUI ich nie uzywa)
+        [StructLayout(LayoutKind.Sequential)]
+        private struct Lz77CompressOptions
+        {
+            public uint blockPixels;
+            public uint maxInFlight;
+            public uint level;
+            public IntPtr statsCb;
+            public uint kernel;
+            public IntPtr batchStats;
+            public uint ioMode;
+            public uint ioQueueDepth;
+            public IntPtr ioStats;
+            public uint rowFilter;
+            public uint colorTransform;
+            public uint entropy;
+        }
+
+        // Wartosc Lz77CompressOptions.entropy (LOGIC_ENTROPY_HUFFMAN)
+        private const uint EntropyHuffman = 1;
+
+        [DllImport("CppLogicDll.dll",
+                   CallingConvention = CallingConvention.StdCall,
+                   CharSet = CharSet.Unicode)]
+        private static extern void StartCompressionEx(
+            string sourceFolder,
+            string outputFolder,
+            bool useASM,
+            int numThreads,
+            ref Lz77CompressOptions options,
+            ProgressCallback progressCb,
+            LogCallback logCb,
+            out long outElapsedMs);
+
         [DllImport("CppLogicDll.dll",
                    CallingConvention = CallingConvention.StdCall,
                    CharSet = CharSet.Unicode)]
@@ -109,6 +150,19 @@ namespace Projekt_JA
             button2.Click += button2_Click;
             button3.Click += button3_Click;
 
+            // --- Przelacznik kodowania entropijnego obok przycisku Kompresuj ---
+            // Domyslnie wylaczony: pliki z kodowaniem dekoduje tylko Dll_CPP.dll,
+            // a czas kompresji C++ obejmowalby prace, ktorej ASM nie wykonuje.
+            checkBoxEntropy = new CheckBox
+            {
+                AutoSize = true,
+                Location = new Point(290, button1.Top + 3),
+                Text = "Kodowanie entropijne",
+                Checked = false,
+                Enabled = !radioButton2.Checked
+            };
+            Controls.Add(checkBoxEntropy);
+
             // --- Dodaj pasek postepu ponizej przycisku Kompresuj/Dekompresuj ---
             progressBar = new ProgressBar
             {
@@ -187,6 +241,7 @@ namespace Projekt_JA
             label3.Visible = true;
             button3.Visible = true;
             button1.Text = "Kompresuj";
+            if (checkBoxEntropy != null) checkBoxEntropy.Visible = true;
             AdjustLayout(true);
         }
 
@@ -197,9 +252,16 @@ namespace Projekt_JA
             label3.Visible = false;
             button3.Visible = false;
             button1.Text = "Dekompresuj";
+            if (checkBoxEntropy != null) checkBoxEntropy.Visible = false;
             AdjustLayout(false);
         }
 
+        // Kodowanie entropijne dostepne tylko z Dll_CPP.dll
+        private void radioButton2_CheckedChanged(object sender, EventArgs e)
+        {
+            if (checkBoxEntropy != null) checkBoxEntropy.Enabled = !radioButton2.Checked;
+        }
+
         // ============================================================
         // AdjustLayout – zmiana rozmiaru groupBox3 i przesuniecie
         //                kontrolek lezacych ponizej (w tym progressBar
@@ -222,6 +284,7 @@ namespace Projekt_JA
             // Kontrolki dodane dynamicznie w Form1_Load
             if (progressBar != null) progressBar.Top += delta;
             if (logTextBox != null) logTextBox.Top += delta;
+            if (checkBoxEntropy != null) checkBoxEntropy.Top += delta;
 
             ClientSize = new Size(ClientSize.Width, ClientSize.Height + delta);
         }
@@ -318,6 +381,7 @@ namespace Projekt_JA
 
             // Odczytaj parametry z GUI przed przelaczeniem na inny watek
             bool useASM = radioButton2.Checked;
+            bool useEntropy = !useASM && checkBoxEntropy.Checked;
             int numThreads = trackBar1.Value;
             string src = sourcePath;
             string dst = destinationPath;
@@ -330,7 +394,7 @@ namespace Projekt_JA
             progressBar.Value = 0;
 
             if (isCompression)
-                await Task.Run(() => RunCompression(src, dst, useASM, numThreads));
+                await Task.Run(() => RunCompression(src, dst, useASM, useEntropy, numThreads));
             else
                 await Task.Run(() => RunDecompression(zip, useASM, numThreads));
 
@@ -341,13 +405,16 @@ namespace Projekt_JA
         // RunCompression (wykonywana w tle przez Task.Run)
         //
         // 1. Tworzy folder tymczasowy.
-        // 2. Wola StartCompression z Logic.dll — ta tworzy N workerow
+        // 2. Wola StartCompression (lub StartCompressionEx z kodowaniem
+        //    entropijnym) z Logic.dll — ta tworzy N workerow
         //    i kompresuje obrazki do folderu tymczasowego (.lz77).
-        // 3. Pakuje pliki .lz77 do archiwum ZIP w sciezce docelowej.
+        // 3. Pakuje pliki .lz77 do archiwum ZIP w sciezce docelowej
+        //    (bloki zakodowane entropijnie zapisywane sa bez deflate,
+        //    pozostale z deflate).
         // 4. Usuwa folder tymczasowy.
         // ============================================================
         private void RunCompression(string sourceFolder, string zipPath,
-                                    bool useASM, int numThreads)
+                                    bool useASM, bool useEntropy, int numThreads)
         {
             string tempFolder = Path.Combine(
                 Path.GetTempPath(),
@@ -360,7 +427,8 @@ namespace Projekt_JA
                 AppendLog("=== Kompresja: start ===");
                 AppendLog($"Zrodlo:   {sourceFolder}");
                 AppendLog($"Wyjscie:  {zipPath}");
-                AppendLog($"Watkow:   {numThreads}  |  DLL: {(useASM ? "ASM" : "C++")}");
+                AppendLog($"Watkow:   {numThreads}  |  DLL: {(useASM ? "ASM" : "C++")}"
+                          + (useEntropy ? "  |  kodowanie entropijne" : ""));
                 AppendLog("");
 
                 // Callbacki – delegaty musza zyc przez caly czas wywolania
@@ -370,10 +438,25 @@ namespace Projekt_JA
                 LogCallback logCb = message => AppendLog(message);
 
                 // Wywolaj logic.cpp – tworzy N workerow, kompresuje obrazki
-                StartCompression(sourceFolder, tempFolder,
-                                 useASM, numThreads,
-                                 progressCb, logCb,
-                                 out long elapsedMs);
+                long elapsedMs;
+                if (useEntropy)
+                {
+                    Lz77CompressOptions options = new Lz77CompressOptions
+                    {
+                        entropy = EntropyHuffman
+                    };
+                    StartCompressionEx(sourceFolder, tempFolder,
+                                       useASM, numThreads, ref options,
+                                       progressCb, logCb,
+                                       out elapsedMs);
+                }
+                else
+                {
+                    StartCompression(sourceFolder, tempFolder,
+                                     useASM, numThreads,
+                                     progressCb, logCb,
+                                     out elapsedMs);
+                }
                 SetElapsedTime(elapsedMs);
 
                 // --- Pakuj wyniki do archiwum ZIP (System.IO.Compression) ---
@@ -391,12 +474,17 @@ namespace Projekt_JA
                     return;
                 }
 
+                // Deflate na strumieniu po kodowaniu Huffmana prawie nic nie zyskuje,
+                // a kosztuje wiecej niz sama kompresja LZ77 — stad NoCompression.
+                CompressionLevel zipLevel = useEntropy ? CompressionLevel.NoCompression
+                                                       : CompressionLevel.Optimal;
+
                 using (ZipArchive archive = ZipFile.Open(zipPath, ZipArchiveMode.Create))
                 {
                     foreach (string file in lz77Files)
                     {
                         // Dodaj plik .lz77 jako wpis w archiwum ZIP
-                        archive.CreateEntryFromFile(file, Path.GetFileName(file));
+                        archive.CreateEntryFromFile(file, Path.GetFileName(file), zipLevel);
                     }
                 }
 
@@ -541,7 +629,6 @@ namespace Projekt_JA
         // Handlery stubowe (podpiete w Designerze, nieuzywane)
         // ============================================================
         private void radioButton1_CheckedChanged(object sender, EventArgs e) { }
-        private void radioButton2_CheckedChanged(object sender, EventArgs e) { }
         private void label1_Click(object sender, EventArgs e) { }
         private void label3_Click(object sender, EventArgs e) { }
         private void label2_Click(object sender, EventArgs e) { }